@@ -0,0 +1,129 @@
+#ifndef AGGREGATE_HPP
+#define AGGREGATE_HPP
+
+#include <vector>
+#include <algorithm>
+#include "dc.hpp"
+using namespace std;
+
+/**
+ * Dynamic connectivity with a value in every vertex and the
+ * aggregate of the values over every connected component
+ * (e.g. their sum, minimum or maximum).
+ *
+ * The Monoid parameter provides the type of the values, its
+ * identity and an associative and commutative operation:
+ *
+ *   typedef ... value_type;
+ *   static value_type identity();
+ *   static value_type combine(const value_type &a, const value_type &b);
+ *
+ * The aggregates are kept for every node of the Euler tours of
+ * F_0 (the identity for edge nodes) and are recomputed together
+ * with the other aggregates of the nodes, so the updates of the
+ * graph keep their complexity. The forests of the other levels
+ * are not affected. The structure runs over HookedTree <Tree>,
+ * so BasicDynamicConnectivity <Tree> itself never calls a hook.
+ */
+
+template <class Tree, class Monoid>
+class AggregatedDynamicConnectivity : public BasicDynamicConnectivity <HookedTree <Tree> >,
+                                      private AggregateHook {
+    public:
+    typedef typename Monoid::value_type value_type;
+
+    /**
+     * Initiates the data structure for a n-vertex graph
+     * (see BasicDynamicConnectivity) with all the values equal
+     * to the identity
+     * Complexity: as in BasicDynamicConnectivity
+     */
+    AggregatedDynamicConnectivity(int _n);
+    AggregatedDynamicConnectivity(int _n, const vector <pair <int, int> > &edges);
+
+    /* the hook is registered by its address */
+    AggregatedDynamicConnectivity(const AggregatedDynamicConnectivity &) = delete;
+
+    /**
+     * Sets the value of the vertex v to x
+     * Complexity: O(log n)
+     */
+    void set_vertex_value(int v, const value_type &x);
+
+    /**
+     * Returns the value of the vertex v
+     * Complexity: O(1)
+     */
+    const value_type &vertex_value(int v) const;
+
+    /**
+     * Returns the aggregate of the values of all the vertices in
+     * the connected component of v
+     * Complexity: O(log n)
+     */
+    value_type component_aggregate(int v);
+
+    private:
+    /* the vertex v has the node v+1 in the Euler tours of F_0 */
+    vector <value_type> Values;
+    vector <value_type> Aggregates;
+
+    void update(node_t x, node_t left, node_t right);
+    void resize(size_t nodes);
+};
+
+template <class Tree, class Monoid>
+AggregatedDynamicConnectivity<Tree, Monoid>::AggregatedDynamicConnectivity(int _n)
+    : BasicDynamicConnectivity <HookedTree <Tree> > (_n),
+      Values(_n, Monoid::identity()),
+      Aggregates(_n + 1, Monoid::identity()) {
+    // all the aggregates are the identity until a value is set
+    this->set_aggregate_hook(this);
+}
+
+template <class Tree, class Monoid>
+AggregatedDynamicConnectivity<Tree, Monoid>::AggregatedDynamicConnectivity(int _n,
+        const vector <pair <int, int> > &edges)
+    : BasicDynamicConnectivity <HookedTree <Tree> > (_n, edges),
+      Values(_n, Monoid::identity()),
+      Aggregates(_n + 1, Monoid::identity()) {
+    this->set_aggregate_hook(this);
+}
+
+template <class Tree, class Monoid>
+void AggregatedDynamicConnectivity<Tree, Monoid>::set_vertex_value(int v, const value_type &x) {
+    Values[v] = x;
+    this->update_vertex(v);
+}
+
+template <class Tree, class Monoid>
+auto AggregatedDynamicConnectivity<Tree, Monoid>::vertex_value(int v) const
+        -> const value_type & {
+    return Values[v];
+}
+
+template <class Tree, class Monoid>
+auto AggregatedDynamicConnectivity<Tree, Monoid>::component_aggregate(int v)
+        -> value_type {
+    node_t root = this->component_root(v);
+    return root < Aggregates.size() ? Aggregates[root] : Monoid::identity();
+}
+
+template <class Tree, class Monoid>
+void AggregatedDynamicConnectivity<Tree, Monoid>::update(node_t x, node_t left,
+                                                         node_t right) {
+    bool vertex = x != NIL && x <= Values.size();
+    value_type own = vertex ? Values[x - 1] : Monoid::identity();
+    Aggregates[x] = Monoid::combine(Monoid::combine(Aggregates[left], own),
+                                    Aggregates[right]);
+}
+
+template <class Tree, class Monoid>
+void AggregatedDynamicConnectivity<Tree, Monoid>::resize(size_t nodes) {
+    // edge nodes are allocated past the vertex nodes; those
+    // created before the hook was set hold the identity
+    if (nodes > Aggregates.size())
+        Aggregates.resize(max(nodes, 2 * Aggregates.size()), Monoid::identity());
+}
+
+#endif
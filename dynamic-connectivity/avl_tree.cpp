@@ -2,62 +2,45 @@
 #include <cstdlib>
 #include "avl_tree.hpp"
 
-AVLNode::AVLNode() {
-    left = right = parent = NULL;
-    height = 1;
-    size = 0;
-    nontree_cnt = 0;
-    on_level_cnt = 0;
-}
-
-VertexNode::VertexNode(int i) {
-    idx = i;
-    size = 1;
-}
-
-EdgeNode::EdgeNode(int _from, int _to, bool _on_level) {
-    from = _from;
-    to = _to;
-    on_level = _on_level;
-    on_level_cnt = _on_level ? 1 : 0;
-}
-
 // BST operations:
 
-void AVLNode::unlink_children() {
-    if (left) {
-        left->parent = NULL;
-        left = NULL;
+/* Detaches the children of x without updating its statistics */
+template <class Hook>
+void BasicAVLTree<Hook>::detach(node_t x) {
+    TourNode &node = Nodes[x];
+    if (node.left != NIL) {
+        set_parent(node.left, NIL);
+        node.left = NIL;
     }
-    if (right) {
-        right->parent = NULL;
-        right = NULL;
+    if (node.right != NIL) {
+        set_parent(node.right, NIL);
+        node.right = NIL;
     }
+}
 
-    update_statistics();
+template <class Hook>
+node_t BasicAVLTree<Hook>::root(node_t x) const {
+    return find_root(x);
 }
 
-AVLNode *AVLNode::root() {
-    AVLNode *cur = this;
-    while (cur->parent != NULL) {
-        cur = cur->parent;
-    }
-    return cur;
+template <class Hook>
+bool BasicAVLTree<Hook>::same_tree(node_t x, node_t y) const {
+    return find_root(x) == find_root(y);
 }
 
 /**
  * Split the tree into two trees, one containing all nodes to the
- * left of the current node (inclusive), and the ones to the
- * righ (exclusive) in the other tree.
- * 
- * Starting from this, we process all the nodes on the path to
- * the root. Each such node has two (possibly NULL) children
+ * left of x (inclusive), and the ones to the righ (exclusive)
+ * in the other tree.
+ *
+ * Starting from x, we process all the nodes on the path to
+ * the root. Each such node has two (possibly NIL) children
  * -- one has already been processed, the subtree of the other
- * is either fully to the left or to the right of this and
+ * is either fully to the left or to the right of x and
  * should be added to the respective tree
  * (left_tree or right_tree).
- * 
- * This creates a series of merge operations with nonnull middle
+ *
+ * This creates a series of merge operations with non-NIL middle
  * node. Note that all subtrees being merged to left_tree
  * (and right_tree) have nondecreasing heights. Also, at the
  * point of each such merge, the left_tree (and right_tree) can
@@ -67,487 +50,309 @@ AVLNode *AVLNode::root() {
  * heights of the subtrees being merged at each step)
  * is O(log n). This gives us the complexity O(log n).
 */
-pair <AVLNode*, AVLNode*> AVLNode::split() {
-    AVLNode *left_child, *right_child, *left_tree, *right_tree, *prv, *cur, *nxt;
-    left_tree = left;
-    right_tree = right;
-    nxt = parent;
-    cur = this;
-
-    cur->unlink_children();
-    cur->parent = NULL;
-    left_tree = merge(left_tree, NULL, cur);
-
-    while (nxt != NULL) {
-        prv = cur;
-        cur = nxt;
-        nxt = nxt->parent;
+template <class Hook>
+pair <node_t, node_t> BasicAVLTree<Hook>::split(node_t x) {
+    node_t left = Nodes[x].left, right = Nodes[x].right;
+    node_t parent = Nodes[x].parent;
 
-        left_child = right_child = NULL;
-
-        bool was_right = (cur->right == prv);
-        if (was_right) {
-            left_child = cur->left;
-            if (left_child)
-                left_child->parent = NULL;
+    detach(x);
+    return split_path(x, parent, merge(left, x, NIL), right);
+}
 
-        } else {
-            right_child = cur->right;
-            if (right_child)
-                right_child->parent = NULL;
+/**
+ * The same walk as in split, except that x itself is
+ * not added to any of the trees
+ */
+template <class Hook>
+pair <node_t, node_t> BasicAVLTree<Hook>::split_around(node_t x) {
+    node_t left = Nodes[x].left, right = Nodes[x].right;
+    node_t parent = Nodes[x].parent;
 
-        }
+    detach(x);
+    set_parent(x, NIL);
+    update_statistics(x);
+    return split_path(x, parent, left, right);
+}
 
-        cur->parent = cur->left = cur->right = NULL;
-        cur->update_statistics();
+/**
+ * Distributes the ancestors of x (starting from its former
+ * parent cur) and their other subtrees between left_tree and
+ * right_tree. The child pointers on the path still lead to x.
+ */
+template <class Hook>
+pair <node_t, node_t> BasicAVLTree<Hook>::split_path(node_t x, node_t cur,
+                                          node_t left_tree, node_t right_tree) {
+    node_t prv = x;
+
+    while (cur != NIL) {
+        node_t nxt = Nodes[cur].parent;
+        bool was_right = (Nodes[cur].right == prv);
+        node_t child = was_right ? Nodes[cur].left : Nodes[cur].right;
+
+        // cur is merged as a middle node, which recomputes
+        // its statistics
+        if (child != NIL)
+            set_parent(child, NIL);
+        Nodes[cur].left = Nodes[cur].right = NIL;
+        set_parent(cur, NIL);
 
         if (was_right) {
-            left_tree = merge(left_child, cur, left_tree);
+            left_tree = merge(child, cur, left_tree);
 
         } else {
-            right_tree = merge(right_tree, cur, right_child);
+            right_tree = merge(right_tree, cur, child);
         }
+
+        prv = cur;
+        cur = nxt;
     }
 
     return {left_tree, right_tree};
 }
 
-void AVLNode::replace_child(AVLNode *old_child, AVLNode *new_child) {
-
-    if (left == old_child) {
-        left = new_child;
-
-    } else if (right == old_child) {
-        right = new_child;
-
-    } else {
-        assert(0);
-    }
-}
-
 /**
- * Recursively merges two trees into one
- * (optionally also inserting a middle vertex).
- * 
- * This procedure keeps taking the child of the tree with greater
- * height until the heights of the two trees can be put as
- * children of a single (middle) vertex.
- * This costs O(abs(left->height - right->height))
- * 
- * However, if the middle vertex is NULL, this can't be done, and
- * the procedure is repeated until one of the trees is empty,
- * which case can be trivially handled.
- * This costs O(log n)
+ * Merges two trees into one (optionally also inserting
+ * a middle vertex).
+ *
+ * With a middle vertex, the procedure descends along the inner
+ * spine of the higher tree to the first subtree whose height
+ * is close to the height of the other tree, puts both of them
+ * as children of the middle vertex in its place and rebalances
+ * the path back to the root. This costs
+ * O(abs(left->height - right->height)).
+ *
+ * Without it, the last node of the left tree (or the first one
+ * of the right tree, whichever tree is lower) is removed and
+ * used as the middle vertex. This costs O(log n).
 */
-AVLNode *AVLNode::merge(AVLNode *left, AVLNode *middle, AVLNode *right) {
+template <class Hook>
+node_t BasicAVLTree<Hook>::merge(node_t left, node_t middle, node_t right) {
 
-    if (left == NULL) {
-        if (middle == NULL) {
+    if (middle == NIL) {
+        if (left == NIL)
             return right;
-        } else {
-            return merge(middle, NULL, right);
-        }
-    }
-    if (right == NULL) {
-        if (middle == NULL) {
+        if (right == NIL)
             return left;
+
+        if (Nodes[left].height <= Nodes[right].height) {
+            node_t last = left;
+            while (Nodes[last].right != NIL)
+                last = Nodes[last].right;
+            left = remove(last);
+            middle = last;
+
         } else {
-            return merge(left, NULL, middle);
+            node_t first = right;
+            while (Nodes[first].left != NIL)
+                first = Nodes[first].left;
+            right = remove(first);
+            middle = first;
         }
     }
 
-    if (middle and abs(left->height - right->height) <= 1) {
+    int hl = Nodes[left].height, hr = Nodes[right].height;
+    node_t parent = NIL;
 
-        middle->left = left;
-        middle->right = right;
-        left->parent = middle;
-        right->parent = middle;
+    if (hl > hr + 1) {
+        // middle replaces a subtree on the right spine of left
+        node_t cur = left;
+        while (Nodes[cur].height > hr + 1) {
+            parent = cur;
+            cur = Nodes[cur].right;
+        }
+        Nodes[parent].right = middle;
+        left = cur;
 
-        middle->update_statistics();
-        return middle;
+    } else if (hr > hl + 1) {
+        // or on the left spine of right
+        node_t cur = right;
+        while (Nodes[cur].height > hl + 1) {
+            parent = cur;
+            cur = Nodes[cur].left;
+        }
+        Nodes[parent].left = middle;
+        right = cur;
     }
 
-    if (left->height <= right->height) {
-
-        if (right->left)
-            right->left->parent = NULL;
-        
-        right->left = merge(left, middle, right->left);
-        right->left->parent = right;
-        right->update_statistics();       
-        return right->balance();
-
-    } else { // left->height > right->height
-
-        if (left->right)
-            left->right->parent = NULL;
-        
-        left->right = merge(left->right, middle, right);
-        left->right->parent = left;
-        left->update_statistics();
-        return left->balance();
-    }
+    set_parent(middle, parent);
+    Nodes[middle].left = left;
+    Nodes[middle].right = right;
+    if (left != NIL)
+        set_parent(left, middle);
+    if (right != NIL)
+        set_parent(right, middle);
+    update_statistics(middle);
+
+    return rebalance_path(parent, middle);
 }
 
-void AVLNode::unlink() {
+/**
+ * Rebalances x and all its ancestors, one of whose subtrees
+ * (rooted in top) changed, and returns the root of the tree
+ */
+template <class Hook>
+node_t BasicAVLTree<Hook>::rebalance_path(node_t x, node_t top) {
+    while (x != NIL) {
+        top = balance(x);
+        x = Nodes[top].parent;
+    }
 
-    // replace this node with its subtree
-    if (left)
-        left->parent = NULL;
-    if (right)
-        right->parent = NULL;
+    return top;
+}
 
-    AVLNode *subtree = merge(left, NULL, right);
-    if (parent) {
-        parent->replace_child(this, subtree);
-        if (subtree)
-            subtree->parent = parent;
+/**
+ * Replaces x with the merge of its subtrees and returns the root
+ * of the remaining tree (NIL if x was the only node)
+ */
+template <class Hook>
+node_t BasicAVLTree<Hook>::remove(node_t x) {
+    node_t left = Nodes[x].left, right = Nodes[x].right;
+    node_t parent = Nodes[x].parent;
+
+    detach(x);
+    set_parent(x, NIL);
+    update_statistics(x);
+
+    node_t subtree = merge(left, NIL, right);
+    if (parent != NIL) {
+        replace_child(parent, x, subtree);
+        if (subtree != NIL)
+            set_parent(subtree, parent);
     }
 
-    // rebalance the tree
-    AVLNode *cur = parent;
-    while (cur) {
-        cur = cur->balance()->parent;
-    }
+    return rebalance_path(parent, subtree);
+}
+
+template <class Hook>
+void BasicAVLTree<Hook>::unlink(node_t x) {
+    remove(x);
+}
 
-    parent = left = right = NULL;
+template <class Hook>
+node_t BasicAVLTree<Hook>::build(const node_t *seq, int k) {
+    return build_balanced(seq, k);
 }
 
-AVLNode* AVLNode::rotate_right() {
-    assert(left != NULL);
-    AVLNode *l_node = left, *lr_node = left->right;
+template <class Hook>
+node_t BasicAVLTree<Hook>::rotate_right(node_t x) {
+    assert(Nodes[x].left != NIL);
+    node_t l_node = Nodes[x].left, lr_node = Nodes[l_node].right;
+
+    set_parent(x, l_node);
+    Nodes[l_node].right = x;
+    set_parent(l_node, NIL);
 
-    this->parent = l_node;
-    l_node->right = this;
-    l_node->parent = NULL;
+    Nodes[x].left = lr_node;
+    if (lr_node != NIL)
+        set_parent(lr_node, x);
 
-    this->left = lr_node;
-    if (lr_node)
-        lr_node->parent = this;
-    
-    this->update_statistics();
-    l_node->update_statistics();
+    update_statistics(x);
+    update_statistics(l_node);
     return l_node;
 }
 
-AVLNode* AVLNode::rotate_left() {
-    assert(right != NULL);
-    AVLNode *r_node = right, *rl_node = right->left;
+template <class Hook>
+node_t BasicAVLTree<Hook>::rotate_left(node_t x) {
+    assert(Nodes[x].right != NIL);
+    node_t r_node = Nodes[x].right, rl_node = Nodes[r_node].left;
 
-    this->parent = r_node;
-    r_node->left = this;
-    r_node->parent = NULL;
+    set_parent(x, r_node);
+    Nodes[r_node].left = x;
+    set_parent(r_node, NIL);
 
-    this->right = rl_node;
-    if (rl_node)
-        rl_node->parent = this;
-    
-    this->update_statistics();
-    r_node->update_statistics();
+    Nodes[x].right = rl_node;
+    if (rl_node != NIL)
+        set_parent(rl_node, x);
+
+    update_statistics(x);
+    update_statistics(r_node);
     return r_node;
 }
 
 /**
- * Rebalances the tree rooted in this node assuming
- * that the subtrees of this node are balanced.
+ * Rebalances the tree rooted in x assuming that the subtrees
+ * of x are balanced.
  * This is done by performing (possibly many) rotations from
  * a higher subtree to the lower one.
 */
-AVLNode* AVLNode::balance() {
-
-    int hl = left ? left->height : 0;
-    int hr = right ? right->height : 0;
-    AVLNode *root, *parent_node = parent;
+template <class Hook>
+node_t BasicAVLTree<Hook>::balance(node_t x) {
+    node_t left = Nodes[x].left, right = Nodes[x].right;
+    int hl = Nodes[left].height;
+    int hr = Nodes[right].height;
+    node_t root, parent_node = Nodes[x].parent;
 
     assert(abs(hl - hr) <= 3);
 
     if (hl > hr + 1) {
-        int hll = left->left ? left->left->height : 0;
-        int hlr = left->right ? left->right->height : 0;
+        int hll = Nodes[Nodes[left].left].height;
+        int hlr = Nodes[Nodes[left].right].height;
 
         if (hll >= hlr) {
-            root = this->rotate_right();
+            root = rotate_right(x);
 
-            if (root->right)
-                root->right->balance();
+            if (Nodes[root].right != NIL)
+                balance(Nodes[root].right);
 
         } else {
-            left = left->rotate_left();
-            left->parent = this;
-            root = this->rotate_right();
+            left = rotate_left(left);
+            Nodes[x].left = left;
+            set_parent(left, x);
+            root = rotate_right(x);
         }
     } else if (hr > hl + 1) {
-        int hrr = right->right ? right->right->height : 0;
-        int hrl = right->left ? right->left->height : 0;
+        int hrr = Nodes[Nodes[right].right].height;
+        int hrl = Nodes[Nodes[right].left].height;
 
         if (hrr >= hrl) {
-            root = this->rotate_left();
+            root = rotate_left(x);
 
-            if (root->left)
-                root->left->balance();
+            if (Nodes[root].left != NIL)
+                balance(Nodes[root].left);
 
         } else {
-            right = right->rotate_right();
-            right->parent = this;
-            root = this->rotate_left();
+            right = rotate_right(right);
+            Nodes[x].right = right;
+            set_parent(right, x);
+            root = rotate_left(x);
         }
     } else {
         // no rebalancing needed at this level
-        root = this;
-        this->update_statistics();
-    }
-
-    root->parent = parent_node;
-    if (parent_node)
-        parent_node->replace_child(this, root);
-    
-    return root;
-}
-
-// Getters for subclass specific fields
-
-bool EdgeNode::is_on_level() {
-    return on_level;
-}
-
-bool AVLNode::is_on_level() {
-    return false;
-}
-
-bool VertexNode::is_on_level() {
-    return AVLNode::is_on_level();
-}
-
-int AVLNode::get_num_nontree_edges() {
-    return 0;
-}
-
-int VertexNode::get_num_nontree_edges() {
-    return NTEdges.size();
-}
-
-int EdgeNode::get_num_nontree_edges() {
-    return AVLNode::get_num_nontree_edges();
-}
-
-// Manage data stored in the nodes
-
-void AVLNode::update_statistics() {
-    height = 1;
-    size = dynamic_cast<VertexNode*>(this) ? 1 : 0;
-    on_level_cnt = is_on_level() ? 1 : 0;
-    nontree_cnt = get_num_nontree_edges();
-
-    if (left) {
-        height = max(height, left->height + 1);
-        size += left->size;
-        on_level_cnt += left->on_level_cnt;
-        nontree_cnt += left->nontree_cnt;
-    }
-    if (right) {
-        height = max(height, right->height + 1);
-        size += right->size;
-        on_level_cnt += right->on_level_cnt;
-        nontree_cnt += right->nontree_cnt;
+        root = x;
+        update_statistics(x);
     }
-}
 
-void AVLNode::update_on_level_cnt(int dx) {
-    for (AVLNode *cur = this; cur != NULL; cur = cur->parent) {
-        cur->on_level_cnt += dx;
-    }
-}
+    set_parent(root, parent_node);
+    if (parent_node != NIL)
+        replace_child(parent_node, x, root);
 
-void AVLNode::update_nontree_cnt(int dx) {
-   for (AVLNode *cur = this; cur != NULL; cur = cur->parent) {
-        cur->nontree_cnt += dx;
-    }
+    return root;
 }
 
-list<int>::iterator VertexNode::push_nontree_edge(int to) {
-    NTEdges.push_front(to);
-    update_nontree_cnt(1);
-    return NTEdges.begin();
-}
+template <class Hook>
+bool BasicAVLTree<Hook>::correct_tree(node_t x, node_t correct_parent) const {
+    const TourNode &node = Nodes[x];
 
-bool AVLNode::pop_nontree_edge(pair <int, int> &edge) {
-    if (nontree_cnt == 0)
+    if (!correct_node(x, correct_parent))
         return false;
-    
-    return (left && left->pop_nontree_edge(edge)) ||
-           (right && right->pop_nontree_edge(edge));
-}
-
-bool VertexNode::pop_nontree_edge(pair <int, int> &edge) {
-    if (NTEdges.empty())
-        return AVLNode::pop_nontree_edge(edge);
-
-    edge = {idx, NTEdges.front()};
-    NTEdges.pop_front();
-    update_nontree_cnt(-1);
-    return true;
-}
-
-bool EdgeNode::pop_nontree_edge(pair <int, int> &edge) {
-    return AVLNode::pop_nontree_edge(edge);
-}
 
-void VertexNode::erase_nontree_edge(list<int>::iterator it) {
-    NTEdges.erase(it);
-    update_nontree_cnt(-1);
-}
-
-bool AVLNode::promote_tree_edge(pair <int, int> &edge) {
-    if (on_level_cnt == 0)
+    if (node.left != NIL && !correct_tree(node.left, x))
         return false;
-    
-    return (left && left->promote_tree_edge(edge)) ||
-           (right && right->promote_tree_edge(edge));
-}
-
-bool EdgeNode::promote_tree_edge(pair <int, int> &edge) {
-    if (on_level) {
-        edge = {from, to};
-        on_level = false;
-        update_on_level_cnt(-1);
-        return true;
-    }
-    
-    return AVLNode::promote_tree_edge(edge);
-}
-
-bool VertexNode::promote_tree_edge(pair <int, int> &edge) {
-    return AVLNode::promote_tree_edge(edge);
-}
-
-// diagnostic methods:
-
-void AVLNode::print_tree(int indent) {
-#ifdef DBG
-    if (left)
-        left->print_tree(indent + 3);
-    print_node(indent);
-    if (right)
-        right->print_tree(indent + 3);
-#else
-    (void) indent;
-#endif
-}
-
-void AVLNode::print_node(int indent) {
-#ifdef DBG
-    char spaces[20] = "                   ";
-    spaces[min(19, indent)] = 0;
-        debug("%s0x%llx: left = 0x%llx, right = 0x%llx, parent = 0x%llx,\n \
-            %sheight = %d, nontree_cnt = %d, on_level_cnt = %d, size = %d\n",
-            spaces, (long long) this, (long long) left,
-            (long long) right, (long long) parent, spaces,
-            height, nontree_cnt, on_level_cnt, size);
-#else
-    (void) indent;
-#endif
-}
-
-void VertexNode::print_node(int indent) {
-#ifdef DBG
-    char spaces[20] = "                   ";
-    spaces[min(19, indent)] = 0;
-    debug("%sVertexNode: %d: ", spaces, idx);
-    for (int x : NTEdges)
-        debug(" %d", x);
-    debug("\n");
-    AVLNode::print_node(indent);
-#else
-    (void) indent;
-#endif
-}
-
-void EdgeNode::print_node(int indent) {
-#ifdef DBG
-    char spaces[20] = "                   ";
-    spaces[min(19, indent)] = 0;
-    debug("%sEdgeNode: (%d %d)\n", spaces, from, to);
-    AVLNode::print_node(indent);
-#else
-    (void) indent;
-#endif
-}
-
-bool AVLNode::correct_tree(AVLNode *correct_parent) {
-    int correct_height = 1;
-    int correct_size = dynamic_cast<VertexNode*>(this) ? 1 : 0;
-    int correct_nontree_cnt = get_num_nontree_edges();
-    int correct_on_level_cnt = is_on_level() ? 1 : 0;
-
-    if (parent != correct_parent) {
-        debug ("parent does not match: 0x%llx vs 0x%llx\n",
-        (long long)parent, (long long)correct_parent);
+    if (node.right != NIL && !correct_tree(node.right, x))
         return false;
-    }
-
-    if (left && left == right) {
-        debug ("left and right children are the same!\n");
-        return false;
-    }
-
-    if (left) {
-        if (!left->correct_tree(this))
-            return false;
-        
-        correct_height = max(correct_height, left->height + 1);
-        correct_size += left->size;
-        correct_nontree_cnt += left->nontree_cnt;
-        correct_on_level_cnt += left->on_level_cnt;
-
-        if (left->height < height - 2) {
-            debug ("height invariant violated\n");
-            return false;
-        }
-
-    } else {
-        if (height > 2) {
-            debug ("height invariant violated\n");
-            return false;
-        }
-    }
-    
-    if (right) {
-        if (!right->correct_tree(this))
-            return false;
-        
-        correct_height = max(correct_height, right->height + 1);
-        correct_size += right->size;
-        correct_nontree_cnt += right->nontree_cnt;
-        correct_on_level_cnt += right->on_level_cnt;
-
-        if (right->height < height - 2) {
-            debug ("height invariant violated\n");
-            return false;
-        }
 
-    } else {
-        if (height > 2) {
-            debug ("height invariant violated\n");
-            return false;
-        }
-    }
-
-    if (correct_height != height) {
+    int hl = Nodes[node.left].height, hr = Nodes[node.right].height;
+    if (node.height != max(hl, hr) + 1) {
         debug ("height does not match\n");
         return false;
-    } 
-    if (correct_size != size) {
-        debug ("size does not match\n");
-        return false;
     }
-    if (correct_nontree_cnt != nontree_cnt) {
-        debug ("nontree_cnt does not match\n");
+    if (abs(hl - hr) > 1) {
+        debug ("height invariant violated\n");
         return false;
     }
-    if (correct_on_level_cnt != on_level_cnt) {
-        debug ("on_level_cnt does not match\n");
-        return false;
-    }
-    
+
     return true;
 }
+
+template class BasicAVLTree<NoHook>;
+template class BasicAVLTree<AggregateHook>;
@@ -2,160 +2,128 @@
 #define AVL_TREE_HPP
 
 #include <cstdio>
+#include <cstdint>
 #include <utility>
-#include <list>
 #include <vector>
 #include <cassert>
+#include "tour_tree.hpp"
 using namespace std;
 
-// A switch for managing debug output
-// #define DBG
-#ifdef DBG
-    #define debug(...) fprintf(stderr, __VA_ARGS__), fflush(stderr)
-#else
-    #define debug(...) {}
-#endif
-
 /**
- * AVL Binary Search Tree node implementation.
+ * AVL Binary Search Tree implementation
  * (https://en.wikipedia.org/wiki/AVL_tree)
+ * over an array of TourNodes.
+ *
+ * The object owns the nodes of all the trees of a forest and
+ * every operation takes node indices (see tour_tree.hpp).
+ * Hook is the policy of the extra aggregates (see TourTree).
  */
 
-class AVLNode {
+template <class Hook = NoHook>
+class BasicAVLTree : public TourTree <Hook> {
+    typedef TourTree <Hook> Base;
+
     public:
-    /* number of vertex nodes in the subtree of this node */
-    int size;
+    template <class OtherHook>
+    using with_hook = BasicAVLTree <OtherHook>;
+
+    using Base::find_root;
 
-    AVLNode();
-    virtual ~AVLNode() {};
+    /**
+     * Splits the tree into two parts and returns their roots.
+     * The first part contains all nodes to the left of x
+     * (inclusive), the second part contains all nodes to the
+     * right of it (exclusive).
+     *
+     * Complexity: O(log n)
+     */
+    pair <node_t, node_t> split(node_t x);
 
     /**
-     * Splits the tree into two parts and returns pointers to
-     * their roots. The first part contains all nodes to the
-     * left of this node (inclusive), the second part contains
-     * all nodes to the right of it (exclusive).
-     * 
+     * Removes x from its tree and splits the rest of it into
+     * the nodes to the left of x and the nodes to the right of
+     * it (both exclusive). Returns the roots of the two parts.
+     * This is split followed by unlink in a single pass.
+     *
      * Complexity: O(log n)
      */
-    pair <AVLNode*, AVLNode*> split();
+    pair <node_t, node_t> split_around(node_t x);
 
     /**
      * Merges two trees (left and right) into one (the middle
      * node is optional) and returns the its root.
      * The order of nodes is as follows:
      * left(unchanged), middle, right(unchanged).
-     * 
-     * Complexity if middle is NULL: O(max(h_l, h_r))
-     * Complexity if middle is not NULL: O(abs(h_l - h_r))
+     *
+     * Complexity if middle is NIL: O(max(h_l, h_r))
+     * Complexity if middle is not NIL: O(abs(h_l - h_r))
      * Here h_l and h_r are the heights of left and right trees
     */
-    static AVLNode *merge(AVLNode *left, AVLNode *middle, AVLNode *right);
+    node_t merge(node_t left, node_t middle, node_t right);
 
     /**
-     * Returns the root of the tree represting the connected
-     * component of this node.
-     * 
+     * Returns the root of the tree containing x
+     *
      * Complexity: O(log n)
      */
-    AVLNode *root();
+    node_t root(node_t x) const;
 
     /**
-     * Removes the current node from the BST it belongs to
-     * 
+     * Checks whether x and y belong to the same tree
+     *
      * Complexity: O(log n)
-    */
-    void unlink();
+     */
+    bool same_tree(node_t x, node_t y) const;
 
     /**
-     * Pops a nontree edge from the subtree of the current node
-     * and returns it in the edge parameter.
-     * Returns true on success and false on failure.
-     * 
+     * Removes x from the tree it belongs to
+     *
      * Complexity: O(log n)
-     */
-    virtual bool pop_nontree_edge(pair <int, int> &edge);
+    */
+    void unlink(node_t x);
 
     /**
-     * Pops a tree edge marked as on_level from the subtree of
-     * this node and returns it in the edge parameter.
-     * Returns true on success and false on failure.
-     * 
-     * Complexity: O(log n)
+     * Builds a tree from the single-node trees seq[0..k-1]
+     * (in this order) and returns its root
+     *
+     * Complexity: O(k)
      */
-    virtual bool promote_tree_edge(pair <int, int> &edge);
+    node_t build(const node_t *seq, int k);
 
     /**
-     * Checks if the invariants hold in the subtree of the current node
-     * 
+     * Checks if the invariants hold in the subtree of x
+     *
      * Complexity: linear in the size of the tree
     */
-    bool correct_tree(AVLNode *correct_parent);
-
-    void print_tree(int indent = 0);
-    virtual void print_node(int indent = 0);
+    bool correct_tree(node_t x, node_t correct_parent) const;
 
     private:
-    AVLNode *balance();
-    AVLNode *rotate_left();
-    AVLNode *rotate_right();
-    void unlink_children();
-
-    void replace_child(AVLNode *old_child, AVLNode *new_child);
-
-    protected:
-    int nontree_cnt, on_level_cnt, height;
-    AVLNode *left, *right, *parent;
-
-    virtual bool is_on_level();
-    virtual int get_num_nontree_edges();
-    void update_nontree_cnt(int dx);
-    void update_on_level_cnt(int dx);
-    void update_statistics();
+    using Base::Nodes;
+    using Base::set_parent;
+    using Base::update_aggregates;
+    using Base::replace_child;
+    using Base::build_balanced;
+    using Base::correct_node;
+
+    node_t balance(node_t x);
+    node_t rebalance_path(node_t x, node_t top);
+    node_t rotate_left(node_t x);
+    node_t rotate_right(node_t x);
+    node_t remove(node_t x);
+    void detach(node_t x);
+    pair <node_t, node_t> split_path(node_t x, node_t cur,
+                                     node_t left_tree, node_t right_tree);
+
+    void update_statistics(node_t x);
 };
 
-/**
- * A node representing a tree edge in an Euler tour.
- * It is used to support merging and splitting of
- * Euler tours.
-*/
-class EdgeNode : public AVLNode {
-    public:
-
-    EdgeNode(int _from, int _to, bool _on_level);
-    bool promote_tree_edge(pair <int, int> &edge);
-    bool pop_nontree_edge(pair <int, int> &edge);
+template <class Hook>
+inline void BasicAVLTree<Hook>::update_statistics(node_t x) {
+    TourNode &node = Nodes[x];
+    node.height = max(Nodes[node.left].height, Nodes[node.right].height) + 1;
+    update_aggregates(x);
+}
 
-    void print_node(int indent = 0);
-    
-    private:
-    int from, to;
-    int get_num_nontree_edges();
-    bool is_on_level();
-    bool on_level;
-};
-
-/**
- * A node representing a vertex in an Euler tour.
- * Used to store the list of nontree edges incident
- * to the vertex.
-*/
-class VertexNode: public AVLNode {
-    public:
+typedef BasicAVLTree <> AVLTree;
 
-    VertexNode(int idx);
-    bool pop_nontree_edge(pair <int, int> &edge);
-    list<int>::iterator push_nontree_edge(int to);
-    void erase_nontree_edge(list<int>::iterator it);
-    bool promote_tree_edge(pair <int, int> &edge);
-
-    void print_node(int indent = 0);
-
-    private:
-    int idx;
-    list <int> NTEdges;
-    
-    int get_num_nontree_edges();
-    bool is_on_level();
-};
-
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,110 @@
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <vector>
+#include "et_trees.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define cycle_counter() __rdtsc()
+#else
+    #define cycle_counter() 0ULL
+#endif
+
+using namespace std;
+
+/**
+ * The split+merge and cut+link benchmarks of ../bench.cpp run
+ * on the pointer-based AVL nodes with virtual dispatch that the
+ * structure started from. The sources in this directory are kept
+ * verbatim, so the numbers can be compared with make bench on
+ * the same machine (same workloads, seeds and output format).
+ */
+
+class Timer {
+    public:
+    Timer() {
+        start_time = chrono::steady_clock::now();
+        start_cycles = cycle_counter();
+    }
+
+    void report(const char *name, long long ops) {
+        auto end_time = chrono::steady_clock::now();
+        unsigned long long end_cycles = cycle_counter();
+        double ns = chrono::duration<double, nano>(end_time - start_time).count();
+
+        printf ("%-40s %12lld ops %10.1f ns/op %10.1f cycles/op\n",
+                name, ops, ns / ops,
+                double(end_cycles - start_cycles) / ops);
+    }
+
+    private:
+    chrono::steady_clock::time_point start_time;
+    unsigned long long start_cycles;
+};
+
+/**
+ * Splits a sequence of n vertex nodes at a random position and
+ * merges the two halves back together.
+ */
+void bench_split_merge(int n, int q) {
+    vector <VertexNode> nodes;
+    nodes.reserve(n);
+    AVLNode *root = NULL;
+    for (int i = 0; i < n; i++) {
+        nodes.push_back(VertexNode(i));
+        root = AVLNode::merge(root, NULL, &nodes[i]);
+    }
+
+    srand(1);
+    vector <int> positions(q);
+    for (int &p: positions)
+        p = rand() % n;
+
+    Timer timer;
+    for (int p: positions) {
+        auto [left, right] = nodes[p].split();
+        root = AVLNode::merge(left, NULL, right);
+    }
+
+    char name[64];
+    sprintf (name, "split+merge virtual (n = %d)", n);
+    timer.report(name, q);
+}
+
+/**
+ * Cuts a random edge of a random spanning tree over n vertices
+ * and links its endpoints back.
+ */
+void bench_link_cut(int n, int q) {
+    ETTForest forest(n);
+    vector <pair <int, int> > edges;
+
+    srand(2);
+    for (int i = 1; i < n; i++) {
+        edges.push_back({rand() % i, i});
+        forest.insert_tree_edge(edges.back().first, edges.back().second, true);
+    }
+
+    vector <int> picks(q);
+    for (int &p: picks)
+        p = rand() % (n - 1);
+
+    Timer timer;
+    for (int p: picks) {
+        forest.remove_tree_edge(edges[p].first, edges[p].second);
+        forest.insert_tree_edge(edges[p].first, edges[p].second, true);
+    }
+
+    char name[64];
+    sprintf (name, "cut+link virtual (n = %d)", n);
+    timer.report(name, q);
+}
+
+int main()
+{
+    for (int n: {1000, 100000, 1000000}) {
+        bench_split_merge(n, 1000000);
+        bench_link_cut(n, 1000000);
+    }
+}
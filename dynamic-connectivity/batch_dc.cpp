@@ -0,0 +1,237 @@
+#include <bits/stdc++.h>
+#include "batch_dc.hpp"
+#include "parallel.hpp"
+
+template <class Tree>
+BasicBatchDynamicConnectivity<Tree>::BasicBatchDynamicConnectivity(int _n)
+    : Base(_n) {}
+
+template <class Tree>
+BasicBatchDynamicConnectivity<Tree>::BasicBatchDynamicConnectivity(int _n,
+        const vector <pair <int, int> > &edges)
+    : Base(_n, edges) {}
+
+template <class Tree>
+const BatchSearchStats &BasicBatchDynamicConnectivity<Tree>::batch_search_stats() const {
+    return Stats;
+}
+
+template <class Tree>
+void BasicBatchDynamicConnectivity<Tree>::remove_batch(const vector <pair <int, int> > &edges) {
+    SeqLock::WriteGuard guard(this->write_lock());
+    this->finish_pending();
+
+    vector <pair <int, pair <int, int> > > cuts;
+    this->cut_batch(edges, cuts);
+
+    size_t on_level = 0;
+    for (int l = cuts.empty() ? -1 : cuts[0].first; l >= 0; l--) {
+        while (on_level < cuts.size() && cuts[on_level].first >= l)
+            on_level++;
+        search_level(cuts, on_level, l);
+    }
+
+    this->release_empty_levels();
+}
+
+/**
+ * Reconnects the fragments of the trees of F_level split by the
+ * first k cuts: first all the fragments but the largest one of
+ * each tree, then the largest fragments of the trees where
+ * a class became too large to be promoted (see
+ * BasicDynamicConnectivity::reconnect_fragments)
+ */
+template <class Tree>
+void BasicBatchDynamicConnectivity<Tree>::search_level(
+        const vector <pair <int, pair <int, int> > > &cuts, size_t k,
+        int level) {
+    Fragments F;
+    this->find_fragments(cuts, k, level, F);
+    int f_cnt = F.vertices.size();
+
+    // the fragments searched, with their original trees
+    vector <pair <int, int> > active;
+    for (int f = 0; f < f_cnt; f++) {
+        int t = F.Trees.find(f);
+        if (f != F.largest[t])
+            active.push_back({F.vertices[f], t});
+    }
+
+    vector <bool> search_largest(f_cnt, false);
+    search_rounds(active, level, F, &search_largest);
+
+    for (int t = 0; t < f_cnt; t++) {
+        if (search_largest[t])
+            active.push_back({F.vertices[F.largest[t]], t});
+    }
+    search_rounds(active, level, F, NULL);
+
+    if (level == 0)
+        this->split_components(F);
+}
+
+/**
+ * Searches the active fragments (a vertex and the original tree
+ * of each) in rounds until none is left. With search_largest,
+ * a fragment stops once it is joined to the largest fragment of
+ * its tree, and the trees where it became too large to be
+ * promoted first are marked in it; without it, a fragment stops
+ * only when it is exhausted or too large.
+ */
+template <class Tree>
+void BasicBatchDynamicConnectivity<Tree>::search_rounds(
+        vector <pair <int, int> > &active, int level, Fragments &F,
+        vector <bool> *search_largest) {
+    int budget = 1;
+    while (!active.empty()) {
+        int a_cnt = active.size();
+
+        // the trees of F_level of the fragments (and of the
+        // largest fragments of their original trees)
+        vector <node_t> roots(a_cnt), largest_roots(a_cnt, NIL);
+        parallel_for(Options.threads, a_cnt, [&](int i) {
+            auto [v, t] = active[i];
+            roots[i] = Forests[level].tree_id(v);
+            if (search_largest != NULL)
+                largest_roots[i] = Forests[level].tree_id(F.vertices[F.largest[t]]);
+        });
+
+        // the classes: one per tree, all of them small enough to
+        // be promoted; an isolated vertex has no edges to look at
+        EdgeTable <int> Seen;
+        vector <pair <int, int> > classes;
+        for (int i = 0; i < a_cnt; i++) {
+            node_t root = roots[i];
+            if (root == NIL || (search_largest != NULL && root == largest_roots[i]))
+                continue;
+            int *seen = Seen.insert(root, root);
+            if (*seen)
+                continue;
+            *seen = 1;
+
+            if (((long long) Forests[level].tree_size(root) << (level+1)) > n) {
+                if (search_largest != NULL)
+                    (*search_largest)[active[i].second] = true;
+                continue;
+            }
+            classes.push_back(active[i]);
+        }
+        active.clear();
+        int c_cnt = classes.size();
+        if (c_cnt == 0)
+            break;
+
+        Stats.rounds++;
+        Stats.searches += c_cnt;
+        this->add_level(level+1);
+        ETTForest <Tree> &Forest = Forests[level], &Next = Forests[level+1];
+
+        // the tree edges of the classes go to the next level first,
+        // so that every class is a single tree there
+        vector <vector <pair <int, int> > > promoted(c_cnt);
+        parallel_for(Options.threads, c_cnt, [&](int c) {
+            Forest.promote_tree_edges(classes[c].first, [&](pair <int, int> e) {
+                Edges.find(e.first, e.second)->level = level+1;
+                promoted[c].push_back(e);
+                return true;
+            });
+        });
+        vector <pair <int, int> > links;
+        for (auto &edges: promoted)
+            links.insert(links.end(), edges.begin(), edges.end());
+        Next.insert_tree_edges(links, true);
+
+        // the probes only read the forest: the nontree edges inside
+        // a class, up to the first one leaving it
+        vector <vector <pair <int, pair <int, int> > > > inside(c_cnt);
+        vector <int> leaving(c_cnt, -1), looked(c_cnt, 0);
+        vector <pair <int, int> > candidates(c_cnt);
+        vector <char> exhausted(c_cnt, false);
+        int workers = Tree::self_adjusting ? 1 : Options.threads;
+        parallel_for(workers, c_cnt, [&](int c) {
+            int v = classes[c].first;
+            NontreeCursor cursor;
+            cursor.vertex = v;
+            pair <int, int> e;
+            while (looked[c] < budget) {
+                int handle = Forest.next_nontree_edge(cursor, e);
+                if (handle == -1) {
+                    exhausted[c] = true;
+                    break;
+                }
+                looked[c]++;
+                if (!Forest.connected(v, e.second)) {
+                    leaving[c] = handle;
+                    candidates[c] = e;
+                    break;
+                }
+                inside[c].push_back({handle, e});
+            }
+
+            // both records of an edge inside may have been visited
+            sort(inside[c].begin(), inside[c].end());
+            inside[c].erase(unique(inside[c].begin(), inside[c].end(),
+                                   [](auto &x, auto &y) { return x.first == y.first; }),
+                            inside[c].end());
+        });
+
+        // the trees joined by the candidates, numbered by their roots
+        vector <node_t> ends(2 * c_cnt, NIL);
+        parallel_for(Options.threads, c_cnt, [&](int c) {
+            if (leaving[c] != -1) {
+                ends[2 * c] = Forest.tree_id(candidates[c].first);
+                ends[2 * c + 1] = Forest.tree_id(candidates[c].second);
+            }
+        });
+        EdgeTable <int> Ids;
+        auto tree_index = [&](node_t root) {
+            int *p = Ids.insert(root, root);
+            if (*p == 0)
+                *p = Ids.size();
+            return *p - 1;
+        };
+        UnionFind Joined(2 * c_cnt);
+
+        vector <int> handles;
+        vector <pair <int, int> > raised;
+        links.clear();
+        for (int c = 0; c < c_cnt; c++) {
+            Stats.edges += looked[c];
+            for (auto &[handle, e]: inside[c]) {
+                handles.push_back(handle);
+                raised.push_back(e);
+            }
+            if (leaving[c] != -1 &&
+                Joined.unite(tree_index(ends[2 * c]), tree_index(ends[2 * c + 1]))) {
+                handles.push_back(leaving[c]);
+                links.push_back(candidates[c]);
+            }
+            if (!exhausted[c])
+                active.push_back(classes[c]);
+        }
+        Stats.hits += links.size();
+
+        Forest.remove_nontree_edges(handles);
+        vector <int> raised_handles;
+        Next.insert_nontree_edges(raised, raised_handles);
+        parallel_for(Options.threads, (int) raised.size(), [&](int i) {
+            EdgeInfo *info = Edges.find(raised[i].first, raised[i].second);
+            info->level = level+1;
+            info->nontree_hook = raised_handles[i];
+        });
+
+        for (int l = 0; l <= level; l++)
+            Forests[l].insert_tree_edges(links, l == level);
+        for (auto [a, b]: links) {
+            EdgeInfo *info = Edges.find(a, b);
+            info->tree = true;
+            info->level = level;
+        }
+
+        budget = budget < INT_MAX / 2 ? 2 * budget : INT_MAX;
+    }
+}
+
+template class BasicBatchDynamicConnectivity<AVLTree>;
+template class BasicBatchDynamicConnectivity<SplayTree>;
+template class BasicBatchDynamicConnectivity<Treap>;
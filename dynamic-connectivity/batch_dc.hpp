@@ -0,0 +1,97 @@
+#ifndef BATCH_DC_HPP
+#define BATCH_DC_HPP
+
+#include <vector>
+#include "dc.hpp"
+using namespace std;
+
+/* Counters of the search for replacements of remove_batch */
+struct BatchSearchStats {
+    /* rounds of the search, over all the levels */
+    long long rounds = 0;
+    /* fragments probed, once per round */
+    long long searches = 0;
+    /* fragments joined to another one by an edge found by a probe */
+    long long hits = 0;
+    /* nontree edges looked at */
+    long long edges = 0;
+};
+
+/**
+ * Dynamic connectivity whose remove_batch searches for the
+ * replacements of the removed tree edges on the threads (see
+ * ConnectivityOptions::threads), with the same interface and the
+ * same levels as DynamicConnectivity otherwise.
+ *
+ * The tree edges of the batch are cut as in DynamicConnectivity.
+ * Then every level, from the top down, is searched in rounds.
+ * In a round, every tree of F_level holding fragments still
+ * searched (the classes) that is small enough has its tree edges
+ * promoted, and then its nontree edges are probed up to the
+ * budget of the round, which doubles from round to round. The
+ * edges inside the class go to the next level; the first edge
+ * leaving it is a candidate. The candidates which join different
+ * classes become tree edges together, and the classes which were
+ * neither exhausted nor joined to the largest fragment of their
+ * tree go on to the next round. As in DynamicConnectivity, the
+ * largest fragment is searched itself only when some class
+ * became too large to be promoted.
+ *
+ * The classes are distinct trees, so their promotions and probes
+ * run in parallel, and the edges of a round are moved between
+ * the forests by the batches of ETTForest, which work on the
+ * trees in parallel. The nodes, the handles and the hashing of
+ * the edges are handled on the calling thread, as are the
+ * acceptance of the candidates (by union-find) and the sorts of
+ * the batches. With a self-adjusting sequence tree (SplayTree),
+ * whose queries restructure it, the probes run on one thread.
+ */
+
+template <class Tree>
+class BasicBatchDynamicConnectivity : public BasicDynamicConnectivity <Tree> {
+    public:
+
+    /**
+     * Initiates the data structure for a n-vertex graph
+     * (see BasicDynamicConnectivity)
+     * Complexity: as in BasicDynamicConnectivity
+     */
+    BasicBatchDynamicConnectivity(int _n);
+    BasicBatchDynamicConnectivity(int _n, const vector <pair <int, int> > &edges);
+
+    /**
+     * Removes a batch of undirected edges, with the same effect
+     * on connectivity as removing them one by one (see above)
+     * Complexity: O(k log^2 n) plus the cost of promotions,
+     * amortized as in remove, where k is the size of the batch;
+     * a round costs O(c log c) on the calling thread, where c is
+     * the number of classes searched in it
+     */
+    void remove_batch(const vector <pair <int, int> > &edges);
+
+    /**
+     * Returns the counters of the search since the structure was
+     * created
+     * Complexity: O(1)
+     */
+    const BatchSearchStats &batch_search_stats() const;
+
+    private:
+    typedef BasicDynamicConnectivity <Tree> Base;
+    typedef typename Base::Fragments Fragments;
+    using Base::Forests;
+    using Base::Edges;
+    using Base::n;
+    using Base::Options;
+
+    BatchSearchStats Stats;
+
+    void search_level(const vector <pair <int, pair <int, int> > > &cuts,
+                      size_t k, int level);
+    void search_rounds(vector <pair <int, int> > &active, int level,
+                       Fragments &F, vector <bool> *search_largest);
+};
+
+typedef BasicBatchDynamicConnectivity <AVLTree> BatchDynamicConnectivity;
+
+#endif
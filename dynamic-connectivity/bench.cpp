@@ -0,0 +1,1071 @@
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+#include "dc.hpp"
+#include "offline.hpp"
+#include "sketch.hpp"
+#include "hybrid.hpp"
+#include "batch_dc.hpp"
+
+#ifdef __linux__
+    #include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define cycle_counter() __rdtsc()
+#else
+    #define cycle_counter() 0ULL
+#endif
+
+using namespace std;
+
+/**
+ * Microbenchmarks of the building blocks of the dynamic
+ * connectivity structure. Each benchmark reports the average
+ * wall clock time and the average number of (TSC) cycles
+ * per operation.
+ */
+
+class Timer {
+    public:
+    Timer() {
+        start_time = chrono::steady_clock::now();
+        start_cycles = cycle_counter();
+    }
+
+    /* Prints the time per operation so far and returns it (in ns) */
+    double report(const char *name, long long ops) {
+        auto end_time = chrono::steady_clock::now();
+        unsigned long long end_cycles = cycle_counter();
+        double ns = chrono::duration<double, nano>(end_time - start_time).count();
+
+        printf ("%-40s %12lld ops %10.1f ns/op %10.1f cycles/op\n",
+                name, ops, ns / ops,
+                double(end_cycles - start_cycles) / ops);
+        return ns / ops;
+    }
+
+    private:
+    chrono::steady_clock::time_point start_time;
+    unsigned long long start_cycles;
+};
+
+/**
+ * The thread counts of the scaling measurements: 1 to N, where
+ * N is the number of hardware threads (or the value of the
+ * BENCH_THREADS environment variable), doubling the count and
+ * ending with N itself
+ */
+vector <int> thread_counts() {
+    int limit = thread::hardware_concurrency();
+    if (getenv("BENCH_THREADS") != NULL)
+        limit = atoi(getenv("BENCH_THREADS"));
+
+    vector <int> counts;
+    for (int t = 1; t < limit; t *= 2)
+        counts.push_back(t);
+    counts.push_back(max(limit, 1));
+    return counts;
+}
+
+/**
+ * Splits a sequence of n vertex nodes at a random position and
+ * merges the two halves back together.
+ */
+template <class Tree>
+void bench_split_merge(const char *tree_name, int n, int q) {
+    Tree tree;
+    vector <node_t> nodes(n);
+    node_t root = NIL;
+    for (int i = 0; i < n; i++) {
+        nodes[i] = tree.new_vertex_node();
+        root = tree.merge(root, NIL, nodes[i]);
+    }
+
+    srand(1);
+    vector <int> positions(q);
+    for (int &p: positions)
+        p = rand() % n;
+
+    Timer timer;
+    for (int p: positions) {
+        auto [left, right] = tree.split(nodes[p]);
+        root = tree.merge(left, NIL, right);
+    }
+
+    char name[64];
+    sprintf (name, "split+merge %s (n = %d)", tree_name, n);
+    timer.report(name, q);
+}
+
+/**
+ * Cuts a random edge of a random spanning tree over n vertices
+ * and links its endpoints back.
+ */
+template <class Tree>
+void bench_link_cut(const char *tree_name, int n, int q) {
+    ETTForest <Tree> forest(n);
+    vector <pair <int, int> > edges;
+
+    srand(2);
+    for (int i = 1; i < n; i++) {
+        edges.push_back({rand() % i, i});
+        forest.insert_tree_edge(edges.back().first, edges.back().second, true);
+    }
+
+    vector <int> picks(q);
+    for (int &p: picks)
+        p = rand() % (n - 1);
+
+    Timer timer;
+    for (int p: picks) {
+        forest.remove_tree_edge(edges[p].first, edges[p].second);
+        forest.insert_tree_edge(edges[p].first, edges[p].second, true);
+    }
+
+    char name[64];
+    sprintf (name, "cut+link %s (n = %d)", tree_name, n);
+    timer.report(name, q);
+}
+
+/* Counts the nodes whose aggregates are recomputed */
+class UpdateCounter : public AggregateHook {
+    public:
+    long long updates = 0;
+
+    void update(node_t, node_t, node_t) {
+        updates++;
+    }
+};
+
+/**
+ * The same workload as bench_link_cut, reporting the average
+ * number of nodes updated (written on the way up the tree) by
+ * a single cut and by a single link instead of the time.
+ */
+template <class Tree>
+void bench_nodes_touched(const char *tree_name, int n, int q) {
+    ETTForest <HookedTree <Tree> > forest(n);
+    vector <pair <int, int> > edges;
+
+    srand(2);
+    for (int i = 1; i < n; i++) {
+        edges.push_back({rand() % i, i});
+        forest.insert_tree_edge(edges.back().first, edges.back().second, true);
+    }
+
+    UpdateCounter cut_counter, link_counter;
+    for (int i = 0; i < q; i++) {
+        int p = rand() % (n - 1);
+        forest.set_aggregate_hook(&cut_counter);
+        forest.remove_tree_edge(edges[p].first, edges[p].second);
+        forest.set_aggregate_hook(&link_counter);
+        forest.insert_tree_edge(edges[p].first, edges[p].second, true);
+    }
+    forest.set_aggregate_hook(NULL);
+
+    printf ("nodes updated by cut/link %s (n = %d) %10.1f %10.1f\n",
+            tree_name, n, double(cut_counter.updates) / q,
+            double(link_counter.updates) / q);
+}
+
+/**
+ * Takes all k tree edges marked as on the level and all k nontree
+ * edges out of a random spanning tree of n vertices, as the
+ * search for a replacement edge does with the smaller side.
+ */
+template <class Tree>
+void bench_promotion(const char *tree_name, int n, int k) {
+    ETTForest <Tree> forest(n);
+
+    srand(8);
+    for (int i = 1; i < n; i++)
+        forest.insert_tree_edge(rand() % i, i, rand() % (n - 1) < k);
+    for (int i = 0; i < k; i++) {
+        // loops are never stored
+        int a = rand() % n, b = rand() % n;
+        if (a != b)
+            forest.insert_nontree_edge(a, b);
+    }
+
+    char name[64];
+    long long taken = 0;
+    {
+        Timer timer;
+        forest.promote_tree_edges(0, [&](pair <int, int>) { taken++; return true; });
+        sprintf (name, "promote %s (n = %d, k = %d)", tree_name, n, k);
+        timer.report(name, max(taken, 1LL));
+    }
+    taken = 0;
+    {
+        Timer timer;
+        forest.pop_nontree_edges(0, [&](pair <int, int>) {
+            taken++;
+            return true;
+        });
+        sprintf (name, "pop nontree %s (n = %d, k = %d)", tree_name, n, k);
+        timer.report(name, max(taken, 1LL));
+    }
+}
+
+/**
+ * A random mix of insertions, deletions and queries on a graph
+ * with n vertices and at most 2n edges.
+ */
+template <class Tree>
+void bench_dynamic_connectivity(const char *tree_name, int n, int q) {
+    BasicDynamicConnectivity <Tree> DC(n);
+    vector <pair <int, int> > edges;
+
+    srand(3);
+    Timer timer;
+    for (int i = 0; i < q; i++) {
+        int t = rand() % 10;
+        int a = rand() % n;
+        int b = rand() % n;
+
+        if (t < 4 && a != b && (int) edges.size() < 2 * n) {
+            edges.push_back({a, b});
+            DC.insert(a, b);
+
+        } else if (t < 7 && !edges.empty()) {
+            swap(edges[rand() % edges.size()], edges.back());
+            DC.remove(edges.back().first, edges.back().second);
+            edges.pop_back();
+
+        } else {
+            DC.connected(a, b);
+        }
+    }
+
+    char name[64];
+    sprintf (name, "dynamic connectivity %s (n = %d)", tree_name, n);
+    timer.report(name, q);
+}
+
+/**
+ * Replaces random edges of a graph with n vertices and m edges
+ * by new random ones, with the given number of samples taken
+ * before the full replacement search (0 turns sampling off).
+ */
+template <class Tree>
+void bench_sampling(const char *tree_name, int n, int m, int q, int samples) {
+    BasicDynamicConnectivity <Tree> DC(n);
+    vector <pair <int, int> > edges;
+
+    srand(5);
+    while ((int) edges.size() < m) {
+        int a = rand() % n, b = rand() % n;
+        if (a != b) {
+            edges.push_back({a, b});
+            DC.insert(a, b);
+        }
+    }
+    ConnectivityOptions options;
+    options.samples = samples;
+    DC.set_options(options);
+
+    Timer timer;
+    for (int i = 0; i < q; i++) {
+        swap(edges[rand() % edges.size()], edges.back());
+        DC.remove(edges.back().first, edges.back().second);
+
+        int a = rand() % n, b = rand() % n;
+        while (a == b) {
+            b = rand() % n;
+        }
+        edges.back() = {a, b};
+        DC.insert(a, b);
+    }
+
+    char name[64];
+    sprintf (name, "sampling %s %d (n = %d, m = %d)", tree_name, samples, n, m);
+    timer.report(name, q);
+
+    const SamplingStats &stats = DC.sampling_stats();
+    if (stats.searches > 0)
+        printf ("    %lld searches, %.2f%% hits, %.2f samples per search\n",
+                stats.searches, 100.0 * stats.hits / stats.searches,
+                double(stats.samples) / stats.searches);
+}
+
+/**
+ * Prints the mean and the tail of the given latencies (in ns)
+ */
+void report_latency(const char *name, vector <double> &latency) {
+    int q = latency.size();
+    double total = 0;
+    for (double t: latency)
+        total += t;
+    sort(latency.begin(), latency.end());
+
+    auto percentile = [&](double p) {
+        return latency[min(q - 1, int(p * q))];
+    };
+    printf ("%s: mean %.0f ns, p50 %.0f ns, p99 %.0f ns, p99.9 %.0f ns, max %.0f ns\n",
+            name, total / q, percentile(0.5), percentile(0.99),
+            percentile(0.999), latency[q - 1]);
+}
+
+/**
+ * The workload of bench_sampling with the interleaved search
+ * given the budget (0 turns it off), timing every remove to
+ * report the tail of its latency.
+ */
+template <class Tree>
+void bench_remove_latency(const char *tree_name, int n, int m, int q, int budget) {
+    BasicDynamicConnectivity <Tree> DC(n);
+    vector <pair <int, int> > edges;
+
+    srand(5);
+    while ((int) edges.size() < m) {
+        int a = rand() % n, b = rand() % n;
+        if (a != b) {
+            edges.push_back({a, b});
+            DC.insert(a, b);
+        }
+    }
+    ConnectivityOptions options;
+    options.interleaved_budget = budget;
+    DC.set_options(options);
+
+    vector <double> latency(q);
+    for (int i = 0; i < q; i++) {
+        swap(edges[rand() % edges.size()], edges.back());
+        auto start = chrono::steady_clock::now();
+        DC.remove(edges.back().first, edges.back().second);
+        latency[i] = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+
+        int a = rand() % n, b = rand() % n;
+        while (a == b) {
+            b = rand() % n;
+        }
+        edges.back() = {a, b};
+        DC.insert(a, b);
+    }
+
+    char name[64];
+    sprintf (name, "remove latency %s %d (n = %d, m = %d)", tree_name, budget, n, m);
+    report_latency(name, latency);
+
+    const InterleavedStats &stats = DC.interleaved_stats();
+    if (stats.searches > 0)
+        printf ("    %lld searches, %.2f%% hits on the smaller side, %.2f%% on "
+                "the larger, %.2f%% without a replacement, %.2f edges per search\n",
+                stats.searches, 100.0 * stats.hits_smaller / stats.searches,
+                100.0 * stats.hits_larger / stats.searches,
+                100.0 * stats.no_replacement / stats.searches,
+                double(stats.edges) / stats.searches);
+}
+
+/**
+ * The workload of bench_sampling with the given remove budget
+ * (negative turns it off), timing every update: an insert
+ * finishes the pending remove first. Between the updates, the
+ * caller is idle
+ * long enough for the given number of steps.
+ */
+template <class Tree>
+void bench_bounded_remove(const char *tree_name, int n, int m, int q,
+                          int budget, int idle_steps) {
+    BasicDynamicConnectivity <Tree> DC(n);
+    vector <pair <int, int> > edges;
+
+    srand(5);
+    while ((int) edges.size() < m) {
+        int a = rand() % n, b = rand() % n;
+        if (a != b) {
+            edges.push_back({a, b});
+            DC.insert(a, b);
+        }
+    }
+    ConnectivityOptions options;
+    options.remove_budget = budget;
+    DC.set_options(options);
+
+    vector <double> latency;
+    latency.reserve(2 * q);
+    auto total_start = chrono::steady_clock::now();
+    for (int i = 0; i < q; i++) {
+        swap(edges[rand() % edges.size()], edges.back());
+        auto start = chrono::steady_clock::now();
+        DC.remove(edges.back().first, edges.back().second);
+        latency.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - start).count());
+
+        for (int j = 0; j < idle_steps; j++)
+            DC.step();
+
+        int a = rand() % n, b = rand() % n;
+        while (a == b) {
+            b = rand() % n;
+        }
+        edges.back() = {a, b};
+        start = chrono::steady_clock::now();
+        DC.insert(a, b);
+        latency.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - start).count());
+
+        for (int j = 0; j < idle_steps; j++)
+            DC.step();
+    }
+    double total = chrono::duration<double, nano>(chrono::steady_clock::now() - total_start).count();
+
+    char name[96];
+    sprintf (name, "update latency %s %d/%d (n = %d, m = %d)",
+             tree_name, budget, idle_steps, n, m);
+    report_latency(name, latency);
+    printf ("    %.0f ns per update with the steps\n", total / (2 * q));
+}
+
+/**
+ * Replaces random edges of a graph with n vertices and m edges
+ * by new random ones on the given engine (DynamicConnectivity
+ * or SketchConnectivity), timing every remove.
+ */
+template <class Engine>
+void bench_engine_random(const char *engine_name, int n, int m, int q) {
+    Engine DC(n);
+    vector <pair <int, int> > edges;
+
+    srand(5);
+    while ((int) edges.size() < m) {
+        int a = rand() % n, b = rand() % n;
+        if (a != b) {
+            edges.push_back({a, b});
+            DC.insert(a, b);
+        }
+    }
+
+    vector <double> latency(q);
+    auto total_start = chrono::steady_clock::now();
+    for (int i = 0; i < q; i++) {
+        swap(edges[rand() % edges.size()], edges.back());
+        auto start = chrono::steady_clock::now();
+        DC.remove(edges.back().first, edges.back().second);
+        latency[i] = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+
+        int a = rand() % n, b = rand() % n;
+        while (a == b) {
+            b = rand() % n;
+        }
+        edges.back() = {a, b};
+        DC.insert(a, b);
+    }
+    double total = chrono::duration<double, nano>(chrono::steady_clock::now() - total_start).count();
+
+    char name[96];
+    sprintf (name, "random removes %s (n = %d, m = %d)", engine_name, n, m);
+    report_latency(name, latency);
+    printf ("    %.0f ns per remove and insert\n", total / q);
+}
+
+/**
+ * Two random trees on n/2 vertices each, joined by a bridge.
+ * Every round inserts k new random edges inside each half and
+ * then removes the bridge (timed) and inserts it back. The
+ * amortized structure scans the new edges of a half in every
+ * remove, while the sketches show right away that nothing
+ * crosses the cut.
+ */
+template <class Engine>
+void bench_engine_adversarial(const char *engine_name, int n, int k, int rounds) {
+    Engine DC(n);
+    int half = n / 2;
+
+    srand(7);
+    for (int v = 1; v < half; v++) {
+        DC.insert(rand() % v, v);
+        DC.insert(half + rand() % v, half + v);
+    }
+    DC.insert(0, half);
+
+    vector <double> latency(rounds);
+    auto total_start = chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        for (int j = 0; j < k; j++) {
+            DC.insert(rand() % half, rand() % half);
+            DC.insert(half + rand() % half, half + rand() % half);
+        }
+
+        auto start = chrono::steady_clock::now();
+        DC.remove(0, half);
+        latency[i] = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+        DC.insert(0, half);
+    }
+    double total = chrono::duration<double, nano>(chrono::steady_clock::now() - total_start).count();
+
+    char name[96];
+    sprintf (name, "bridge removes %s (n = %d, k = %d)", engine_name, n, k);
+    report_latency(name, latency);
+    printf ("    %.0f ns per round of %d updates\n", total / rounds, 2 * k + 2);
+}
+
+/**
+ * One writer replaces random edges of a graph with n vertices
+ * and m edges by new random ones for the given time, while the
+ * given number of threads check random pairs of vertices with
+ * concurrent_connected. Reports the throughput of both.
+ */
+template <class Tree>
+void bench_concurrent_reads(const char *tree_name, int n, int m, int readers, int ms) {
+    BasicDynamicConnectivity <Tree> DC(n);
+    vector <pair <int, int> > edges;
+
+    srand(5);
+    while ((int) edges.size() < m) {
+        int a = rand() % n, b = rand() % n;
+        if (a != b) {
+            edges.push_back({a, b});
+            DC.insert(a, b);
+        }
+    }
+    ConnectivityOptions options;
+    options.concurrent_reads = true;
+    DC.set_options(options);
+
+    atomic <bool> done(false);
+    atomic <long long> reads(0), hits(0);
+    vector <thread> threads;
+    for (int r = 0; r < readers; r++) {
+        threads.emplace_back([&, r]() {
+            minstd_rand gen(r + 1);
+            long long cnt = 0, connected = 0;
+            while (!done) {
+                connected += DC.concurrent_connected(gen() % n, gen() % n);
+                cnt++;
+            }
+            reads += cnt;
+            hits += connected;
+        });
+    }
+
+    auto start = chrono::steady_clock::now();
+    auto end = start + chrono::milliseconds(ms);
+    long long writes = 0;
+    while (chrono::steady_clock::now() < end) {
+        // a batch of replacements between the checks of the clock
+        for (int i = 0; i < 64; i++, writes += 2) {
+            swap(edges[rand() % edges.size()], edges.back());
+            DC.remove(edges.back().first, edges.back().second);
+
+            int a = rand() % n, b = rand() % n;
+            while (a == b) {
+                b = rand() % n;
+            }
+            edges.back() = {a, b};
+            DC.insert(a, b);
+        }
+    }
+    done = true;
+    for (thread &t: threads)
+        t.join();
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf ("concurrent reads %s %d readers (n = %d, m = %d): "
+            "%.2f M reads/s (%.2f M per reader), %.2f M writes/s, %.1f%% connected\n",
+            tree_name, readers, n, m, reads / seconds / 1e6,
+            readers > 0 ? reads / seconds / 1e6 / readers : 0.0,
+            writes / seconds / 1e6, reads > 0 ? 100.0 * hits / reads : 0.0);
+}
+
+/* Returns the resident set size of the process in bytes */
+long long resident_memory() {
+#ifdef __linux__
+    long long pages = 0, resident = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (statm) {
+        if (fscanf(statm, "%lld %lld", &pages, &resident) != 2)
+            resident = 0;
+        fclose(statm);
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Measures the memory used per vertex (right after construction)
+ * and per edge (after m random insertions followed by m/3
+ * removals and reinsertions, which spread the edges over levels)
+ * on a graph with n vertices.
+ */
+void bench_memory(int n, int m) {
+    long long before = resident_memory();
+    DynamicConnectivity *DC = new DynamicConnectivity(n);
+    long long after_construction = resident_memory();
+
+    srand(5);
+    vector <pair <int, int> > edges;
+    for (int i = 0; i < m; i++) {
+        int a = rand() % n;
+        int b = rand() % n;
+        if (a != b) {
+            edges.push_back({a, b});
+            DC->insert(a, b);
+        }
+    }
+    for (int i = 0; i < m / 3; i++) {
+        auto e = edges[rand() % edges.size()];
+        DC->remove(e.first, e.second);
+        DC->insert(e.first, e.second);
+    }
+    long long after_insertions = resident_memory();
+
+    printf ("memory (n = %d, m = %d) %29.1f B/vertex %9.1f B/edge\n",
+            n, m, double(after_construction - before) / n,
+            double(after_insertions - after_construction) / edges.size());
+    delete DC;
+}
+
+/**
+ * Builds the structure for a random graph with n vertices and
+ * m edges: edge by edge and with the bulk-loading constructor
+ */
+template <class Tree>
+void bench_bulk_load(const char *tree_name, int n, int m) {
+    srand(6);
+    vector <pair <int, int> > edges(m);
+    for (auto &e: edges)
+        e = {rand() % n, rand() % n};
+
+    char name[64];
+    {
+        Timer timer;
+        BasicDynamicConnectivity <Tree> DC(n);
+        for (auto e: edges)
+            DC.insert(e.first, e.second);
+        sprintf (name, "insert one by one %s (n = %d)", tree_name, n);
+        timer.report(name, m);
+    }
+    {
+        Timer timer;
+        BasicDynamicConnectivity <Tree> DC(n, edges);
+        sprintf (name, "bulk load %s (n = %d)", tree_name, n);
+        timer.report(name, m);
+    }
+}
+
+/**
+ * Alternating batches of k random insertions and k random
+ * removals on a graph with n vertices and about n edges:
+ * applied with single calls and with insert_batch/remove_batch
+ * on 1 to N threads (see thread_counts), with the speedup over
+ * one thread
+ */
+template <class Tree>
+void bench_batches(const char *tree_name, int n, int k, int rounds) {
+    srand(7);
+    vector <vector <pair <int, int> > > batches;
+    vector <pair <int, int> > edges;
+    for (int i = 0; i < n; i++)
+        edges.push_back({rand() % n, rand() % n});
+    vector <pair <int, int> > initial = edges;
+
+    for (int r = 0; r < rounds; r++) {
+        vector <pair <int, int> > inserted, removed;
+        for (int j = 0; j < k; j++) {
+            swap(edges[rand() % edges.size()], edges.back());
+            removed.push_back(edges.back());
+            edges.pop_back();
+        }
+        for (int j = 0; j < k; j++) {
+            inserted.push_back({rand() % n, rand() % n});
+            edges.push_back(inserted.back());
+        }
+        batches.push_back(removed);
+        batches.push_back(inserted);
+    }
+
+    char name[64];
+    {
+        BasicDynamicConnectivity <Tree> DC(n, initial);
+        Timer timer;
+        for (size_t i = 0; i < batches.size(); i++) {
+            for (auto e: batches[i]) {
+                if (i % 2 == 0)
+                    DC.remove(e.first, e.second);
+                else
+                    DC.insert(e.first, e.second);
+            }
+        }
+        sprintf (name, "single updates %s (k = %d)", tree_name, k);
+        timer.report(name, 2LL * k * rounds);
+    }
+    double one_thread = 0;
+    for (int threads: thread_counts()) {
+        BasicDynamicConnectivity <Tree> DC(n, initial);
+        ConnectivityOptions options;
+        options.threads = threads;
+        DC.set_options(options);
+        Timer timer;
+        for (size_t i = 0; i < batches.size(); i++) {
+            if (i % 2 == 0)
+                DC.remove_batch(batches[i]);
+            else
+                DC.insert_batch(batches[i]);
+        }
+        sprintf (name, "batched updates %s (k = %d, t = %d)", tree_name, k, threads);
+        double ns = timer.report(name, 2LL * k * rounds);
+        if (threads == 1)
+            one_thread = ns;
+        else
+            printf ("%-40s %.2fx\n", "  speedup over t = 1", one_thread / ns);
+    }
+}
+
+/* Prints the share of the fragments joined by the probes, where there are any */
+template <class DC>
+void print_batch_search(DC &) {}
+
+template <class Tree>
+void print_batch_search(BasicBatchDynamicConnectivity <Tree> &DC) {
+    const BatchSearchStats &stats = DC.batch_search_stats();
+    if (stats.searches > 0)
+        printf (", %.1f%% of fragments joined by the probes in %lld rounds",
+                100.0 * stats.hits / stats.searches, stats.rounds);
+}
+
+/**
+ * Removes batches of k random edges from a graph with n vertices
+ * and m random edges (and inserts as many new ones), timing only
+ * the removals, with the given engine on 1 to N threads (see
+ * thread_counts), with the speedup over one thread
+ */
+template <class DC>
+void bench_batch_search(const char *engine_name, int n, int m, int k, int rounds) {
+    srand(9);
+    vector <pair <int, int> > edges;
+    for (int i = 0; i < m; i++)
+        edges.push_back({rand() % n, rand() % n});
+    vector <pair <int, int> > initial = edges;
+
+    vector <vector <pair <int, int> > > removed(rounds), inserted(rounds);
+    for (int r = 0; r < rounds; r++) {
+        for (int j = 0; j < k; j++) {
+            swap(edges[rand() % edges.size()], edges.back());
+            removed[r].push_back(edges.back());
+            edges.back() = {rand() % n, rand() % n};
+            inserted[r].push_back(edges.back());
+        }
+    }
+
+    double one_thread = 0;
+    for (int threads: thread_counts()) {
+        DC D(n, initial);
+        ConnectivityOptions options;
+        options.threads = threads;
+        D.set_options(options);
+
+        double ns = 0;
+        for (int r = 0; r < rounds; r++) {
+            auto start = chrono::steady_clock::now();
+            D.remove_batch(removed[r]);
+            ns += chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+            D.insert_batch(inserted[r]);
+        }
+
+        ns /= double(k) * rounds;
+        if (threads == 1)
+            one_thread = ns;
+        printf ("batch search %s (n = %d, m = %d, k = %d, t = %d): %.1f ns per removal (speedup %.2fx)",
+                engine_name, n, m, k, threads, ns, one_thread / ns);
+        print_batch_search(D);
+        printf ("\n");
+    }
+}
+
+/**
+ * Removes batches of k random edges of a random spanning tree of
+ * n vertices, so that all the cuts of a batch fall into one Euler
+ * tour (and inserts them back), timing only the removals on 1 to
+ * N threads (see thread_counts), with the speedup over one thread
+ */
+template <class Tree>
+void bench_bulk_cuts(const char *tree_name, int n, int k, int rounds) {
+    srand(10);
+    vector <pair <int, int> > tree;
+    for (int v = 1; v < n; v++)
+        tree.push_back({rand() % v, v});
+
+    vector <vector <pair <int, int> > > batches(rounds);
+    for (int r = 0; r < rounds; r++) {
+        for (int j = 0; j < k; j++)
+            batches[r].push_back(tree[rand() % tree.size()]);
+        sort(batches[r].begin(), batches[r].end());
+        batches[r].erase(unique(batches[r].begin(), batches[r].end()), batches[r].end());
+    }
+
+    double one_thread = 0;
+    for (int threads: thread_counts()) {
+        BasicDynamicConnectivity <Tree> DC(n, tree);
+        ConnectivityOptions options;
+        options.threads = threads;
+        DC.set_options(options);
+
+        double ns = 0;
+        long long cuts = 0;
+        for (int r = 0; r < rounds; r++) {
+            auto start = chrono::steady_clock::now();
+            DC.remove_batch(batches[r]);
+            ns += chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+            cuts += batches[r].size();
+            DC.insert_batch(batches[r]);
+        }
+
+        ns /= double(cuts);
+        if (threads == 1)
+            one_thread = ns;
+        printf ("bulk cuts %s (n = %d, k = %d, t = %d): %.1f ns per cut (speedup %.2fx)\n",
+                tree_name, n, k, threads, ns, one_thread / ns);
+    }
+}
+
+/**
+ * Answers q random connectivity queries on a graph with n
+ * vertices and n random edges (the Euler tours of F_0 are much
+ * larger than the caches for large n) one by one and in batches
+ * of the given size
+ */
+void bench_connected_batch(int n, int q, int batch) {
+    srand(10);
+    vector <pair <int, int> > edges(n), queries(q);
+    for (auto &e: edges)
+        e = {rand() % n, rand() % n};
+    for (auto &query: queries)
+        query = {rand() % n, rand() % n};
+
+    DynamicConnectivity DC(n, edges);
+    char name[64];
+    long long connected = 0;
+    {
+        Timer timer;
+        for (auto [a, b]: queries)
+            connected += DC.connected(a, b);
+        sprintf (name, "connected (n = %d)", n);
+        timer.report(name, q);
+    }
+    {
+        Timer timer;
+        vector <pair <int, int> > part;
+        vector <bool> answers;
+        for (int i = 0; i < q; i += batch) {
+            part.assign(queries.begin() + i, queries.begin() + min(q, i + batch));
+            DC.connected_batch(part, answers);
+            for (bool answer: answers)
+                connected -= answer;
+        }
+        sprintf (name, "connected_batch %d (n = %d)", batch, n);
+        timer.report(name, q);
+    }
+    // both must give the same answers
+    if (connected != 0)
+        printf ("    mismatch of %lld answers\n", connected);
+}
+
+/**
+ * Inserts m random edges into a graph with n vertices with a
+ * plain union-find, HybridConnectivity and DynamicConnectivity,
+ * with a connectivity query after every insertion, and times the
+ * first removal of HybridConnectivity, which builds the HDT
+ * structure from its log
+ */
+void bench_ingestion(int n, int m) {
+    srand(11);
+    vector <pair <int, int> > edges(m), queries(m);
+    for (auto &e: edges)
+        e = {rand() % n, rand() % n};
+    for (auto &query: queries)
+        query = {rand() % n, rand() % n};
+
+    char name[64];
+    // the numbers of connected pairs must agree
+    long long connected[3] = {0, 0, 0};
+    {
+        UnionFind UF(n);
+        Timer timer;
+        for (int i = 0; i < m; i++) {
+            UF.unite(edges[i].first, edges[i].second);
+            connected[0] += UF.find(queries[i].first) == UF.find(queries[i].second);
+        }
+        sprintf (name, "ingestion union-find (n = %d)", n);
+        timer.report(name, m);
+    }
+    {
+        HybridConnectivity HC(n);
+        Timer timer;
+        for (int i = 0; i < m; i++) {
+            HC.insert(edges[i].first, edges[i].second);
+            connected[1] += HC.connected(queries[i].first, queries[i].second);
+        }
+        sprintf (name, "ingestion hybrid (n = %d)", n);
+        timer.report(name, m);
+
+        Timer switch_timer;
+        HC.remove(edges[0].first, edges[0].second);
+        sprintf (name, "first remove hybrid (m = %d)", m);
+        switch_timer.report(name, 1);
+    }
+    {
+        DynamicConnectivity DC(n);
+        Timer timer;
+        for (int i = 0; i < m; i++) {
+            DC.insert(edges[i].first, edges[i].second);
+            connected[2] += DC.connected(queries[i].first, queries[i].second);
+        }
+        sprintf (name, "ingestion hdt (n = %d)", n);
+        timer.report(name, m);
+    }
+    if (connected[0] != connected[1] || connected[0] != connected[2])
+        printf ("    mismatch of the answers\n");
+}
+
+/**
+ * Replays the random mix of bench_dynamic_connectivity, recorded
+ * in advance, with the online structure and the offline engine
+ */
+void bench_offline(int n, int q) {
+    vector <pair <char, pair <int, int> > > log;
+    vector <pair <int, int> > edges;
+
+    srand(3);
+    for (int i = 0; i < q; i++) {
+        int t = rand() % 10;
+        int a = rand() % n;
+        int b = rand() % n;
+
+        if (t < 4 && a != b && (int) edges.size() < 2 * n) {
+            edges.push_back({a, b});
+            log.push_back({'+', {a, b}});
+
+        } else if (t < 7 && !edges.empty()) {
+            swap(edges[rand() % edges.size()], edges.back());
+            log.push_back({'-', edges.back()});
+            edges.pop_back();
+
+        } else {
+            log.push_back({'?', {a, b}});
+        }
+    }
+
+    char name[64];
+    long long connected = 0;
+    {
+        Timer timer;
+        BasicDynamicConnectivity <Treap> DC(n);
+        for (auto [type, e]: log) {
+            if (type == '+')
+                DC.insert(e.first, e.second);
+            else if (type == '-')
+                DC.remove(e.first, e.second);
+            else
+                connected += DC.connected(e.first, e.second);
+        }
+        sprintf (name, "online replay treap (n = %d)", n);
+        timer.report(name, q);
+    }
+    {
+        Timer timer;
+        OfflineConnectivity OC(n);
+        vector <int> queries;
+        for (auto [type, e]: log) {
+            if (type == '+')
+                OC.insert(e.first, e.second);
+            else if (type == '-')
+                OC.remove(e.first, e.second);
+            else
+                queries.push_back(OC.connected(e.first, e.second));
+        }
+        OC.solve();
+        for (int query: queries)
+            connected -= OC.answer(query);
+        sprintf (name, "offline replay (n = %d)", n);
+        timer.report(name, q);
+    }
+    if (connected != 0)
+        printf ("offline replay: the answers differ\n");
+}
+
+/* Runs the benchmarks depending on the sequence tree */
+template <class Tree>
+void bench_tree(const char *tree_name, int n, int q) {
+    bench_split_merge <Tree> (tree_name, n, q);
+    bench_link_cut <Tree> (tree_name, n, q);
+    bench_nodes_touched <Tree> (tree_name, n, q / 10);
+    bench_dynamic_connectivity <Tree> (tree_name, n, q);
+}
+
+/* Builds and destroys the structure for an empty n-vertex graph */
+void bench_construction(int n, int q) {
+    Timer timer;
+    for (int i = 0; i < q; i++) {
+        DynamicConnectivity DC(n);
+        DC.connected(0, n - 1);
+    }
+
+    char name[64];
+    sprintf (name, "construction (n = %d)", n);
+    timer.report(name, q);
+}
+
+int main()
+{
+    // must run first, in a fresh process (freed memory is not
+    // returned to the system)
+    bench_memory(1000000, 1000000);
+
+    bench_bulk_load <AVLTree> ("avl", 1000000, 5000000);
+    for (int k: {100, 10000}) {
+        bench_batches <AVLTree> ("avl", 1000000, k, 100000 / k);
+        bench_batches <Treap> ("treap", 1000000, k, 100000 / k);
+    }
+    bench_ingestion(1000000, 5000000);
+    for (int n: {100000, 4000000}) {
+        for (int batch: {16, 1024})
+            bench_connected_batch(n, 4000000, batch);
+    }
+    bench_batch_search <DynamicConnectivity> ("hdt", 1000000, 2000000, 10000, 20);
+    bench_batch_search <BatchDynamicConnectivity> ("batch", 1000000, 2000000, 10000, 20);
+    for (int k: {1000, 100000}) {
+        bench_bulk_cuts <AVLTree> ("avl", 1000000, k, 10);
+        bench_bulk_cuts <Treap> ("treap", 1000000, k, 10);
+    }
+    for (int n: {1000, 1000000})
+        bench_offline(n, 1000000);
+    for (int k: {100, 10000, 1000000}) {
+        bench_promotion <AVLTree> ("avl", 1000000, k);
+        bench_promotion <Treap> ("treap", 1000000, k);
+    }
+    bench_bulk_load <Treap> ("treap", 1000000, 5000000);
+    for (int samples: {0, 4, 16}) {
+        bench_sampling <AVLTree> ("avl", 100000, 200000, 1000000, samples);
+        bench_sampling <AVLTree> ("avl", 100000, 1000000, 1000000, samples);
+    }
+    for (int budget: {0, 16, 64}) {
+        bench_remove_latency <AVLTree> ("avl", 100000, 200000, 1000000, budget);
+        bench_remove_latency <AVLTree> ("avl", 100000, 1000000, 1000000, budget);
+    }
+    bench_engine_random <DynamicConnectivity> ("hdt", 100000, 200000, 1000000);
+    bench_engine_random <SketchConnectivity> ("sketch", 100000, 200000, 1000000);
+    for (int k: {100, 1000}) {
+        bench_engine_adversarial <DynamicConnectivity> ("hdt", 100000, k, 200);
+        bench_engine_adversarial <SketchConnectivity> ("sketch", 100000, k, 200);
+    }
+    for (int readers: {0, 1, 2, 4, 8})
+        bench_concurrent_reads <AVLTree> ("avl", 100000, 200000, readers, 2000);
+    bench_bounded_remove <AVLTree> ("avl", 100000, 200000, 1000000, -1, 0);
+    for (int idle_steps: {0, 10, 100})
+        bench_bounded_remove <AVLTree> ("avl", 100000, 200000, 1000000, 4, idle_steps);
+
+    for (int n: {1000, 100000, 1000000}) {
+        bench_construction(n, 10000000 / n);
+        bench_tree <AVLTree> ("avl", n, 1000000);
+        bench_tree <SplayTree> ("splay", n, 1000000);
+        bench_tree <Treap> ("treap", n, 1000000);
+    }
+}
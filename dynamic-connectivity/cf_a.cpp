@@ -1,17 +1,15 @@
 #include <cstdio>
-#include "dc.hpp"
+#include <vector>
+#include "offline.hpp"
 
-#include "dc.cpp"
-#include "avl_tree.cpp"
-#include "et_trees.cpp"
+#include "offline.cpp"
 
 /**
  * A solution to the "Connect and Disconnect" problem from codeforces
- * (https://codeforces.com/gym/100551/problem/A) to validate the
- * correctness and performance of the DynamicConnectivity class.
- * This solution gets a Memory Limit Exceeded verdict (the model
- * solution uses less because in the problem queries can be
- * processed offline)
+ * (https://codeforces.com/gym/100551/problem/A).
+ * All operations are known in advance, so they are recorded and
+ * answered together by OfflineConnectivity (with DynamicConnectivity,
+ * the solution gets a Memory Limit Exceeded verdict).
 */
 
 int main()
@@ -21,10 +19,9 @@ int main()
 
     int n, k;
     scanf ("%d %d", &n, &k);
-    // number of connected components
-    int n_cc = n;
 
-    DynamicConnectivity DC(n);
+    OfflineConnectivity OC(n);
+    vector <int> queries;
 
     while(k--) {
         char type;
@@ -37,22 +34,20 @@ int main()
         }
         switch(type) {
         case '?':
-            printf ("%d\n", n_cc);
+            queries.push_back(OC.count_components());
             break;
 
         case '+':
-            if (!DC.connected(a,b)) {
-                n_cc--;
-            }
-            DC.insert(a,b);
+            OC.insert(a,b);
             break;
         
         case '-':
-            DC.remove(a,b);
-            if (!DC.connected(a,b)) {
-                n_cc++;
-            }
+            OC.remove(a,b);
             break;
         }
     }
-}
\ No newline at end of file
+
+    OC.solve();
+    for (int query: queries)
+        printf ("%d\n", OC.answer(query));
+}
@@ -0,0 +1,1359 @@
+#include <cstdio>
+#include <vector>
+#ifndef OFFLINE_HPP
+#define OFFLINE_HPP
+
+#include <utility>
+#include <vector>
+#ifndef EDGE_TABLE_HPP
+#define EDGE_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+using namespace std;
+
+/* Packs the undirected edge (a,b) into a 64-bit key */
+inline uint64_t edge_key(int a, int b) {
+if (a > b)
+swap(a, b);
+return (uint64_t(uint32_t(a)) << 32) | uint32_t(b);
+}
+
+/* Fibonacci hashing: the top bits of the product are well mixed */
+inline size_t edge_hash(uint64_t key, int shift) {
+return (key * 0x9E3779B97F4A7C15ULL) >> shift;
+}
+
+/**
+* Hash table mapping undirected edges to values of type Info.
+*
+* Uses open addressing with linear probing over a single array
+* of slots, each holding the edge together with its value, so a
+* lookup touches one or two cache lines. The edge is stored as
+* two 32-bit endpoints, so that a slot is aligned only as the
+* value: with a 4-byte value, a slot takes 12 bytes instead of
+* 16.
+* Erased slots are filled by shifting the following entries
+* back (no tombstones), so probe sequences stay short under
+* any mix of insertions and deletions.
+*
+* Pointers returned by find and insert stay valid until the
+* next call to insert or erase.
+*/
+
+template <class Info>
+class EdgeTable {
+public:
+
+EdgeTable() {
+count = 0;
+shift = 64 - 4;
+Slots.assign(size_t(1) << (64 - shift), Slot(EMPTY));
+}
+
+/**
+* Returns the value stored for the (a,b) edge
+* or NULL if there is none
+* Complexity: O(1) (expected)
+*/
+Info *find(int a, int b) {
+size_t i = probe(edge_key(a, b));
+return Slots[i].key() == EMPTY ? NULL : &Slots[i].info;
+}
+
+/**
+* Returns the value stored for the (a,b) edge, creating
+* a value-initialized entry if there is none
+* Complexity: O(1) (expected, amortized)
+*/
+Info *insert(int a, int b) {
+uint64_t key = edge_key(a, b);
+
+// keep the load factor at most 1/2
+if (2 * (size_t(count) + 1) > Slots.size())
+rehash(shift - 1);
+
+size_t i = probe(key);
+if (Slots[i].key() == EMPTY) {
+Slots[i] = Slot(key);
+count++;
+}
+return &Slots[i].info;
+}
+
+/**
+* Removes the entry pointed to by info (obtained from find
+* or insert) from the table
+* Complexity: O(1) (expected)
+*/
+void erase(Info *info);
+
+/**
+* Makes room for the given number of edges, so that
+* inserting them does not trigger any further rehashing
+* Complexity: O(edges + size of the table)
+*/
+void reserve(int edges) {
+int new_shift = shift;
+while (2 * size_t(edges) > (size_t(1) << (64 - new_shift)))
+new_shift--;
+if (new_shift != shift)
+rehash(new_shift);
+}
+
+/* Returns the number of edges stored in the table */
+int size() {
+return count;
+}
+
+/**
+* Calls f(a, b, info) for every entry, where (a,b) is the
+* edge with a <= b
+* Complexity: O(capacity of the table)
+*/
+template <class F>
+void for_each(F f) {
+for (Slot &slot: Slots) {
+if (slot.key() != EMPTY)
+f(int(slot.a), int(slot.b), slot.info);
+}
+}
+
+private:
+struct Slot {
+/* the endpoints a <= b, both UINT32_MAX in an empty slot */
+uint32_t a, b;
+Info info;
+
+Slot(uint64_t key) : a(uint32_t(key >> 32)), b(uint32_t(key)), info() {}
+
+uint64_t key() const {
+return (uint64_t(a) << 32) | b;
+}
+};
+
+static constexpr uint64_t EMPTY = UINT64_MAX;
+
+vector <Slot> Slots;
+int count;
+int shift;
+
+size_t home(uint64_t key) {
+return edge_hash(key, shift);
+}
+
+/**
+* Returns the index of the slot holding key or of the empty
+* slot that ends its probe sequence.
+*/
+size_t probe(uint64_t key) {
+size_t mask = Slots.size() - 1;
+size_t i = home(key);
+while (Slots[i].key() != EMPTY && Slots[i].key() != key) {
+i = (i + 1) & mask;
+}
+return i;
+}
+
+void rehash(int new_shift);
+};
+
+/**
+* Backward shift deletion: walks the cluster following the
+* erased slot and moves back every entry whose home position
+* does not lie cyclically between the hole and the entry.
+*/
+template <class Info>
+void EdgeTable<Info>::erase(Info *info) {
+Slot *slot = reinterpret_cast<Slot*>(
+reinterpret_cast<char*>(info) - offsetof(Slot, info));
+size_t mask = Slots.size() - 1;
+size_t hole = slot - Slots.data();
+
+for (size_t j = (hole + 1) & mask; Slots[j].key() != EMPTY; j = (j + 1) & mask) {
+size_t h = home(Slots[j].key());
+
+bool movable = (hole <= j) ? (h <= hole || h > j)
+: (h <= hole && h > j);
+if (movable) {
+Slots[hole] = Slots[j];
+hole = j;
+}
+}
+
+Slots[hole].a = Slots[hole].b = UINT32_MAX;
+count--;
+}
+
+template <class Info>
+void EdgeTable<Info>::rehash(int new_shift) {
+vector <Slot> old_slots;
+old_slots.swap(Slots);
+
+shift = new_shift;
+Slots.assign(size_t(1) << (64 - shift), Slot(EMPTY));
+
+for (Slot &slot: old_slots) {
+if (slot.key() != EMPTY)
+Slots[probe(slot.key())] = slot;
+}
+}
+
+/**
+* Hash index of edges stored outside of it, e.g. in the nodes
+* of a forest. A slot holds only the handle of an edge (0 marks
+* an empty slot and is never a handle), and the endpoints of a
+* handle h are read from endpoints(h), a function passed to
+* every call which needs them.
+*
+* The layout is that of EdgeTable, but a slot takes only the 4
+* bytes of a handle; in exchange, every probe of a lookup reads
+* the endpoints of the handle it passes. The endpoints of a
+* handle must not change while it is in the index.
+*/
+
+template <class Handle>
+class EdgeIndex {
+public:
+
+EdgeIndex() {
+count = 0;
+shift = 64 - 4;
+Slots.assign(size_t(1) << (64 - shift), 0);
+}
+
+/**
+* Returns the handle of the (a,b) edge or 0 if there is none
+* Complexity: O(1) (expected)
+*/
+template <class F>
+Handle find(int a, int b, F endpoints) const {
+uint64_t key = edge_key(a, b);
+size_t mask = Slots.size() - 1;
+size_t i = edge_hash(key, shift);
+while (Slots[i] != 0 && key_of(Slots[i], endpoints) != key)
+i = (i + 1) & mask;
+return Slots[i];
+}
+
+/**
+* Adds the edge with handle h, which must not be in the
+* index yet
+* Complexity: O(1) (expected, amortized)
+*/
+template <class F>
+void insert(Handle h, F endpoints) {
+// keep the load factor at most 1/2
+if (2 * (size_t(count) + 1) > Slots.size())
+rehash(shift - 1, endpoints);
+
+Slots[free_slot(key_of(h, endpoints))] = h;
+count++;
+}
+
+/**
+* Removes the edge with handle h from the index
+* Complexity: O(1) (expected)
+*/
+template <class F>
+void erase(Handle h, F endpoints);
+
+/**
+* Makes room for the given number of edges, so that
+* inserting them does not trigger any further rehashing
+* Complexity: O(edges + size of the index)
+*/
+template <class F>
+void reserve(int edges, F endpoints) {
+int new_shift = shift;
+while (2 * size_t(edges) > (size_t(1) << (64 - new_shift)))
+new_shift--;
+if (new_shift != shift)
+rehash(new_shift, endpoints);
+}
+
+/* Returns the number of edges in the index */
+int size() const {
+return count;
+}
+
+private:
+vector <Handle> Slots;
+int count;
+int shift;
+
+template <class F>
+static uint64_t key_of(Handle h, F endpoints) {
+pair <int, int> edge = endpoints(h);
+return edge_key(edge.first, edge.second);
+}
+
+/* Returns the first empty slot of the probe sequence of key */
+size_t free_slot(uint64_t key) const {
+size_t mask = Slots.size() - 1;
+size_t i = edge_hash(key, shift);
+while (Slots[i] != 0)
+i = (i + 1) & mask;
+return i;
+}
+
+template <class F>
+void rehash(int new_shift, F endpoints);
+};
+
+/* Backward shift deletion, as in EdgeTable::erase */
+template <class Handle>
+template <class F>
+void EdgeIndex<Handle>::erase(Handle h, F endpoints) {
+size_t mask = Slots.size() - 1;
+size_t hole = edge_hash(key_of(h, endpoints), shift);
+while (Slots[hole] != h)
+hole = (hole + 1) & mask;
+
+for (size_t j = (hole + 1) & mask; Slots[j] != 0; j = (j + 1) & mask) {
+size_t home = edge_hash(key_of(Slots[j], endpoints), shift);
+
+bool movable = (hole <= j) ? (home <= hole || home > j)
+: (home <= hole && home > j);
+if (movable) {
+Slots[hole] = Slots[j];
+hole = j;
+}
+}
+
+Slots[hole] = 0;
+count--;
+}
+
+template <class Handle>
+template <class F>
+void EdgeIndex<Handle>::rehash(int new_shift, F endpoints) {
+vector <Handle> old_slots;
+old_slots.swap(Slots);
+
+shift = new_shift;
+Slots.assign(size_t(1) << (64 - shift), 0);
+
+for (Handle h: old_slots) {
+if (h != 0)
+Slots[free_slot(key_of(h, endpoints))] = h;
+}
+}
+
+#endif
+#ifndef UNION_FIND_HPP
+#define UNION_FIND_HPP
+
+#include <utility>
+#include <vector>
+using namespace std;
+
+/**
+* Disjoint set union over n elements with union by size
+* and path halving
+* (https://en.wikipedia.org/wiki/Disjoint-set_data_structure).
+*/
+
+class UnionFind {
+public:
+
+UnionFind(int n) {
+Parent.resize(n);
+Size.assign(n, 1);
+for (int i = 0; i < n; i++)
+Parent[i] = i;
+}
+
+/**
+* Returns the representative of the set containing a
+* Complexity: O(alpha(n)) (amortized)
+*/
+int find(int a) {
+while (Parent[a] != a) {
+Parent[a] = Parent[Parent[a]];
+a = Parent[a];
+}
+return a;
+}
+
+/**
+* Merges the sets containing a and b
+* Returns false if they were already the same set
+* Complexity: O(alpha(n)) (amortized)
+*/
+bool unite(int a, int b) {
+a = find(a);
+b = find(b);
+if (a == b)
+return false;
+
+if (Size[a] < Size[b])
+swap(a, b);
+Parent[b] = a;
+Size[a] += Size[b];
+return true;
+}
+
+/**
+* Returns the size of the set containing a
+* Complexity: O(alpha(n)) (amortized)
+*/
+int size(int a) {
+return Size[find(a)];
+}
+
+private:
+vector <int> Parent;
+vector <int> Size;
+};
+
+/**
+* Disjoint set union over n elements with union by size and
+* no path compression, so that the unions can be undone in
+* the reverse order.
+*/
+
+class RollbackUnionFind {
+public:
+
+RollbackUnionFind(int n) {
+Parent.resize(n);
+Size.assign(n, 1);
+for (int i = 0; i < n; i++)
+Parent[i] = i;
+sets = n;
+}
+
+/**
+* Returns the representative of the set containing a
+* Complexity: O(log n)
+*/
+int find(int a) const {
+while (Parent[a] != a)
+a = Parent[a];
+return a;
+}
+
+/**
+* Merges the sets containing a and b
+* Returns false if they were already the same set
+* Complexity: O(log n)
+*/
+bool unite(int a, int b) {
+a = find(a);
+b = find(b);
+if (a == b)
+return false;
+
+if (Size[a] < Size[b])
+swap(a, b);
+Parent[b] = a;
+Size[a] += Size[b];
+History.push_back(b);
+sets--;
+return true;
+}
+
+/* Returns the number of sets */
+int count() const {
+return sets;
+}
+
+/**
+* Returns a checkpoint to roll back to, which stays valid
+* until the unions made before it are rolled back
+* Complexity: O(1)
+*/
+int checkpoint() const {
+return History.size();
+}
+
+/**
+* Undoes all unions made since the checkpoint
+* Complexity: O(1) per union undone
+*/
+void rollback(int checkpoint) {
+while ((int) History.size() > checkpoint) {
+int b = History.back(), a = Parent[b];
+History.pop_back();
+Parent[b] = b;
+Size[a] -= Size[b];
+sets++;
+}
+}
+
+private:
+vector <int> Parent;
+vector <int> Size;
+/* the roots which got a parent, in the order of the unions */
+vector <int> History;
+int sets;
+};
+
+#endif
+using namespace std;
+
+/**
+* Offline dynamic connectivity for operation sequences known
+* in advance. The operations are only recorded, and solve()
+* answers all queries together: every edge is alive during an
+* interval of the queries, which is split into O(log q) nodes
+* of a segment tree over the queries. A DFS over the segment
+* tree joins the edges of every node on the path from the root
+* in a union-find with rollback, so at a leaf it holds exactly
+* the graph at the time of its query.
+*
+* The queries give the same results as DynamicConnectivity
+* given the same operations (parallel edges are counted and
+* loops are ignored).
+*/
+
+class OfflineConnectivity {
+public:
+
+OfflineConnectivity(int _n);
+
+/**
+* Records an insertion of the undirected edge (a,b)
+* Complexity: O(1) (expected)
+*/
+void insert(int a, int b);
+
+/**
+* Records a removal of one copy of the undirected edge (a,b)
+* Removing an edge which is not in the graph has no effect.
+* Complexity: O(1) (expected)
+*/
+void remove(int a, int b);
+
+/**
+* Records a query whether vertices a and b are connected
+* and returns its index for answer()
+* Complexity: O(1) (amortized)
+*/
+int connected(int a, int b);
+
+/**
+* Records a query for the number of connected components
+* and returns its index for answer()
+* Complexity: O(1) (amortized)
+*/
+int count_components();
+
+/**
+* Answers all queries recorded so far. After this call, no
+* more operations can be recorded.
+* Complexity: O(n + q log q log n) where q is the number of
+* recorded operations, with O(n + q log q) memory
+*/
+void solve();
+
+/**
+* Returns the answer to the query with the given index:
+* 0 or 1 for connected, the number of components for
+* count_components
+* Complexity: O(1)
+*/
+int answer(int query) const;
+
+private:
+struct Query {
+/* a is -1 for count_components */
+int a, b;
+};
+
+struct OpenEdge {
+/* number of parallel copies of the edge in the graph */
+int cnt = 0;
+/* index of the first query after the edge appeared */
+int since = 0;
+};
+
+struct Interval {
+int a, b;
+/* the edge is alive for the queries in [begin, end) */
+int begin, end;
+};
+
+void close(int a, int b, int begin);
+void answer_queries(int node, int lo, int hi, RollbackUnionFind &UF);
+
+int n;
+vector <Query> Queries;
+vector <int> Answers;
+vector <Interval> Intervals;
+EdgeTable <OpenEdge> Open;
+
+/* the edges of every segment tree node, stored contiguously */
+vector <int> NodeStart;
+vector <pair <int, int> > NodeEdges;
+};
+
+#endif
+
+#include <cassert>
+#ifndef OFFLINE_HPP
+#define OFFLINE_HPP
+
+#include <utility>
+#include <vector>
+#ifndef EDGE_TABLE_HPP
+#define EDGE_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+using namespace std;
+
+/* Packs the undirected edge (a,b) into a 64-bit key */
+inline uint64_t edge_key(int a, int b) {
+if (a > b)
+swap(a, b);
+return (uint64_t(uint32_t(a)) << 32) | uint32_t(b);
+}
+
+/* Fibonacci hashing: the top bits of the product are well mixed */
+inline size_t edge_hash(uint64_t key, int shift) {
+return (key * 0x9E3779B97F4A7C15ULL) >> shift;
+}
+
+/**
+* Hash table mapping undirected edges to values of type Info.
+*
+* Uses open addressing with linear probing over a single array
+* of slots, each holding the edge together with its value, so a
+* lookup touches one or two cache lines. The edge is stored as
+* two 32-bit endpoints, so that a slot is aligned only as the
+* value: with a 4-byte value, a slot takes 12 bytes instead of
+* 16.
+* Erased slots are filled by shifting the following entries
+* back (no tombstones), so probe sequences stay short under
+* any mix of insertions and deletions.
+*
+* Pointers returned by find and insert stay valid until the
+* next call to insert or erase.
+*/
+
+template <class Info>
+class EdgeTable {
+public:
+
+EdgeTable() {
+count = 0;
+shift = 64 - 4;
+Slots.assign(size_t(1) << (64 - shift), Slot(EMPTY));
+}
+
+/**
+* Returns the value stored for the (a,b) edge
+* or NULL if there is none
+* Complexity: O(1) (expected)
+*/
+Info *find(int a, int b) {
+size_t i = probe(edge_key(a, b));
+return Slots[i].key() == EMPTY ? NULL : &Slots[i].info;
+}
+
+/**
+* Returns the value stored for the (a,b) edge, creating
+* a value-initialized entry if there is none
+* Complexity: O(1) (expected, amortized)
+*/
+Info *insert(int a, int b) {
+uint64_t key = edge_key(a, b);
+
+// keep the load factor at most 1/2
+if (2 * (size_t(count) + 1) > Slots.size())
+rehash(shift - 1);
+
+size_t i = probe(key);
+if (Slots[i].key() == EMPTY) {
+Slots[i] = Slot(key);
+count++;
+}
+return &Slots[i].info;
+}
+
+/**
+* Removes the entry pointed to by info (obtained from find
+* or insert) from the table
+* Complexity: O(1) (expected)
+*/
+void erase(Info *info);
+
+/**
+* Makes room for the given number of edges, so that
+* inserting them does not trigger any further rehashing
+* Complexity: O(edges + size of the table)
+*/
+void reserve(int edges) {
+int new_shift = shift;
+while (2 * size_t(edges) > (size_t(1) << (64 - new_shift)))
+new_shift--;
+if (new_shift != shift)
+rehash(new_shift);
+}
+
+/* Returns the number of edges stored in the table */
+int size() {
+return count;
+}
+
+/**
+* Calls f(a, b, info) for every entry, where (a,b) is the
+* edge with a <= b
+* Complexity: O(capacity of the table)
+*/
+template <class F>
+void for_each(F f) {
+for (Slot &slot: Slots) {
+if (slot.key() != EMPTY)
+f(int(slot.a), int(slot.b), slot.info);
+}
+}
+
+private:
+struct Slot {
+/* the endpoints a <= b, both UINT32_MAX in an empty slot */
+uint32_t a, b;
+Info info;
+
+Slot(uint64_t key) : a(uint32_t(key >> 32)), b(uint32_t(key)), info() {}
+
+uint64_t key() const {
+return (uint64_t(a) << 32) | b;
+}
+};
+
+static constexpr uint64_t EMPTY = UINT64_MAX;
+
+vector <Slot> Slots;
+int count;
+int shift;
+
+size_t home(uint64_t key) {
+return edge_hash(key, shift);
+}
+
+/**
+* Returns the index of the slot holding key or of the empty
+* slot that ends its probe sequence.
+*/
+size_t probe(uint64_t key) {
+size_t mask = Slots.size() - 1;
+size_t i = home(key);
+while (Slots[i].key() != EMPTY && Slots[i].key() != key) {
+i = (i + 1) & mask;
+}
+return i;
+}
+
+void rehash(int new_shift);
+};
+
+/**
+* Backward shift deletion: walks the cluster following the
+* erased slot and moves back every entry whose home position
+* does not lie cyclically between the hole and the entry.
+*/
+template <class Info>
+void EdgeTable<Info>::erase(Info *info) {
+Slot *slot = reinterpret_cast<Slot*>(
+reinterpret_cast<char*>(info) - offsetof(Slot, info));
+size_t mask = Slots.size() - 1;
+size_t hole = slot - Slots.data();
+
+for (size_t j = (hole + 1) & mask; Slots[j].key() != EMPTY; j = (j + 1) & mask) {
+size_t h = home(Slots[j].key());
+
+bool movable = (hole <= j) ? (h <= hole || h > j)
+: (h <= hole && h > j);
+if (movable) {
+Slots[hole] = Slots[j];
+hole = j;
+}
+}
+
+Slots[hole].a = Slots[hole].b = UINT32_MAX;
+count--;
+}
+
+template <class Info>
+void EdgeTable<Info>::rehash(int new_shift) {
+vector <Slot> old_slots;
+old_slots.swap(Slots);
+
+shift = new_shift;
+Slots.assign(size_t(1) << (64 - shift), Slot(EMPTY));
+
+for (Slot &slot: old_slots) {
+if (slot.key() != EMPTY)
+Slots[probe(slot.key())] = slot;
+}
+}
+
+/**
+* Hash index of edges stored outside of it, e.g. in the nodes
+* of a forest. A slot holds only the handle of an edge (0 marks
+* an empty slot and is never a handle), and the endpoints of a
+* handle h are read from endpoints(h), a function passed to
+* every call which needs them.
+*
+* The layout is that of EdgeTable, but a slot takes only the 4
+* bytes of a handle; in exchange, every probe of a lookup reads
+* the endpoints of the handle it passes. The endpoints of a
+* handle must not change while it is in the index.
+*/
+
+template <class Handle>
+class EdgeIndex {
+public:
+
+EdgeIndex() {
+count = 0;
+shift = 64 - 4;
+Slots.assign(size_t(1) << (64 - shift), 0);
+}
+
+/**
+* Returns the handle of the (a,b) edge or 0 if there is none
+* Complexity: O(1) (expected)
+*/
+template <class F>
+Handle find(int a, int b, F endpoints) const {
+uint64_t key = edge_key(a, b);
+size_t mask = Slots.size() - 1;
+size_t i = edge_hash(key, shift);
+while (Slots[i] != 0 && key_of(Slots[i], endpoints) != key)
+i = (i + 1) & mask;
+return Slots[i];
+}
+
+/**
+* Adds the edge with handle h, which must not be in the
+* index yet
+* Complexity: O(1) (expected, amortized)
+*/
+template <class F>
+void insert(Handle h, F endpoints) {
+// keep the load factor at most 1/2
+if (2 * (size_t(count) + 1) > Slots.size())
+rehash(shift - 1, endpoints);
+
+Slots[free_slot(key_of(h, endpoints))] = h;
+count++;
+}
+
+/**
+* Removes the edge with handle h from the index
+* Complexity: O(1) (expected)
+*/
+template <class F>
+void erase(Handle h, F endpoints);
+
+/**
+* Makes room for the given number of edges, so that
+* inserting them does not trigger any further rehashing
+* Complexity: O(edges + size of the index)
+*/
+template <class F>
+void reserve(int edges, F endpoints) {
+int new_shift = shift;
+while (2 * size_t(edges) > (size_t(1) << (64 - new_shift)))
+new_shift--;
+if (new_shift != shift)
+rehash(new_shift, endpoints);
+}
+
+/* Returns the number of edges in the index */
+int size() const {
+return count;
+}
+
+private:
+vector <Handle> Slots;
+int count;
+int shift;
+
+template <class F>
+static uint64_t key_of(Handle h, F endpoints) {
+pair <int, int> edge = endpoints(h);
+return edge_key(edge.first, edge.second);
+}
+
+/* Returns the first empty slot of the probe sequence of key */
+size_t free_slot(uint64_t key) const {
+size_t mask = Slots.size() - 1;
+size_t i = edge_hash(key, shift);
+while (Slots[i] != 0)
+i = (i + 1) & mask;
+return i;
+}
+
+template <class F>
+void rehash(int new_shift, F endpoints);
+};
+
+/* Backward shift deletion, as in EdgeTable::erase */
+template <class Handle>
+template <class F>
+void EdgeIndex<Handle>::erase(Handle h, F endpoints) {
+size_t mask = Slots.size() - 1;
+size_t hole = edge_hash(key_of(h, endpoints), shift);
+while (Slots[hole] != h)
+hole = (hole + 1) & mask;
+
+for (size_t j = (hole + 1) & mask; Slots[j] != 0; j = (j + 1) & mask) {
+size_t home = edge_hash(key_of(Slots[j], endpoints), shift);
+
+bool movable = (hole <= j) ? (home <= hole || home > j)
+: (home <= hole && home > j);
+if (movable) {
+Slots[hole] = Slots[j];
+hole = j;
+}
+}
+
+Slots[hole] = 0;
+count--;
+}
+
+template <class Handle>
+template <class F>
+void EdgeIndex<Handle>::rehash(int new_shift, F endpoints) {
+vector <Handle> old_slots;
+old_slots.swap(Slots);
+
+shift = new_shift;
+Slots.assign(size_t(1) << (64 - shift), 0);
+
+for (Handle h: old_slots) {
+if (h != 0)
+Slots[free_slot(key_of(h, endpoints))] = h;
+}
+}
+
+#endif
+#ifndef UNION_FIND_HPP
+#define UNION_FIND_HPP
+
+#include <utility>
+#include <vector>
+using namespace std;
+
+/**
+* Disjoint set union over n elements with union by size
+* and path halving
+* (https://en.wikipedia.org/wiki/Disjoint-set_data_structure).
+*/
+
+class UnionFind {
+public:
+
+UnionFind(int n) {
+Parent.resize(n);
+Size.assign(n, 1);
+for (int i = 0; i < n; i++)
+Parent[i] = i;
+}
+
+/**
+* Returns the representative of the set containing a
+* Complexity: O(alpha(n)) (amortized)
+*/
+int find(int a) {
+while (Parent[a] != a) {
+Parent[a] = Parent[Parent[a]];
+a = Parent[a];
+}
+return a;
+}
+
+/**
+* Merges the sets containing a and b
+* Returns false if they were already the same set
+* Complexity: O(alpha(n)) (amortized)
+*/
+bool unite(int a, int b) {
+a = find(a);
+b = find(b);
+if (a == b)
+return false;
+
+if (Size[a] < Size[b])
+swap(a, b);
+Parent[b] = a;
+Size[a] += Size[b];
+return true;
+}
+
+/**
+* Returns the size of the set containing a
+* Complexity: O(alpha(n)) (amortized)
+*/
+int size(int a) {
+return Size[find(a)];
+}
+
+private:
+vector <int> Parent;
+vector <int> Size;
+};
+
+/**
+* Disjoint set union over n elements with union by size and
+* no path compression, so that the unions can be undone in
+* the reverse order.
+*/
+
+class RollbackUnionFind {
+public:
+
+RollbackUnionFind(int n) {
+Parent.resize(n);
+Size.assign(n, 1);
+for (int i = 0; i < n; i++)
+Parent[i] = i;
+sets = n;
+}
+
+/**
+* Returns the representative of the set containing a
+* Complexity: O(log n)
+*/
+int find(int a) const {
+while (Parent[a] != a)
+a = Parent[a];
+return a;
+}
+
+/**
+* Merges the sets containing a and b
+* Returns false if they were already the same set
+* Complexity: O(log n)
+*/
+bool unite(int a, int b) {
+a = find(a);
+b = find(b);
+if (a == b)
+return false;
+
+if (Size[a] < Size[b])
+swap(a, b);
+Parent[b] = a;
+Size[a] += Size[b];
+History.push_back(b);
+sets--;
+return true;
+}
+
+/* Returns the number of sets */
+int count() const {
+return sets;
+}
+
+/**
+* Returns a checkpoint to roll back to, which stays valid
+* until the unions made before it are rolled back
+* Complexity: O(1)
+*/
+int checkpoint() const {
+return History.size();
+}
+
+/**
+* Undoes all unions made since the checkpoint
+* Complexity: O(1) per union undone
+*/
+void rollback(int checkpoint) {
+while ((int) History.size() > checkpoint) {
+int b = History.back(), a = Parent[b];
+History.pop_back();
+Parent[b] = b;
+Size[a] -= Size[b];
+sets++;
+}
+}
+
+private:
+vector <int> Parent;
+vector <int> Size;
+/* the roots which got a parent, in the order of the unions */
+vector <int> History;
+int sets;
+};
+
+#endif
+using namespace std;
+
+/**
+* Offline dynamic connectivity for operation sequences known
+* in advance. The operations are only recorded, and solve()
+* answers all queries together: every edge is alive during an
+* interval of the queries, which is split into O(log q) nodes
+* of a segment tree over the queries. A DFS over the segment
+* tree joins the edges of every node on the path from the root
+* in a union-find with rollback, so at a leaf it holds exactly
+* the graph at the time of its query.
+*
+* The queries give the same results as DynamicConnectivity
+* given the same operations (parallel edges are counted and
+* loops are ignored).
+*/
+
+class OfflineConnectivity {
+public:
+
+OfflineConnectivity(int _n);
+
+/**
+* Records an insertion of the undirected edge (a,b)
+* Complexity: O(1) (expected)
+*/
+void insert(int a, int b);
+
+/**
+* Records a removal of one copy of the undirected edge (a,b)
+* Removing an edge which is not in the graph has no effect.
+* Complexity: O(1) (expected)
+*/
+void remove(int a, int b);
+
+/**
+* Records a query whether vertices a and b are connected
+* and returns its index for answer()
+* Complexity: O(1) (amortized)
+*/
+int connected(int a, int b);
+
+/**
+* Records a query for the number of connected components
+* and returns its index for answer()
+* Complexity: O(1) (amortized)
+*/
+int count_components();
+
+/**
+* Answers all queries recorded so far. After this call, no
+* more operations can be recorded.
+* Complexity: O(n + q log q log n) where q is the number of
+* recorded operations, with O(n + q log q) memory
+*/
+void solve();
+
+/**
+* Returns the answer to the query with the given index:
+* 0 or 1 for connected, the number of components for
+* count_components
+* Complexity: O(1)
+*/
+int answer(int query) const;
+
+private:
+struct Query {
+/* a is -1 for count_components */
+int a, b;
+};
+
+struct OpenEdge {
+/* number of parallel copies of the edge in the graph */
+int cnt = 0;
+/* index of the first query after the edge appeared */
+int since = 0;
+};
+
+struct Interval {
+int a, b;
+/* the edge is alive for the queries in [begin, end) */
+int begin, end;
+};
+
+void close(int a, int b, int begin);
+void answer_queries(int node, int lo, int hi, RollbackUnionFind &UF);
+
+int n;
+vector <Query> Queries;
+vector <int> Answers;
+vector <Interval> Intervals;
+EdgeTable <OpenEdge> Open;
+
+/* the edges of every segment tree node, stored contiguously */
+vector <int> NodeStart;
+vector <pair <int, int> > NodeEdges;
+};
+
+#endif
+
+OfflineConnectivity::OfflineConnectivity(int _n) {
+n = _n;
+}
+
+void OfflineConnectivity::insert(int a, int b) {
+// loops never affect connectivity
+if (a == b)
+return;
+
+OpenEdge *edge = Open.insert(a, b);
+if (edge->cnt++ == 0)
+edge->since = Queries.size();
+}
+
+void OfflineConnectivity::remove(int a, int b) {
+OpenEdge *edge = Open.find(a, b);
+if (edge == NULL || --edge->cnt > 0)
+return;
+
+close(a, b, edge->since);
+Open.erase(edge);
+}
+
+/* Records the lifetime of an edge, unless no query saw it */
+void OfflineConnectivity::close(int a, int b, int begin) {
+int end = Queries.size();
+if (begin < end)
+Intervals.push_back({a, b, begin, end});
+}
+
+int OfflineConnectivity::connected(int a, int b) {
+Queries.push_back({a, b});
+return Queries.size() - 1;
+}
+
+int OfflineConnectivity::count_components() {
+Queries.push_back({-1, -1});
+return Queries.size() - 1;
+}
+
+/**
+* The segment tree is a complete binary tree with the queries
+* in the leaves; node i has children 2i and 2i+1. Its nodes
+* store the edges in one array, grouped by a counting sort.
+*/
+void OfflineConnectivity::solve() {
+Open.for_each([&](int a, int b, OpenEdge &edge) {
+close(a, b, edge.since);
+});
+Open = EdgeTable <OpenEdge>();
+
+int q = Queries.size();
+Answers.assign(q, 0);
+if (q == 0)
+return;
+
+int leaves = 1;
+while (leaves < q)
+leaves *= 2;
+
+// the nodes covering [begin, end), bottom up
+auto for_each_node = [&](const Interval &e, auto f) {
+for (int l = e.begin + leaves, r = e.end + leaves; l < r; l /= 2, r /= 2) {
+if (l & 1)
+f(l++);
+if (r & 1)
+f(--r);
+}
+};
+
+NodeStart.assign(2 * leaves + 1, 0);
+for (const Interval &e: Intervals)
+for_each_node(e, [&](int node) { NodeStart[node + 1]++; });
+for (int i = 0; i < 2 * leaves; i++)
+NodeStart[i + 1] += NodeStart[i];
+
+NodeEdges.resize(NodeStart.back());
+vector <int> fill(NodeStart.begin(), NodeStart.end() - 1);
+for (const Interval &e: Intervals)
+for_each_node(e, [&](int node) { NodeEdges[fill[node]++] = {e.a, e.b}; });
+vector <Interval>().swap(Intervals);
+
+RollbackUnionFind UF(n);
+answer_queries(1, 0, leaves, UF);
+
+vector <int>().swap(NodeStart);
+vector <pair <int, int> >().swap(NodeEdges);
+}
+
+/**
+* Joins the edges of the node covering the queries [lo, hi) and
+* descends into its children, then rolls the joins back
+*/
+void OfflineConnectivity::answer_queries(int node, int lo, int hi,
+RollbackUnionFind &UF) {
+if (lo >= (int) Queries.size())
+return;
+
+int checkpoint = UF.checkpoint();
+for (int i = NodeStart[node]; i < NodeStart[node + 1]; i++)
+UF.unite(NodeEdges[i].first, NodeEdges[i].second);
+
+if (hi - lo == 1) {
+const Query &query = Queries[lo];
+if (query.a == -1)
+Answers[lo] = UF.count();
+else
+Answers[lo] = UF.find(query.a) == UF.find(query.b);
+
+} else {
+int mid = (lo + hi) / 2;
+answer_queries(2 * node, lo, mid, UF);
+answer_queries(2 * node + 1, mid, hi, UF);
+}
+
+UF.rollback(checkpoint);
+}
+
+int OfflineConnectivity::answer(int query) const {
+assert(query < (int) Answers.size());
+return Answers[query];
+}
+
+/**
+* A solution to the "Connect and Disconnect" problem from codeforces
+* (https://codeforces.com/gym/100551/problem/A).
+* All operations are known in advance, so they are recorded and
+* answered together by OfflineConnectivity (with DynamicConnectivity,
+* the solution gets a Memory Limit Exceeded verdict).
+*/
+
+int main()
+{
+freopen("connect.in", "r", stdin);
+freopen("connect.out", "w", stdout);
+
+int n, k;
+scanf ("%d %d", &n, &k);
+
+OfflineConnectivity OC(n);
+vector <int> queries;
+
+while(k--) {
+char type;
+int a, b;
+scanf (" %c", &type);
+if (type != '?') {
+scanf ("%d %d", &a, &b);
+a--;
+b--;
+}
+switch(type) {
+case '?':
+queries.push_back(OC.count_components());
+break;
+
+case '+':
+OC.insert(a,b);
+break;
+
+case '-':
+OC.remove(a,b);
+break;
+}
+}
+
+OC.solve();
+for (int query: queries)
+printf ("%d\n", OC.answer(query));
+}
@@ -3,7 +3,10 @@
 
 #include "dc.cpp"
 #include "et_trees.cpp"
+#include "tour_tree.cpp"
 #include "avl_tree.cpp"
+#include "splay_tree.cpp"
+#include "treap.cpp"
 
 /**
  * Solution to the problem Disconnected Graph:
@@ -35,21 +38,14 @@ int main(int argc, char **argv)
 
     int n, m;
     scanf ("%d %d", &n, &m);
-    DynamicConnectivity DC(n);
     vector <pair <int, int> > edges(m);
 
-    int n_cc = n;
-
     for (auto &e: edges) {
         scanf ("%d %d", &e.first, &e.second);
         e.first--;
         e.second--;
-        
-        if (!DC.connected(e.first,e.second)) {
-            n_cc--;
-        }
-        DC.insert(e.first,e.second);
     }
+    DynamicConnectivity DC(n, edges);
 
     int k;
     scanf ("%d", &k);
@@ -76,24 +72,14 @@ int main(int argc, char **argv)
         Q[i].pop_back();
 
         for (int e: Q[i-1]) if (!in(e, Q[i])) {
-            int a = edges[e].first;
-            int b = edges[e].second;
-            if (!DC.connected(a,b)) {
-                n_cc--;
-            }
-            DC.insert(a,b);
+            DC.insert(edges[e].first, edges[e].second);
         }
 
         for (int e: Q[i]) if (!in(e, Q[i-1])) {
-            int a = edges[e].first;
-            int b = edges[e].second;
-            DC.remove(a,b);
-            if (!DC.connected(a,b)) {
-                n_cc++;
-            }
+            DC.remove(edges[e].first, edges[e].second);
         }
 
-        Res[q] = n_cc;
+        Res[q] = DC.count_components();
     }
 
     for (int i = 0; i < k; i++) {
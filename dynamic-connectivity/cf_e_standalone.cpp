@@ -0,0 +1,12822 @@
+#pragma GCC optimize("O3")
+#include <cstdio>
+
+#include <bits/stdc++.h>
+#ifndef DC_HPP
+#define DC_HPP
+
+#include <vector>
+#include <map>
+#include <functional>
+
+#ifndef ET_TREES_HPP
+#define ET_TREES_HPP
+
+#include <vector>
+#include <cstdint>
+#include <set>
+#ifndef AVL_TREE_HPP
+#define AVL_TREE_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <cassert>
+#ifndef TOUR_TREE_HPP
+#define TOUR_TREE_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <cassert>
+using namespace std;
+
+// A switch for managing debug output
+// #define DBG
+#ifdef DBG
+#define debug(...) fprintf(stderr, __VA_ARGS__), fflush(stderr)
+#else
+#define debug(...) {}
+#endif
+
+/* Nodes are addressed by 32-bit indices into the node array */
+typedef uint32_t node_t;
+
+/* Index of the sentinel node, which stands for an empty tree */
+const node_t NIL = 0;
+
+enum NodeFlags : uint8_t {
+/* the node represents a vertex (otherwise a tree edge) */
+VERTEX_NODE = 1,
+/* the node is a tree edge on the level of the forest */
+ON_LEVEL = 2
+};
+
+/**
+* A node of an Euler tour: either a vertex or one direction
+* of a tree edge (see et_trees.hpp). All the fields used while
+* restructuring the tree are packed into 32 bytes, so two nodes
+* share a cache line.
+*/
+struct TourNode {
+node_t left, right, parent;
+
+/* number of vertex nodes in the subtree of this node */
+int size;
+/* number of vertex nodes in the subtree storing nontree edges */
+int nontree_cnt;
+/* number of ON_LEVEL edge nodes in the subtree */
+int on_level_cnt;
+
+/**
+* Vertex nodes: the first record of the list of nontree
+* edges of the vertex (-1 if it is empty, see et_trees.hpp)
+* Edge nodes: the vertex the edge leads to
+*/
+int aux;
+
+/* height of the subtree (maintained only by AVLTree) */
+uint8_t height;
+uint8_t flags;
+};
+
+/**
+* Extra aggregates of the subtrees, maintained outside of the
+* nodes on behalf of a user of a forest: update(x, left, right)
+* is called whenever the aggregates of the node x are recomputed
+* from those of its children (NIL for a missing child).
+* Before a node past the array of nodes is updated, resize(k)
+* tells that the forest has grown to k nodes; update itself must
+* not grow the storage, as a forest may recompute the nodes of
+* different trees on several threads at once (see ETTForest::
+* link_batch and ETTForest::plan_cuts) and update may only write
+* the aggregates of x.
+*
+* The hook is a policy of the sequence trees (see TourTree):
+* only the trees instantiated with AggregateHook call it.
+*/
+class AggregateHook {
+public:
+static constexpr bool enabled = true;
+
+virtual void update(node_t x, node_t left, node_t right) = 0;
+virtual void resize(size_t) {}
+virtual ~AggregateHook() {}
+};
+
+/* The hook policy of the trees without extra aggregates */
+struct NoHook {
+static constexpr bool enabled = false;
+};
+
+/**
+* The part of a balanced sequence tree which does not depend on
+* the balancing scheme: the array of TourNodes owned by a forest,
+* allocation of nodes and the aggregates stored in them.
+*
+* Node 0 is a sentinel (NIL) whose aggregates are all zero, so
+* they can be summed without checking for missing children. Edge
+* nodes are allocated in pairs (e, e+1), one for each direction
+* of the edge; released nodes are reused before the array grows.
+*
+* ETTForest (et_trees.hpp) takes the sequence tree as a template
+* parameter. Besides the methods below, a sequence tree provides:
+*
+*   pair <node_t, node_t> split(node_t x);
+*   pair <node_t, node_t> split_around(node_t x);
+*   node_t merge(node_t left, node_t middle, node_t right);
+*   node_t root(node_t x);
+*   bool same_tree(node_t x, node_t y);
+*   void unlink(node_t x);
+*   node_t build(const node_t *seq, int k);
+*   bool correct_tree(node_t x, node_t correct_parent) const;
+*
+* with the semantics documented in avl_tree.hpp, and the alias
+*
+*   template <class OtherHook> using with_hook = ...;
+*
+* for the same tree with another hook policy. A sequence tree
+* may restructure the tree in any of them (even in root), so a
+* root returned by one call is only valid until the next one.
+* Only a tree which sets self_adjusting does so in root,
+* same_tree and find_nontree_edge; in the others, these only
+* read the tree and may run on several threads at once.
+* Implementations: AVLTree (avl_tree.hpp), SplayTree
+* (splay_tree.hpp) and Treap (treap.hpp).
+*
+* The Hook parameter is NoHook or AggregateHook. With NoHook,
+* the call of the hook is compiled out of every recomputation
+* of the aggregates; the trees are compiled for both policies
+* and HookedTree below names the one calling a hook.
+*/
+
+template <class Hook>
+class TourTree {
+public:
+typedef Hook hook_type;
+
+/* whether the queries restructure the tree (see above) */
+static constexpr bool self_adjusting = false;
+
+/* the number of walks of find_roots in flight */
+static constexpr int ROOT_WALKS = 32;
+
+TourTree();
+
+/**
+* Creates a new single-node tree representing a vertex
+* Complexity: O(1) (amortized)
+*/
+node_t new_vertex_node();
+
+/**
+* Releases the vertex node x, which must form
+* a single-node tree
+* Complexity: O(1)
+*/
+void free_vertex_node(node_t x);
+
+/**
+* Creates two single-node trees: e representing the edge
+* (a,b) (on the level if on_level is set) and e+1
+* representing the edge (b,a). Returns e.
+* Complexity: O(1) (amortized)
+*/
+node_t new_edge_nodes(int a, int b, bool on_level);
+
+/**
+* Releases the pair of edge nodes starting at e
+* Both of them must already be unlinked
+* Complexity: O(1)
+*/
+void free_edge_nodes(node_t e);
+
+const TourNode &operator[](node_t x) const {
+return Nodes[x];
+}
+
+/**
+* Sets the hook maintaining extra aggregates (or turns them
+* off if hook is NULL) and tells it the number of nodes.
+* The aggregates of the existing nodes are not recomputed.
+* With NoHook, the hook is never called.
+* Complexity: O(1) besides the resize of the hook
+*/
+void set_aggregate_hook(Hook *_hook);
+
+/**
+* Sets key to a number ordering x among the nodes of its
+* tree as the sequence does and root to the root of the
+* tree, without restructuring the tree. Returns false (and
+* no key) if x is deeper than MAX_KEY_DEPTH, as its path from
+* the root does not fit in the key then.
+* Complexity: O(depth of x)
+*/
+bool order_key(node_t x, uint64_t &key, node_t &root) const;
+static constexpr int MAX_KEY_DEPTH = 62;
+
+/**
+* Recomputes the aggregates of x and all its ancestors
+* Complexity: O(depth of x)
+*/
+void update_path(node_t x);
+
+/**
+* Returns the root of the tree containing x without
+* restructuring the tree (for diagnostics)
+*
+* Complexity: O(depth of x)
+*/
+node_t find_root(node_t x) const;
+
+/**
+* Like find_root, but loads the parent pointers atomically
+* (see set_parent), so that it may run while another thread
+* restructures the tree. The result is then meaningless and
+* must be validated by the caller (see SeqLock in
+* seqlock.hpp). Gives up and
+* returns NIL after limit steps, as a concurrent rotation may
+* close a cycle of parent pointers for a moment.
+*
+* Complexity: O(min(depth of x, limit))
+*/
+node_t find_root_concurrent(node_t x, int limit) const;
+
+/**
+* Sets roots[i] to find_root(xs[i]) for all i < k. Up to
+* ROOT_WALKS walks advance in lock-step, each prefetching
+* the next node on its path, so that the cache misses of
+* different walks overlap; a finished walk is replaced by
+* the next one right away.
+*
+* Complexity: O(sum of the depths of the nodes)
+*/
+void find_roots(const node_t *xs, int k, node_t *roots) const;
+
+/**
+* Reserves memory for k nodes (including NIL), so that the
+* array of nodes is not reallocated while it holds at most
+* k of them
+*
+* Complexity: O(k)
+*/
+void reserve(int k);
+
+/**
+* Appends the nodes of the tree rooted in x to seq (in
+* order) and turns each of them into a single-node tree
+* (to be reassembled with build)
+*
+* Complexity: O(size of the tree)
+*/
+void flatten(node_t x, vector <node_t> &seq);
+
+/**
+* Calls f(y) for every node y of the tree rooted in x, in
+* order, walking the parent pointers (without restructuring
+* the tree or allocating memory)
+*
+* Complexity: O(size of the tree)
+*/
+template <class F>
+void for_each_node(node_t x, F f) const;
+
+/**
+* Returns the r-th (from 0, in order) vertex node storing
+* nontree edges in the tree rooted in x or NIL if there are
+* at most r of them
+*
+* Complexity: O(height of the tree)
+*/
+node_t find_nontree_edge(node_t x, int r);
+
+/**
+* Calls f(v, head) for the vertex nodes v storing nontree
+* edges in the tree rooted in x, in order. head is the list
+* of v, which f may shorten by setting it to its remaining
+* part; f returns false to end the traversal. f must not
+* restructure the tree, but it may set the lists of other
+* vertex nodes (with set_nontree_head).
+*
+* The counters of the nodes above the lists emptied by f
+* are recomputed once, when the traversal leaves them.
+*
+* Complexity: O(k log(n/k)) plus the time of f, where k is
+* the number of vertex nodes visited
+*/
+template <class F>
+void scan_nontree_heads(node_t x, F f);
+
+/**
+* Sets the head of the list of nontree edges stored in
+* the vertex node x
+*
+* Complexity: O(depth of x) if the list becomes empty or
+* stops being empty, O(1) otherwise
+*/
+void set_nontree_head(node_t x, int head);
+
+/**
+* Unmarks the edge nodes marked as on_level in the tree
+* rooted in x and calls f(edge) with the edge (a,b) of each
+* of them, until f returns false. A single traversal, pruned
+* by the counters, visits only the marked nodes and their
+* ancestors and clears the counters on its way back up.
+* f must not modify the tree.
+*
+* Complexity: O(k log(n/k)) plus the time of f, where k is
+* the number of marked nodes
+*/
+template <class F>
+void take_on_level(node_t x, F f);
+
+void print_tree(node_t x, int indent = 0) const;
+void print_node(node_t x, int indent = 0) const;
+
+protected:
+vector <TourNode> Nodes;
+/* first released edge pair and vertex node (or NIL) */
+node_t free_pairs, free_vertices;
+Hook *hook;
+
+void set_parent(node_t x, node_t parent);
+void init_node(node_t x, const TourNode &init);
+void replace_child(node_t x, node_t old_child, node_t new_child);
+node_t build_balanced(const node_t *seq, int k);
+
+node_t descend_to_nontree_edge(node_t x, int r = 0) const;
+node_t descend_to_on_level(node_t x) const;
+pair <int, int> unmark_on_level(node_t x);
+
+void update_on_level_cnt(node_t x, int dx);
+void update_nontree_cnt(node_t x, int dx);
+void update_aggregates(node_t x);
+void grow_nodes(size_t k);
+
+bool correct_node(node_t x, node_t correct_parent) const;
+};
+
+/**
+* Every write of a parent goes through here: find_root_concurrent
+* loads the parents while the tree changes, so the stores must be
+* atomic. A store releases the node it links to, so that a walk
+* which reaches a newly allocated node also sees it initialized;
+* on x86 both sides are plain moves.
+*/
+template <class Hook>
+inline void TourTree<Hook>::set_parent(node_t x, node_t parent) {
+__atomic_store_n(&Nodes[x].parent, parent, __ATOMIC_RELEASE);
+}
+
+template <class Hook>
+inline void TourTree<Hook>::update_aggregates(node_t x) {
+TourNode &node = Nodes[x];
+const TourNode &l = Nodes[node.left];
+const TourNode &r = Nodes[node.right];
+bool vertex = node.flags & VERTEX_NODE;
+
+node.size = l.size + r.size + (vertex ? 1 : 0);
+node.on_level_cnt = l.on_level_cnt + r.on_level_cnt +
+((node.flags & ON_LEVEL) ? 1 : 0);
+node.nontree_cnt = l.nontree_cnt + r.nontree_cnt +
+((vertex && node.aux != -1) ? 1 : 0);
+
+if constexpr (Hook::enabled) {
+if (hook != NULL)
+hook->update(x, node.left, node.right);
+}
+}
+
+template <class Hook>
+template <class F>
+void TourTree<Hook>::for_each_node(node_t x, F f) const {
+if (x == NIL)
+return;
+
+node_t cur = x;
+while (Nodes[cur].left != NIL)
+cur = Nodes[cur].left;
+
+while (true) {
+f(cur);
+
+if (Nodes[cur].right != NIL) {
+// the successor is the first node of the right subtree
+cur = Nodes[cur].right;
+while (Nodes[cur].left != NIL)
+cur = Nodes[cur].left;
+
+} else {
+// the successor is the first ancestor entered from the left
+while (cur != x && Nodes[Nodes[cur].parent].right == cur)
+cur = Nodes[cur].parent;
+if (cur == x)
+return;
+cur = Nodes[cur].parent;
+}
+}
+}
+
+/**
+* Walks down into the subtrees with marked nodes first, then
+* unmarks the node itself and goes right. A node is left (with
+* its counter zeroed) only when nothing below it is marked, so
+* the walk comes back to every node at most twice. When f asks
+* to stop, only the counters on the path back to x are stale.
+*/
+template <class Hook>
+template <class F>
+void TourTree<Hook>::take_on_level(node_t x, F f) {
+node_t cur = x;
+
+while (Nodes[x].on_level_cnt > 0) {
+TourNode &node = Nodes[cur];
+
+if (Nodes[node.left].on_level_cnt > 0) {
+cur = node.left;
+continue;
+}
+if (node.flags & ON_LEVEL) {
+node.flags &= ~ON_LEVEL;
+if (!f(pair <int, int> (Nodes[cur+1].aux, node.aux))) {
+for (node_t y = cur; y != Nodes[x].parent; y = Nodes[y].parent) {
+Nodes[y].on_level_cnt = Nodes[Nodes[y].left].on_level_cnt +
+Nodes[Nodes[y].right].on_level_cnt +
+((Nodes[y].flags & ON_LEVEL) ? 1 : 0);
+}
+return;
+}
+}
+if (Nodes[node.right].on_level_cnt > 0) {
+cur = node.right;
+continue;
+}
+
+node.on_level_cnt = 0;
+cur = node.parent;
+}
+}
+
+/**
+* An in-order walk through the nodes with nontree edges below
+* them. The node the walk came from tells which part of a node
+* comes next. Once f asks to stop, the walk only goes back up to
+* the root, fixing the counters.
+*/
+template <class Hook>
+template <class F>
+void TourTree<Hook>::scan_nontree_heads(node_t x, F f) {
+node_t cur = x, prv = Nodes[x].parent;
+bool more = true;
+
+while (cur != Nodes[x].parent) {
+node_t left = Nodes[cur].left, right = Nodes[cur].right;
+
+if (prv == Nodes[cur].parent) {
+if (more && Nodes[left].nontree_cnt > 0) {
+prv = cur;
+cur = left;
+continue;
+}
+prv = left;
+}
+
+if (prv == left) {
+if (more && (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1) {
+int head = Nodes[cur].aux;
+more = f(cur, head);
+Nodes[cur].aux = head;
+}
+if (more && Nodes[right].nontree_cnt > 0) {
+prv = cur;
+cur = right;
+continue;
+}
+}
+
+bool own = (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1;
+Nodes[cur].nontree_cnt = Nodes[left].nontree_cnt +
+Nodes[right].nontree_cnt + (own ? 1 : 0);
+prv = cur;
+cur = Nodes[cur].parent;
+}
+}
+
+/* The sequence tree Tree calling an AggregateHook */
+template <class Tree>
+using HookedTree = typename Tree::template with_hook <AggregateHook>;
+
+#endif
+using namespace std;
+
+/**
+* AVL Binary Search Tree implementation
+* (https://en.wikipedia.org/wiki/AVL_tree)
+* over an array of TourNodes.
+*
+* The object owns the nodes of all the trees of a forest and
+* every operation takes node indices (see tour_tree.hpp).
+* Hook is the policy of the extra aggregates (see TourTree).
+*/
+
+template <class Hook = NoHook>
+class BasicAVLTree : public TourTree <Hook> {
+typedef TourTree <Hook> Base;
+
+public:
+template <class OtherHook>
+using with_hook = BasicAVLTree <OtherHook>;
+
+using Base::find_root;
+
+/**
+* Splits the tree into two parts and returns their roots.
+* The first part contains all nodes to the left of x
+* (inclusive), the second part contains all nodes to the
+* right of it (exclusive).
+*
+* Complexity: O(log n)
+*/
+pair <node_t, node_t> split(node_t x);
+
+/**
+* Removes x from its tree and splits the rest of it into
+* the nodes to the left of x and the nodes to the right of
+* it (both exclusive). Returns the roots of the two parts.
+* This is split followed by unlink in a single pass.
+*
+* Complexity: O(log n)
+*/
+pair <node_t, node_t> split_around(node_t x);
+
+/**
+* Merges two trees (left and right) into one (the middle
+* node is optional) and returns the its root.
+* The order of nodes is as follows:
+* left(unchanged), middle, right(unchanged).
+*
+* Complexity if middle is NIL: O(max(h_l, h_r))
+* Complexity if middle is not NIL: O(abs(h_l - h_r))
+* Here h_l and h_r are the heights of left and right trees
+*/
+node_t merge(node_t left, node_t middle, node_t right);
+
+/**
+* Returns the root of the tree containing x
+*
+* Complexity: O(log n)
+*/
+node_t root(node_t x) const;
+
+/**
+* Checks whether x and y belong to the same tree
+*
+* Complexity: O(log n)
+*/
+bool same_tree(node_t x, node_t y) const;
+
+/**
+* Removes x from the tree it belongs to
+*
+* Complexity: O(log n)
+*/
+void unlink(node_t x);
+
+/**
+* Builds a tree from the single-node trees seq[0..k-1]
+* (in this order) and returns its root
+*
+* Complexity: O(k)
+*/
+node_t build(const node_t *seq, int k);
+
+/**
+* Checks if the invariants hold in the subtree of x
+*
+* Complexity: linear in the size of the tree
+*/
+bool correct_tree(node_t x, node_t correct_parent) const;
+
+private:
+using Base::Nodes;
+using Base::set_parent;
+using Base::update_aggregates;
+using Base::replace_child;
+using Base::build_balanced;
+using Base::correct_node;
+
+node_t balance(node_t x);
+node_t rebalance_path(node_t x, node_t top);
+node_t rotate_left(node_t x);
+node_t rotate_right(node_t x);
+node_t remove(node_t x);
+void detach(node_t x);
+pair <node_t, node_t> split_path(node_t x, node_t cur,
+node_t left_tree, node_t right_tree);
+
+void update_statistics(node_t x);
+};
+
+template <class Hook>
+inline void BasicAVLTree<Hook>::update_statistics(node_t x) {
+TourNode &node = Nodes[x];
+node.height = max(Nodes[node.left].height, Nodes[node.right].height) + 1;
+update_aggregates(x);
+}
+
+typedef BasicAVLTree <> AVLTree;
+
+#endif
+#ifndef SPLAY_TREE_HPP
+#define SPLAY_TREE_HPP
+
+#include <utility>
+#ifndef TOUR_TREE_HPP
+#define TOUR_TREE_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <cassert>
+using namespace std;
+
+// A switch for managing debug output
+// #define DBG
+#ifdef DBG
+#define debug(...) fprintf(stderr, __VA_ARGS__), fflush(stderr)
+#else
+#define debug(...) {}
+#endif
+
+/* Nodes are addressed by 32-bit indices into the node array */
+typedef uint32_t node_t;
+
+/* Index of the sentinel node, which stands for an empty tree */
+const node_t NIL = 0;
+
+enum NodeFlags : uint8_t {
+/* the node represents a vertex (otherwise a tree edge) */
+VERTEX_NODE = 1,
+/* the node is a tree edge on the level of the forest */
+ON_LEVEL = 2
+};
+
+/**
+* A node of an Euler tour: either a vertex or one direction
+* of a tree edge (see et_trees.hpp). All the fields used while
+* restructuring the tree are packed into 32 bytes, so two nodes
+* share a cache line.
+*/
+struct TourNode {
+node_t left, right, parent;
+
+/* number of vertex nodes in the subtree of this node */
+int size;
+/* number of vertex nodes in the subtree storing nontree edges */
+int nontree_cnt;
+/* number of ON_LEVEL edge nodes in the subtree */
+int on_level_cnt;
+
+/**
+* Vertex nodes: the first record of the list of nontree
+* edges of the vertex (-1 if it is empty, see et_trees.hpp)
+* Edge nodes: the vertex the edge leads to
+*/
+int aux;
+
+/* height of the subtree (maintained only by AVLTree) */
+uint8_t height;
+uint8_t flags;
+};
+
+/**
+* Extra aggregates of the subtrees, maintained outside of the
+* nodes on behalf of a user of a forest: update(x, left, right)
+* is called whenever the aggregates of the node x are recomputed
+* from those of its children (NIL for a missing child).
+* Before a node past the array of nodes is updated, resize(k)
+* tells that the forest has grown to k nodes; update itself must
+* not grow the storage, as a forest may recompute the nodes of
+* different trees on several threads at once (see ETTForest::
+* link_batch and ETTForest::plan_cuts) and update may only write
+* the aggregates of x.
+*
+* The hook is a policy of the sequence trees (see TourTree):
+* only the trees instantiated with AggregateHook call it.
+*/
+class AggregateHook {
+public:
+static constexpr bool enabled = true;
+
+virtual void update(node_t x, node_t left, node_t right) = 0;
+virtual void resize(size_t) {}
+virtual ~AggregateHook() {}
+};
+
+/* The hook policy of the trees without extra aggregates */
+struct NoHook {
+static constexpr bool enabled = false;
+};
+
+/**
+* The part of a balanced sequence tree which does not depend on
+* the balancing scheme: the array of TourNodes owned by a forest,
+* allocation of nodes and the aggregates stored in them.
+*
+* Node 0 is a sentinel (NIL) whose aggregates are all zero, so
+* they can be summed without checking for missing children. Edge
+* nodes are allocated in pairs (e, e+1), one for each direction
+* of the edge; released nodes are reused before the array grows.
+*
+* ETTForest (et_trees.hpp) takes the sequence tree as a template
+* parameter. Besides the methods below, a sequence tree provides:
+*
+*   pair <node_t, node_t> split(node_t x);
+*   pair <node_t, node_t> split_around(node_t x);
+*   node_t merge(node_t left, node_t middle, node_t right);
+*   node_t root(node_t x);
+*   bool same_tree(node_t x, node_t y);
+*   void unlink(node_t x);
+*   node_t build(const node_t *seq, int k);
+*   bool correct_tree(node_t x, node_t correct_parent) const;
+*
+* with the semantics documented in avl_tree.hpp, and the alias
+*
+*   template <class OtherHook> using with_hook = ...;
+*
+* for the same tree with another hook policy. A sequence tree
+* may restructure the tree in any of them (even in root), so a
+* root returned by one call is only valid until the next one.
+* Only a tree which sets self_adjusting does so in root,
+* same_tree and find_nontree_edge; in the others, these only
+* read the tree and may run on several threads at once.
+* Implementations: AVLTree (avl_tree.hpp), SplayTree
+* (splay_tree.hpp) and Treap (treap.hpp).
+*
+* The Hook parameter is NoHook or AggregateHook. With NoHook,
+* the call of the hook is compiled out of every recomputation
+* of the aggregates; the trees are compiled for both policies
+* and HookedTree below names the one calling a hook.
+*/
+
+template <class Hook>
+class TourTree {
+public:
+typedef Hook hook_type;
+
+/* whether the queries restructure the tree (see above) */
+static constexpr bool self_adjusting = false;
+
+/* the number of walks of find_roots in flight */
+static constexpr int ROOT_WALKS = 32;
+
+TourTree();
+
+/**
+* Creates a new single-node tree representing a vertex
+* Complexity: O(1) (amortized)
+*/
+node_t new_vertex_node();
+
+/**
+* Releases the vertex node x, which must form
+* a single-node tree
+* Complexity: O(1)
+*/
+void free_vertex_node(node_t x);
+
+/**
+* Creates two single-node trees: e representing the edge
+* (a,b) (on the level if on_level is set) and e+1
+* representing the edge (b,a). Returns e.
+* Complexity: O(1) (amortized)
+*/
+node_t new_edge_nodes(int a, int b, bool on_level);
+
+/**
+* Releases the pair of edge nodes starting at e
+* Both of them must already be unlinked
+* Complexity: O(1)
+*/
+void free_edge_nodes(node_t e);
+
+const TourNode &operator[](node_t x) const {
+return Nodes[x];
+}
+
+/**
+* Sets the hook maintaining extra aggregates (or turns them
+* off if hook is NULL) and tells it the number of nodes.
+* The aggregates of the existing nodes are not recomputed.
+* With NoHook, the hook is never called.
+* Complexity: O(1) besides the resize of the hook
+*/
+void set_aggregate_hook(Hook *_hook);
+
+/**
+* Sets key to a number ordering x among the nodes of its
+* tree as the sequence does and root to the root of the
+* tree, without restructuring the tree. Returns false (and
+* no key) if x is deeper than MAX_KEY_DEPTH, as its path from
+* the root does not fit in the key then.
+* Complexity: O(depth of x)
+*/
+bool order_key(node_t x, uint64_t &key, node_t &root) const;
+static constexpr int MAX_KEY_DEPTH = 62;
+
+/**
+* Recomputes the aggregates of x and all its ancestors
+* Complexity: O(depth of x)
+*/
+void update_path(node_t x);
+
+/**
+* Returns the root of the tree containing x without
+* restructuring the tree (for diagnostics)
+*
+* Complexity: O(depth of x)
+*/
+node_t find_root(node_t x) const;
+
+/**
+* Like find_root, but loads the parent pointers atomically
+* (see set_parent), so that it may run while another thread
+* restructures the tree. The result is then meaningless and
+* must be validated by the caller (see SeqLock in
+* seqlock.hpp). Gives up and
+* returns NIL after limit steps, as a concurrent rotation may
+* close a cycle of parent pointers for a moment.
+*
+* Complexity: O(min(depth of x, limit))
+*/
+node_t find_root_concurrent(node_t x, int limit) const;
+
+/**
+* Sets roots[i] to find_root(xs[i]) for all i < k. Up to
+* ROOT_WALKS walks advance in lock-step, each prefetching
+* the next node on its path, so that the cache misses of
+* different walks overlap; a finished walk is replaced by
+* the next one right away.
+*
+* Complexity: O(sum of the depths of the nodes)
+*/
+void find_roots(const node_t *xs, int k, node_t *roots) const;
+
+/**
+* Reserves memory for k nodes (including NIL), so that the
+* array of nodes is not reallocated while it holds at most
+* k of them
+*
+* Complexity: O(k)
+*/
+void reserve(int k);
+
+/**
+* Appends the nodes of the tree rooted in x to seq (in
+* order) and turns each of them into a single-node tree
+* (to be reassembled with build)
+*
+* Complexity: O(size of the tree)
+*/
+void flatten(node_t x, vector <node_t> &seq);
+
+/**
+* Calls f(y) for every node y of the tree rooted in x, in
+* order, walking the parent pointers (without restructuring
+* the tree or allocating memory)
+*
+* Complexity: O(size of the tree)
+*/
+template <class F>
+void for_each_node(node_t x, F f) const;
+
+/**
+* Returns the r-th (from 0, in order) vertex node storing
+* nontree edges in the tree rooted in x or NIL if there are
+* at most r of them
+*
+* Complexity: O(height of the tree)
+*/
+node_t find_nontree_edge(node_t x, int r);
+
+/**
+* Calls f(v, head) for the vertex nodes v storing nontree
+* edges in the tree rooted in x, in order. head is the list
+* of v, which f may shorten by setting it to its remaining
+* part; f returns false to end the traversal. f must not
+* restructure the tree, but it may set the lists of other
+* vertex nodes (with set_nontree_head).
+*
+* The counters of the nodes above the lists emptied by f
+* are recomputed once, when the traversal leaves them.
+*
+* Complexity: O(k log(n/k)) plus the time of f, where k is
+* the number of vertex nodes visited
+*/
+template <class F>
+void scan_nontree_heads(node_t x, F f);
+
+/**
+* Sets the head of the list of nontree edges stored in
+* the vertex node x
+*
+* Complexity: O(depth of x) if the list becomes empty or
+* stops being empty, O(1) otherwise
+*/
+void set_nontree_head(node_t x, int head);
+
+/**
+* Unmarks the edge nodes marked as on_level in the tree
+* rooted in x and calls f(edge) with the edge (a,b) of each
+* of them, until f returns false. A single traversal, pruned
+* by the counters, visits only the marked nodes and their
+* ancestors and clears the counters on its way back up.
+* f must not modify the tree.
+*
+* Complexity: O(k log(n/k)) plus the time of f, where k is
+* the number of marked nodes
+*/
+template <class F>
+void take_on_level(node_t x, F f);
+
+void print_tree(node_t x, int indent = 0) const;
+void print_node(node_t x, int indent = 0) const;
+
+protected:
+vector <TourNode> Nodes;
+/* first released edge pair and vertex node (or NIL) */
+node_t free_pairs, free_vertices;
+Hook *hook;
+
+void set_parent(node_t x, node_t parent);
+void init_node(node_t x, const TourNode &init);
+void replace_child(node_t x, node_t old_child, node_t new_child);
+node_t build_balanced(const node_t *seq, int k);
+
+node_t descend_to_nontree_edge(node_t x, int r = 0) const;
+node_t descend_to_on_level(node_t x) const;
+pair <int, int> unmark_on_level(node_t x);
+
+void update_on_level_cnt(node_t x, int dx);
+void update_nontree_cnt(node_t x, int dx);
+void update_aggregates(node_t x);
+void grow_nodes(size_t k);
+
+bool correct_node(node_t x, node_t correct_parent) const;
+};
+
+/**
+* Every write of a parent goes through here: find_root_concurrent
+* loads the parents while the tree changes, so the stores must be
+* atomic. A store releases the node it links to, so that a walk
+* which reaches a newly allocated node also sees it initialized;
+* on x86 both sides are plain moves.
+*/
+template <class Hook>
+inline void TourTree<Hook>::set_parent(node_t x, node_t parent) {
+__atomic_store_n(&Nodes[x].parent, parent, __ATOMIC_RELEASE);
+}
+
+template <class Hook>
+inline void TourTree<Hook>::update_aggregates(node_t x) {
+TourNode &node = Nodes[x];
+const TourNode &l = Nodes[node.left];
+const TourNode &r = Nodes[node.right];
+bool vertex = node.flags & VERTEX_NODE;
+
+node.size = l.size + r.size + (vertex ? 1 : 0);
+node.on_level_cnt = l.on_level_cnt + r.on_level_cnt +
+((node.flags & ON_LEVEL) ? 1 : 0);
+node.nontree_cnt = l.nontree_cnt + r.nontree_cnt +
+((vertex && node.aux != -1) ? 1 : 0);
+
+if constexpr (Hook::enabled) {
+if (hook != NULL)
+hook->update(x, node.left, node.right);
+}
+}
+
+template <class Hook>
+template <class F>
+void TourTree<Hook>::for_each_node(node_t x, F f) const {
+if (x == NIL)
+return;
+
+node_t cur = x;
+while (Nodes[cur].left != NIL)
+cur = Nodes[cur].left;
+
+while (true) {
+f(cur);
+
+if (Nodes[cur].right != NIL) {
+// the successor is the first node of the right subtree
+cur = Nodes[cur].right;
+while (Nodes[cur].left != NIL)
+cur = Nodes[cur].left;
+
+} else {
+// the successor is the first ancestor entered from the left
+while (cur != x && Nodes[Nodes[cur].parent].right == cur)
+cur = Nodes[cur].parent;
+if (cur == x)
+return;
+cur = Nodes[cur].parent;
+}
+}
+}
+
+/**
+* Walks down into the subtrees with marked nodes first, then
+* unmarks the node itself and goes right. A node is left (with
+* its counter zeroed) only when nothing below it is marked, so
+* the walk comes back to every node at most twice. When f asks
+* to stop, only the counters on the path back to x are stale.
+*/
+template <class Hook>
+template <class F>
+void TourTree<Hook>::take_on_level(node_t x, F f) {
+node_t cur = x;
+
+while (Nodes[x].on_level_cnt > 0) {
+TourNode &node = Nodes[cur];
+
+if (Nodes[node.left].on_level_cnt > 0) {
+cur = node.left;
+continue;
+}
+if (node.flags & ON_LEVEL) {
+node.flags &= ~ON_LEVEL;
+if (!f(pair <int, int> (Nodes[cur+1].aux, node.aux))) {
+for (node_t y = cur; y != Nodes[x].parent; y = Nodes[y].parent) {
+Nodes[y].on_level_cnt = Nodes[Nodes[y].left].on_level_cnt +
+Nodes[Nodes[y].right].on_level_cnt +
+((Nodes[y].flags & ON_LEVEL) ? 1 : 0);
+}
+return;
+}
+}
+if (Nodes[node.right].on_level_cnt > 0) {
+cur = node.right;
+continue;
+}
+
+node.on_level_cnt = 0;
+cur = node.parent;
+}
+}
+
+/**
+* An in-order walk through the nodes with nontree edges below
+* them. The node the walk came from tells which part of a node
+* comes next. Once f asks to stop, the walk only goes back up to
+* the root, fixing the counters.
+*/
+template <class Hook>
+template <class F>
+void TourTree<Hook>::scan_nontree_heads(node_t x, F f) {
+node_t cur = x, prv = Nodes[x].parent;
+bool more = true;
+
+while (cur != Nodes[x].parent) {
+node_t left = Nodes[cur].left, right = Nodes[cur].right;
+
+if (prv == Nodes[cur].parent) {
+if (more && Nodes[left].nontree_cnt > 0) {
+prv = cur;
+cur = left;
+continue;
+}
+prv = left;
+}
+
+if (prv == left) {
+if (more && (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1) {
+int head = Nodes[cur].aux;
+more = f(cur, head);
+Nodes[cur].aux = head;
+}
+if (more && Nodes[right].nontree_cnt > 0) {
+prv = cur;
+cur = right;
+continue;
+}
+}
+
+bool own = (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1;
+Nodes[cur].nontree_cnt = Nodes[left].nontree_cnt +
+Nodes[right].nontree_cnt + (own ? 1 : 0);
+prv = cur;
+cur = Nodes[cur].parent;
+}
+}
+
+/* The sequence tree Tree calling an AggregateHook */
+template <class Tree>
+using HookedTree = typename Tree::template with_hook <AggregateHook>;
+
+#endif
+using namespace std;
+
+/**
+* Splay tree implementation
+* (https://en.wikipedia.org/wiki/Splay_tree)
+* over an array of TourNodes.
+*
+* Every operation splays the node it accesses to the root, so
+* recently used parts of the Euler tours stay near the roots.
+* A merge with a middle node and a split take just a splay and
+* O(1) relinking, which makes link and cut cheap. All the bounds
+* below are amortized over a sequence of operations.
+* Hook is the policy of the extra aggregates (see TourTree).
+*/
+
+template <class Hook = NoHook>
+class BasicSplayTree : public TourTree <Hook> {
+typedef TourTree <Hook> Base;
+
+public:
+template <class OtherHook>
+using with_hook = BasicSplayTree <OtherHook>;
+
+/* every access splays the node it reaches */
+static constexpr bool self_adjusting = true;
+
+/**
+* Splits the tree into two parts and returns their roots.
+* The first part contains all nodes to the left of x
+* (inclusive), the second part contains all nodes to the
+* right of it (exclusive).
+*
+* Complexity: O(log n) (amortized)
+*/
+pair <node_t, node_t> split(node_t x);
+
+/**
+* Removes x from its tree and splits the rest of it into
+* the nodes to the left and to the right of x (exclusive)
+*
+* Complexity: O(log n) (amortized)
+*/
+pair <node_t, node_t> split_around(node_t x);
+
+/**
+* Merges two trees (left and right) into one (the middle
+* node is optional) and returns its root.
+* The order of nodes is as follows:
+* left(unchanged), middle, right(unchanged).
+*
+* Complexity if middle is NIL: O(log n) (amortized)
+* Complexity if middle is not NIL: O(1)
+*/
+node_t merge(node_t left, node_t middle, node_t right);
+
+/**
+* Splays x to the root of its tree and returns it
+*
+* Complexity: O(log n) (amortized)
+*/
+node_t root(node_t x);
+
+/**
+* Checks whether x and y belong to the same tree
+*
+* Complexity: O(log n) (amortized)
+*/
+bool same_tree(node_t x, node_t y);
+
+/**
+* Removes x from the tree it belongs to
+*
+* Complexity: O(log n) (amortized)
+*/
+void unlink(node_t x);
+
+/**
+* Builds a tree from the single-node trees seq[0..k-1]
+* (in this order) and returns its root
+*
+* Complexity: O(k)
+*/
+node_t build(const node_t *seq, int k);
+
+/**
+* As in TourTree, but every node found is splayed to the root
+* (which pays for the descent to it) and the next one is
+* looked for from there
+*/
+node_t find_nontree_edge(node_t x, int r);
+template <class F>
+void scan_nontree_heads(node_t x, F f);
+template <class F>
+void take_on_level(node_t x, F f);
+void set_nontree_head(node_t x, int head);
+
+/**
+* Checks if the invariants hold in the subtree of x
+*
+* Complexity: linear in the size of the tree
+*/
+bool correct_tree(node_t x, node_t correct_parent) const;
+
+private:
+using Base::Nodes;
+using Base::set_parent;
+using Base::update_aggregates;
+using Base::replace_child;
+using Base::build_balanced;
+using Base::correct_node;
+using Base::descend_to_nontree_edge;
+using Base::descend_to_on_level;
+using Base::unmark_on_level;
+
+void rotate(node_t x);
+void splay(node_t x);
+};
+
+template <class Hook>
+template <class F>
+void BasicSplayTree<Hook>::scan_nontree_heads(node_t x, F f) {
+node_t v = descend_to_nontree_edge(x);
+while (v != NIL) {
+splay(v);
+int head = Nodes[v].aux;
+bool more = f(v, head);
+
+// f may have splayed other nodes
+set_nontree_head(v, head);
+if (!more)
+return;
+v = descend_to_nontree_edge(v);
+}
+}
+
+template <class Hook>
+template <class F>
+void BasicSplayTree<Hook>::take_on_level(node_t x, F f) {
+node_t cur = descend_to_on_level(x);
+while (cur != NIL) {
+splay(cur);
+if (!f(unmark_on_level(cur)))
+return;
+cur = descend_to_on_level(cur);
+}
+}
+
+typedef BasicSplayTree <> SplayTree;
+
+#endif
+#ifndef TREAP_HPP
+#define TREAP_HPP
+
+#include <utility>
+#ifndef TOUR_TREE_HPP
+#define TOUR_TREE_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <cassert>
+using namespace std;
+
+// A switch for managing debug output
+// #define DBG
+#ifdef DBG
+#define debug(...) fprintf(stderr, __VA_ARGS__), fflush(stderr)
+#else
+#define debug(...) {}
+#endif
+
+/* Nodes are addressed by 32-bit indices into the node array */
+typedef uint32_t node_t;
+
+/* Index of the sentinel node, which stands for an empty tree */
+const node_t NIL = 0;
+
+enum NodeFlags : uint8_t {
+/* the node represents a vertex (otherwise a tree edge) */
+VERTEX_NODE = 1,
+/* the node is a tree edge on the level of the forest */
+ON_LEVEL = 2
+};
+
+/**
+* A node of an Euler tour: either a vertex or one direction
+* of a tree edge (see et_trees.hpp). All the fields used while
+* restructuring the tree are packed into 32 bytes, so two nodes
+* share a cache line.
+*/
+struct TourNode {
+node_t left, right, parent;
+
+/* number of vertex nodes in the subtree of this node */
+int size;
+/* number of vertex nodes in the subtree storing nontree edges */
+int nontree_cnt;
+/* number of ON_LEVEL edge nodes in the subtree */
+int on_level_cnt;
+
+/**
+* Vertex nodes: the first record of the list of nontree
+* edges of the vertex (-1 if it is empty, see et_trees.hpp)
+* Edge nodes: the vertex the edge leads to
+*/
+int aux;
+
+/* height of the subtree (maintained only by AVLTree) */
+uint8_t height;
+uint8_t flags;
+};
+
+/**
+* Extra aggregates of the subtrees, maintained outside of the
+* nodes on behalf of a user of a forest: update(x, left, right)
+* is called whenever the aggregates of the node x are recomputed
+* from those of its children (NIL for a missing child).
+* Before a node past the array of nodes is updated, resize(k)
+* tells that the forest has grown to k nodes; update itself must
+* not grow the storage, as a forest may recompute the nodes of
+* different trees on several threads at once (see ETTForest::
+* link_batch and ETTForest::plan_cuts) and update may only write
+* the aggregates of x.
+*
+* The hook is a policy of the sequence trees (see TourTree):
+* only the trees instantiated with AggregateHook call it.
+*/
+class AggregateHook {
+public:
+static constexpr bool enabled = true;
+
+virtual void update(node_t x, node_t left, node_t right) = 0;
+virtual void resize(size_t) {}
+virtual ~AggregateHook() {}
+};
+
+/* The hook policy of the trees without extra aggregates */
+struct NoHook {
+static constexpr bool enabled = false;
+};
+
+/**
+* The part of a balanced sequence tree which does not depend on
+* the balancing scheme: the array of TourNodes owned by a forest,
+* allocation of nodes and the aggregates stored in them.
+*
+* Node 0 is a sentinel (NIL) whose aggregates are all zero, so
+* they can be summed without checking for missing children. Edge
+* nodes are allocated in pairs (e, e+1), one for each direction
+* of the edge; released nodes are reused before the array grows.
+*
+* ETTForest (et_trees.hpp) takes the sequence tree as a template
+* parameter. Besides the methods below, a sequence tree provides:
+*
+*   pair <node_t, node_t> split(node_t x);
+*   pair <node_t, node_t> split_around(node_t x);
+*   node_t merge(node_t left, node_t middle, node_t right);
+*   node_t root(node_t x);
+*   bool same_tree(node_t x, node_t y);
+*   void unlink(node_t x);
+*   node_t build(const node_t *seq, int k);
+*   bool correct_tree(node_t x, node_t correct_parent) const;
+*
+* with the semantics documented in avl_tree.hpp, and the alias
+*
+*   template <class OtherHook> using with_hook = ...;
+*
+* for the same tree with another hook policy. A sequence tree
+* may restructure the tree in any of them (even in root), so a
+* root returned by one call is only valid until the next one.
+* Only a tree which sets self_adjusting does so in root,
+* same_tree and find_nontree_edge; in the others, these only
+* read the tree and may run on several threads at once.
+* Implementations: AVLTree (avl_tree.hpp), SplayTree
+* (splay_tree.hpp) and Treap (treap.hpp).
+*
+* The Hook parameter is NoHook or AggregateHook. With NoHook,
+* the call of the hook is compiled out of every recomputation
+* of the aggregates; the trees are compiled for both policies
+* and HookedTree below names the one calling a hook.
+*/
+
+template <class Hook>
+class TourTree {
+public:
+typedef Hook hook_type;
+
+/* whether the queries restructure the tree (see above) */
+static constexpr bool self_adjusting = false;
+
+/* the number of walks of find_roots in flight */
+static constexpr int ROOT_WALKS = 32;
+
+TourTree();
+
+/**
+* Creates a new single-node tree representing a vertex
+* Complexity: O(1) (amortized)
+*/
+node_t new_vertex_node();
+
+/**
+* Releases the vertex node x, which must form
+* a single-node tree
+* Complexity: O(1)
+*/
+void free_vertex_node(node_t x);
+
+/**
+* Creates two single-node trees: e representing the edge
+* (a,b) (on the level if on_level is set) and e+1
+* representing the edge (b,a). Returns e.
+* Complexity: O(1) (amortized)
+*/
+node_t new_edge_nodes(int a, int b, bool on_level);
+
+/**
+* Releases the pair of edge nodes starting at e
+* Both of them must already be unlinked
+* Complexity: O(1)
+*/
+void free_edge_nodes(node_t e);
+
+const TourNode &operator[](node_t x) const {
+return Nodes[x];
+}
+
+/**
+* Sets the hook maintaining extra aggregates (or turns them
+* off if hook is NULL) and tells it the number of nodes.
+* The aggregates of the existing nodes are not recomputed.
+* With NoHook, the hook is never called.
+* Complexity: O(1) besides the resize of the hook
+*/
+void set_aggregate_hook(Hook *_hook);
+
+/**
+* Sets key to a number ordering x among the nodes of its
+* tree as the sequence does and root to the root of the
+* tree, without restructuring the tree. Returns false (and
+* no key) if x is deeper than MAX_KEY_DEPTH, as its path from
+* the root does not fit in the key then.
+* Complexity: O(depth of x)
+*/
+bool order_key(node_t x, uint64_t &key, node_t &root) const;
+static constexpr int MAX_KEY_DEPTH = 62;
+
+/**
+* Recomputes the aggregates of x and all its ancestors
+* Complexity: O(depth of x)
+*/
+void update_path(node_t x);
+
+/**
+* Returns the root of the tree containing x without
+* restructuring the tree (for diagnostics)
+*
+* Complexity: O(depth of x)
+*/
+node_t find_root(node_t x) const;
+
+/**
+* Like find_root, but loads the parent pointers atomically
+* (see set_parent), so that it may run while another thread
+* restructures the tree. The result is then meaningless and
+* must be validated by the caller (see SeqLock in
+* seqlock.hpp). Gives up and
+* returns NIL after limit steps, as a concurrent rotation may
+* close a cycle of parent pointers for a moment.
+*
+* Complexity: O(min(depth of x, limit))
+*/
+node_t find_root_concurrent(node_t x, int limit) const;
+
+/**
+* Sets roots[i] to find_root(xs[i]) for all i < k. Up to
+* ROOT_WALKS walks advance in lock-step, each prefetching
+* the next node on its path, so that the cache misses of
+* different walks overlap; a finished walk is replaced by
+* the next one right away.
+*
+* Complexity: O(sum of the depths of the nodes)
+*/
+void find_roots(const node_t *xs, int k, node_t *roots) const;
+
+/**
+* Reserves memory for k nodes (including NIL), so that the
+* array of nodes is not reallocated while it holds at most
+* k of them
+*
+* Complexity: O(k)
+*/
+void reserve(int k);
+
+/**
+* Appends the nodes of the tree rooted in x to seq (in
+* order) and turns each of them into a single-node tree
+* (to be reassembled with build)
+*
+* Complexity: O(size of the tree)
+*/
+void flatten(node_t x, vector <node_t> &seq);
+
+/**
+* Calls f(y) for every node y of the tree rooted in x, in
+* order, walking the parent pointers (without restructuring
+* the tree or allocating memory)
+*
+* Complexity: O(size of the tree)
+*/
+template <class F>
+void for_each_node(node_t x, F f) const;
+
+/**
+* Returns the r-th (from 0, in order) vertex node storing
+* nontree edges in the tree rooted in x or NIL if there are
+* at most r of them
+*
+* Complexity: O(height of the tree)
+*/
+node_t find_nontree_edge(node_t x, int r);
+
+/**
+* Calls f(v, head) for the vertex nodes v storing nontree
+* edges in the tree rooted in x, in order. head is the list
+* of v, which f may shorten by setting it to its remaining
+* part; f returns false to end the traversal. f must not
+* restructure the tree, but it may set the lists of other
+* vertex nodes (with set_nontree_head).
+*
+* The counters of the nodes above the lists emptied by f
+* are recomputed once, when the traversal leaves them.
+*
+* Complexity: O(k log(n/k)) plus the time of f, where k is
+* the number of vertex nodes visited
+*/
+template <class F>
+void scan_nontree_heads(node_t x, F f);
+
+/**
+* Sets the head of the list of nontree edges stored in
+* the vertex node x
+*
+* Complexity: O(depth of x) if the list becomes empty or
+* stops being empty, O(1) otherwise
+*/
+void set_nontree_head(node_t x, int head);
+
+/**
+* Unmarks the edge nodes marked as on_level in the tree
+* rooted in x and calls f(edge) with the edge (a,b) of each
+* of them, until f returns false. A single traversal, pruned
+* by the counters, visits only the marked nodes and their
+* ancestors and clears the counters on its way back up.
+* f must not modify the tree.
+*
+* Complexity: O(k log(n/k)) plus the time of f, where k is
+* the number of marked nodes
+*/
+template <class F>
+void take_on_level(node_t x, F f);
+
+void print_tree(node_t x, int indent = 0) const;
+void print_node(node_t x, int indent = 0) const;
+
+protected:
+vector <TourNode> Nodes;
+/* first released edge pair and vertex node (or NIL) */
+node_t free_pairs, free_vertices;
+Hook *hook;
+
+void set_parent(node_t x, node_t parent);
+void init_node(node_t x, const TourNode &init);
+void replace_child(node_t x, node_t old_child, node_t new_child);
+node_t build_balanced(const node_t *seq, int k);
+
+node_t descend_to_nontree_edge(node_t x, int r = 0) const;
+node_t descend_to_on_level(node_t x) const;
+pair <int, int> unmark_on_level(node_t x);
+
+void update_on_level_cnt(node_t x, int dx);
+void update_nontree_cnt(node_t x, int dx);
+void update_aggregates(node_t x);
+void grow_nodes(size_t k);
+
+bool correct_node(node_t x, node_t correct_parent) const;
+};
+
+/**
+* Every write of a parent goes through here: find_root_concurrent
+* loads the parents while the tree changes, so the stores must be
+* atomic. A store releases the node it links to, so that a walk
+* which reaches a newly allocated node also sees it initialized;
+* on x86 both sides are plain moves.
+*/
+template <class Hook>
+inline void TourTree<Hook>::set_parent(node_t x, node_t parent) {
+__atomic_store_n(&Nodes[x].parent, parent, __ATOMIC_RELEASE);
+}
+
+template <class Hook>
+inline void TourTree<Hook>::update_aggregates(node_t x) {
+TourNode &node = Nodes[x];
+const TourNode &l = Nodes[node.left];
+const TourNode &r = Nodes[node.right];
+bool vertex = node.flags & VERTEX_NODE;
+
+node.size = l.size + r.size + (vertex ? 1 : 0);
+node.on_level_cnt = l.on_level_cnt + r.on_level_cnt +
+((node.flags & ON_LEVEL) ? 1 : 0);
+node.nontree_cnt = l.nontree_cnt + r.nontree_cnt +
+((vertex && node.aux != -1) ? 1 : 0);
+
+if constexpr (Hook::enabled) {
+if (hook != NULL)
+hook->update(x, node.left, node.right);
+}
+}
+
+template <class Hook>
+template <class F>
+void TourTree<Hook>::for_each_node(node_t x, F f) const {
+if (x == NIL)
+return;
+
+node_t cur = x;
+while (Nodes[cur].left != NIL)
+cur = Nodes[cur].left;
+
+while (true) {
+f(cur);
+
+if (Nodes[cur].right != NIL) {
+// the successor is the first node of the right subtree
+cur = Nodes[cur].right;
+while (Nodes[cur].left != NIL)
+cur = Nodes[cur].left;
+
+} else {
+// the successor is the first ancestor entered from the left
+while (cur != x && Nodes[Nodes[cur].parent].right == cur)
+cur = Nodes[cur].parent;
+if (cur == x)
+return;
+cur = Nodes[cur].parent;
+}
+}
+}
+
+/**
+* Walks down into the subtrees with marked nodes first, then
+* unmarks the node itself and goes right. A node is left (with
+* its counter zeroed) only when nothing below it is marked, so
+* the walk comes back to every node at most twice. When f asks
+* to stop, only the counters on the path back to x are stale.
+*/
+template <class Hook>
+template <class F>
+void TourTree<Hook>::take_on_level(node_t x, F f) {
+node_t cur = x;
+
+while (Nodes[x].on_level_cnt > 0) {
+TourNode &node = Nodes[cur];
+
+if (Nodes[node.left].on_level_cnt > 0) {
+cur = node.left;
+continue;
+}
+if (node.flags & ON_LEVEL) {
+node.flags &= ~ON_LEVEL;
+if (!f(pair <int, int> (Nodes[cur+1].aux, node.aux))) {
+for (node_t y = cur; y != Nodes[x].parent; y = Nodes[y].parent) {
+Nodes[y].on_level_cnt = Nodes[Nodes[y].left].on_level_cnt +
+Nodes[Nodes[y].right].on_level_cnt +
+((Nodes[y].flags & ON_LEVEL) ? 1 : 0);
+}
+return;
+}
+}
+if (Nodes[node.right].on_level_cnt > 0) {
+cur = node.right;
+continue;
+}
+
+node.on_level_cnt = 0;
+cur = node.parent;
+}
+}
+
+/**
+* An in-order walk through the nodes with nontree edges below
+* them. The node the walk came from tells which part of a node
+* comes next. Once f asks to stop, the walk only goes back up to
+* the root, fixing the counters.
+*/
+template <class Hook>
+template <class F>
+void TourTree<Hook>::scan_nontree_heads(node_t x, F f) {
+node_t cur = x, prv = Nodes[x].parent;
+bool more = true;
+
+while (cur != Nodes[x].parent) {
+node_t left = Nodes[cur].left, right = Nodes[cur].right;
+
+if (prv == Nodes[cur].parent) {
+if (more && Nodes[left].nontree_cnt > 0) {
+prv = cur;
+cur = left;
+continue;
+}
+prv = left;
+}
+
+if (prv == left) {
+if (more && (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1) {
+int head = Nodes[cur].aux;
+more = f(cur, head);
+Nodes[cur].aux = head;
+}
+if (more && Nodes[right].nontree_cnt > 0) {
+prv = cur;
+cur = right;
+continue;
+}
+}
+
+bool own = (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1;
+Nodes[cur].nontree_cnt = Nodes[left].nontree_cnt +
+Nodes[right].nontree_cnt + (own ? 1 : 0);
+prv = cur;
+cur = Nodes[cur].parent;
+}
+}
+
+/* The sequence tree Tree calling an AggregateHook */
+template <class Tree>
+using HookedTree = typename Tree::template with_hook <AggregateHook>;
+
+#endif
+using namespace std;
+
+/**
+* Treap implementation (https://en.wikipedia.org/wiki/Treap)
+* over an array of TourNodes.
+*
+* The tree is a binary search tree by the order of nodes and
+* a max-heap by their priorities. Priorities are computed by
+* hashing node indices, so they take no space in the nodes.
+* Split and merge never rotate: they only relink the nodes on
+* the paths they walk. All the bounds below are expected.
+* Hook is the policy of the extra aggregates (see TourTree).
+*/
+
+template <class Hook = NoHook>
+class BasicTreap : public TourTree <Hook> {
+typedef TourTree <Hook> Base;
+
+public:
+template <class OtherHook>
+using with_hook = BasicTreap <OtherHook>;
+
+using Base::find_root;
+
+/**
+* Splits the tree into two parts and returns their roots.
+* The first part contains all nodes to the left of x
+* (inclusive), the second part contains all nodes to the
+* right of it (exclusive).
+*
+* Complexity: O(log n)
+*/
+pair <node_t, node_t> split(node_t x);
+
+/**
+* Removes x from its tree and splits the rest of it into
+* the nodes to the left and to the right of x (exclusive)
+*
+* Complexity: O(log n)
+*/
+pair <node_t, node_t> split_around(node_t x);
+
+/**
+* Merges two trees (left and right) into one (the middle
+* node is optional) and returns its root.
+* The order of nodes is as follows:
+* left(unchanged), middle, right(unchanged).
+*
+* Complexity: O(log n)
+*/
+node_t merge(node_t left, node_t middle, node_t right);
+
+/**
+* Returns the root of the tree containing x
+*
+* Complexity: O(log n)
+*/
+node_t root(node_t x) const;
+
+/**
+* Checks whether x and y belong to the same tree
+*
+* Complexity: O(log n)
+*/
+bool same_tree(node_t x, node_t y) const;
+
+/**
+* Removes x from the tree it belongs to
+*
+* Complexity: O(log n)
+*/
+void unlink(node_t x);
+
+/**
+* Builds a tree from the single-node trees seq[0..k-1]
+* (in this order) and returns its root
+*
+* Complexity: O(k)
+*/
+node_t build(const node_t *seq, int k);
+
+/**
+* Checks if the invariants hold in the subtree of x
+*
+* Complexity: linear in the size of the tree
+*/
+bool correct_tree(node_t x, node_t correct_parent) const;
+
+private:
+using Base::Nodes;
+using Base::set_parent;
+using Base::update_aggregates;
+using Base::replace_child;
+using Base::correct_node;
+
+static uint32_t priority(node_t x);
+node_t join(node_t left, node_t right);
+pair <node_t, node_t> split_path(node_t x, node_t left_tree,
+node_t right_tree);
+};
+
+/* The finalizer of MurmurHash3, which mixes consecutive indices well */
+template <class Hook>
+inline uint32_t BasicTreap<Hook>::priority(node_t x) {
+uint32_t h = x;
+h ^= h >> 16;
+h *= 0x85ebca6b;
+h ^= h >> 13;
+h *= 0xc2b2ae35;
+h ^= h >> 16;
+return h;
+}
+
+typedef BasicTreap <> Treap;
+
+#endif
+#ifndef EDGE_TABLE_HPP
+#define EDGE_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+using namespace std;
+
+/* Packs the undirected edge (a,b) into a 64-bit key */
+inline uint64_t edge_key(int a, int b) {
+if (a > b)
+swap(a, b);
+return (uint64_t(uint32_t(a)) << 32) | uint32_t(b);
+}
+
+/* Fibonacci hashing: the top bits of the product are well mixed */
+inline size_t edge_hash(uint64_t key, int shift) {
+return (key * 0x9E3779B97F4A7C15ULL) >> shift;
+}
+
+/**
+* Hash table mapping undirected edges to values of type Info.
+*
+* Uses open addressing with linear probing over a single array
+* of slots, each holding the edge together with its value, so a
+* lookup touches one or two cache lines. The edge is stored as
+* two 32-bit endpoints, so that a slot is aligned only as the
+* value: with a 4-byte value, a slot takes 12 bytes instead of
+* 16.
+* Erased slots are filled by shifting the following entries
+* back (no tombstones), so probe sequences stay short under
+* any mix of insertions and deletions.
+*
+* Pointers returned by find and insert stay valid until the
+* next call to insert or erase.
+*/
+
+template <class Info>
+class EdgeTable {
+public:
+
+EdgeTable() {
+count = 0;
+shift = 64 - 4;
+Slots.assign(size_t(1) << (64 - shift), Slot(EMPTY));
+}
+
+/**
+* Returns the value stored for the (a,b) edge
+* or NULL if there is none
+* Complexity: O(1) (expected)
+*/
+Info *find(int a, int b) {
+size_t i = probe(edge_key(a, b));
+return Slots[i].key() == EMPTY ? NULL : &Slots[i].info;
+}
+
+/**
+* Returns the value stored for the (a,b) edge, creating
+* a value-initialized entry if there is none
+* Complexity: O(1) (expected, amortized)
+*/
+Info *insert(int a, int b) {
+uint64_t key = edge_key(a, b);
+
+// keep the load factor at most 1/2
+if (2 * (size_t(count) + 1) > Slots.size())
+rehash(shift - 1);
+
+size_t i = probe(key);
+if (Slots[i].key() == EMPTY) {
+Slots[i] = Slot(key);
+count++;
+}
+return &Slots[i].info;
+}
+
+/**
+* Removes the entry pointed to by info (obtained from find
+* or insert) from the table
+* Complexity: O(1) (expected)
+*/
+void erase(Info *info);
+
+/**
+* Makes room for the given number of edges, so that
+* inserting them does not trigger any further rehashing
+* Complexity: O(edges + size of the table)
+*/
+void reserve(int edges) {
+int new_shift = shift;
+while (2 * size_t(edges) > (size_t(1) << (64 - new_shift)))
+new_shift--;
+if (new_shift != shift)
+rehash(new_shift);
+}
+
+/* Returns the number of edges stored in the table */
+int size() {
+return count;
+}
+
+/**
+* Calls f(a, b, info) for every entry, where (a,b) is the
+* edge with a <= b
+* Complexity: O(capacity of the table)
+*/
+template <class F>
+void for_each(F f) {
+for (Slot &slot: Slots) {
+if (slot.key() != EMPTY)
+f(int(slot.a), int(slot.b), slot.info);
+}
+}
+
+private:
+struct Slot {
+/* the endpoints a <= b, both UINT32_MAX in an empty slot */
+uint32_t a, b;
+Info info;
+
+Slot(uint64_t key) : a(uint32_t(key >> 32)), b(uint32_t(key)), info() {}
+
+uint64_t key() const {
+return (uint64_t(a) << 32) | b;
+}
+};
+
+static constexpr uint64_t EMPTY = UINT64_MAX;
+
+vector <Slot> Slots;
+int count;
+int shift;
+
+size_t home(uint64_t key) {
+return edge_hash(key, shift);
+}
+
+/**
+* Returns the index of the slot holding key or of the empty
+* slot that ends its probe sequence.
+*/
+size_t probe(uint64_t key) {
+size_t mask = Slots.size() - 1;
+size_t i = home(key);
+while (Slots[i].key() != EMPTY && Slots[i].key() != key) {
+i = (i + 1) & mask;
+}
+return i;
+}
+
+void rehash(int new_shift);
+};
+
+/**
+* Backward shift deletion: walks the cluster following the
+* erased slot and moves back every entry whose home position
+* does not lie cyclically between the hole and the entry.
+*/
+template <class Info>
+void EdgeTable<Info>::erase(Info *info) {
+Slot *slot = reinterpret_cast<Slot*>(
+reinterpret_cast<char*>(info) - offsetof(Slot, info));
+size_t mask = Slots.size() - 1;
+size_t hole = slot - Slots.data();
+
+for (size_t j = (hole + 1) & mask; Slots[j].key() != EMPTY; j = (j + 1) & mask) {
+size_t h = home(Slots[j].key());
+
+bool movable = (hole <= j) ? (h <= hole || h > j)
+: (h <= hole && h > j);
+if (movable) {
+Slots[hole] = Slots[j];
+hole = j;
+}
+}
+
+Slots[hole].a = Slots[hole].b = UINT32_MAX;
+count--;
+}
+
+template <class Info>
+void EdgeTable<Info>::rehash(int new_shift) {
+vector <Slot> old_slots;
+old_slots.swap(Slots);
+
+shift = new_shift;
+Slots.assign(size_t(1) << (64 - shift), Slot(EMPTY));
+
+for (Slot &slot: old_slots) {
+if (slot.key() != EMPTY)
+Slots[probe(slot.key())] = slot;
+}
+}
+
+/**
+* Hash index of edges stored outside of it, e.g. in the nodes
+* of a forest. A slot holds only the handle of an edge (0 marks
+* an empty slot and is never a handle), and the endpoints of a
+* handle h are read from endpoints(h), a function passed to
+* every call which needs them.
+*
+* The layout is that of EdgeTable, but a slot takes only the 4
+* bytes of a handle; in exchange, every probe of a lookup reads
+* the endpoints of the handle it passes. The endpoints of a
+* handle must not change while it is in the index.
+*/
+
+template <class Handle>
+class EdgeIndex {
+public:
+
+EdgeIndex() {
+count = 0;
+shift = 64 - 4;
+Slots.assign(size_t(1) << (64 - shift), 0);
+}
+
+/**
+* Returns the handle of the (a,b) edge or 0 if there is none
+* Complexity: O(1) (expected)
+*/
+template <class F>
+Handle find(int a, int b, F endpoints) const {
+uint64_t key = edge_key(a, b);
+size_t mask = Slots.size() - 1;
+size_t i = edge_hash(key, shift);
+while (Slots[i] != 0 && key_of(Slots[i], endpoints) != key)
+i = (i + 1) & mask;
+return Slots[i];
+}
+
+/**
+* Adds the edge with handle h, which must not be in the
+* index yet
+* Complexity: O(1) (expected, amortized)
+*/
+template <class F>
+void insert(Handle h, F endpoints) {
+// keep the load factor at most 1/2
+if (2 * (size_t(count) + 1) > Slots.size())
+rehash(shift - 1, endpoints);
+
+Slots[free_slot(key_of(h, endpoints))] = h;
+count++;
+}
+
+/**
+* Removes the edge with handle h from the index
+* Complexity: O(1) (expected)
+*/
+template <class F>
+void erase(Handle h, F endpoints);
+
+/**
+* Makes room for the given number of edges, so that
+* inserting them does not trigger any further rehashing
+* Complexity: O(edges + size of the index)
+*/
+template <class F>
+void reserve(int edges, F endpoints) {
+int new_shift = shift;
+while (2 * size_t(edges) > (size_t(1) << (64 - new_shift)))
+new_shift--;
+if (new_shift != shift)
+rehash(new_shift, endpoints);
+}
+
+/* Returns the number of edges in the index */
+int size() const {
+return count;
+}
+
+private:
+vector <Handle> Slots;
+int count;
+int shift;
+
+template <class F>
+static uint64_t key_of(Handle h, F endpoints) {
+pair <int, int> edge = endpoints(h);
+return edge_key(edge.first, edge.second);
+}
+
+/* Returns the first empty slot of the probe sequence of key */
+size_t free_slot(uint64_t key) const {
+size_t mask = Slots.size() - 1;
+size_t i = edge_hash(key, shift);
+while (Slots[i] != 0)
+i = (i + 1) & mask;
+return i;
+}
+
+template <class F>
+void rehash(int new_shift, F endpoints);
+};
+
+/* Backward shift deletion, as in EdgeTable::erase */
+template <class Handle>
+template <class F>
+void EdgeIndex<Handle>::erase(Handle h, F endpoints) {
+size_t mask = Slots.size() - 1;
+size_t hole = edge_hash(key_of(h, endpoints), shift);
+while (Slots[hole] != h)
+hole = (hole + 1) & mask;
+
+for (size_t j = (hole + 1) & mask; Slots[j] != 0; j = (j + 1) & mask) {
+size_t home = edge_hash(key_of(Slots[j], endpoints), shift);
+
+bool movable = (hole <= j) ? (home <= hole || home > j)
+: (home <= hole && home > j);
+if (movable) {
+Slots[hole] = Slots[j];
+hole = j;
+}
+}
+
+Slots[hole] = 0;
+count--;
+}
+
+template <class Handle>
+template <class F>
+void EdgeIndex<Handle>::rehash(int new_shift, F endpoints) {
+vector <Handle> old_slots;
+old_slots.swap(Slots);
+
+shift = new_shift;
+Slots.assign(size_t(1) << (64 - shift), 0);
+
+for (Handle h: old_slots) {
+if (h != 0)
+Slots[free_slot(key_of(h, endpoints))] = h;
+}
+}
+
+#endif
+using namespace std;
+
+/**
+* One direction of a nontree edge, stored in the list of its
+* source vertex (headed in the vertex node). The lists are
+* intrusive and index based: prev and next are indices of
+* records in the same pool (-1 marks the ends of a list). The
+* two directions of an edge are allocated together at indices
+* 2k and 2k+1, so the record of the opposite direction is
+* always at index r ^ 1 and its target is the source of r.
+*/
+struct NontreeRecord {
+int to;
+int prev, next;
+};
+
+/**
+* Position of a walk over the nontree edges of the connected
+* component of vertex (see next_nontree_edge): the number of
+* vertices with nontree edges visited so far and the current
+* record on the list of the last one (-1 before the first).
+*/
+struct NontreeCursor {
+int vertex;
+int rank = 0;
+int record = -1;
+};
+
+/**
+* Euler Tour Tree Forest data structure for storing a forest
+* over n vertices.
+*
+* Each tree is represented as an Euler tour stored on a balanced
+* sequence tree given by the Tree parameter: AVLTree, SplayTree
+* or Treap (see tour_tree.hpp). An Euler tour is formed by two edge nodes
+* for every tree edge (one in each direction) and a single
+* vertex node for each vertex. Since an Euler tour visits a
+* vertex the same number of times as its degree, there may be
+* many possible positions for a vertex node in the Euler tour.
+* For example, the following a two Euler tours are equivalent:
+* (0,1) ~ (1) ~ (1, 4) ~ (4) ~ (4,1) ~ (1,0)
+* (0,1) ~ (1, 4) ~ (4) ~ (4,1) ~ (1) ~ (1,0)
+*
+* A sparse forest creates the node of a vertex only when the
+* first edge incident to it is stored, and releases it as soon
+* as the vertex is isolated again (a vertex without a node is
+* a single-vertex tree). This keeps the memory of a forest
+* proportional to the number of edges it stores. The nodes of
+* the vertices are found through a hash table, until so many
+* vertices have nodes that an array indexed by the vertices
+* (4 bytes per vertex) takes less memory.
+*/
+
+template <class Tree>
+class ETTForest {
+public:
+
+/**
+* Initializes the data structure for a n-vertex graph
+* Complexity: O(n) for a dense forest, O(1) for a sparse one
+*/
+ETTForest(int n, bool sparse = false);
+
+/**
+* Checks whether the forest stores no edges
+* Complexity: O(1)
+*/
+bool empty();
+
+/**
+* Stores a nontree edge (a,b) and returns its handle, which
+* identifies the edge in remove_nontree_edge
+* a and b (a != b) already need to be in the same connected
+* component
+* Complexity: O(log n)
+*/
+int insert_nontree_edge(int a, int b);
+
+/**
+* Stores a batch of nontree edges like insert_nontree_edge
+* and sets handles[i] to the handle of the i-th one. The
+* handles and the nodes of the endpoints are allocated on
+* the calling thread; the records are then pushed on the
+* lists of their vertices in parallel, one tree at a time
+* per thread (see set_threads).
+* Complexity: O(k (log n + log k)) where k is the number of
+* edges; O(k log k) of it on the calling thread
+*/
+void insert_nontree_edges(const vector <pair <int, int> > &edges,
+vector <int> &handles);
+
+/**
+* Adds a tree edge (a,b) and marks it as being on the
+* level equal to the level of the forest (on_level == true)
+* or on a level above it (on_level == false)
+* Returns the sizes of the trees of a and b it joined.
+*
+* a and b need to be in different connected components
+* Compexity: O(log n)
+*/
+pair <int, int> insert_tree_edge(int a, int b, bool on_level);
+
+/**
+* Adds all edges of a forest as tree edges on the level of
+* the forest, which must not store any tree edges yet.
+* Each tree is laid out by a single DFS and its Euler tour
+* is built bottom-up, without any splits or merges.
+* Complexity: O(n + k) where k is the number of edges
+*/
+void build_trees(const vector <pair <int, int> > &edges);
+
+/**
+* Adds a batch of tree edges on the level of the forest.
+* Every edge must join two different trees and the edges
+* must not form a cycle over the trees.
+*
+* In each group of trees joined by the batch, the largest
+* tree stays in place and is split once per vertex where
+* others are attached. All the other trees are flattened and
+* their Euler tours are rebuilt together with the new edges,
+* so no tree is split or merged more than once per batch.
+* The groups are flattened, rebuilt and linked in parallel
+* (see set_threads).
+* Complexity: O(k log n + s) where k is the number of edges
+* and s is the total size of the trees that are not the
+* largest in their group
+*/
+void link_batch(const vector <pair <int, int> > &edges);
+
+/**
+* Adds a batch of tree edges like insert_tree_edge, under the
+* conditions of link_batch. The nodes of the edges are
+* allocated and indexed on the calling thread. The edges are
+* then grouped by the trees they join and the edges of each
+* group are linked one by one, the groups in parallel (see
+* set_threads). Unlike link_batch, an edge costs O(log n)
+* whatever the sizes of the trees it joins, which suits
+* many edges joining a few large trees.
+* Complexity: O(k (log n + log k)) where k is the number of
+* edges; O(k log k) of it on the calling thread
+*/
+void insert_tree_edges(const vector <pair <int, int> > &edges, bool on_level);
+
+/**
+* Sets the number of threads the batches (link_batch,
+* plan_cuts and the others) may use (1, the default, keeps
+* them on the calling thread). The groups of trees joined by
+* a batch share no nodes, so each of them is flattened,
+* rebuilt and attached to its largest tree by one thread;
+* plan_cuts places the nodes of the edges in their tours in
+* parallel and plans the rounds only with more than one
+* thread. The other batches work on different trees in
+* parallel.
+* Complexity: O(1)
+*/
+void set_threads(int _threads);
+
+/**
+* Returns an identifier of the tree containing v which
+* stays valid until the forest is modified, or NIL if v
+* is isolated and has no node in a sparse forest
+* Complexity: O(depth of the node of v)
+*/
+node_t tree_id(int v);
+
+/**
+* Returns the number of vertices of the tree with the given
+* identifier (see tree_id)
+* Complexity: O(1)
+*/
+int tree_size(node_t id) const;
+
+/**
+* Calls f(edge) for the tree edges on the level of the forest
+* in the connected component containing a and marks them as
+* being on a level above the forest, in a single traversal
+* of its Euler tour, until f returns false (the edge passed
+* to it is marked all the same). f must not modify the forest.
+*
+* Complexity: O(log n + k log(n/k)) where k is the number of
+* tree edges being promoted
+*/
+template <class F>
+void promote_tree_edges(int a, F f);
+
+/**
+* Removes a tree edge (a,b) from the forest
+* Returns the sizes of the resulting trees of a and b.
+* Complexity: O(log n)
+*/
+pair <int, int> remove_tree_edge(int a, int b);
+
+/**
+* Plans the removal of the first k tree edges of the list,
+* carried out in rounds: each round runs cut_task(i) for all
+* i < cut_tasks() and is followed by next_cut_round, until
+* there are no tasks left; finish_cuts completes the plan.
+* No other calls may come in between.
+*
+* The nodes of the edges are ordered by their places in the
+* tours (see TourTree::order_key) and every tour is split
+* around all of them by halving: a task splits one piece of
+* the tour around its middle planned node. The pieces are
+* then assigned to the new tours by the nesting of the pairs
+* of edge nodes, and the pieces of each new tour are merged
+* pairwise, halving their number in every round. The tasks
+* of a round touch disjoint trees, so they may run on
+* different threads at once, also with an aggregate hook.
+* A tour containing a node too deep for its key (possible in
+* a splay tree) has its edges cut right away, one by one, and
+* so have all the tours on one thread (see set_threads).
+*
+* Complexity: O(k (log n + log k)) in total, in O(log k)
+* rounds of tasks of O(log n) each; the ordering of the nodes
+* and the assignment of the pieces take O(k log k) and O(k)
+* on one thread
+*/
+void plan_cuts(const vector <pair <int, int> > &edges, size_t k);
+
+/**
+* Returns the number of tasks of the current round of the
+* plan (0 when all the cuts are made)
+* Complexity: O(1)
+*/
+int cut_tasks() const;
+
+/**
+* Runs the i-th task of the current round of the plan
+* Complexity: O(log n)
+*/
+void cut_task(int i);
+
+/**
+* Prepares the next round of the plan after all the tasks of
+* the current one are done
+* Complexity: O(t) where t is the number of tasks of the
+* round, and O(k) after the last round of splits
+*/
+void next_cut_round();
+
+/**
+* Releases the nodes of the edges of the plan (and of the
+* vertices they left isolated in a sparse forest)
+* Complexity: O(k) where k is the number of planned edges
+*/
+void finish_cuts();
+
+/**
+* Removes the nontree edge with the given handle
+* from the forest
+* Complexity: O(log n)
+*/
+void remove_nontree_edge(int handle);
+
+/**
+* Removes the nontree edges with the given handles like
+* remove_nontree_edge. The records are erased from the lists
+* of their vertices in parallel, one tree at a time per
+* thread (see set_threads); the handles are released on the
+* calling thread.
+* Complexity: O(k (log n + log k)) where k is the number of
+* edges; O(k log k) of it on the calling thread
+*/
+void remove_nontree_edges(const vector <int> &handles);
+
+/**
+* Checks whether vertices a and b are connected
+* Complexity: O(log n)
+*/
+bool connected(int a, int b);
+
+/**
+* Sets answers[i] to connected(a, b) for the i-th query (a,b)
+* The root walks of all the queries are interleaved (see
+* TourTree::find_roots), unless the sequence tree is self
+* adjusting, whose queries are answered one by one.
+* Complexity: O(k log n) where k is the number of queries
+*/
+void connected_batch(const vector <pair <int, int> > &queries,
+vector <bool> &answers);
+
+/**
+* Pops the nontree edges stored in the connected component
+* of a one by one, in a single traversal of its Euler tour,
+* and calls f(edge) for each of them (with the endpoint in
+* the component first) until f returns false. f must not
+* modify the forest.
+*
+* Complexity: O(log n + k log(n/k)) plus O(log n) per edge
+* whose other endpoint stores no other nontree edge, where k
+* is the number of vertices with nontree edges visited
+*/
+template <class F>
+void pop_nontree_edges(int a, F f);
+
+/**
+* Looks at a nontree edge stored in the connected component
+* of a without removing it: the first edge of the
+* (r mod k)-th vertex with nontree edges, out of k such
+* vertices. Returns the handle of the edge and the edge
+* itself (with the endpoint in the component first) in the
+* edge parameter, or -1 if the component stores no nontree
+* edges.
+* Complexity: O(log n)
+*/
+int sample_nontree_edge(int a, uint32_t r, pair <int, int> &edge);
+
+/**
+* Advances the cursor to the next nontree edge stored in the
+* connected component of cursor.vertex, visiting the vertices
+* with nontree edges in the order of the Euler tour. Returns
+* the handle of the edge and the edge itself (with the
+* endpoint in the component first) in the edge parameter, or
+* -1 after the last edge. Nothing is modified, and the cursor
+* stays valid as long as no edge is inserted or removed.
+* Complexity: O(1) within the list of a vertex, O(log n) to
+* move to the next vertex
+*/
+int next_nontree_edge(NontreeCursor &cursor, pair <int, int> &edge);
+
+/**
+* Returns the number of vertices in the connected component
+* containing the vertex a
+* Complexity: O(log n)
+*/
+int size(int a);
+
+/**
+* Calls f(u) for every vertex u in the connected component
+* of v, in the order of its Euler tour
+* Only for a dense forest, whose vertex nodes are numbered
+* by the vertices.
+* Complexity: O(log n + k) where k is the size of the component
+*/
+template <class F>
+void for_each_vertex(int v, F f);
+
+/**
+* Calls f(a, b) once for every tree edge (a,b), a < b, in
+* the connected component of v
+* Complexity: O(log n + k) where k is the size of the component
+*/
+template <class F>
+void for_each_tree_edge(int v, F f);
+
+/**
+* Sets the hook maintaining extra aggregates of the Euler
+* tours (see AggregateHook in tour_tree.hpp); only a forest
+* over a HookedTree calls it
+* Complexity: O(1)
+*/
+void set_aggregate_hook(typename Tree::hook_type *hook);
+
+/**
+* Recomputes the extra aggregates which depend on the vertex
+* node of v after its value changed
+* Only for a dense forest.
+* Complexity: O(log n)
+*/
+void update_vertex(int v);
+
+/**
+* Calls f(x) for the vertex node of v and each of its
+* ancestors, up to the root of its Euler tour, so that
+* invertible extra aggregates (e.g. sums or XORs) can be
+* changed in place when only the value of v changes
+* Only for a dense forest.
+* Complexity: O(log n)
+*/
+template <class F>
+void for_each_ancestor(int v, F f);
+
+/**
+* Returns the root of the Euler tour of the connected
+* component of v, which holds its aggregates
+* Only for a dense forest.
+* Complexity: O(log n)
+*/
+node_t tour_root(int v);
+
+/**
+* Reserves the nodes of a spanning tree of all the vertices,
+* so that the array of nodes of the Euler tours is never
+* reallocated (see concurrent_root)
+* Only for a dense forest.
+* Complexity: O(n)
+*/
+void reserve_spanning_forest();
+
+/**
+* Returns the root of the Euler tour of v like tour_root, but
+* without restructuring the tour and with atomic loads of the
+* parent pointers, for readers running concurrently with the
+* thread updating the forest (which must have reserved the
+* spanning forest). The result must be validated by the
+* reader; it is NIL if the walk gave up.
+* Only for a dense forest.
+* Complexity: O(depth of the node of v)
+*/
+node_t concurrent_root(int v) const;
+
+/**
+* Checks whether the invariants of the data structure hold
+* Complexity: O(n log n + m), where m is the number of edges
+* currently in the forest
+*/
+bool correct();
+
+void print();
+
+private:
+int n;
+bool sparse;
+
+/* the nodes of all Euler tours; in a dense forest vertex v is the node v+1 */
+Tree Tour;
+/* first node of the pair representing a tree edge, whose nodes hold its endpoints */
+EdgeIndex <node_t> TEdgeHooks;
+/* sparse forests: nodes of present vertices, keyed by the loop (v,v) */
+EdgeTable <node_t> VertexHooks;
+/* sparse forests: the nodes of all vertices (NIL if absent), once it replaces VertexHooks */
+vector <node_t> VertexNodes;
+
+/**
+* Pool of nontree edge records (see NontreeRecord). The handle
+* of an edge is the index k of its pair of records 2k, 2k+1.
+* Free pairs form a list linked through the next field of
+* their first record, starting at NTFree.
+*/
+vector <NontreeRecord> NTEdges;
+int NTFree;
+int nontree_edges;
+
+/* the threads of the batches */
+int threads;
+
+/**
+* The plan of plan_cuts: the first nodes of the planned edges
+* and the nodes of those cut in rounds, ordered by their tours
+* (the g-th tour from CutGroupStart[g]) and their places in
+* them, with the indices of their edges in CutOwner. The piece
+* of the g-th tour before its j-th node (or after the last one)
+* is CutPieces[CutGroupStart[g] + g + j] once split off.
+*/
+struct CutSegment {
+// the nodes lo..hi of the group form the tree being split
+int lo, hi, group;
+};
+vector <node_t> CutEdges, CutNodes, CutPieces;
+vector <int> CutOwner, CutGroupStart;
+vector <CutSegment> CutSegments, NextSegments;
+/* the pieces of each new tour at MergeList[MergeStart[t]..], merged at MergeTasks */
+bool merging;
+vector <int> MergeList, MergeStart, MergeTasks;
+
+node_t vertex_node(int v);
+auto edge_endpoints() const;
+node_t materialize(int v);
+void index_vertices();
+void release_if_isolated(int v);
+pair <int, int> cut_edge_nodes(node_t ab_edge);
+pair <int, int> link_edge_nodes(node_t ab_edge, node_t x, node_t y);
+template <class F>
+void for_each_by_tree(const vector <node_t> &xs, F f);
+void plan_merges();
+void push_nontree_record(int v, int r);
+void link_nontree_record(node_t x, int r);
+void erase_nontree_record(int v, int r);
+void release_nontree_edge(int handle);
+};
+
+template <class Tree>
+template <class F>
+void ETTForest<Tree>::for_each_vertex(int v, F f) {
+assert(!sparse);
+Tour.for_each_node(Tour.root(v + 1), [&](node_t x) {
+if (Tour[x].flags & VERTEX_NODE)
+f(int(x) - 1);
+});
+}
+
+/**
+* The edge nodes of an Euler tour form a closed walk, so the
+* source of an edge node is the target of the previous one (of
+* the last one for the first). Each edge is reported in the
+* direction in which its source is smaller.
+*/
+template <class Tree>
+template <class F>
+void ETTForest<Tree>::for_each_tree_edge(int v, F f) {
+node_t x = vertex_node(v);
+if (x == NIL)
+return;
+
+int first = -1, previous = -1;
+Tour.for_each_node(Tour.root(x), [&](node_t y) {
+if (Tour[y].flags & VERTEX_NODE)
+return;
+
+int target = Tour[y].aux;
+if (previous == -1)
+first = target;
+else if (previous < target)
+f(previous, target);
+previous = target;
+});
+
+if (first != -1 && previous < first)
+f(previous, first);
+}
+
+template <class Tree>
+template <class F>
+void ETTForest<Tree>::for_each_ancestor(int v, F f) {
+assert(!sparse);
+// a splay tree brings the node to the root first
+Tour.root(v + 1);
+for (node_t x = v + 1; x != NIL; x = Tour[x].parent)
+f(x);
+}
+
+template <class Tree>
+template <class F>
+void ETTForest<Tree>::promote_tree_edges(int a, F f) {
+node_t x = vertex_node(a);
+if (x != NIL)
+Tour.take_on_level(Tour.root(x), f);
+}
+
+/**
+* The traversal hands over the list of each vertex. Its records
+* are unlinked from the head of the list, while their twins are
+* erased from the lists of the other endpoints as usual.
+*/
+template <class Tree>
+template <class F>
+void ETTForest<Tree>::pop_nontree_edges(int a, F f) {
+node_t x = vertex_node(a);
+if (x == NIL)
+return;
+
+Tour.scan_nontree_heads(Tour.root(x), [&](node_t, int &head) {
+while (head != -1) {
+int r = head;
+head = NTEdges[r].next;
+if (head != -1)
+NTEdges[head].prev = -1;
+
+// the source of the record is the target of its twin
+pair <int, int> edge = {NTEdges[r ^ 1].to, NTEdges[r].to};
+erase_nontree_record(edge.second, r ^ 1);
+release_nontree_edge(r / 2);
+release_if_isolated(edge.second);
+
+if (!f(edge))
+return false;
+}
+return true;
+});
+
+release_if_isolated(a);
+}
+
+#endif
+#ifndef EDGE_TABLE_HPP
+#define EDGE_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+using namespace std;
+
+/* Packs the undirected edge (a,b) into a 64-bit key */
+inline uint64_t edge_key(int a, int b) {
+if (a > b)
+swap(a, b);
+return (uint64_t(uint32_t(a)) << 32) | uint32_t(b);
+}
+
+/* Fibonacci hashing: the top bits of the product are well mixed */
+inline size_t edge_hash(uint64_t key, int shift) {
+return (key * 0x9E3779B97F4A7C15ULL) >> shift;
+}
+
+/**
+* Hash table mapping undirected edges to values of type Info.
+*
+* Uses open addressing with linear probing over a single array
+* of slots, each holding the edge together with its value, so a
+* lookup touches one or two cache lines. The edge is stored as
+* two 32-bit endpoints, so that a slot is aligned only as the
+* value: with a 4-byte value, a slot takes 12 bytes instead of
+* 16.
+* Erased slots are filled by shifting the following entries
+* back (no tombstones), so probe sequences stay short under
+* any mix of insertions and deletions.
+*
+* Pointers returned by find and insert stay valid until the
+* next call to insert or erase.
+*/
+
+template <class Info>
+class EdgeTable {
+public:
+
+EdgeTable() {
+count = 0;
+shift = 64 - 4;
+Slots.assign(size_t(1) << (64 - shift), Slot(EMPTY));
+}
+
+/**
+* Returns the value stored for the (a,b) edge
+* or NULL if there is none
+* Complexity: O(1) (expected)
+*/
+Info *find(int a, int b) {
+size_t i = probe(edge_key(a, b));
+return Slots[i].key() == EMPTY ? NULL : &Slots[i].info;
+}
+
+/**
+* Returns the value stored for the (a,b) edge, creating
+* a value-initialized entry if there is none
+* Complexity: O(1) (expected, amortized)
+*/
+Info *insert(int a, int b) {
+uint64_t key = edge_key(a, b);
+
+// keep the load factor at most 1/2
+if (2 * (size_t(count) + 1) > Slots.size())
+rehash(shift - 1);
+
+size_t i = probe(key);
+if (Slots[i].key() == EMPTY) {
+Slots[i] = Slot(key);
+count++;
+}
+return &Slots[i].info;
+}
+
+/**
+* Removes the entry pointed to by info (obtained from find
+* or insert) from the table
+* Complexity: O(1) (expected)
+*/
+void erase(Info *info);
+
+/**
+* Makes room for the given number of edges, so that
+* inserting them does not trigger any further rehashing
+* Complexity: O(edges + size of the table)
+*/
+void reserve(int edges) {
+int new_shift = shift;
+while (2 * size_t(edges) > (size_t(1) << (64 - new_shift)))
+new_shift--;
+if (new_shift != shift)
+rehash(new_shift);
+}
+
+/* Returns the number of edges stored in the table */
+int size() {
+return count;
+}
+
+/**
+* Calls f(a, b, info) for every entry, where (a,b) is the
+* edge with a <= b
+* Complexity: O(capacity of the table)
+*/
+template <class F>
+void for_each(F f) {
+for (Slot &slot: Slots) {
+if (slot.key() != EMPTY)
+f(int(slot.a), int(slot.b), slot.info);
+}
+}
+
+private:
+struct Slot {
+/* the endpoints a <= b, both UINT32_MAX in an empty slot */
+uint32_t a, b;
+Info info;
+
+Slot(uint64_t key) : a(uint32_t(key >> 32)), b(uint32_t(key)), info() {}
+
+uint64_t key() const {
+return (uint64_t(a) << 32) | b;
+}
+};
+
+static constexpr uint64_t EMPTY = UINT64_MAX;
+
+vector <Slot> Slots;
+int count;
+int shift;
+
+size_t home(uint64_t key) {
+return edge_hash(key, shift);
+}
+
+/**
+* Returns the index of the slot holding key or of the empty
+* slot that ends its probe sequence.
+*/
+size_t probe(uint64_t key) {
+size_t mask = Slots.size() - 1;
+size_t i = home(key);
+while (Slots[i].key() != EMPTY && Slots[i].key() != key) {
+i = (i + 1) & mask;
+}
+return i;
+}
+
+void rehash(int new_shift);
+};
+
+/**
+* Backward shift deletion: walks the cluster following the
+* erased slot and moves back every entry whose home position
+* does not lie cyclically between the hole and the entry.
+*/
+template <class Info>
+void EdgeTable<Info>::erase(Info *info) {
+Slot *slot = reinterpret_cast<Slot*>(
+reinterpret_cast<char*>(info) - offsetof(Slot, info));
+size_t mask = Slots.size() - 1;
+size_t hole = slot - Slots.data();
+
+for (size_t j = (hole + 1) & mask; Slots[j].key() != EMPTY; j = (j + 1) & mask) {
+size_t h = home(Slots[j].key());
+
+bool movable = (hole <= j) ? (h <= hole || h > j)
+: (h <= hole && h > j);
+if (movable) {
+Slots[hole] = Slots[j];
+hole = j;
+}
+}
+
+Slots[hole].a = Slots[hole].b = UINT32_MAX;
+count--;
+}
+
+template <class Info>
+void EdgeTable<Info>::rehash(int new_shift) {
+vector <Slot> old_slots;
+old_slots.swap(Slots);
+
+shift = new_shift;
+Slots.assign(size_t(1) << (64 - shift), Slot(EMPTY));
+
+for (Slot &slot: old_slots) {
+if (slot.key() != EMPTY)
+Slots[probe(slot.key())] = slot;
+}
+}
+
+/**
+* Hash index of edges stored outside of it, e.g. in the nodes
+* of a forest. A slot holds only the handle of an edge (0 marks
+* an empty slot and is never a handle), and the endpoints of a
+* handle h are read from endpoints(h), a function passed to
+* every call which needs them.
+*
+* The layout is that of EdgeTable, but a slot takes only the 4
+* bytes of a handle; in exchange, every probe of a lookup reads
+* the endpoints of the handle it passes. The endpoints of a
+* handle must not change while it is in the index.
+*/
+
+template <class Handle>
+class EdgeIndex {
+public:
+
+EdgeIndex() {
+count = 0;
+shift = 64 - 4;
+Slots.assign(size_t(1) << (64 - shift), 0);
+}
+
+/**
+* Returns the handle of the (a,b) edge or 0 if there is none
+* Complexity: O(1) (expected)
+*/
+template <class F>
+Handle find(int a, int b, F endpoints) const {
+uint64_t key = edge_key(a, b);
+size_t mask = Slots.size() - 1;
+size_t i = edge_hash(key, shift);
+while (Slots[i] != 0 && key_of(Slots[i], endpoints) != key)
+i = (i + 1) & mask;
+return Slots[i];
+}
+
+/**
+* Adds the edge with handle h, which must not be in the
+* index yet
+* Complexity: O(1) (expected, amortized)
+*/
+template <class F>
+void insert(Handle h, F endpoints) {
+// keep the load factor at most 1/2
+if (2 * (size_t(count) + 1) > Slots.size())
+rehash(shift - 1, endpoints);
+
+Slots[free_slot(key_of(h, endpoints))] = h;
+count++;
+}
+
+/**
+* Removes the edge with handle h from the index
+* Complexity: O(1) (expected)
+*/
+template <class F>
+void erase(Handle h, F endpoints);
+
+/**
+* Makes room for the given number of edges, so that
+* inserting them does not trigger any further rehashing
+* Complexity: O(edges + size of the index)
+*/
+template <class F>
+void reserve(int edges, F endpoints) {
+int new_shift = shift;
+while (2 * size_t(edges) > (size_t(1) << (64 - new_shift)))
+new_shift--;
+if (new_shift != shift)
+rehash(new_shift, endpoints);
+}
+
+/* Returns the number of edges in the index */
+int size() const {
+return count;
+}
+
+private:
+vector <Handle> Slots;
+int count;
+int shift;
+
+template <class F>
+static uint64_t key_of(Handle h, F endpoints) {
+pair <int, int> edge = endpoints(h);
+return edge_key(edge.first, edge.second);
+}
+
+/* Returns the first empty slot of the probe sequence of key */
+size_t free_slot(uint64_t key) const {
+size_t mask = Slots.size() - 1;
+size_t i = edge_hash(key, shift);
+while (Slots[i] != 0)
+i = (i + 1) & mask;
+return i;
+}
+
+template <class F>
+void rehash(int new_shift, F endpoints);
+};
+
+/* Backward shift deletion, as in EdgeTable::erase */
+template <class Handle>
+template <class F>
+void EdgeIndex<Handle>::erase(Handle h, F endpoints) {
+size_t mask = Slots.size() - 1;
+size_t hole = edge_hash(key_of(h, endpoints), shift);
+while (Slots[hole] != h)
+hole = (hole + 1) & mask;
+
+for (size_t j = (hole + 1) & mask; Slots[j] != 0; j = (j + 1) & mask) {
+size_t home = edge_hash(key_of(Slots[j], endpoints), shift);
+
+bool movable = (hole <= j) ? (home <= hole || home > j)
+: (home <= hole && home > j);
+if (movable) {
+Slots[hole] = Slots[j];
+hole = j;
+}
+}
+
+Slots[hole] = 0;
+count--;
+}
+
+template <class Handle>
+template <class F>
+void EdgeIndex<Handle>::rehash(int new_shift, F endpoints) {
+vector <Handle> old_slots;
+old_slots.swap(Slots);
+
+shift = new_shift;
+Slots.assign(size_t(1) << (64 - shift), 0);
+
+for (Handle h: old_slots) {
+if (h != 0)
+Slots[free_slot(key_of(h, endpoints))] = h;
+}
+}
+
+#endif
+#ifndef UNION_FIND_HPP
+#define UNION_FIND_HPP
+
+#include <utility>
+#include <vector>
+using namespace std;
+
+/**
+* Disjoint set union over n elements with union by size
+* and path halving
+* (https://en.wikipedia.org/wiki/Disjoint-set_data_structure).
+*/
+
+class UnionFind {
+public:
+
+UnionFind(int n) {
+Parent.resize(n);
+Size.assign(n, 1);
+for (int i = 0; i < n; i++)
+Parent[i] = i;
+}
+
+/**
+* Returns the representative of the set containing a
+* Complexity: O(alpha(n)) (amortized)
+*/
+int find(int a) {
+while (Parent[a] != a) {
+Parent[a] = Parent[Parent[a]];
+a = Parent[a];
+}
+return a;
+}
+
+/**
+* Merges the sets containing a and b
+* Returns false if they were already the same set
+* Complexity: O(alpha(n)) (amortized)
+*/
+bool unite(int a, int b) {
+a = find(a);
+b = find(b);
+if (a == b)
+return false;
+
+if (Size[a] < Size[b])
+swap(a, b);
+Parent[b] = a;
+Size[a] += Size[b];
+return true;
+}
+
+/**
+* Returns the size of the set containing a
+* Complexity: O(alpha(n)) (amortized)
+*/
+int size(int a) {
+return Size[find(a)];
+}
+
+private:
+vector <int> Parent;
+vector <int> Size;
+};
+
+/**
+* Disjoint set union over n elements with union by size and
+* no path compression, so that the unions can be undone in
+* the reverse order.
+*/
+
+class RollbackUnionFind {
+public:
+
+RollbackUnionFind(int n) {
+Parent.resize(n);
+Size.assign(n, 1);
+for (int i = 0; i < n; i++)
+Parent[i] = i;
+sets = n;
+}
+
+/**
+* Returns the representative of the set containing a
+* Complexity: O(log n)
+*/
+int find(int a) const {
+while (Parent[a] != a)
+a = Parent[a];
+return a;
+}
+
+/**
+* Merges the sets containing a and b
+* Returns false if they were already the same set
+* Complexity: O(log n)
+*/
+bool unite(int a, int b) {
+a = find(a);
+b = find(b);
+if (a == b)
+return false;
+
+if (Size[a] < Size[b])
+swap(a, b);
+Parent[b] = a;
+Size[a] += Size[b];
+History.push_back(b);
+sets--;
+return true;
+}
+
+/* Returns the number of sets */
+int count() const {
+return sets;
+}
+
+/**
+* Returns a checkpoint to roll back to, which stays valid
+* until the unions made before it are rolled back
+* Complexity: O(1)
+*/
+int checkpoint() const {
+return History.size();
+}
+
+/**
+* Undoes all unions made since the checkpoint
+* Complexity: O(1) per union undone
+*/
+void rollback(int checkpoint) {
+while ((int) History.size() > checkpoint) {
+int b = History.back(), a = Parent[b];
+History.pop_back();
+Parent[b] = b;
+Size[a] -= Size[b];
+sets++;
+}
+}
+
+private:
+vector <int> Parent;
+vector <int> Size;
+/* the roots which got a parent, in the order of the unions */
+vector <int> History;
+int sets;
+};
+
+#endif
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+using namespace std;
+
+/**
+* Sequence lock (https://en.wikipedia.org/wiki/Seqlock) for a
+* single writer and any number of readers, in the form given by
+* Boehm (https://www.hpl.hp.com/techreports/2012/HPL-2012-68.pdf).
+*
+* The sequence number is odd while the writer modifies the
+* protected data. A reader remembers an even sequence number,
+* reads the data without taking any lock and validates the
+* number afterwards: if it changed, the reader saw a write in
+* progress and must retry. Readers never write shared memory,
+* so they do not slow each other down or block the writer.
+*
+* The readers must load the protected data with (relaxed)
+* atomic loads and must not trust any of it before validation,
+* e.g. they must be ready for pointers that lead nowhere. The
+* writer must store the fields which the readers load with
+* atomic stores too (see TourTree::set_parent); it may
+* keep using plain stores for the fields which are never read
+* concurrently.
+*/
+
+class SeqLock {
+public:
+
+SeqLock() : sequence(0) {}
+
+/**
+* Marks the beginning of a write (must not be nested)
+* Complexity: O(1)
+*/
+void write_begin() {
+uint64_t s = __atomic_load_n(&sequence, __ATOMIC_RELAXED);
+__atomic_store_n(&sequence, s + 1, __ATOMIC_RELAXED);
+// the stores of the write may not be seen before the odd number
+__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+* Marks the end of a write
+* Complexity: O(1)
+*/
+void write_end() {
+uint64_t s = __atomic_load_n(&sequence, __ATOMIC_RELAXED);
+__atomic_store_n(&sequence, s + 1, __ATOMIC_RELEASE);
+}
+
+/**
+* Waits until no write is in progress and returns the
+* sequence number to validate the read with
+* After a short spin, the reader yields its processor, which
+* may be the one the writer is waiting for.
+* Complexity: O(1) unless a write is in progress
+*/
+uint64_t read_begin() const {
+uint64_t s;
+for (int spins = 0; (s = __atomic_load_n(&sequence, __ATOMIC_ACQUIRE)) & 1; spins++) {
+if (spins < 64)
+pause();
+else
+this_thread::yield();
+}
+return s;
+}
+
+/**
+* Checks whether no write started since read_begin returned s
+* Complexity: O(1)
+*/
+bool read_validate(uint64_t s) const {
+// the loads of the read may not be seen after the number
+__atomic_thread_fence(__ATOMIC_ACQUIRE);
+return __atomic_load_n(&sequence, __ATOMIC_RELAXED) == s;
+}
+
+/* Holds the lock for writing (if it is not NULL) in a scope */
+class WriteGuard {
+public:
+WriteGuard(SeqLock *_lock) : lock(_lock) {
+if (lock != NULL)
+lock->write_begin();
+}
+~WriteGuard() {
+if (lock != NULL)
+lock->write_end();
+}
+
+private:
+SeqLock *lock;
+};
+
+private:
+uint64_t sequence;
+
+static void pause() {
+#if defined(__x86_64__) || defined(__i386__)
+__builtin_ia32_pause();
+#endif
+}
+};
+
+#endif
+using namespace std;
+
+/* Everything DynamicConnectivity knows about an undirected edge */
+struct EdgeInfo {
+/* number of parallel copies of the edge in the graph */
+int cnt = 0;
+/* level of the edge (see below) */
+int level = 0;
+/* whether the edge belongs to the spanning forests */
+bool tree = false;
+/* handle of a nontree edge in the forest of its level */
+int nontree_hook = -1;
+};
+
+/**
+* A change of the connected components of the graph: the
+* components of a and b were merged or a component was split
+* into those of a and b. The sizes are those of the two
+* components before the merge or after the split.
+*/
+struct ComponentEvent {
+enum Type { MERGE, SPLIT } type;
+int a, b;
+int size_a, size_b;
+};
+
+/* Counters of the sampling of replacement edges in remove */
+struct SamplingStats {
+/* searches on a level with some nontree edges to sample */
+long long searches = 0;
+/* searches ended by a sampled edge */
+long long hits = 0;
+/* nontree edges sampled */
+long long samples = 0;
+};
+
+/* Counters of the interleaved search on both sides of a cut */
+struct InterleavedStats {
+/* searches on a level with some nontree edges on the smaller side */
+long long searches = 0;
+/* replacements found on the smaller and on the larger side */
+long long hits_smaller = 0, hits_larger = 0;
+/* searches which showed that there is no replacement */
+long long no_replacement = 0;
+/* nontree edges looked at */
+long long edges = 0;
+};
+
+/**
+* The policies of the search for replacements, of the batches
+* and of the readers of DynamicConnectivity, which are set
+* together (see valid for the combinations allowed)
+*/
+struct ConnectivityOptions {
+/**
+* Number of nontree edges sampled before the search for a
+* replacement of a removed tree edge on each level (0 turns
+* the sampling off). The samples are taken at random from the
+* smaller side of the cut, and the first one leading to the
+* other side replaces the removed edge right away. Only if
+* none does, the tree edges of the smaller side are promoted
+* and all its nontree edges are scanned as usual. When most
+* replacements are easy to find, this skips the promotions;
+* a sampled edge which does not cross only costs O(log n).
+*/
+int samples = 0;
+
+/**
+* Number of nontree edges looked at by the interleaved search
+* for a replacement on each level (0 turns it off), after the
+* sampling. The search alternates between the nontree edges
+* of both sides of the cut, without moving any of them, and
+* stops as soon as an edge crosses the cut or one side runs
+* out of edges (then there is no replacement on this level).
+* Only when the budget is used up, the smaller side is
+* searched as usual, promoting its tree and nontree edges, so
+* the amortized bound is kept. A crossing edge near the top
+* of the lists of the larger side is found without scanning
+* the whole smaller side.
+*/
+int interleaved_budget = 0;
+
+/**
+* Units of work after which a remove leaves the rest of its
+* search pending (negative means no bound, 0 that a remove
+* only cuts the edge). A unit is a tree edge promoted or
+* a nontree edge looked at (sampled, by the interleaved search
+* or by the scan), at O(log n) each. The sampling and the
+* interleaved search of a level run whole once started, so a
+* call does at most budget + samples + interleaved_budget units.
+* The search is continued by step(), and finished first by
+* every other update and by the queries whose answers depend
+* on it: connected(a, b) when a and b are on the two sides of
+* the pending cut, component_size, the statistics of the
+* components and the visitors.
+*/
+int remove_budget = -1;
+
+/**
+* Number of threads the batches may use (1 runs them on the
+* calling thread). remove_batch cuts the removed tree edges of
+* all the levels in parallel rounds of splits and merges of the
+* tours, also within one tree (see ETTForest::plan_cuts);
+* insert_batch links the groups of trees of F_0 joined by the
+* batch in parallel (see ETTForest::link_batch). The search
+* for replacements of remove_batch is sequential here; see
+* BatchDynamicConnectivity (batch_dc.hpp) for one which runs
+* on the threads. The threads are kept across the batches
+* (see WorkerPool in parallel.hpp).
+*/
+int threads = 1;
+
+/**
+* Whether other threads may call concurrent_connected while
+* the owner of the structure (the only writer) keeps calling
+* the other methods. The connectivity is answered from the
+* trees of F_0 by root walks validated with a sequence lock
+* (seqlock.hpp): every method which may change F_0 marks
+* a write, and a read which overlaps one is retried. The
+* readers take no lock and do not write shared memory, so
+* they scale with the number of threads, and the writer never
+* waits for them. The nodes of F_0 are reserved up front, so
+* they are never reallocated under the readers. The queries
+* of the writer count as writes only if they finish a pending
+* remove. Not allowed with a self-adjusting sequence tree
+* (SplayTree), whose queries restructure it: every query of
+* the writer would count as a write and the root walks of the
+* readers would not be bounded by O(log n).
+*/
+bool concurrent_reads = false;
+};
+
+/**
+* Dynamic Connectivity data structure as designed by
+* Jacob Holm, Kristian de Lichtenberg and Mikkel Thorup
+* (https://u.cs.biu.ac.il/~rodittl/p723-holm.pdf -- section 3).
+*
+* Brief description of the algorithm:
+* Let G be the graph we are maintaining.
+* Each edge of G is assigned a level from [0, log n].
+* A newly added edge is assigned level 0, which can change
+* during the course of the algorithm.
+* The data structure keeps a family of log n forests:
+* F_0, F_1, ..., F_{log n}.
+* F_i is a maximal spanning forest of G such that all edges in
+* it have level at least i. Also, we maintain that F_{i+1} is
+* always a subgraph of F_i. Furthermore, we will maintain that
+* edges on level i form connected components of size
+* at most n / (2^i). Hence, (log n + 1) levels are guaranteed
+* to capture all the edges of G.
+*
+* Each forest is implemented as an union of Euler Tour Trees
+* (et_trees.hpp).This data structure suports connectivity
+* testing, edge insertion and removal (all in O(log n) time).
+* Those allow us to answer the connectivity queries (F_0 is a
+* maximal spanning forest of G) and handle the edges belonging
+* to the forests.
+*
+* Euler tour trees also allow us to store values in a given
+* vertex and then pop them from a given connected component
+* in F_i. This allows us to store the edges that are not in
+* the forest (nontree edges) and then access those incident
+* to a given connected component one by one (each in O(log n)
+* time). An edge of level i which does not belong to F_i is
+* stored in its endpoints in the Euler tour trees for F_i.
+* After a tree edge has been removed, this allows us to find
+* a replacement edge, which would reconnect the two resulting
+* connected components. Processing each candidate takes O(log n)
+* time. However, we will be able to promote each edge that did
+* not reconnect the connected components to the next level.
+* As each edge can be promoted at most log n times, the total
+* cost of looking for replacements (over the whole runtime) is
+* bounded by O(m * log^2 n) where m is the number of edge
+* insertions.
+*
+* The Tree parameter selects the sequence tree storing the Euler
+* tours (AVLTree, SplayTree or Treap, see tour_tree.hpp); the
+* bounds above hold for all of them (amortized for SplayTree,
+* expected for Treap). DynamicConnectivity uses AVL trees.
+*/
+
+template <class Tree>
+class BasicDynamicConnectivity {
+public:
+
+/**
+* Initiates the data structure for a n-vertex graph
+* Only F_0 is built up front; the forests of higher levels
+* are created when the first edge is promoted to them, store
+* only the vertices with edges on their level and are freed
+* once they become empty again.
+* Complexity: O(n)
+*/
+BasicDynamicConnectivity(int n);
+
+/**
+* Initiates the data structure for a n-vertex graph with
+* the given edges (as if they were inserted one by one)
+* A spanning forest is found with union-find and its Euler
+* tours are built directly; the remaining edges are stored
+* as nontree edges on level 0.
+* Complexity: O(n + m) (expected), where m is the number
+* of edges
+*/
+BasicDynamicConnectivity(int n, const vector <pair <int, int> > &edges);
+
+/**
+* Inserts an undirected (a,b) edge to the graph
+* (parallel edges are supported, loops are ignored)
+* Complexity (runtime): O(log n)
+* Complexity (cost accounting for amortization): O(log^2 n)
+*/
+void insert(int a, int b);
+
+/** Removes an undirected (a,b) edge from the graph
+* If there are multiple such edges, removes only one
+*
+* Complexity (runtime): only bounded by the number of
+* edges added so far, but the total cost of all calls is
+* amortized over the whole lifetime of the structure
+* (O(log^2 n + budget log n) with a remove budget, see
+* ConnectivityOptions::remove_budget)
+*
+* Complexity (cost accounting for amortization): O(log n)
+*/
+void remove(int a, int b);
+
+/**
+* Sets the policies of the structure, which must be valid
+* (see valid), and finishes the pending remove (if any).
+* Enabling the concurrent reads must happen before the
+* readers start, and disabling them after they stop.
+* Complexity: O(n) when the concurrent reads are enabled
+* (the nodes of F_0 are reserved), O(1) otherwise, plus the
+* cost of the pending remove
+*/
+void set_options(const ConnectivityOptions &_options);
+
+/**
+* Returns the policies set by set_options
+* Complexity: O(1)
+*/
+const ConnectivityOptions &options() const;
+
+/**
+* Checks whether the policies may be combined. Every count
+* must be non-negative and there must be at least one thread.
+* Then:
+*
+*   remove_budget  samples / interleaved_budget  allowed
+*   any            any                           yes
+*
+*   remove_budget  threads                       allowed
+*   any            any                           yes (*)
+*
+*   remove_budget  concurrent_reads              allowed
+*   negative       true                          yes (***)
+*   >= 0           true                          no (**)
+*
+* (*) remove_batch finishes the pending remove first and is
+* never left pending itself: the budget bounds only remove.
+* (**) a pending remove would make the trees of F_0, which
+* the readers walk, disagree with the graph.
+* (***) unless the sequence tree is self adjusting.
+* Complexity: O(1)
+*/
+static bool valid(const ConnectivityOptions &options);
+
+/**
+* Continues the pending remove (if any) by at most the
+* remove budget of work (at least one unit), e.g. when the
+* caller is idle.
+* Returns whether some of it is still pending.
+* Complexity: O(log^2 n + budget log n)
+*/
+bool step();
+
+/**
+* Checks whether the search of a remove is pending
+* Complexity: O(1)
+*/
+bool pending() const;
+
+/**
+* Inserts a batch of undirected edges, with the same result
+* as inserting them one by one
+* The edges are classified as tree and nontree edges in one
+* sweep (with union-find over the trees of F_0 they hit) and
+* all new tree edges are linked into F_0 together
+* (see ETTForest::link_batch).
+* Complexity: O(k log n + s) where k is the size of the batch
+* and s is the total size of the trees of F_0 linked to
+* a larger one
+*/
+void insert_batch(const vector <pair <int, int> > &edges);
+
+/**
+* Removes a batch of undirected edges, with the same effect
+* on connectivity as removing them one by one
+* All removed tree edges are cut from each level at once.
+* Then, from the top level down, the fragments of the trees
+* they split are reconnected: every fragment but the largest
+* one of its tree is searched for edges leaving it, once per
+* level rather than once per removed edge.
+* Complexity: O(k log^2 n) plus the cost of promotions,
+* amortized as in remove
+*/
+void remove_batch(const vector <pair <int, int> > &edges);
+
+/**
+* Checks whether vertices a and b are connected in the graph
+* Complexity: O(log n)
+*/
+bool connected(int a, int b);
+
+/**
+* Sets answers[i] to whether the vertices of the i-th query
+* are connected in the graph
+* The walks to the roots of the Euler tours in F_0 of all
+* the queries advance in lock-step and prefetch their next
+* nodes, so a batch waits for many cache misses at once
+* instead of one after another (see TourTree::find_roots).
+* A pending remove is finished first.
+* Complexity: O(k log n) where k is the number of queries
+*/
+void connected_batch(const vector <pair <int, int> > &queries,
+vector <bool> &answers);
+
+/**
+* Returns the number of connected components of the graph
+* The statistics of the components are maintained by the
+* links and cuts of F_0 which change the components, from
+* the sizes of the trees they join or split.
+* A pending remove is finished first.
+* Complexity: O(1) plus the cost of the pending remove
+*/
+int count_components();
+
+/**
+* Returns the number of vertices in the connected component
+* of v
+* Complexity: O(log n)
+*/
+int component_size(int v);
+
+/**
+* Returns the size of the largest connected component
+* A pending remove is finished first.
+* Complexity: O(1) plus the cost of the pending remove
+*/
+int largest_component();
+
+/**
+* Returns the sizes of the k largest connected components
+* (or of all of them if there are fewer) in non-increasing
+* order
+* A pending remove is finished first.
+* Complexity: O(k) plus the cost of the pending remove
+*/
+vector <int> largest_components(int k);
+
+/**
+* Calls f(u) for every vertex u in the connected component
+* of v, walking its Euler tour in F_0 (f must not modify
+* the structure)
+* Complexity: O(log n + k) where k is the size of the component
+*/
+template <class F>
+void for_each_vertex(int v, F f);
+
+/**
+* Calls f(a, b) for every edge (a,b) of the spanning tree of
+* the connected component of v maintained in F_0, once per
+* edge (f must not modify the structure)
+* Complexity: O(log n + k) where k is the size of the component
+*/
+template <class F>
+void for_each_tree_edge(int v, F f);
+
+/**
+* Sets the function called on every merge and split of the
+* components by the following updates (an empty function
+* turns the events off). The handler is called during the
+* update, so it must not modify the structure.
+* A batch reports only its net effect: insert_batch reports
+* a merge per new tree edge and remove_batch a split per
+* component which stays apart from the rest of its former
+* component.
+* Complexity: O(1) per event on top of the handler
+*/
+void set_event_handler(function <void(const ComponentEvent &)> handler);
+
+/**
+* Returns the counters of the sampling since the structure
+* was created
+* Complexity: O(1)
+*/
+const SamplingStats &sampling_stats() const;
+
+/**
+* Returns the counters of the interleaved search since the
+* structure was created
+* Complexity: O(1)
+*/
+const InterleavedStats &interleaved_stats() const;
+
+/**
+* Checks whether vertices a and b are connected, from any
+* thread, concurrently with the writer (see
+* ConnectivityOptions::concurrent_reads). The answer is that
+* of the graph between two updates of the writer, from its
+* own point of view of the updates (see SeqLock).
+* Complexity: O(log n) per attempt; an attempt is repeated
+* if it overlapped an update
+*/
+bool concurrent_connected(int a, int b) const;
+
+/**
+*  Checks if the invariants of the data structure hold
+* Complexity: O(n log n)
+*/
+bool correct();
+
+/* With DBG defined, prints the data structure to stderr */
+void print();
+
+protected:
+/* Access to the Euler tours of F_0 for the extra aggregates */
+void set_aggregate_hook(typename Tree::hook_type *hook);
+void update_vertex(int v);
+node_t component_root(int v);
+
+/**
+* The fragments of the trees of a level split by a batch:
+* a vertex and the size of every fragment, the original
+* trees joining them (by the union-find Trees, whose
+* representatives index largest) and the fragment of each
+* original tree with the most vertices. Ids numbers the
+* fragments by their tree_id (an isolated vertex v by
+* (NIL,v)), from 1.
+*/
+struct Fragments {
+EdgeTable <int> Ids;
+vector <int> vertices, sizes, largest;
+UnionFind Trees = UnionFind(0);
+};
+
+/* The steps of remove_batch for the engines built on this one */
+void cut_batch(const vector <pair <int, int> > &edges,
+vector <pair <int, pair <int, int> > > &cuts);
+void find_fragments(const vector <pair <int, pair <int, int> > > &cuts,
+size_t k, int level, Fragments &F);
+void split_components(Fragments &F);
+void finish_pending();
+void add_level(int level);
+void release_empty_levels();
+SeqLock *write_lock();
+
+vector <ETTForest <Tree> > Forests;
+EdgeTable <EdgeInfo> Edges;
+int n, L;
+ConnectivityOptions Options;
+
+private:
+pair <int, int> insert_edge(int a, int b, int level, EdgeInfo *info);
+void join_components(int a, int b, pair <int, int> sizes);
+void split_component(int a, int b, pair <int, int> sizes);
+void promote_tree_edges(int a, int level, int &work, int budget);
+bool sample_replacement(int a, int b, int level, int &work,
+pair <int, int> &replacement);
+bool search_both_sides(int a, int b, int level, int &work,
+pair <int, int> &replacement, bool &found);
+bool find_replacement(int &work, int budget,
+pair <int, int> &replacement, bool &found);
+bool continue_remove(int budget);
+bool reconnect_fragment(int v, int level, int largest);
+void reconnect_fragments(const vector <pair <int, pair <int, int> > > &cuts,
+size_t k, int level);
+
+/* the number of components and of components of each size */
+int components;
+map <int, int> ComponentSizes;
+function <void(const ComponentEvent &)> EventHandler;
+
+/* the counters of the searches */
+SamplingStats Sampling;
+InterleavedStats Interleaved;
+
+/* the state of the generator of the samples */
+uint64_t random_state;
+uint32_t next_random();
+
+/* the stages of the search for a replacement on a level */
+enum SearchStage { SEARCH_START, SEARCH_PROMOTE, SEARCH_SCAN };
+
+/**
+* The search for a replacement of a removed tree edge (a,b)
+* (which split the trees of F_0 into the given sizes): it
+* has got down to the given level, where the component of
+* small is searched for edges to that of large
+*/
+struct PendingRemove {
+bool active = false;
+int a, b;
+pair <int, int> sizes;
+int level;
+SearchStage stage;
+int small, large;
+};
+
+PendingRemove Pending;
+int search_budget() const;
+
+/* marks the writes of F_0 for the concurrent readers */
+SeqLock ReadLock;
+SeqLock *query_lock();
+};
+
+template <class Tree>
+template <class F>
+void BasicDynamicConnectivity<Tree>::for_each_vertex(int v, F f) {
+SeqLock::WriteGuard guard(query_lock());
+finish_pending();
+Forests[0].for_each_vertex(v, f);
+}
+
+template <class Tree>
+template <class F>
+void BasicDynamicConnectivity<Tree>::for_each_tree_edge(int v, F f) {
+SeqLock::WriteGuard guard(query_lock());
+finish_pending();
+Forests[0].for_each_tree_edge(v, f);
+}
+
+typedef BasicDynamicConnectivity <AVLTree> DynamicConnectivity;
+
+#endif
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+/**
+* Threads kept for parallel_for across its calls, so that a call
+* only wakes them up instead of starting new threads. The workers
+* are started when a call first needs them and sleep between the
+* calls; they are stopped at the exit of the program.
+*
+* The pool runs one job at a time. A job handed to it while it
+* runs another (from another thread, or from a job itself) is
+* refused and its caller runs it alone.
+*/
+
+class WorkerPool {
+public:
+
+/* Returns the pool shared by all calls of parallel_for */
+static WorkerPool &instance() {
+static WorkerPool pool;
+return pool;
+}
+
+~WorkerPool() {
+{
+lock_guard <mutex> lock(state);
+stop = true;
+}
+wake.notify_all();
+for (thread &worker: workers)
+worker.join();
+}
+
+/**
+* Calls f(i) for every i in [0, k) on the calling thread and
+* the given number of workers, and returns when all calls
+* have finished; returns false without calling f if the pool
+* is running another job
+* Complexity: O(k) calls of f plus O(helpers) to wake up the
+* workers (and to start those which do not exist yet)
+*/
+template <class F>
+bool run(int helpers, int k, F &f) {
+unique_lock <mutex> own(busy, try_to_lock);
+if (!own.owns_lock())
+return false;
+
+{
+lock_guard <mutex> lock(state);
+while ((int) workers.size() < helpers)
+workers.emplace_back(&WorkerPool::work_loop, this, int(workers.size()));
+
+job = &f;
+call = [](void *g, int i) { (*static_cast<F*>(g))(i); };
+total = k;
+next = 0;
+wanted = helpers;
+active = helpers;
+generation++;
+}
+wake.notify_all();
+
+work();
+unique_lock <mutex> lock(state);
+done.wait(lock, [&]() { return active == 0; });
+return true;
+}
+
+private:
+/* held by the thread whose job the pool runs */
+mutex busy;
+
+/* guards the fields below, except next */
+mutex state;
+condition_variable wake, done;
+vector <thread> workers;
+bool stop = false;
+/* the number of jobs so far, so that a worker joins each one once */
+uint64_t generation = 0;
+/* the workers 0..wanted-1 take part in the job; active have not finished it */
+int wanted = 0, active = 0;
+
+/* the job: call(job, i) for i in [0, total), handed out by next */
+void *job = NULL;
+void (*call)(void *, int) = NULL;
+int total = 0;
+atomic <int> next;
+
+WorkerPool() : next(0) {}
+
+void work() {
+for (int i = next++; i < total; i = next++)
+call(job, i);
+}
+
+void work_loop(int id) {
+uint64_t seen = 0;
+unique_lock <mutex> lock(state);
+while (true) {
+wake.wait(lock, [&]() {
+return stop || (generation != seen && id < wanted);
+});
+if (stop)
+return;
+seen = generation;
+
+lock.unlock();
+work();
+lock.lock();
+if (--active == 0)
+done.notify_one();
+}
+}
+};
+
+/**
+* Calls f(i) for every i in [0, k) on up to the given number of
+* threads (the calling one included) and returns when all calls
+* have finished. The indices are handed out one by one, so calls
+* of different costs are balanced between the threads. The calls
+* must be independent of each other.
+* The other threads come from WorkerPool; if it is busy (e.g. f
+* calls parallel_for itself), f runs on the calling thread only.
+* Complexity: O(k) calls of f plus O(threads) to wake up the
+* workers; with threads <= 1 or k <= 1, f runs on the calling
+* thread only
+*/
+template <class F>
+void parallel_for(int threads, int k, F f) {
+threads = min(threads, k);
+if (threads > 1 && WorkerPool::instance().run(threads - 1, k, f))
+return;
+
+for (int i = 0; i < k; i++)
+f(i);
+}
+
+#endif
+
+template <class Tree>
+BasicDynamicConnectivity<Tree>::BasicDynamicConnectivity(int _n) {
+n = _n;
+L = 0;
+while (n > (1<<L)) L++;
+
+// higher levels are created when the first edge reaches them
+Forests.emplace_back(n);
+
+components = n;
+if (n > 0)
+ComponentSizes[1] = n;
+
+random_state = 0x9e3779b97f4a7c15ULL;
+}
+
+template <class Tree>
+BasicDynamicConnectivity<Tree>::BasicDynamicConnectivity(int _n,
+const vector <pair <int, int> > &edges)
+: BasicDynamicConnectivity(_n) {
+
+UnionFind UF(n);
+vector <pair <int, int> > tree_edges;
+Edges.reserve(edges.size());
+
+for (auto [a, b]: edges) {
+if (a == b)
+continue;
+
+EdgeInfo *info = Edges.insert(a, b);
+if (info->cnt++ > 0)
+continue;
+
+// nontree edges are stored while all the vertices are
+// still isolated, which makes it O(1) per edge
+info->tree = UF.unite(a, b);
+if (info->tree)
+tree_edges.push_back({a, b});
+else
+info->nontree_hook = Forests[0].insert_nontree_edge(a, b);
+}
+
+Forests[0].build_trees(tree_edges);
+
+vector <int> sizes(n, 0);
+for (int v = 0; v < n; v++)
+sizes[UF.find(v)]++;
+
+components = 0;
+ComponentSizes.clear();
+for (int v = 0; v < n; v++) {
+if (sizes[v] > 0) {
+components++;
+ComponentSizes[sizes[v]]++;
+}
+}
+}
+
+/**
+* Inserts a (possibly duplicate) edge to the graph.
+*
+* Complexity: O(log n)
+*
+* Extra amortization cost: O(log^2 n) (a new edge is inserted)
+*/
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::insert(int a, int b) {
+
+// loops never affect connectivity
+if (a == b)
+return;
+
+SeqLock::WriteGuard guard(write_lock());
+finish_pending();
+
+EdgeInfo *info = Edges.insert(a, b);
+if (info->cnt++ == 0) {
+auto sizes = insert_edge(a, b, 0, info);
+if (info->tree)
+join_components(a, b, sizes);
+}
+}
+
+/**
+* Inserts an unique (a,b) edge to the graph with the given level
+* and records the level and the kind of the edge in its entry
+* of the edge table
+*
+* If a and b are not connected, it's added to the forest and
+* the sizes of the trees of F_0 it joined are returned.
+* Otherwise it is added to the list of nontree edges to be
+* accessed later when we'll be looking for replacement edges.
+*
+* Complexity: O((level+1) * log n) -- O(log^2 n)
+*/
+template <class Tree>
+pair <int, int> BasicDynamicConnectivity<Tree>::insert_edge(int a, int b, int level, EdgeInfo *info) {
+
+info->level = level;
+info->tree = !Forests[level].connected(a,b);
+pair <int, int> sizes = {0, 0};
+
+if (info->tree) {
+
+for (int l = 0; l <= level; l++) {
+auto joined = Forests[l].insert_tree_edge(a, b, (level == l));
+if (l == 0)
+sizes = joined;
+}
+
+} else {
+info->nontree_hook = Forests[level].insert_nontree_edge(a,b);
+}
+return sizes;
+}
+
+/**
+* Records that the components of a and b (of the given sizes)
+* were joined and reports it to the event handler
+*/
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::join_components(int a, int b, pair <int, int> sizes) {
+for (int size: {sizes.first, sizes.second}) {
+auto it = ComponentSizes.find(size);
+if (--it->second == 0)
+ComponentSizes.erase(it);
+}
+ComponentSizes[sizes.first + sizes.second]++;
+components--;
+
+if (EventHandler)
+EventHandler({ComponentEvent::MERGE, a, b, sizes.first, sizes.second});
+}
+
+/**
+* Records that a component was split into the components of a
+* and b (of the given sizes) and reports it to the event handler
+*/
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::split_component(int a, int b, pair <int, int> sizes) {
+auto it = ComponentSizes.find(sizes.first + sizes.second);
+if (--it->second == 0)
+ComponentSizes.erase(it);
+ComponentSizes[sizes.first]++;
+ComponentSizes[sizes.second]++;
+components++;
+
+if (EventHandler)
+EventHandler({ComponentEvent::SPLIT, a, b, sizes.first, sizes.second});
+}
+
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::set_aggregate_hook(typename Tree::hook_type *hook) {
+Forests[0].set_aggregate_hook(hook);
+}
+
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::update_vertex(int v) {
+SeqLock::WriteGuard guard(write_lock());
+Forests[0].update_vertex(v);
+}
+
+template <class Tree>
+node_t BasicDynamicConnectivity<Tree>::component_root(int v) {
+SeqLock::WriteGuard guard(query_lock());
+finish_pending();
+return Forests[0].tour_root(v);
+}
+
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::set_options(const ConnectivityOptions &_options) {
+assert(valid(_options));
+SeqLock::WriteGuard guard(write_lock());
+finish_pending();
+
+if (_options.concurrent_reads && !Options.concurrent_reads) {
+Forests[0].reserve_spanning_forest();
+// F_0 must not move either when a level is added
+Forests.reserve(L + 1);
+}
+for (auto &forest: Forests)
+forest.set_threads(_options.threads);
+Options = _options;
+}
+
+template <class Tree>
+const ConnectivityOptions &BasicDynamicConnectivity<Tree>::options() const {
+return Options;
+}
+
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::valid(const ConnectivityOptions &options) {
+if (options.samples < 0 || options.interleaved_budget < 0 ||
+options.threads < 1)
+return false;
+
+return !options.concurrent_reads ||
+(options.remove_budget < 0 && !Tree::self_adjusting);
+}
+
+template <class Tree>
+const SamplingStats &BasicDynamicConnectivity<Tree>::sampling_stats() const {
+return Sampling;
+}
+
+template <class Tree>
+const InterleavedStats &BasicDynamicConnectivity<Tree>::interleaved_stats() const {
+return Interleaved;
+}
+
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::set_event_handler(
+function <void(const ComponentEvent &)> handler) {
+EventHandler = handler;
+}
+
+/**
+* Checks whether vertices a and b are connected
+* Complexity: O(log n)
+*/
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::connected(int a, int b) {
+SeqLock::WriteGuard guard(query_lock());
+if (Forests[0].connected(a, b))
+return true;
+
+// only the two sides of a pending cut may still be connected
+if (Pending.active &&
+((Forests[0].connected(a, Pending.a) && Forests[0].connected(b, Pending.b)) ||
+(Forests[0].connected(a, Pending.b) && Forests[0].connected(b, Pending.a)))) {
+finish_pending();
+return Forests[0].connected(a, b);
+}
+
+return false;
+}
+
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::connected_batch(const vector <pair <int, int> > &queries,
+vector <bool> &answers) {
+SeqLock::WriteGuard guard(query_lock());
+finish_pending();
+Forests[0].connected_batch(queries, answers);
+}
+
+template <class Tree>
+int BasicDynamicConnectivity<Tree>::count_components() {
+SeqLock::WriteGuard guard(query_lock());
+finish_pending();
+return components;
+}
+
+template <class Tree>
+int BasicDynamicConnectivity<Tree>::component_size(int v) {
+SeqLock::WriteGuard guard(query_lock());
+finish_pending();
+return Forests[0].size(v);
+}
+
+template <class Tree>
+int BasicDynamicConnectivity<Tree>::largest_component() {
+SeqLock::WriteGuard guard(query_lock());
+finish_pending();
+return ComponentSizes.empty() ? 0 : ComponentSizes.rbegin()->first;
+}
+
+template <class Tree>
+vector <int> BasicDynamicConnectivity<Tree>::largest_components(int k) {
+SeqLock::WriteGuard guard(query_lock());
+finish_pending();
+
+vector <int> sizes;
+for (auto it = ComponentSizes.rbegin(); it != ComponentSizes.rend(); it++) {
+for (int i = 0; i < it->second && (int) sizes.size() < k; i++)
+sizes.push_back(it->first);
+if ((int) sizes.size() == k)
+break;
+}
+return sizes;
+}
+
+/**
+* Looks for a replacement of the edge (a,b) of the pending
+* remove among nontree edges on its current level.
+* Returns true if the search on this level ended, with found
+* telling whether a replacement was found, and false if it ran
+* out of the budget (work counts the units spent so far).
+*
+* Let A and B be the trees containing a and b (w.l.o.g let A_l
+* be the smaller one). In order to reconnect A and B suffices
+* to browse through all nontree edges with one endpoint in A.
+* The other endpoint will either be in A or in B (the (a,b) edge
+* has just been removed).
+* Since, by our invariant, A_i and B_i together have at most
+* n / 2^l vertices, A_i has at most n / 2^{l+1} of them.
+* Thus, we can promote its tree edges to the next level.
+* This way, each nontree edge with both endpoints in A can also
+* be promoted to the next level (there, it'll be a nontree edge
+* too). This allows us to account for the O(log n) operations
+* needed to process it. When we encounter a nontree edge with
+* one endpoint in A and another in B, we stop the procedure.
+*
+* Every promotion keeps the invariants, so the search can stop
+* after any edge and continue later: the tree edges of A which
+* are still on the level and the nontree edges which are still
+* stored in A are exactly those not processed yet. The nontree
+* edges are moved only once all the tree edges of A are, so that
+* their endpoints are connected on the next level.
+*
+* Complexity: O(log n) per each edge whose level grows by one
+* (amortized) plus O(log n) (not amortized)
+*
+*/
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::find_replacement(int &work, int budget,
+pair <int, int> &replacement, bool &found) {
+PendingRemove &p = Pending;
+int level = p.level;
+found = false;
+
+if (p.stage == SEARCH_START) {
+// the sampling and the interleaved search run whole, so
+// they start only within the budget
+if (work >= budget)
+return false;
+
+p.small = p.a;
+p.large = p.b;
+if (Forests[level].size(p.small) > Forests[level].size(p.large))
+swap(p.small, p.large);
+
+if (Options.samples > 0 &&
+sample_replacement(p.small, p.large, level, work, replacement))
+return found = true;
+
+if (Options.interleaved_budget > 0 &&
+search_both_sides(p.small, p.large, level, work, replacement, found))
+return true;
+
+add_level(level+1);
+p.stage = SEARCH_PROMOTE;
+}
+
+if (p.stage == SEARCH_PROMOTE) {
+// Promote tree edges from A to the next level:
+if (work < budget)
+promote_tree_edges(p.small, level, work, budget);
+if (work >= budget)
+return false;
+p.stage = SEARCH_SCAN;
+}
+
+// Browse through all nontree edges with one endpoint in A:
+bool stopped = false;
+Forests[level].pop_nontree_edges(p.small, [&](pair <int, int> edge) {
+work++;
+if (Forests[level].connected(edge.second, p.large)) {
+replacement = edge;
+found = true;
+return false;
+}
+
+EdgeInfo *info = Edges.find(edge.first, edge.second);
+info->level = level+1;
+info->nontree_hook =
+Forests[level+1].insert_nontree_edge(edge.first, edge.second);
+
+stopped = work >= budget;
+return !stopped;
+});
+
+return found || !stopped;
+}
+
+/**
+* Samples nontree edges of the component of a in F_level and
+* returns true when one of them leads to the component of b.
+* Such an edge is removed from F_level, like the replacement
+* found by the full search. Nothing else changes, so a miss
+* leaves the structure as it was.
+*/
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::sample_replacement(int a, int b, int level,
+int &work, pair <int, int> &replacement) {
+for (int i = 0; i < Options.samples; i++) {
+pair <int, int> edge;
+int handle = Forests[level].sample_nontree_edge(a, next_random(), edge);
+if (handle == -1)
+return false;
+
+// searches without any candidates are not counted
+if (i == 0)
+Sampling.searches++;
+Sampling.samples++;
+work++;
+if (Forests[level].connected(edge.second, b)) {
+Forests[level].remove_nontree_edge(handle);
+replacement = edge;
+Sampling.hits++;
+return true;
+}
+}
+
+return false;
+}
+
+/**
+* Looks at the nontree edges of the components of a (the
+* smaller one) and b in F_level in turns, within the budget.
+* Returns true if the search was decided: found tells if a
+* replacement was found (and removed from F_level like in the
+* full search) and false means that one side has no edges
+* leading to the other. The edges of a side are visited in the
+* order of its Euler tour, so the walks are never repeated.
+*/
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::search_both_sides(int a, int b, int level,
+int &work, pair <int, int> &replacement, bool &found) {
+NontreeCursor cursors[2] = {{a}, {b}};
+int other[2] = {b, a};
+found = false;
+
+for (int i = 0; i < Options.interleaved_budget; i++) {
+int side = i % 2;
+pair <int, int> edge;
+int handle = Forests[level].next_nontree_edge(cursors[side], edge);
+if (handle == -1) {
+// a search which looked at nothing is not counted
+if (i > 0)
+Interleaved.no_replacement++;
+return true;
+}
+
+if (i == 0)
+Interleaved.searches++;
+Interleaved.edges++;
+work++;
+
+if (Forests[level].connected(edge.second, other[side])) {
+Forests[level].remove_nontree_edge(handle);
+replacement = edge;
+found = true;
+if (side == 0)
+Interleaved.hits_smaller++;
+else
+Interleaved.hits_larger++;
+return true;
+}
+}
+
+return false;
+}
+
+/* xorshift64* (https://en.wikipedia.org/wiki/Xorshift) */
+template <class Tree>
+uint32_t BasicDynamicConnectivity<Tree>::next_random() {
+random_state ^= random_state >> 12;
+random_state ^= random_state << 25;
+random_state ^= random_state >> 27;
+return (random_state * 0x2545f4914f6cdd1dULL) >> 32;
+}
+
+/**
+* Moves the tree edges of the component of a in F_level to the
+* next level, streaming them from the traversal of F_level,
+* until work reaches the budget
+*/
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::promote_tree_edges(int a, int level,
+int &work, int budget) {
+Forests[level].promote_tree_edges(a, [&](pair <int, int> e) {
+Edges.find(e.first, e.second)->level = level+1;
+Forests[level+1].insert_tree_edge(e.first, e.second, true);
+return ++work < budget;
+});
+}
+
+/**
+* Removes an (a,b) edge from the graph and looks for its
+* replacement
+*
+* If it's a nontree edge, removing it does not impact
+* connectivity. Otherwise, after removing it, a and b
+* are in different trees at all levels. However, levels
+* where (a,b) used to exist can contain edges connecting
+* those trees.
+*
+* Complexity: O(log^2 n) (not amortized) and O(log n)
+* per each edge whose level grows by one (amortized)
+*/
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::remove(int a, int b) {
+
+SeqLock::WriteGuard guard(write_lock());
+finish_pending();
+
+// Check if the edge exists
+EdgeInfo *info = Edges.find(a, b);
+if (info == NULL)
+return;
+
+if (--info->cnt > 0)
+return;
+
+// Remove the edge:
+int level = info->level;
+bool tree = info->tree;
+int nontree_hook = info->nontree_hook;
+Edges.erase(info);
+
+if (!tree) {
+Forests[level].remove_nontree_edge(nontree_hook);
+release_empty_levels();
+return;
+}
+
+// the sizes of the trees of F_0, which stay split if no
+// replacement is found on any level
+pair <int, int> sizes;
+for (int l = 0; l <= level; l++) {
+auto split = Forests[l].remove_tree_edge(a,b);
+if (l == 0)
+sizes = split;
+}
+
+// Look for a replacement of the removed edge:
+Pending = {true, a, b, sizes, level, SEARCH_START, a, b};
+continue_remove(search_budget());
+}
+
+/**
+* Continues the search of the pending remove from the top level
+* down, until it finds a replacement, shows that there is none
+* or runs out of the budget. Returns whether it is still pending.
+*/
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::continue_remove(int budget) {
+PendingRemove &p = Pending;
+pair <int, int> replacement;
+bool found = false;
+int work = 0;
+
+while (p.level >= 0) {
+if (!find_replacement(work, budget, replacement, found))
+return true;
+if (found)
+break;
+
+p.level--;
+p.stage = SEARCH_START;
+}
+
+p.active = false;
+if (found)
+insert_edge(replacement.first, replacement.second, p.level,
+Edges.find(replacement.first, replacement.second));
+else
+split_component(p.a, p.b, p.sizes);
+
+release_empty_levels();
+return false;
+}
+
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::finish_pending() {
+if (Pending.active)
+continue_remove(INT_MAX);
+}
+
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::step() {
+SeqLock::WriteGuard guard(write_lock());
+return Pending.active && continue_remove(max(search_budget(), 1));
+}
+
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::pending() const {
+return Pending.active;
+}
+
+/* The work a remove or a step may do before the search is left pending */
+template <class Tree>
+int BasicDynamicConnectivity<Tree>::search_budget() const {
+return Options.remove_budget >= 0 ? Options.remove_budget : INT_MAX;
+}
+
+template <class Tree>
+SeqLock *BasicDynamicConnectivity<Tree>::write_lock() {
+return Options.concurrent_reads ? &ReadLock : NULL;
+}
+
+/**
+* A query writes F_0 only if it finishes a pending remove (the
+* sequence trees of the concurrent reads do not restructure
+* themselves on access); otherwise it only reads, and marking
+* a write would make the readers retry
+*/
+template <class Tree>
+SeqLock *BasicDynamicConnectivity<Tree>::query_lock() {
+return Pending.active ? write_lock() : NULL;
+}
+
+/**
+* Walks from a and b to the roots of their Euler tours in F_0
+* and retries until no update overlapped the walks. A walk
+* which gave up (NIL) or any other torn result of an overlap
+* is discarded by the validation.
+*/
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::concurrent_connected(int a, int b) const {
+if (a == b)
+return true;
+
+while (true) {
+uint64_t s = ReadLock.read_begin();
+node_t root_a = Forests[0].concurrent_root(a);
+node_t root_b = Forests[0].concurrent_root(b);
+if (ReadLock.read_validate(s))
+return root_a == root_b;
+}
+}
+
+/* Creates the (empty) forest of the given level if there is none yet */
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::add_level(int level) {
+if ((int) Forests.size() == level) {
+Forests.emplace_back(n, true);
+Forests.back().set_threads(Options.threads);
+}
+}
+
+/**
+* Drops the empty forests from the top of the hierarchy
+* (if F_i is empty, so are all the forests above it)
+* Complexity: O(1) per each dropped level plus the cost of
+* freeing its memory
+*/
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::release_empty_levels() {
+while (Forests.size() > 1 && Forests.back().empty())
+Forests.pop_back();
+}
+
+/**
+* Classifies the new edges in one sweep: an edge is a tree edge
+* if it joins two trees of F_0 which are not joined yet by
+* the tree edges of the batch seen so far.
+*/
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::insert_batch(const vector <pair <int, int> > &edges) {
+SeqLock::WriteGuard guard(write_lock());
+finish_pending();
+
+vector <pair <int, int> > links, nontree;
+
+// union-find over the trees of F_0 hit by the batch,
+// with the sizes of the components they form
+EdgeTable <int> TreeIds;
+UnionFind UF(2 * edges.size());
+vector <int> sizes;
+auto tree_index = [&](int v) {
+node_t t = Forests[0].tree_id(v);
+int *p = TreeIds.insert(t, t);
+if (*p == 0) {
+*p = TreeIds.size();
+sizes.push_back(Forests[0].tree_size(t));
+}
+return UF.find(*p - 1);
+};
+
+Edges.reserve(Edges.size() + edges.size());
+for (auto [a, b]: edges) {
+if (a == b)
+continue;
+
+EdgeInfo *info = Edges.insert(a, b);
+if (info->cnt++ > 0)
+continue;
+
+info->level = 0;
+int ta = tree_index(a), tb = tree_index(b);
+info->tree = UF.unite(ta, tb);
+if (info->tree) {
+links.push_back({a, b});
+join_components(a, b, {sizes[ta], sizes[tb]});
+sizes[UF.find(ta)] = sizes[ta] + sizes[tb];
+
+} else {
+nontree.push_back({a, b});
+}
+}
+
+// the tree ids are only valid until the forest is modified
+Forests[0].link_batch(links);
+
+for (auto [a, b]: nontree)
+Edges.find(a, b)->nontree_hook = Forests[0].insert_nontree_edge(a, b);
+}
+
+/**
+* Searches the component of v in F_level for edges leaving it,
+* as long as it is small enough (at most n / 2^{level+1}
+* vertices) to have its edges promoted to the next level and
+* it is not connected to the vertex largest.
+* Every edge found reconnects two fragments and becomes a tree
+* edge on the level.
+* Returns true if the search stopped because the component
+* became too large while still separate from largest.
+*/
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::reconnect_fragment(int v, int level,
+int largest) {
+if (v != largest && Forests[level].connected(v, largest))
+return false;
+
+while (((long long) Forests[level].size(v) << (level+1)) <= n) {
+
+add_level(level+1);
+
+// the fragment may have grown since the last promotion
+int work = 0;
+promote_tree_edges(v, level, work, INT_MAX);
+
+// the nontree edges inside the fragment go to the next
+// level, up to the first one leaving it
+pair <int, int> edge;
+bool leaving = false;
+Forests[level].pop_nontree_edges(v, [&](pair <int, int> e) {
+if (!Forests[level].connected(e.second, v)) {
+edge = e;
+leaving = true;
+return false;
+}
+
+EdgeInfo *info = Edges.find(e.first, e.second);
+info->level = level+1;
+info->nontree_hook =
+Forests[level+1].insert_nontree_edge(e.first, e.second);
+return true;
+});
+if (!leaving)
+return false;
+
+insert_edge(edge.first, edge.second, level,
+Edges.find(edge.first, edge.second));
+if (v != largest && Forests[level].connected(v, largest))
+return false;
+}
+
+return v != largest;
+}
+
+/**
+* Reconnects the fragments of the trees of F_level split by the
+* first k cuts, like the search for a replacement edge in remove
+* does for the smaller side of a single cut.
+*
+* Every fragment except the largest one of its original tree is
+* searched until it is connected to the largest one. Searches
+* end early only when a component becomes too large to have its
+* edges promoted, and as the original tree has at most
+* n / 2^level vertices, such a component is the only large one.
+* The largest fragment is then small and is searched itself,
+* so every edge between two fragments is found.
+*/
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::reconnect_fragments(
+const vector <pair <int, pair <int, int> > > &cuts, size_t k,
+int level) {
+Fragments F;
+find_fragments(cuts, k, level, F);
+int f_cnt = F.vertices.size();
+
+vector <bool> search_largest(f_cnt, false);
+for (int f = 0; f < f_cnt; f++) {
+int t = F.Trees.find(f), l = F.largest[t];
+if (f != l && reconnect_fragment(F.vertices[f], level, F.vertices[l]))
+search_largest[t] = true;
+}
+
+for (int t = 0; t < f_cnt; t++) {
+if (search_largest[t]) {
+int v = F.vertices[F.largest[t]];
+reconnect_fragment(v, level, v);
+}
+}
+
+if (level == 0)
+split_components(F);
+}
+
+/**
+* Finds the fragments of the trees of F_level split by the first
+* k cuts, with the original trees joining them and the largest
+* fragment of each
+*/
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::find_fragments(
+const vector <pair <int, pair <int, int> > > &cuts, size_t k,
+int level, Fragments &F) {
+ETTForest <Tree> &Forest = Forests[level];
+
+// an isolated vertex (with no node) is a fragment by itself
+auto fragment_index = [&](int v) {
+node_t t = Forest.tree_id(v);
+int *p = t == NIL ? F.Ids.insert(NIL, v) : F.Ids.insert(t, t);
+if (*p == 0) {
+F.vertices.push_back(v);
+*p = F.vertices.size();
+}
+return *p - 1;
+};
+
+// the cut edges join the fragments of an original tree
+F.Trees = UnionFind(2 * k);
+for (size_t i = 0; i < k; i++) {
+F.Trees.unite(fragment_index(cuts[i].second.first),
+fragment_index(cuts[i].second.second));
+}
+
+int f_cnt = F.vertices.size();
+F.largest.assign(f_cnt, -1);
+F.sizes.resize(f_cnt);
+for (int f = 0; f < f_cnt; f++) {
+int t = F.Trees.find(f);
+F.sizes[f] = Forest.size(F.vertices[f]);
+if (F.largest[t] == -1 || F.sizes[f] > F.sizes[F.largest[t]])
+F.largest[t] = f;
+}
+}
+
+/**
+* Records the net effect of a batch of removals on the
+* components: the fragments of every original component of F_0
+* which are still apart after the reconnection split off it one
+* by one (transient splits reconnected by the batch are never
+* reported)
+*/
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::split_components(Fragments &F) {
+const vector <int> &fragments = F.vertices, &sizes = F.sizes;
+UnionFind &Trees = F.Trees;
+// the size of every original component which is left and
+// its first fragment found to be apart
+vector <int> left(fragments.size(), 0), first(fragments.size(), -1);
+for (size_t f = 0; f < fragments.size(); f++)
+left[Trees.find(f)] += sizes[f];
+
+EdgeTable <bool> Seen;
+for (size_t f = 0; f < fragments.size(); f++) {
+node_t id = Forests[0].tree_id(fragments[f]);
+bool *seen = Seen.insert(id, id);
+if (*seen)
+continue;
+*seen = true;
+
+int t = Trees.find(f);
+if (first[t] == -1) {
+first[t] = f;
+continue;
+}
+
+int size = Forests[0].tree_size(id);
+left[t] -= size;
+split_component(fragments[first[t]], fragments[f], {left[t], size});
+}
+}
+
+/**
+* Removes the edges and cuts the tree edges among them (see
+* cut_batch). Then the fragments are reconnected from the top
+* level down, so that edges found on a level are already in
+* place when the level below is searched.
+*/
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::remove_batch(const vector <pair <int, int> > &edges) {
+SeqLock::WriteGuard guard(write_lock());
+finish_pending();
+
+vector <pair <int, pair <int, int> > > cuts;
+cut_batch(edges, cuts);
+
+size_t on_level = 0;
+for (int l = cuts.empty() ? -1 : cuts[0].first; l >= 0; l--) {
+while (on_level < cuts.size() && cuts[on_level].first >= l)
+on_level++;
+reconnect_fragments(cuts, on_level, l);
+}
+
+release_empty_levels();
+}
+
+/**
+* Removes the edges in a single sweep over the batch and cuts the
+* tree edges among them from all their levels. Sets cuts to these
+* edges with their levels, from the top level down, so that the
+* edges cut from a level form a prefix.
+*/
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::cut_batch(const vector <pair <int, int> > &edges,
+vector <pair <int, pair <int, int> > > &cuts) {
+for (auto [a, b]: edges) {
+EdgeInfo *info = Edges.find(a, b);
+if (info == NULL || --info->cnt > 0)
+continue;
+
+if (info->tree)
+cuts.push_back({info->level, {a, b}});
+else
+Forests[info->level].remove_nontree_edge(info->nontree_hook);
+Edges.erase(info);
+}
+
+if (cuts.empty())
+return;
+
+sort(cuts.rbegin(), cuts.rend());
+int top = cuts[0].first;
+vector <pair <int, int> > cut_edges;
+for (auto &cut: cuts)
+cut_edges.push_back(cut.second);
+
+// the forests of the levels share no memory, so the rounds
+// of cuts of all the levels run together (see plan_cuts)
+size_t on_level = 0;
+for (int l = top; l >= 0; l--) {
+while (on_level < cuts.size() && cuts[on_level].first >= l)
+on_level++;
+Forests[l].plan_cuts(cut_edges, on_level);
+}
+vector <pair <int, int> > tasks;
+while (true) {
+tasks.clear();
+for (int l = 0; l <= top; l++) {
+for (int i = 0; i < Forests[l].cut_tasks(); i++)
+tasks.push_back({l, i});
+}
+if (tasks.empty())
+break;
+
+parallel_for(Options.threads, tasks.size(), [&](int i) {
+Forests[tasks[i].first].cut_task(tasks[i].second);
+});
+for (int l = 0; l <= top; l++)
+Forests[l].next_cut_round();
+}
+for (int l = 0; l <= top; l++)
+Forests[l].finish_cuts();
+}
+
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::print() {
+#ifdef DBG
+for (int i = 0; i < (int) Forests.size(); i++) {
+debug ("--------------Level %d-------------------\n", i);
+Forests[i].print();
+}
+#endif
+}
+
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::correct() {
+SeqLock::WriteGuard guard(write_lock());
+finish_pending();
+
+if ((int) Forests.size() > L + 1)
+return false;
+
+// the statistics of the components
+vector <node_t> ids(n);
+for (int v = 0; v < n; v++)
+ids[v] = Forests[0].tree_id(v);
+sort(ids.begin(), ids.end());
+
+map <int, int> sizes;
+for (int i = 0, j = 0; i < n; i = j) {
+while (j < n && ids[j] == ids[i])
+j++;
+sizes[j - i]++;
+}
+if (sizes != ComponentSizes)
+return false;
+
+int count = 0;
+for (auto [size, cnt]: sizes)
+count += cnt;
+if (count != components)
+return false;
+
+for (int l = 0; l < (int) Forests.size(); l++) {
+if (!Forests[l].correct()) {
+return false;
+}
+}
+return Forests.size() == 1 || !Forests.back().empty();
+}
+
+template class BasicDynamicConnectivity<AVLTree>;
+template class BasicDynamicConnectivity<SplayTree>;
+template class BasicDynamicConnectivity<Treap>;
+template class BasicDynamicConnectivity<HookedTree<AVLTree> >;
+template class BasicDynamicConnectivity<HookedTree<SplayTree> >;
+template class BasicDynamicConnectivity<HookedTree<Treap> >;
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#ifndef ET_TREES_HPP
+#define ET_TREES_HPP
+
+#include <vector>
+#include <cstdint>
+#include <set>
+#ifndef AVL_TREE_HPP
+#define AVL_TREE_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <cassert>
+#ifndef TOUR_TREE_HPP
+#define TOUR_TREE_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <cassert>
+using namespace std;
+
+// A switch for managing debug output
+// #define DBG
+#ifdef DBG
+#define debug(...) fprintf(stderr, __VA_ARGS__), fflush(stderr)
+#else
+#define debug(...) {}
+#endif
+
+/* Nodes are addressed by 32-bit indices into the node array */
+typedef uint32_t node_t;
+
+/* Index of the sentinel node, which stands for an empty tree */
+const node_t NIL = 0;
+
+enum NodeFlags : uint8_t {
+/* the node represents a vertex (otherwise a tree edge) */
+VERTEX_NODE = 1,
+/* the node is a tree edge on the level of the forest */
+ON_LEVEL = 2
+};
+
+/**
+* A node of an Euler tour: either a vertex or one direction
+* of a tree edge (see et_trees.hpp). All the fields used while
+* restructuring the tree are packed into 32 bytes, so two nodes
+* share a cache line.
+*/
+struct TourNode {
+node_t left, right, parent;
+
+/* number of vertex nodes in the subtree of this node */
+int size;
+/* number of vertex nodes in the subtree storing nontree edges */
+int nontree_cnt;
+/* number of ON_LEVEL edge nodes in the subtree */
+int on_level_cnt;
+
+/**
+* Vertex nodes: the first record of the list of nontree
+* edges of the vertex (-1 if it is empty, see et_trees.hpp)
+* Edge nodes: the vertex the edge leads to
+*/
+int aux;
+
+/* height of the subtree (maintained only by AVLTree) */
+uint8_t height;
+uint8_t flags;
+};
+
+/**
+* Extra aggregates of the subtrees, maintained outside of the
+* nodes on behalf of a user of a forest: update(x, left, right)
+* is called whenever the aggregates of the node x are recomputed
+* from those of its children (NIL for a missing child).
+* Before a node past the array of nodes is updated, resize(k)
+* tells that the forest has grown to k nodes; update itself must
+* not grow the storage, as a forest may recompute the nodes of
+* different trees on several threads at once (see ETTForest::
+* link_batch and ETTForest::plan_cuts) and update may only write
+* the aggregates of x.
+*
+* The hook is a policy of the sequence trees (see TourTree):
+* only the trees instantiated with AggregateHook call it.
+*/
+class AggregateHook {
+public:
+static constexpr bool enabled = true;
+
+virtual void update(node_t x, node_t left, node_t right) = 0;
+virtual void resize(size_t) {}
+virtual ~AggregateHook() {}
+};
+
+/* The hook policy of the trees without extra aggregates */
+struct NoHook {
+static constexpr bool enabled = false;
+};
+
+/**
+* The part of a balanced sequence tree which does not depend on
+* the balancing scheme: the array of TourNodes owned by a forest,
+* allocation of nodes and the aggregates stored in them.
+*
+* Node 0 is a sentinel (NIL) whose aggregates are all zero, so
+* they can be summed without checking for missing children. Edge
+* nodes are allocated in pairs (e, e+1), one for each direction
+* of the edge; released nodes are reused before the array grows.
+*
+* ETTForest (et_trees.hpp) takes the sequence tree as a template
+* parameter. Besides the methods below, a sequence tree provides:
+*
+*   pair <node_t, node_t> split(node_t x);
+*   pair <node_t, node_t> split_around(node_t x);
+*   node_t merge(node_t left, node_t middle, node_t right);
+*   node_t root(node_t x);
+*   bool same_tree(node_t x, node_t y);
+*   void unlink(node_t x);
+*   node_t build(const node_t *seq, int k);
+*   bool correct_tree(node_t x, node_t correct_parent) const;
+*
+* with the semantics documented in avl_tree.hpp, and the alias
+*
+*   template <class OtherHook> using with_hook = ...;
+*
+* for the same tree with another hook policy. A sequence tree
+* may restructure the tree in any of them (even in root), so a
+* root returned by one call is only valid until the next one.
+* Only a tree which sets self_adjusting does so in root,
+* same_tree and find_nontree_edge; in the others, these only
+* read the tree and may run on several threads at once.
+* Implementations: AVLTree (avl_tree.hpp), SplayTree
+* (splay_tree.hpp) and Treap (treap.hpp).
+*
+* The Hook parameter is NoHook or AggregateHook. With NoHook,
+* the call of the hook is compiled out of every recomputation
+* of the aggregates; the trees are compiled for both policies
+* and HookedTree below names the one calling a hook.
+*/
+
+template <class Hook>
+class TourTree {
+public:
+typedef Hook hook_type;
+
+/* whether the queries restructure the tree (see above) */
+static constexpr bool self_adjusting = false;
+
+/* the number of walks of find_roots in flight */
+static constexpr int ROOT_WALKS = 32;
+
+TourTree();
+
+/**
+* Creates a new single-node tree representing a vertex
+* Complexity: O(1) (amortized)
+*/
+node_t new_vertex_node();
+
+/**
+* Releases the vertex node x, which must form
+* a single-node tree
+* Complexity: O(1)
+*/
+void free_vertex_node(node_t x);
+
+/**
+* Creates two single-node trees: e representing the edge
+* (a,b) (on the level if on_level is set) and e+1
+* representing the edge (b,a). Returns e.
+* Complexity: O(1) (amortized)
+*/
+node_t new_edge_nodes(int a, int b, bool on_level);
+
+/**
+* Releases the pair of edge nodes starting at e
+* Both of them must already be unlinked
+* Complexity: O(1)
+*/
+void free_edge_nodes(node_t e);
+
+const TourNode &operator[](node_t x) const {
+return Nodes[x];
+}
+
+/**
+* Sets the hook maintaining extra aggregates (or turns them
+* off if hook is NULL) and tells it the number of nodes.
+* The aggregates of the existing nodes are not recomputed.
+* With NoHook, the hook is never called.
+* Complexity: O(1) besides the resize of the hook
+*/
+void set_aggregate_hook(Hook *_hook);
+
+/**
+* Sets key to a number ordering x among the nodes of its
+* tree as the sequence does and root to the root of the
+* tree, without restructuring the tree. Returns false (and
+* no key) if x is deeper than MAX_KEY_DEPTH, as its path from
+* the root does not fit in the key then.
+* Complexity: O(depth of x)
+*/
+bool order_key(node_t x, uint64_t &key, node_t &root) const;
+static constexpr int MAX_KEY_DEPTH = 62;
+
+/**
+* Recomputes the aggregates of x and all its ancestors
+* Complexity: O(depth of x)
+*/
+void update_path(node_t x);
+
+/**
+* Returns the root of the tree containing x without
+* restructuring the tree (for diagnostics)
+*
+* Complexity: O(depth of x)
+*/
+node_t find_root(node_t x) const;
+
+/**
+* Like find_root, but loads the parent pointers atomically
+* (see set_parent), so that it may run while another thread
+* restructures the tree. The result is then meaningless and
+* must be validated by the caller (see SeqLock in
+* seqlock.hpp). Gives up and
+* returns NIL after limit steps, as a concurrent rotation may
+* close a cycle of parent pointers for a moment.
+*
+* Complexity: O(min(depth of x, limit))
+*/
+node_t find_root_concurrent(node_t x, int limit) const;
+
+/**
+* Sets roots[i] to find_root(xs[i]) for all i < k. Up to
+* ROOT_WALKS walks advance in lock-step, each prefetching
+* the next node on its path, so that the cache misses of
+* different walks overlap; a finished walk is replaced by
+* the next one right away.
+*
+* Complexity: O(sum of the depths of the nodes)
+*/
+void find_roots(const node_t *xs, int k, node_t *roots) const;
+
+/**
+* Reserves memory for k nodes (including NIL), so that the
+* array of nodes is not reallocated while it holds at most
+* k of them
+*
+* Complexity: O(k)
+*/
+void reserve(int k);
+
+/**
+* Appends the nodes of the tree rooted in x to seq (in
+* order) and turns each of them into a single-node tree
+* (to be reassembled with build)
+*
+* Complexity: O(size of the tree)
+*/
+void flatten(node_t x, vector <node_t> &seq);
+
+/**
+* Calls f(y) for every node y of the tree rooted in x, in
+* order, walking the parent pointers (without restructuring
+* the tree or allocating memory)
+*
+* Complexity: O(size of the tree)
+*/
+template <class F>
+void for_each_node(node_t x, F f) const;
+
+/**
+* Returns the r-th (from 0, in order) vertex node storing
+* nontree edges in the tree rooted in x or NIL if there are
+* at most r of them
+*
+* Complexity: O(height of the tree)
+*/
+node_t find_nontree_edge(node_t x, int r);
+
+/**
+* Calls f(v, head) for the vertex nodes v storing nontree
+* edges in the tree rooted in x, in order. head is the list
+* of v, which f may shorten by setting it to its remaining
+* part; f returns false to end the traversal. f must not
+* restructure the tree, but it may set the lists of other
+* vertex nodes (with set_nontree_head).
+*
+* The counters of the nodes above the lists emptied by f
+* are recomputed once, when the traversal leaves them.
+*
+* Complexity: O(k log(n/k)) plus the time of f, where k is
+* the number of vertex nodes visited
+*/
+template <class F>
+void scan_nontree_heads(node_t x, F f);
+
+/**
+* Sets the head of the list of nontree edges stored in
+* the vertex node x
+*
+* Complexity: O(depth of x) if the list becomes empty or
+* stops being empty, O(1) otherwise
+*/
+void set_nontree_head(node_t x, int head);
+
+/**
+* Unmarks the edge nodes marked as on_level in the tree
+* rooted in x and calls f(edge) with the edge (a,b) of each
+* of them, until f returns false. A single traversal, pruned
+* by the counters, visits only the marked nodes and their
+* ancestors and clears the counters on its way back up.
+* f must not modify the tree.
+*
+* Complexity: O(k log(n/k)) plus the time of f, where k is
+* the number of marked nodes
+*/
+template <class F>
+void take_on_level(node_t x, F f);
+
+void print_tree(node_t x, int indent = 0) const;
+void print_node(node_t x, int indent = 0) const;
+
+protected:
+vector <TourNode> Nodes;
+/* first released edge pair and vertex node (or NIL) */
+node_t free_pairs, free_vertices;
+Hook *hook;
+
+void set_parent(node_t x, node_t parent);
+void init_node(node_t x, const TourNode &init);
+void replace_child(node_t x, node_t old_child, node_t new_child);
+node_t build_balanced(const node_t *seq, int k);
+
+node_t descend_to_nontree_edge(node_t x, int r = 0) const;
+node_t descend_to_on_level(node_t x) const;
+pair <int, int> unmark_on_level(node_t x);
+
+void update_on_level_cnt(node_t x, int dx);
+void update_nontree_cnt(node_t x, int dx);
+void update_aggregates(node_t x);
+void grow_nodes(size_t k);
+
+bool correct_node(node_t x, node_t correct_parent) const;
+};
+
+/**
+* Every write of a parent goes through here: find_root_concurrent
+* loads the parents while the tree changes, so the stores must be
+* atomic. A store releases the node it links to, so that a walk
+* which reaches a newly allocated node also sees it initialized;
+* on x86 both sides are plain moves.
+*/
+template <class Hook>
+inline void TourTree<Hook>::set_parent(node_t x, node_t parent) {
+__atomic_store_n(&Nodes[x].parent, parent, __ATOMIC_RELEASE);
+}
+
+template <class Hook>
+inline void TourTree<Hook>::update_aggregates(node_t x) {
+TourNode &node = Nodes[x];
+const TourNode &l = Nodes[node.left];
+const TourNode &r = Nodes[node.right];
+bool vertex = node.flags & VERTEX_NODE;
+
+node.size = l.size + r.size + (vertex ? 1 : 0);
+node.on_level_cnt = l.on_level_cnt + r.on_level_cnt +
+((node.flags & ON_LEVEL) ? 1 : 0);
+node.nontree_cnt = l.nontree_cnt + r.nontree_cnt +
+((vertex && node.aux != -1) ? 1 : 0);
+
+if constexpr (Hook::enabled) {
+if (hook != NULL)
+hook->update(x, node.left, node.right);
+}
+}
+
+template <class Hook>
+template <class F>
+void TourTree<Hook>::for_each_node(node_t x, F f) const {
+if (x == NIL)
+return;
+
+node_t cur = x;
+while (Nodes[cur].left != NIL)
+cur = Nodes[cur].left;
+
+while (true) {
+f(cur);
+
+if (Nodes[cur].right != NIL) {
+// the successor is the first node of the right subtree
+cur = Nodes[cur].right;
+while (Nodes[cur].left != NIL)
+cur = Nodes[cur].left;
+
+} else {
+// the successor is the first ancestor entered from the left
+while (cur != x && Nodes[Nodes[cur].parent].right == cur)
+cur = Nodes[cur].parent;
+if (cur == x)
+return;
+cur = Nodes[cur].parent;
+}
+}
+}
+
+/**
+* Walks down into the subtrees with marked nodes first, then
+* unmarks the node itself and goes right. A node is left (with
+* its counter zeroed) only when nothing below it is marked, so
+* the walk comes back to every node at most twice. When f asks
+* to stop, only the counters on the path back to x are stale.
+*/
+template <class Hook>
+template <class F>
+void TourTree<Hook>::take_on_level(node_t x, F f) {
+node_t cur = x;
+
+while (Nodes[x].on_level_cnt > 0) {
+TourNode &node = Nodes[cur];
+
+if (Nodes[node.left].on_level_cnt > 0) {
+cur = node.left;
+continue;
+}
+if (node.flags & ON_LEVEL) {
+node.flags &= ~ON_LEVEL;
+if (!f(pair <int, int> (Nodes[cur+1].aux, node.aux))) {
+for (node_t y = cur; y != Nodes[x].parent; y = Nodes[y].parent) {
+Nodes[y].on_level_cnt = Nodes[Nodes[y].left].on_level_cnt +
+Nodes[Nodes[y].right].on_level_cnt +
+((Nodes[y].flags & ON_LEVEL) ? 1 : 0);
+}
+return;
+}
+}
+if (Nodes[node.right].on_level_cnt > 0) {
+cur = node.right;
+continue;
+}
+
+node.on_level_cnt = 0;
+cur = node.parent;
+}
+}
+
+/**
+* An in-order walk through the nodes with nontree edges below
+* them. The node the walk came from tells which part of a node
+* comes next. Once f asks to stop, the walk only goes back up to
+* the root, fixing the counters.
+*/
+template <class Hook>
+template <class F>
+void TourTree<Hook>::scan_nontree_heads(node_t x, F f) {
+node_t cur = x, prv = Nodes[x].parent;
+bool more = true;
+
+while (cur != Nodes[x].parent) {
+node_t left = Nodes[cur].left, right = Nodes[cur].right;
+
+if (prv == Nodes[cur].parent) {
+if (more && Nodes[left].nontree_cnt > 0) {
+prv = cur;
+cur = left;
+continue;
+}
+prv = left;
+}
+
+if (prv == left) {
+if (more && (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1) {
+int head = Nodes[cur].aux;
+more = f(cur, head);
+Nodes[cur].aux = head;
+}
+if (more && Nodes[right].nontree_cnt > 0) {
+prv = cur;
+cur = right;
+continue;
+}
+}
+
+bool own = (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1;
+Nodes[cur].nontree_cnt = Nodes[left].nontree_cnt +
+Nodes[right].nontree_cnt + (own ? 1 : 0);
+prv = cur;
+cur = Nodes[cur].parent;
+}
+}
+
+/* The sequence tree Tree calling an AggregateHook */
+template <class Tree>
+using HookedTree = typename Tree::template with_hook <AggregateHook>;
+
+#endif
+using namespace std;
+
+/**
+* AVL Binary Search Tree implementation
+* (https://en.wikipedia.org/wiki/AVL_tree)
+* over an array of TourNodes.
+*
+* The object owns the nodes of all the trees of a forest and
+* every operation takes node indices (see tour_tree.hpp).
+* Hook is the policy of the extra aggregates (see TourTree).
+*/
+
+template <class Hook = NoHook>
+class BasicAVLTree : public TourTree <Hook> {
+typedef TourTree <Hook> Base;
+
+public:
+template <class OtherHook>
+using with_hook = BasicAVLTree <OtherHook>;
+
+using Base::find_root;
+
+/**
+* Splits the tree into two parts and returns their roots.
+* The first part contains all nodes to the left of x
+* (inclusive), the second part contains all nodes to the
+* right of it (exclusive).
+*
+* Complexity: O(log n)
+*/
+pair <node_t, node_t> split(node_t x);
+
+/**
+* Removes x from its tree and splits the rest of it into
+* the nodes to the left of x and the nodes to the right of
+* it (both exclusive). Returns the roots of the two parts.
+* This is split followed by unlink in a single pass.
+*
+* Complexity: O(log n)
+*/
+pair <node_t, node_t> split_around(node_t x);
+
+/**
+* Merges two trees (left and right) into one (the middle
+* node is optional) and returns the its root.
+* The order of nodes is as follows:
+* left(unchanged), middle, right(unchanged).
+*
+* Complexity if middle is NIL: O(max(h_l, h_r))
+* Complexity if middle is not NIL: O(abs(h_l - h_r))
+* Here h_l and h_r are the heights of left and right trees
+*/
+node_t merge(node_t left, node_t middle, node_t right);
+
+/**
+* Returns the root of the tree containing x
+*
+* Complexity: O(log n)
+*/
+node_t root(node_t x) const;
+
+/**
+* Checks whether x and y belong to the same tree
+*
+* Complexity: O(log n)
+*/
+bool same_tree(node_t x, node_t y) const;
+
+/**
+* Removes x from the tree it belongs to
+*
+* Complexity: O(log n)
+*/
+void unlink(node_t x);
+
+/**
+* Builds a tree from the single-node trees seq[0..k-1]
+* (in this order) and returns its root
+*
+* Complexity: O(k)
+*/
+node_t build(const node_t *seq, int k);
+
+/**
+* Checks if the invariants hold in the subtree of x
+*
+* Complexity: linear in the size of the tree
+*/
+bool correct_tree(node_t x, node_t correct_parent) const;
+
+private:
+using Base::Nodes;
+using Base::set_parent;
+using Base::update_aggregates;
+using Base::replace_child;
+using Base::build_balanced;
+using Base::correct_node;
+
+node_t balance(node_t x);
+node_t rebalance_path(node_t x, node_t top);
+node_t rotate_left(node_t x);
+node_t rotate_right(node_t x);
+node_t remove(node_t x);
+void detach(node_t x);
+pair <node_t, node_t> split_path(node_t x, node_t cur,
+node_t left_tree, node_t right_tree);
+
+void update_statistics(node_t x);
+};
+
+template <class Hook>
+inline void BasicAVLTree<Hook>::update_statistics(node_t x) {
+TourNode &node = Nodes[x];
+node.height = max(Nodes[node.left].height, Nodes[node.right].height) + 1;
+update_aggregates(x);
+}
+
+typedef BasicAVLTree <> AVLTree;
+
+#endif
+#ifndef SPLAY_TREE_HPP
+#define SPLAY_TREE_HPP
+
+#include <utility>
+#ifndef TOUR_TREE_HPP
+#define TOUR_TREE_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <cassert>
+using namespace std;
+
+// A switch for managing debug output
+// #define DBG
+#ifdef DBG
+#define debug(...) fprintf(stderr, __VA_ARGS__), fflush(stderr)
+#else
+#define debug(...) {}
+#endif
+
+/* Nodes are addressed by 32-bit indices into the node array */
+typedef uint32_t node_t;
+
+/* Index of the sentinel node, which stands for an empty tree */
+const node_t NIL = 0;
+
+enum NodeFlags : uint8_t {
+/* the node represents a vertex (otherwise a tree edge) */
+VERTEX_NODE = 1,
+/* the node is a tree edge on the level of the forest */
+ON_LEVEL = 2
+};
+
+/**
+* A node of an Euler tour: either a vertex or one direction
+* of a tree edge (see et_trees.hpp). All the fields used while
+* restructuring the tree are packed into 32 bytes, so two nodes
+* share a cache line.
+*/
+struct TourNode {
+node_t left, right, parent;
+
+/* number of vertex nodes in the subtree of this node */
+int size;
+/* number of vertex nodes in the subtree storing nontree edges */
+int nontree_cnt;
+/* number of ON_LEVEL edge nodes in the subtree */
+int on_level_cnt;
+
+/**
+* Vertex nodes: the first record of the list of nontree
+* edges of the vertex (-1 if it is empty, see et_trees.hpp)
+* Edge nodes: the vertex the edge leads to
+*/
+int aux;
+
+/* height of the subtree (maintained only by AVLTree) */
+uint8_t height;
+uint8_t flags;
+};
+
+/**
+* Extra aggregates of the subtrees, maintained outside of the
+* nodes on behalf of a user of a forest: update(x, left, right)
+* is called whenever the aggregates of the node x are recomputed
+* from those of its children (NIL for a missing child).
+* Before a node past the array of nodes is updated, resize(k)
+* tells that the forest has grown to k nodes; update itself must
+* not grow the storage, as a forest may recompute the nodes of
+* different trees on several threads at once (see ETTForest::
+* link_batch and ETTForest::plan_cuts) and update may only write
+* the aggregates of x.
+*
+* The hook is a policy of the sequence trees (see TourTree):
+* only the trees instantiated with AggregateHook call it.
+*/
+class AggregateHook {
+public:
+static constexpr bool enabled = true;
+
+virtual void update(node_t x, node_t left, node_t right) = 0;
+virtual void resize(size_t) {}
+virtual ~AggregateHook() {}
+};
+
+/* The hook policy of the trees without extra aggregates */
+struct NoHook {
+static constexpr bool enabled = false;
+};
+
+/**
+* The part of a balanced sequence tree which does not depend on
+* the balancing scheme: the array of TourNodes owned by a forest,
+* allocation of nodes and the aggregates stored in them.
+*
+* Node 0 is a sentinel (NIL) whose aggregates are all zero, so
+* they can be summed without checking for missing children. Edge
+* nodes are allocated in pairs (e, e+1), one for each direction
+* of the edge; released nodes are reused before the array grows.
+*
+* ETTForest (et_trees.hpp) takes the sequence tree as a template
+* parameter. Besides the methods below, a sequence tree provides:
+*
+*   pair <node_t, node_t> split(node_t x);
+*   pair <node_t, node_t> split_around(node_t x);
+*   node_t merge(node_t left, node_t middle, node_t right);
+*   node_t root(node_t x);
+*   bool same_tree(node_t x, node_t y);
+*   void unlink(node_t x);
+*   node_t build(const node_t *seq, int k);
+*   bool correct_tree(node_t x, node_t correct_parent) const;
+*
+* with the semantics documented in avl_tree.hpp, and the alias
+*
+*   template <class OtherHook> using with_hook = ...;
+*
+* for the same tree with another hook policy. A sequence tree
+* may restructure the tree in any of them (even in root), so a
+* root returned by one call is only valid until the next one.
+* Only a tree which sets self_adjusting does so in root,
+* same_tree and find_nontree_edge; in the others, these only
+* read the tree and may run on several threads at once.
+* Implementations: AVLTree (avl_tree.hpp), SplayTree
+* (splay_tree.hpp) and Treap (treap.hpp).
+*
+* The Hook parameter is NoHook or AggregateHook. With NoHook,
+* the call of the hook is compiled out of every recomputation
+* of the aggregates; the trees are compiled for both policies
+* and HookedTree below names the one calling a hook.
+*/
+
+template <class Hook>
+class TourTree {
+public:
+typedef Hook hook_type;
+
+/* whether the queries restructure the tree (see above) */
+static constexpr bool self_adjusting = false;
+
+/* the number of walks of find_roots in flight */
+static constexpr int ROOT_WALKS = 32;
+
+TourTree();
+
+/**
+* Creates a new single-node tree representing a vertex
+* Complexity: O(1) (amortized)
+*/
+node_t new_vertex_node();
+
+/**
+* Releases the vertex node x, which must form
+* a single-node tree
+* Complexity: O(1)
+*/
+void free_vertex_node(node_t x);
+
+/**
+* Creates two single-node trees: e representing the edge
+* (a,b) (on the level if on_level is set) and e+1
+* representing the edge (b,a). Returns e.
+* Complexity: O(1) (amortized)
+*/
+node_t new_edge_nodes(int a, int b, bool on_level);
+
+/**
+* Releases the pair of edge nodes starting at e
+* Both of them must already be unlinked
+* Complexity: O(1)
+*/
+void free_edge_nodes(node_t e);
+
+const TourNode &operator[](node_t x) const {
+return Nodes[x];
+}
+
+/**
+* Sets the hook maintaining extra aggregates (or turns them
+* off if hook is NULL) and tells it the number of nodes.
+* The aggregates of the existing nodes are not recomputed.
+* With NoHook, the hook is never called.
+* Complexity: O(1) besides the resize of the hook
+*/
+void set_aggregate_hook(Hook *_hook);
+
+/**
+* Sets key to a number ordering x among the nodes of its
+* tree as the sequence does and root to the root of the
+* tree, without restructuring the tree. Returns false (and
+* no key) if x is deeper than MAX_KEY_DEPTH, as its path from
+* the root does not fit in the key then.
+* Complexity: O(depth of x)
+*/
+bool order_key(node_t x, uint64_t &key, node_t &root) const;
+static constexpr int MAX_KEY_DEPTH = 62;
+
+/**
+* Recomputes the aggregates of x and all its ancestors
+* Complexity: O(depth of x)
+*/
+void update_path(node_t x);
+
+/**
+* Returns the root of the tree containing x without
+* restructuring the tree (for diagnostics)
+*
+* Complexity: O(depth of x)
+*/
+node_t find_root(node_t x) const;
+
+/**
+* Like find_root, but loads the parent pointers atomically
+* (see set_parent), so that it may run while another thread
+* restructures the tree. The result is then meaningless and
+* must be validated by the caller (see SeqLock in
+* seqlock.hpp). Gives up and
+* returns NIL after limit steps, as a concurrent rotation may
+* close a cycle of parent pointers for a moment.
+*
+* Complexity: O(min(depth of x, limit))
+*/
+node_t find_root_concurrent(node_t x, int limit) const;
+
+/**
+* Sets roots[i] to find_root(xs[i]) for all i < k. Up to
+* ROOT_WALKS walks advance in lock-step, each prefetching
+* the next node on its path, so that the cache misses of
+* different walks overlap; a finished walk is replaced by
+* the next one right away.
+*
+* Complexity: O(sum of the depths of the nodes)
+*/
+void find_roots(const node_t *xs, int k, node_t *roots) const;
+
+/**
+* Reserves memory for k nodes (including NIL), so that the
+* array of nodes is not reallocated while it holds at most
+* k of them
+*
+* Complexity: O(k)
+*/
+void reserve(int k);
+
+/**
+* Appends the nodes of the tree rooted in x to seq (in
+* order) and turns each of them into a single-node tree
+* (to be reassembled with build)
+*
+* Complexity: O(size of the tree)
+*/
+void flatten(node_t x, vector <node_t> &seq);
+
+/**
+* Calls f(y) for every node y of the tree rooted in x, in
+* order, walking the parent pointers (without restructuring
+* the tree or allocating memory)
+*
+* Complexity: O(size of the tree)
+*/
+template <class F>
+void for_each_node(node_t x, F f) const;
+
+/**
+* Returns the r-th (from 0, in order) vertex node storing
+* nontree edges in the tree rooted in x or NIL if there are
+* at most r of them
+*
+* Complexity: O(height of the tree)
+*/
+node_t find_nontree_edge(node_t x, int r);
+
+/**
+* Calls f(v, head) for the vertex nodes v storing nontree
+* edges in the tree rooted in x, in order. head is the list
+* of v, which f may shorten by setting it to its remaining
+* part; f returns false to end the traversal. f must not
+* restructure the tree, but it may set the lists of other
+* vertex nodes (with set_nontree_head).
+*
+* The counters of the nodes above the lists emptied by f
+* are recomputed once, when the traversal leaves them.
+*
+* Complexity: O(k log(n/k)) plus the time of f, where k is
+* the number of vertex nodes visited
+*/
+template <class F>
+void scan_nontree_heads(node_t x, F f);
+
+/**
+* Sets the head of the list of nontree edges stored in
+* the vertex node x
+*
+* Complexity: O(depth of x) if the list becomes empty or
+* stops being empty, O(1) otherwise
+*/
+void set_nontree_head(node_t x, int head);
+
+/**
+* Unmarks the edge nodes marked as on_level in the tree
+* rooted in x and calls f(edge) with the edge (a,b) of each
+* of them, until f returns false. A single traversal, pruned
+* by the counters, visits only the marked nodes and their
+* ancestors and clears the counters on its way back up.
+* f must not modify the tree.
+*
+* Complexity: O(k log(n/k)) plus the time of f, where k is
+* the number of marked nodes
+*/
+template <class F>
+void take_on_level(node_t x, F f);
+
+void print_tree(node_t x, int indent = 0) const;
+void print_node(node_t x, int indent = 0) const;
+
+protected:
+vector <TourNode> Nodes;
+/* first released edge pair and vertex node (or NIL) */
+node_t free_pairs, free_vertices;
+Hook *hook;
+
+void set_parent(node_t x, node_t parent);
+void init_node(node_t x, const TourNode &init);
+void replace_child(node_t x, node_t old_child, node_t new_child);
+node_t build_balanced(const node_t *seq, int k);
+
+node_t descend_to_nontree_edge(node_t x, int r = 0) const;
+node_t descend_to_on_level(node_t x) const;
+pair <int, int> unmark_on_level(node_t x);
+
+void update_on_level_cnt(node_t x, int dx);
+void update_nontree_cnt(node_t x, int dx);
+void update_aggregates(node_t x);
+void grow_nodes(size_t k);
+
+bool correct_node(node_t x, node_t correct_parent) const;
+};
+
+/**
+* Every write of a parent goes through here: find_root_concurrent
+* loads the parents while the tree changes, so the stores must be
+* atomic. A store releases the node it links to, so that a walk
+* which reaches a newly allocated node also sees it initialized;
+* on x86 both sides are plain moves.
+*/
+template <class Hook>
+inline void TourTree<Hook>::set_parent(node_t x, node_t parent) {
+__atomic_store_n(&Nodes[x].parent, parent, __ATOMIC_RELEASE);
+}
+
+template <class Hook>
+inline void TourTree<Hook>::update_aggregates(node_t x) {
+TourNode &node = Nodes[x];
+const TourNode &l = Nodes[node.left];
+const TourNode &r = Nodes[node.right];
+bool vertex = node.flags & VERTEX_NODE;
+
+node.size = l.size + r.size + (vertex ? 1 : 0);
+node.on_level_cnt = l.on_level_cnt + r.on_level_cnt +
+((node.flags & ON_LEVEL) ? 1 : 0);
+node.nontree_cnt = l.nontree_cnt + r.nontree_cnt +
+((vertex && node.aux != -1) ? 1 : 0);
+
+if constexpr (Hook::enabled) {
+if (hook != NULL)
+hook->update(x, node.left, node.right);
+}
+}
+
+template <class Hook>
+template <class F>
+void TourTree<Hook>::for_each_node(node_t x, F f) const {
+if (x == NIL)
+return;
+
+node_t cur = x;
+while (Nodes[cur].left != NIL)
+cur = Nodes[cur].left;
+
+while (true) {
+f(cur);
+
+if (Nodes[cur].right != NIL) {
+// the successor is the first node of the right subtree
+cur = Nodes[cur].right;
+while (Nodes[cur].left != NIL)
+cur = Nodes[cur].left;
+
+} else {
+// the successor is the first ancestor entered from the left
+while (cur != x && Nodes[Nodes[cur].parent].right == cur)
+cur = Nodes[cur].parent;
+if (cur == x)
+return;
+cur = Nodes[cur].parent;
+}
+}
+}
+
+/**
+* Walks down into the subtrees with marked nodes first, then
+* unmarks the node itself and goes right. A node is left (with
+* its counter zeroed) only when nothing below it is marked, so
+* the walk comes back to every node at most twice. When f asks
+* to stop, only the counters on the path back to x are stale.
+*/
+template <class Hook>
+template <class F>
+void TourTree<Hook>::take_on_level(node_t x, F f) {
+node_t cur = x;
+
+while (Nodes[x].on_level_cnt > 0) {
+TourNode &node = Nodes[cur];
+
+if (Nodes[node.left].on_level_cnt > 0) {
+cur = node.left;
+continue;
+}
+if (node.flags & ON_LEVEL) {
+node.flags &= ~ON_LEVEL;
+if (!f(pair <int, int> (Nodes[cur+1].aux, node.aux))) {
+for (node_t y = cur; y != Nodes[x].parent; y = Nodes[y].parent) {
+Nodes[y].on_level_cnt = Nodes[Nodes[y].left].on_level_cnt +
+Nodes[Nodes[y].right].on_level_cnt +
+((Nodes[y].flags & ON_LEVEL) ? 1 : 0);
+}
+return;
+}
+}
+if (Nodes[node.right].on_level_cnt > 0) {
+cur = node.right;
+continue;
+}
+
+node.on_level_cnt = 0;
+cur = node.parent;
+}
+}
+
+/**
+* An in-order walk through the nodes with nontree edges below
+* them. The node the walk came from tells which part of a node
+* comes next. Once f asks to stop, the walk only goes back up to
+* the root, fixing the counters.
+*/
+template <class Hook>
+template <class F>
+void TourTree<Hook>::scan_nontree_heads(node_t x, F f) {
+node_t cur = x, prv = Nodes[x].parent;
+bool more = true;
+
+while (cur != Nodes[x].parent) {
+node_t left = Nodes[cur].left, right = Nodes[cur].right;
+
+if (prv == Nodes[cur].parent) {
+if (more && Nodes[left].nontree_cnt > 0) {
+prv = cur;
+cur = left;
+continue;
+}
+prv = left;
+}
+
+if (prv == left) {
+if (more && (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1) {
+int head = Nodes[cur].aux;
+more = f(cur, head);
+Nodes[cur].aux = head;
+}
+if (more && Nodes[right].nontree_cnt > 0) {
+prv = cur;
+cur = right;
+continue;
+}
+}
+
+bool own = (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1;
+Nodes[cur].nontree_cnt = Nodes[left].nontree_cnt +
+Nodes[right].nontree_cnt + (own ? 1 : 0);
+prv = cur;
+cur = Nodes[cur].parent;
+}
+}
+
+/* The sequence tree Tree calling an AggregateHook */
+template <class Tree>
+using HookedTree = typename Tree::template with_hook <AggregateHook>;
+
+#endif
+using namespace std;
+
+/**
+* Splay tree implementation
+* (https://en.wikipedia.org/wiki/Splay_tree)
+* over an array of TourNodes.
+*
+* Every operation splays the node it accesses to the root, so
+* recently used parts of the Euler tours stay near the roots.
+* A merge with a middle node and a split take just a splay and
+* O(1) relinking, which makes link and cut cheap. All the bounds
+* below are amortized over a sequence of operations.
+* Hook is the policy of the extra aggregates (see TourTree).
+*/
+
+template <class Hook = NoHook>
+class BasicSplayTree : public TourTree <Hook> {
+typedef TourTree <Hook> Base;
+
+public:
+template <class OtherHook>
+using with_hook = BasicSplayTree <OtherHook>;
+
+/* every access splays the node it reaches */
+static constexpr bool self_adjusting = true;
+
+/**
+* Splits the tree into two parts and returns their roots.
+* The first part contains all nodes to the left of x
+* (inclusive), the second part contains all nodes to the
+* right of it (exclusive).
+*
+* Complexity: O(log n) (amortized)
+*/
+pair <node_t, node_t> split(node_t x);
+
+/**
+* Removes x from its tree and splits the rest of it into
+* the nodes to the left and to the right of x (exclusive)
+*
+* Complexity: O(log n) (amortized)
+*/
+pair <node_t, node_t> split_around(node_t x);
+
+/**
+* Merges two trees (left and right) into one (the middle
+* node is optional) and returns its root.
+* The order of nodes is as follows:
+* left(unchanged), middle, right(unchanged).
+*
+* Complexity if middle is NIL: O(log n) (amortized)
+* Complexity if middle is not NIL: O(1)
+*/
+node_t merge(node_t left, node_t middle, node_t right);
+
+/**
+* Splays x to the root of its tree and returns it
+*
+* Complexity: O(log n) (amortized)
+*/
+node_t root(node_t x);
+
+/**
+* Checks whether x and y belong to the same tree
+*
+* Complexity: O(log n) (amortized)
+*/
+bool same_tree(node_t x, node_t y);
+
+/**
+* Removes x from the tree it belongs to
+*
+* Complexity: O(log n) (amortized)
+*/
+void unlink(node_t x);
+
+/**
+* Builds a tree from the single-node trees seq[0..k-1]
+* (in this order) and returns its root
+*
+* Complexity: O(k)
+*/
+node_t build(const node_t *seq, int k);
+
+/**
+* As in TourTree, but every node found is splayed to the root
+* (which pays for the descent to it) and the next one is
+* looked for from there
+*/
+node_t find_nontree_edge(node_t x, int r);
+template <class F>
+void scan_nontree_heads(node_t x, F f);
+template <class F>
+void take_on_level(node_t x, F f);
+void set_nontree_head(node_t x, int head);
+
+/**
+* Checks if the invariants hold in the subtree of x
+*
+* Complexity: linear in the size of the tree
+*/
+bool correct_tree(node_t x, node_t correct_parent) const;
+
+private:
+using Base::Nodes;
+using Base::set_parent;
+using Base::update_aggregates;
+using Base::replace_child;
+using Base::build_balanced;
+using Base::correct_node;
+using Base::descend_to_nontree_edge;
+using Base::descend_to_on_level;
+using Base::unmark_on_level;
+
+void rotate(node_t x);
+void splay(node_t x);
+};
+
+template <class Hook>
+template <class F>
+void BasicSplayTree<Hook>::scan_nontree_heads(node_t x, F f) {
+node_t v = descend_to_nontree_edge(x);
+while (v != NIL) {
+splay(v);
+int head = Nodes[v].aux;
+bool more = f(v, head);
+
+// f may have splayed other nodes
+set_nontree_head(v, head);
+if (!more)
+return;
+v = descend_to_nontree_edge(v);
+}
+}
+
+template <class Hook>
+template <class F>
+void BasicSplayTree<Hook>::take_on_level(node_t x, F f) {
+node_t cur = descend_to_on_level(x);
+while (cur != NIL) {
+splay(cur);
+if (!f(unmark_on_level(cur)))
+return;
+cur = descend_to_on_level(cur);
+}
+}
+
+typedef BasicSplayTree <> SplayTree;
+
+#endif
+#ifndef TREAP_HPP
+#define TREAP_HPP
+
+#include <utility>
+#ifndef TOUR_TREE_HPP
+#define TOUR_TREE_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <cassert>
+using namespace std;
+
+// A switch for managing debug output
+// #define DBG
+#ifdef DBG
+#define debug(...) fprintf(stderr, __VA_ARGS__), fflush(stderr)
+#else
+#define debug(...) {}
+#endif
+
+/* Nodes are addressed by 32-bit indices into the node array */
+typedef uint32_t node_t;
+
+/* Index of the sentinel node, which stands for an empty tree */
+const node_t NIL = 0;
+
+enum NodeFlags : uint8_t {
+/* the node represents a vertex (otherwise a tree edge) */
+VERTEX_NODE = 1,
+/* the node is a tree edge on the level of the forest */
+ON_LEVEL = 2
+};
+
+/**
+* A node of an Euler tour: either a vertex or one direction
+* of a tree edge (see et_trees.hpp). All the fields used while
+* restructuring the tree are packed into 32 bytes, so two nodes
+* share a cache line.
+*/
+struct TourNode {
+node_t left, right, parent;
+
+/* number of vertex nodes in the subtree of this node */
+int size;
+/* number of vertex nodes in the subtree storing nontree edges */
+int nontree_cnt;
+/* number of ON_LEVEL edge nodes in the subtree */
+int on_level_cnt;
+
+/**
+* Vertex nodes: the first record of the list of nontree
+* edges of the vertex (-1 if it is empty, see et_trees.hpp)
+* Edge nodes: the vertex the edge leads to
+*/
+int aux;
+
+/* height of the subtree (maintained only by AVLTree) */
+uint8_t height;
+uint8_t flags;
+};
+
+/**
+* Extra aggregates of the subtrees, maintained outside of the
+* nodes on behalf of a user of a forest: update(x, left, right)
+* is called whenever the aggregates of the node x are recomputed
+* from those of its children (NIL for a missing child).
+* Before a node past the array of nodes is updated, resize(k)
+* tells that the forest has grown to k nodes; update itself must
+* not grow the storage, as a forest may recompute the nodes of
+* different trees on several threads at once (see ETTForest::
+* link_batch and ETTForest::plan_cuts) and update may only write
+* the aggregates of x.
+*
+* The hook is a policy of the sequence trees (see TourTree):
+* only the trees instantiated with AggregateHook call it.
+*/
+class AggregateHook {
+public:
+static constexpr bool enabled = true;
+
+virtual void update(node_t x, node_t left, node_t right) = 0;
+virtual void resize(size_t) {}
+virtual ~AggregateHook() {}
+};
+
+/* The hook policy of the trees without extra aggregates */
+struct NoHook {
+static constexpr bool enabled = false;
+};
+
+/**
+* The part of a balanced sequence tree which does not depend on
+* the balancing scheme: the array of TourNodes owned by a forest,
+* allocation of nodes and the aggregates stored in them.
+*
+* Node 0 is a sentinel (NIL) whose aggregates are all zero, so
+* they can be summed without checking for missing children. Edge
+* nodes are allocated in pairs (e, e+1), one for each direction
+* of the edge; released nodes are reused before the array grows.
+*
+* ETTForest (et_trees.hpp) takes the sequence tree as a template
+* parameter. Besides the methods below, a sequence tree provides:
+*
+*   pair <node_t, node_t> split(node_t x);
+*   pair <node_t, node_t> split_around(node_t x);
+*   node_t merge(node_t left, node_t middle, node_t right);
+*   node_t root(node_t x);
+*   bool same_tree(node_t x, node_t y);
+*   void unlink(node_t x);
+*   node_t build(const node_t *seq, int k);
+*   bool correct_tree(node_t x, node_t correct_parent) const;
+*
+* with the semantics documented in avl_tree.hpp, and the alias
+*
+*   template <class OtherHook> using with_hook = ...;
+*
+* for the same tree with another hook policy. A sequence tree
+* may restructure the tree in any of them (even in root), so a
+* root returned by one call is only valid until the next one.
+* Only a tree which sets self_adjusting does so in root,
+* same_tree and find_nontree_edge; in the others, these only
+* read the tree and may run on several threads at once.
+* Implementations: AVLTree (avl_tree.hpp), SplayTree
+* (splay_tree.hpp) and Treap (treap.hpp).
+*
+* The Hook parameter is NoHook or AggregateHook. With NoHook,
+* the call of the hook is compiled out of every recomputation
+* of the aggregates; the trees are compiled for both policies
+* and HookedTree below names the one calling a hook.
+*/
+
+template <class Hook>
+class TourTree {
+public:
+typedef Hook hook_type;
+
+/* whether the queries restructure the tree (see above) */
+static constexpr bool self_adjusting = false;
+
+/* the number of walks of find_roots in flight */
+static constexpr int ROOT_WALKS = 32;
+
+TourTree();
+
+/**
+* Creates a new single-node tree representing a vertex
+* Complexity: O(1) (amortized)
+*/
+node_t new_vertex_node();
+
+/**
+* Releases the vertex node x, which must form
+* a single-node tree
+* Complexity: O(1)
+*/
+void free_vertex_node(node_t x);
+
+/**
+* Creates two single-node trees: e representing the edge
+* (a,b) (on the level if on_level is set) and e+1
+* representing the edge (b,a). Returns e.
+* Complexity: O(1) (amortized)
+*/
+node_t new_edge_nodes(int a, int b, bool on_level);
+
+/**
+* Releases the pair of edge nodes starting at e
+* Both of them must already be unlinked
+* Complexity: O(1)
+*/
+void free_edge_nodes(node_t e);
+
+const TourNode &operator[](node_t x) const {
+return Nodes[x];
+}
+
+/**
+* Sets the hook maintaining extra aggregates (or turns them
+* off if hook is NULL) and tells it the number of nodes.
+* The aggregates of the existing nodes are not recomputed.
+* With NoHook, the hook is never called.
+* Complexity: O(1) besides the resize of the hook
+*/
+void set_aggregate_hook(Hook *_hook);
+
+/**
+* Sets key to a number ordering x among the nodes of its
+* tree as the sequence does and root to the root of the
+* tree, without restructuring the tree. Returns false (and
+* no key) if x is deeper than MAX_KEY_DEPTH, as its path from
+* the root does not fit in the key then.
+* Complexity: O(depth of x)
+*/
+bool order_key(node_t x, uint64_t &key, node_t &root) const;
+static constexpr int MAX_KEY_DEPTH = 62;
+
+/**
+* Recomputes the aggregates of x and all its ancestors
+* Complexity: O(depth of x)
+*/
+void update_path(node_t x);
+
+/**
+* Returns the root of the tree containing x without
+* restructuring the tree (for diagnostics)
+*
+* Complexity: O(depth of x)
+*/
+node_t find_root(node_t x) const;
+
+/**
+* Like find_root, but loads the parent pointers atomically
+* (see set_parent), so that it may run while another thread
+* restructures the tree. The result is then meaningless and
+* must be validated by the caller (see SeqLock in
+* seqlock.hpp). Gives up and
+* returns NIL after limit steps, as a concurrent rotation may
+* close a cycle of parent pointers for a moment.
+*
+* Complexity: O(min(depth of x, limit))
+*/
+node_t find_root_concurrent(node_t x, int limit) const;
+
+/**
+* Sets roots[i] to find_root(xs[i]) for all i < k. Up to
+* ROOT_WALKS walks advance in lock-step, each prefetching
+* the next node on its path, so that the cache misses of
+* different walks overlap; a finished walk is replaced by
+* the next one right away.
+*
+* Complexity: O(sum of the depths of the nodes)
+*/
+void find_roots(const node_t *xs, int k, node_t *roots) const;
+
+/**
+* Reserves memory for k nodes (including NIL), so that the
+* array of nodes is not reallocated while it holds at most
+* k of them
+*
+* Complexity: O(k)
+*/
+void reserve(int k);
+
+/**
+* Appends the nodes of the tree rooted in x to seq (in
+* order) and turns each of them into a single-node tree
+* (to be reassembled with build)
+*
+* Complexity: O(size of the tree)
+*/
+void flatten(node_t x, vector <node_t> &seq);
+
+/**
+* Calls f(y) for every node y of the tree rooted in x, in
+* order, walking the parent pointers (without restructuring
+* the tree or allocating memory)
+*
+* Complexity: O(size of the tree)
+*/
+template <class F>
+void for_each_node(node_t x, F f) const;
+
+/**
+* Returns the r-th (from 0, in order) vertex node storing
+* nontree edges in the tree rooted in x or NIL if there are
+* at most r of them
+*
+* Complexity: O(height of the tree)
+*/
+node_t find_nontree_edge(node_t x, int r);
+
+/**
+* Calls f(v, head) for the vertex nodes v storing nontree
+* edges in the tree rooted in x, in order. head is the list
+* of v, which f may shorten by setting it to its remaining
+* part; f returns false to end the traversal. f must not
+* restructure the tree, but it may set the lists of other
+* vertex nodes (with set_nontree_head).
+*
+* The counters of the nodes above the lists emptied by f
+* are recomputed once, when the traversal leaves them.
+*
+* Complexity: O(k log(n/k)) plus the time of f, where k is
+* the number of vertex nodes visited
+*/
+template <class F>
+void scan_nontree_heads(node_t x, F f);
+
+/**
+* Sets the head of the list of nontree edges stored in
+* the vertex node x
+*
+* Complexity: O(depth of x) if the list becomes empty or
+* stops being empty, O(1) otherwise
+*/
+void set_nontree_head(node_t x, int head);
+
+/**
+* Unmarks the edge nodes marked as on_level in the tree
+* rooted in x and calls f(edge) with the edge (a,b) of each
+* of them, until f returns false. A single traversal, pruned
+* by the counters, visits only the marked nodes and their
+* ancestors and clears the counters on its way back up.
+* f must not modify the tree.
+*
+* Complexity: O(k log(n/k)) plus the time of f, where k is
+* the number of marked nodes
+*/
+template <class F>
+void take_on_level(node_t x, F f);
+
+void print_tree(node_t x, int indent = 0) const;
+void print_node(node_t x, int indent = 0) const;
+
+protected:
+vector <TourNode> Nodes;
+/* first released edge pair and vertex node (or NIL) */
+node_t free_pairs, free_vertices;
+Hook *hook;
+
+void set_parent(node_t x, node_t parent);
+void init_node(node_t x, const TourNode &init);
+void replace_child(node_t x, node_t old_child, node_t new_child);
+node_t build_balanced(const node_t *seq, int k);
+
+node_t descend_to_nontree_edge(node_t x, int r = 0) const;
+node_t descend_to_on_level(node_t x) const;
+pair <int, int> unmark_on_level(node_t x);
+
+void update_on_level_cnt(node_t x, int dx);
+void update_nontree_cnt(node_t x, int dx);
+void update_aggregates(node_t x);
+void grow_nodes(size_t k);
+
+bool correct_node(node_t x, node_t correct_parent) const;
+};
+
+/**
+* Every write of a parent goes through here: find_root_concurrent
+* loads the parents while the tree changes, so the stores must be
+* atomic. A store releases the node it links to, so that a walk
+* which reaches a newly allocated node also sees it initialized;
+* on x86 both sides are plain moves.
+*/
+template <class Hook>
+inline void TourTree<Hook>::set_parent(node_t x, node_t parent) {
+__atomic_store_n(&Nodes[x].parent, parent, __ATOMIC_RELEASE);
+}
+
+template <class Hook>
+inline void TourTree<Hook>::update_aggregates(node_t x) {
+TourNode &node = Nodes[x];
+const TourNode &l = Nodes[node.left];
+const TourNode &r = Nodes[node.right];
+bool vertex = node.flags & VERTEX_NODE;
+
+node.size = l.size + r.size + (vertex ? 1 : 0);
+node.on_level_cnt = l.on_level_cnt + r.on_level_cnt +
+((node.flags & ON_LEVEL) ? 1 : 0);
+node.nontree_cnt = l.nontree_cnt + r.nontree_cnt +
+((vertex && node.aux != -1) ? 1 : 0);
+
+if constexpr (Hook::enabled) {
+if (hook != NULL)
+hook->update(x, node.left, node.right);
+}
+}
+
+template <class Hook>
+template <class F>
+void TourTree<Hook>::for_each_node(node_t x, F f) const {
+if (x == NIL)
+return;
+
+node_t cur = x;
+while (Nodes[cur].left != NIL)
+cur = Nodes[cur].left;
+
+while (true) {
+f(cur);
+
+if (Nodes[cur].right != NIL) {
+// the successor is the first node of the right subtree
+cur = Nodes[cur].right;
+while (Nodes[cur].left != NIL)
+cur = Nodes[cur].left;
+
+} else {
+// the successor is the first ancestor entered from the left
+while (cur != x && Nodes[Nodes[cur].parent].right == cur)
+cur = Nodes[cur].parent;
+if (cur == x)
+return;
+cur = Nodes[cur].parent;
+}
+}
+}
+
+/**
+* Walks down into the subtrees with marked nodes first, then
+* unmarks the node itself and goes right. A node is left (with
+* its counter zeroed) only when nothing below it is marked, so
+* the walk comes back to every node at most twice. When f asks
+* to stop, only the counters on the path back to x are stale.
+*/
+template <class Hook>
+template <class F>
+void TourTree<Hook>::take_on_level(node_t x, F f) {
+node_t cur = x;
+
+while (Nodes[x].on_level_cnt > 0) {
+TourNode &node = Nodes[cur];
+
+if (Nodes[node.left].on_level_cnt > 0) {
+cur = node.left;
+continue;
+}
+if (node.flags & ON_LEVEL) {
+node.flags &= ~ON_LEVEL;
+if (!f(pair <int, int> (Nodes[cur+1].aux, node.aux))) {
+for (node_t y = cur; y != Nodes[x].parent; y = Nodes[y].parent) {
+Nodes[y].on_level_cnt = Nodes[Nodes[y].left].on_level_cnt +
+Nodes[Nodes[y].right].on_level_cnt +
+((Nodes[y].flags & ON_LEVEL) ? 1 : 0);
+}
+return;
+}
+}
+if (Nodes[node.right].on_level_cnt > 0) {
+cur = node.right;
+continue;
+}
+
+node.on_level_cnt = 0;
+cur = node.parent;
+}
+}
+
+/**
+* An in-order walk through the nodes with nontree edges below
+* them. The node the walk came from tells which part of a node
+* comes next. Once f asks to stop, the walk only goes back up to
+* the root, fixing the counters.
+*/
+template <class Hook>
+template <class F>
+void TourTree<Hook>::scan_nontree_heads(node_t x, F f) {
+node_t cur = x, prv = Nodes[x].parent;
+bool more = true;
+
+while (cur != Nodes[x].parent) {
+node_t left = Nodes[cur].left, right = Nodes[cur].right;
+
+if (prv == Nodes[cur].parent) {
+if (more && Nodes[left].nontree_cnt > 0) {
+prv = cur;
+cur = left;
+continue;
+}
+prv = left;
+}
+
+if (prv == left) {
+if (more && (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1) {
+int head = Nodes[cur].aux;
+more = f(cur, head);
+Nodes[cur].aux = head;
+}
+if (more && Nodes[right].nontree_cnt > 0) {
+prv = cur;
+cur = right;
+continue;
+}
+}
+
+bool own = (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1;
+Nodes[cur].nontree_cnt = Nodes[left].nontree_cnt +
+Nodes[right].nontree_cnt + (own ? 1 : 0);
+prv = cur;
+cur = Nodes[cur].parent;
+}
+}
+
+/* The sequence tree Tree calling an AggregateHook */
+template <class Tree>
+using HookedTree = typename Tree::template with_hook <AggregateHook>;
+
+#endif
+using namespace std;
+
+/**
+* Treap implementation (https://en.wikipedia.org/wiki/Treap)
+* over an array of TourNodes.
+*
+* The tree is a binary search tree by the order of nodes and
+* a max-heap by their priorities. Priorities are computed by
+* hashing node indices, so they take no space in the nodes.
+* Split and merge never rotate: they only relink the nodes on
+* the paths they walk. All the bounds below are expected.
+* Hook is the policy of the extra aggregates (see TourTree).
+*/
+
+template <class Hook = NoHook>
+class BasicTreap : public TourTree <Hook> {
+typedef TourTree <Hook> Base;
+
+public:
+template <class OtherHook>
+using with_hook = BasicTreap <OtherHook>;
+
+using Base::find_root;
+
+/**
+* Splits the tree into two parts and returns their roots.
+* The first part contains all nodes to the left of x
+* (inclusive), the second part contains all nodes to the
+* right of it (exclusive).
+*
+* Complexity: O(log n)
+*/
+pair <node_t, node_t> split(node_t x);
+
+/**
+* Removes x from its tree and splits the rest of it into
+* the nodes to the left and to the right of x (exclusive)
+*
+* Complexity: O(log n)
+*/
+pair <node_t, node_t> split_around(node_t x);
+
+/**
+* Merges two trees (left and right) into one (the middle
+* node is optional) and returns its root.
+* The order of nodes is as follows:
+* left(unchanged), middle, right(unchanged).
+*
+* Complexity: O(log n)
+*/
+node_t merge(node_t left, node_t middle, node_t right);
+
+/**
+* Returns the root of the tree containing x
+*
+* Complexity: O(log n)
+*/
+node_t root(node_t x) const;
+
+/**
+* Checks whether x and y belong to the same tree
+*
+* Complexity: O(log n)
+*/
+bool same_tree(node_t x, node_t y) const;
+
+/**
+* Removes x from the tree it belongs to
+*
+* Complexity: O(log n)
+*/
+void unlink(node_t x);
+
+/**
+* Builds a tree from the single-node trees seq[0..k-1]
+* (in this order) and returns its root
+*
+* Complexity: O(k)
+*/
+node_t build(const node_t *seq, int k);
+
+/**
+* Checks if the invariants hold in the subtree of x
+*
+* Complexity: linear in the size of the tree
+*/
+bool correct_tree(node_t x, node_t correct_parent) const;
+
+private:
+using Base::Nodes;
+using Base::set_parent;
+using Base::update_aggregates;
+using Base::replace_child;
+using Base::correct_node;
+
+static uint32_t priority(node_t x);
+node_t join(node_t left, node_t right);
+pair <node_t, node_t> split_path(node_t x, node_t left_tree,
+node_t right_tree);
+};
+
+/* The finalizer of MurmurHash3, which mixes consecutive indices well */
+template <class Hook>
+inline uint32_t BasicTreap<Hook>::priority(node_t x) {
+uint32_t h = x;
+h ^= h >> 16;
+h *= 0x85ebca6b;
+h ^= h >> 13;
+h *= 0xc2b2ae35;
+h ^= h >> 16;
+return h;
+}
+
+typedef BasicTreap <> Treap;
+
+#endif
+#ifndef EDGE_TABLE_HPP
+#define EDGE_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+using namespace std;
+
+/* Packs the undirected edge (a,b) into a 64-bit key */
+inline uint64_t edge_key(int a, int b) {
+if (a > b)
+swap(a, b);
+return (uint64_t(uint32_t(a)) << 32) | uint32_t(b);
+}
+
+/* Fibonacci hashing: the top bits of the product are well mixed */
+inline size_t edge_hash(uint64_t key, int shift) {
+return (key * 0x9E3779B97F4A7C15ULL) >> shift;
+}
+
+/**
+* Hash table mapping undirected edges to values of type Info.
+*
+* Uses open addressing with linear probing over a single array
+* of slots, each holding the edge together with its value, so a
+* lookup touches one or two cache lines. The edge is stored as
+* two 32-bit endpoints, so that a slot is aligned only as the
+* value: with a 4-byte value, a slot takes 12 bytes instead of
+* 16.
+* Erased slots are filled by shifting the following entries
+* back (no tombstones), so probe sequences stay short under
+* any mix of insertions and deletions.
+*
+* Pointers returned by find and insert stay valid until the
+* next call to insert or erase.
+*/
+
+template <class Info>
+class EdgeTable {
+public:
+
+EdgeTable() {
+count = 0;
+shift = 64 - 4;
+Slots.assign(size_t(1) << (64 - shift), Slot(EMPTY));
+}
+
+/**
+* Returns the value stored for the (a,b) edge
+* or NULL if there is none
+* Complexity: O(1) (expected)
+*/
+Info *find(int a, int b) {
+size_t i = probe(edge_key(a, b));
+return Slots[i].key() == EMPTY ? NULL : &Slots[i].info;
+}
+
+/**
+* Returns the value stored for the (a,b) edge, creating
+* a value-initialized entry if there is none
+* Complexity: O(1) (expected, amortized)
+*/
+Info *insert(int a, int b) {
+uint64_t key = edge_key(a, b);
+
+// keep the load factor at most 1/2
+if (2 * (size_t(count) + 1) > Slots.size())
+rehash(shift - 1);
+
+size_t i = probe(key);
+if (Slots[i].key() == EMPTY) {
+Slots[i] = Slot(key);
+count++;
+}
+return &Slots[i].info;
+}
+
+/**
+* Removes the entry pointed to by info (obtained from find
+* or insert) from the table
+* Complexity: O(1) (expected)
+*/
+void erase(Info *info);
+
+/**
+* Makes room for the given number of edges, so that
+* inserting them does not trigger any further rehashing
+* Complexity: O(edges + size of the table)
+*/
+void reserve(int edges) {
+int new_shift = shift;
+while (2 * size_t(edges) > (size_t(1) << (64 - new_shift)))
+new_shift--;
+if (new_shift != shift)
+rehash(new_shift);
+}
+
+/* Returns the number of edges stored in the table */
+int size() {
+return count;
+}
+
+/**
+* Calls f(a, b, info) for every entry, where (a,b) is the
+* edge with a <= b
+* Complexity: O(capacity of the table)
+*/
+template <class F>
+void for_each(F f) {
+for (Slot &slot: Slots) {
+if (slot.key() != EMPTY)
+f(int(slot.a), int(slot.b), slot.info);
+}
+}
+
+private:
+struct Slot {
+/* the endpoints a <= b, both UINT32_MAX in an empty slot */
+uint32_t a, b;
+Info info;
+
+Slot(uint64_t key) : a(uint32_t(key >> 32)), b(uint32_t(key)), info() {}
+
+uint64_t key() const {
+return (uint64_t(a) << 32) | b;
+}
+};
+
+static constexpr uint64_t EMPTY = UINT64_MAX;
+
+vector <Slot> Slots;
+int count;
+int shift;
+
+size_t home(uint64_t key) {
+return edge_hash(key, shift);
+}
+
+/**
+* Returns the index of the slot holding key or of the empty
+* slot that ends its probe sequence.
+*/
+size_t probe(uint64_t key) {
+size_t mask = Slots.size() - 1;
+size_t i = home(key);
+while (Slots[i].key() != EMPTY && Slots[i].key() != key) {
+i = (i + 1) & mask;
+}
+return i;
+}
+
+void rehash(int new_shift);
+};
+
+/**
+* Backward shift deletion: walks the cluster following the
+* erased slot and moves back every entry whose home position
+* does not lie cyclically between the hole and the entry.
+*/
+template <class Info>
+void EdgeTable<Info>::erase(Info *info) {
+Slot *slot = reinterpret_cast<Slot*>(
+reinterpret_cast<char*>(info) - offsetof(Slot, info));
+size_t mask = Slots.size() - 1;
+size_t hole = slot - Slots.data();
+
+for (size_t j = (hole + 1) & mask; Slots[j].key() != EMPTY; j = (j + 1) & mask) {
+size_t h = home(Slots[j].key());
+
+bool movable = (hole <= j) ? (h <= hole || h > j)
+: (h <= hole && h > j);
+if (movable) {
+Slots[hole] = Slots[j];
+hole = j;
+}
+}
+
+Slots[hole].a = Slots[hole].b = UINT32_MAX;
+count--;
+}
+
+template <class Info>
+void EdgeTable<Info>::rehash(int new_shift) {
+vector <Slot> old_slots;
+old_slots.swap(Slots);
+
+shift = new_shift;
+Slots.assign(size_t(1) << (64 - shift), Slot(EMPTY));
+
+for (Slot &slot: old_slots) {
+if (slot.key() != EMPTY)
+Slots[probe(slot.key())] = slot;
+}
+}
+
+/**
+* Hash index of edges stored outside of it, e.g. in the nodes
+* of a forest. A slot holds only the handle of an edge (0 marks
+* an empty slot and is never a handle), and the endpoints of a
+* handle h are read from endpoints(h), a function passed to
+* every call which needs them.
+*
+* The layout is that of EdgeTable, but a slot takes only the 4
+* bytes of a handle; in exchange, every probe of a lookup reads
+* the endpoints of the handle it passes. The endpoints of a
+* handle must not change while it is in the index.
+*/
+
+template <class Handle>
+class EdgeIndex {
+public:
+
+EdgeIndex() {
+count = 0;
+shift = 64 - 4;
+Slots.assign(size_t(1) << (64 - shift), 0);
+}
+
+/**
+* Returns the handle of the (a,b) edge or 0 if there is none
+* Complexity: O(1) (expected)
+*/
+template <class F>
+Handle find(int a, int b, F endpoints) const {
+uint64_t key = edge_key(a, b);
+size_t mask = Slots.size() - 1;
+size_t i = edge_hash(key, shift);
+while (Slots[i] != 0 && key_of(Slots[i], endpoints) != key)
+i = (i + 1) & mask;
+return Slots[i];
+}
+
+/**
+* Adds the edge with handle h, which must not be in the
+* index yet
+* Complexity: O(1) (expected, amortized)
+*/
+template <class F>
+void insert(Handle h, F endpoints) {
+// keep the load factor at most 1/2
+if (2 * (size_t(count) + 1) > Slots.size())
+rehash(shift - 1, endpoints);
+
+Slots[free_slot(key_of(h, endpoints))] = h;
+count++;
+}
+
+/**
+* Removes the edge with handle h from the index
+* Complexity: O(1) (expected)
+*/
+template <class F>
+void erase(Handle h, F endpoints);
+
+/**
+* Makes room for the given number of edges, so that
+* inserting them does not trigger any further rehashing
+* Complexity: O(edges + size of the index)
+*/
+template <class F>
+void reserve(int edges, F endpoints) {
+int new_shift = shift;
+while (2 * size_t(edges) > (size_t(1) << (64 - new_shift)))
+new_shift--;
+if (new_shift != shift)
+rehash(new_shift, endpoints);
+}
+
+/* Returns the number of edges in the index */
+int size() const {
+return count;
+}
+
+private:
+vector <Handle> Slots;
+int count;
+int shift;
+
+template <class F>
+static uint64_t key_of(Handle h, F endpoints) {
+pair <int, int> edge = endpoints(h);
+return edge_key(edge.first, edge.second);
+}
+
+/* Returns the first empty slot of the probe sequence of key */
+size_t free_slot(uint64_t key) const {
+size_t mask = Slots.size() - 1;
+size_t i = edge_hash(key, shift);
+while (Slots[i] != 0)
+i = (i + 1) & mask;
+return i;
+}
+
+template <class F>
+void rehash(int new_shift, F endpoints);
+};
+
+/* Backward shift deletion, as in EdgeTable::erase */
+template <class Handle>
+template <class F>
+void EdgeIndex<Handle>::erase(Handle h, F endpoints) {
+size_t mask = Slots.size() - 1;
+size_t hole = edge_hash(key_of(h, endpoints), shift);
+while (Slots[hole] != h)
+hole = (hole + 1) & mask;
+
+for (size_t j = (hole + 1) & mask; Slots[j] != 0; j = (j + 1) & mask) {
+size_t home = edge_hash(key_of(Slots[j], endpoints), shift);
+
+bool movable = (hole <= j) ? (home <= hole || home > j)
+: (home <= hole && home > j);
+if (movable) {
+Slots[hole] = Slots[j];
+hole = j;
+}
+}
+
+Slots[hole] = 0;
+count--;
+}
+
+template <class Handle>
+template <class F>
+void EdgeIndex<Handle>::rehash(int new_shift, F endpoints) {
+vector <Handle> old_slots;
+old_slots.swap(Slots);
+
+shift = new_shift;
+Slots.assign(size_t(1) << (64 - shift), 0);
+
+for (Handle h: old_slots) {
+if (h != 0)
+Slots[free_slot(key_of(h, endpoints))] = h;
+}
+}
+
+#endif
+using namespace std;
+
+/**
+* One direction of a nontree edge, stored in the list of its
+* source vertex (headed in the vertex node). The lists are
+* intrusive and index based: prev and next are indices of
+* records in the same pool (-1 marks the ends of a list). The
+* two directions of an edge are allocated together at indices
+* 2k and 2k+1, so the record of the opposite direction is
+* always at index r ^ 1 and its target is the source of r.
+*/
+struct NontreeRecord {
+int to;
+int prev, next;
+};
+
+/**
+* Position of a walk over the nontree edges of the connected
+* component of vertex (see next_nontree_edge): the number of
+* vertices with nontree edges visited so far and the current
+* record on the list of the last one (-1 before the first).
+*/
+struct NontreeCursor {
+int vertex;
+int rank = 0;
+int record = -1;
+};
+
+/**
+* Euler Tour Tree Forest data structure for storing a forest
+* over n vertices.
+*
+* Each tree is represented as an Euler tour stored on a balanced
+* sequence tree given by the Tree parameter: AVLTree, SplayTree
+* or Treap (see tour_tree.hpp). An Euler tour is formed by two edge nodes
+* for every tree edge (one in each direction) and a single
+* vertex node for each vertex. Since an Euler tour visits a
+* vertex the same number of times as its degree, there may be
+* many possible positions for a vertex node in the Euler tour.
+* For example, the following a two Euler tours are equivalent:
+* (0,1) ~ (1) ~ (1, 4) ~ (4) ~ (4,1) ~ (1,0)
+* (0,1) ~ (1, 4) ~ (4) ~ (4,1) ~ (1) ~ (1,0)
+*
+* A sparse forest creates the node of a vertex only when the
+* first edge incident to it is stored, and releases it as soon
+* as the vertex is isolated again (a vertex without a node is
+* a single-vertex tree). This keeps the memory of a forest
+* proportional to the number of edges it stores. The nodes of
+* the vertices are found through a hash table, until so many
+* vertices have nodes that an array indexed by the vertices
+* (4 bytes per vertex) takes less memory.
+*/
+
+template <class Tree>
+class ETTForest {
+public:
+
+/**
+* Initializes the data structure for a n-vertex graph
+* Complexity: O(n) for a dense forest, O(1) for a sparse one
+*/
+ETTForest(int n, bool sparse = false);
+
+/**
+* Checks whether the forest stores no edges
+* Complexity: O(1)
+*/
+bool empty();
+
+/**
+* Stores a nontree edge (a,b) and returns its handle, which
+* identifies the edge in remove_nontree_edge
+* a and b (a != b) already need to be in the same connected
+* component
+* Complexity: O(log n)
+*/
+int insert_nontree_edge(int a, int b);
+
+/**
+* Stores a batch of nontree edges like insert_nontree_edge
+* and sets handles[i] to the handle of the i-th one. The
+* handles and the nodes of the endpoints are allocated on
+* the calling thread; the records are then pushed on the
+* lists of their vertices in parallel, one tree at a time
+* per thread (see set_threads).
+* Complexity: O(k (log n + log k)) where k is the number of
+* edges; O(k log k) of it on the calling thread
+*/
+void insert_nontree_edges(const vector <pair <int, int> > &edges,
+vector <int> &handles);
+
+/**
+* Adds a tree edge (a,b) and marks it as being on the
+* level equal to the level of the forest (on_level == true)
+* or on a level above it (on_level == false)
+* Returns the sizes of the trees of a and b it joined.
+*
+* a and b need to be in different connected components
+* Compexity: O(log n)
+*/
+pair <int, int> insert_tree_edge(int a, int b, bool on_level);
+
+/**
+* Adds all edges of a forest as tree edges on the level of
+* the forest, which must not store any tree edges yet.
+* Each tree is laid out by a single DFS and its Euler tour
+* is built bottom-up, without any splits or merges.
+* Complexity: O(n + k) where k is the number of edges
+*/
+void build_trees(const vector <pair <int, int> > &edges);
+
+/**
+* Adds a batch of tree edges on the level of the forest.
+* Every edge must join two different trees and the edges
+* must not form a cycle over the trees.
+*
+* In each group of trees joined by the batch, the largest
+* tree stays in place and is split once per vertex where
+* others are attached. All the other trees are flattened and
+* their Euler tours are rebuilt together with the new edges,
+* so no tree is split or merged more than once per batch.
+* The groups are flattened, rebuilt and linked in parallel
+* (see set_threads).
+* Complexity: O(k log n + s) where k is the number of edges
+* and s is the total size of the trees that are not the
+* largest in their group
+*/
+void link_batch(const vector <pair <int, int> > &edges);
+
+/**
+* Adds a batch of tree edges like insert_tree_edge, under the
+* conditions of link_batch. The nodes of the edges are
+* allocated and indexed on the calling thread. The edges are
+* then grouped by the trees they join and the edges of each
+* group are linked one by one, the groups in parallel (see
+* set_threads). Unlike link_batch, an edge costs O(log n)
+* whatever the sizes of the trees it joins, which suits
+* many edges joining a few large trees.
+* Complexity: O(k (log n + log k)) where k is the number of
+* edges; O(k log k) of it on the calling thread
+*/
+void insert_tree_edges(const vector <pair <int, int> > &edges, bool on_level);
+
+/**
+* Sets the number of threads the batches (link_batch,
+* plan_cuts and the others) may use (1, the default, keeps
+* them on the calling thread). The groups of trees joined by
+* a batch share no nodes, so each of them is flattened,
+* rebuilt and attached to its largest tree by one thread;
+* plan_cuts places the nodes of the edges in their tours in
+* parallel and plans the rounds only with more than one
+* thread. The other batches work on different trees in
+* parallel.
+* Complexity: O(1)
+*/
+void set_threads(int _threads);
+
+/**
+* Returns an identifier of the tree containing v which
+* stays valid until the forest is modified, or NIL if v
+* is isolated and has no node in a sparse forest
+* Complexity: O(depth of the node of v)
+*/
+node_t tree_id(int v);
+
+/**
+* Returns the number of vertices of the tree with the given
+* identifier (see tree_id)
+* Complexity: O(1)
+*/
+int tree_size(node_t id) const;
+
+/**
+* Calls f(edge) for the tree edges on the level of the forest
+* in the connected component containing a and marks them as
+* being on a level above the forest, in a single traversal
+* of its Euler tour, until f returns false (the edge passed
+* to it is marked all the same). f must not modify the forest.
+*
+* Complexity: O(log n + k log(n/k)) where k is the number of
+* tree edges being promoted
+*/
+template <class F>
+void promote_tree_edges(int a, F f);
+
+/**
+* Removes a tree edge (a,b) from the forest
+* Returns the sizes of the resulting trees of a and b.
+* Complexity: O(log n)
+*/
+pair <int, int> remove_tree_edge(int a, int b);
+
+/**
+* Plans the removal of the first k tree edges of the list,
+* carried out in rounds: each round runs cut_task(i) for all
+* i < cut_tasks() and is followed by next_cut_round, until
+* there are no tasks left; finish_cuts completes the plan.
+* No other calls may come in between.
+*
+* The nodes of the edges are ordered by their places in the
+* tours (see TourTree::order_key) and every tour is split
+* around all of them by halving: a task splits one piece of
+* the tour around its middle planned node. The pieces are
+* then assigned to the new tours by the nesting of the pairs
+* of edge nodes, and the pieces of each new tour are merged
+* pairwise, halving their number in every round. The tasks
+* of a round touch disjoint trees, so they may run on
+* different threads at once, also with an aggregate hook.
+* A tour containing a node too deep for its key (possible in
+* a splay tree) has its edges cut right away, one by one, and
+* so have all the tours on one thread (see set_threads).
+*
+* Complexity: O(k (log n + log k)) in total, in O(log k)
+* rounds of tasks of O(log n) each; the ordering of the nodes
+* and the assignment of the pieces take O(k log k) and O(k)
+* on one thread
+*/
+void plan_cuts(const vector <pair <int, int> > &edges, size_t k);
+
+/**
+* Returns the number of tasks of the current round of the
+* plan (0 when all the cuts are made)
+* Complexity: O(1)
+*/
+int cut_tasks() const;
+
+/**
+* Runs the i-th task of the current round of the plan
+* Complexity: O(log n)
+*/
+void cut_task(int i);
+
+/**
+* Prepares the next round of the plan after all the tasks of
+* the current one are done
+* Complexity: O(t) where t is the number of tasks of the
+* round, and O(k) after the last round of splits
+*/
+void next_cut_round();
+
+/**
+* Releases the nodes of the edges of the plan (and of the
+* vertices they left isolated in a sparse forest)
+* Complexity: O(k) where k is the number of planned edges
+*/
+void finish_cuts();
+
+/**
+* Removes the nontree edge with the given handle
+* from the forest
+* Complexity: O(log n)
+*/
+void remove_nontree_edge(int handle);
+
+/**
+* Removes the nontree edges with the given handles like
+* remove_nontree_edge. The records are erased from the lists
+* of their vertices in parallel, one tree at a time per
+* thread (see set_threads); the handles are released on the
+* calling thread.
+* Complexity: O(k (log n + log k)) where k is the number of
+* edges; O(k log k) of it on the calling thread
+*/
+void remove_nontree_edges(const vector <int> &handles);
+
+/**
+* Checks whether vertices a and b are connected
+* Complexity: O(log n)
+*/
+bool connected(int a, int b);
+
+/**
+* Sets answers[i] to connected(a, b) for the i-th query (a,b)
+* The root walks of all the queries are interleaved (see
+* TourTree::find_roots), unless the sequence tree is self
+* adjusting, whose queries are answered one by one.
+* Complexity: O(k log n) where k is the number of queries
+*/
+void connected_batch(const vector <pair <int, int> > &queries,
+vector <bool> &answers);
+
+/**
+* Pops the nontree edges stored in the connected component
+* of a one by one, in a single traversal of its Euler tour,
+* and calls f(edge) for each of them (with the endpoint in
+* the component first) until f returns false. f must not
+* modify the forest.
+*
+* Complexity: O(log n + k log(n/k)) plus O(log n) per edge
+* whose other endpoint stores no other nontree edge, where k
+* is the number of vertices with nontree edges visited
+*/
+template <class F>
+void pop_nontree_edges(int a, F f);
+
+/**
+* Looks at a nontree edge stored in the connected component
+* of a without removing it: the first edge of the
+* (r mod k)-th vertex with nontree edges, out of k such
+* vertices. Returns the handle of the edge and the edge
+* itself (with the endpoint in the component first) in the
+* edge parameter, or -1 if the component stores no nontree
+* edges.
+* Complexity: O(log n)
+*/
+int sample_nontree_edge(int a, uint32_t r, pair <int, int> &edge);
+
+/**
+* Advances the cursor to the next nontree edge stored in the
+* connected component of cursor.vertex, visiting the vertices
+* with nontree edges in the order of the Euler tour. Returns
+* the handle of the edge and the edge itself (with the
+* endpoint in the component first) in the edge parameter, or
+* -1 after the last edge. Nothing is modified, and the cursor
+* stays valid as long as no edge is inserted or removed.
+* Complexity: O(1) within the list of a vertex, O(log n) to
+* move to the next vertex
+*/
+int next_nontree_edge(NontreeCursor &cursor, pair <int, int> &edge);
+
+/**
+* Returns the number of vertices in the connected component
+* containing the vertex a
+* Complexity: O(log n)
+*/
+int size(int a);
+
+/**
+* Calls f(u) for every vertex u in the connected component
+* of v, in the order of its Euler tour
+* Only for a dense forest, whose vertex nodes are numbered
+* by the vertices.
+* Complexity: O(log n + k) where k is the size of the component
+*/
+template <class F>
+void for_each_vertex(int v, F f);
+
+/**
+* Calls f(a, b) once for every tree edge (a,b), a < b, in
+* the connected component of v
+* Complexity: O(log n + k) where k is the size of the component
+*/
+template <class F>
+void for_each_tree_edge(int v, F f);
+
+/**
+* Sets the hook maintaining extra aggregates of the Euler
+* tours (see AggregateHook in tour_tree.hpp); only a forest
+* over a HookedTree calls it
+* Complexity: O(1)
+*/
+void set_aggregate_hook(typename Tree::hook_type *hook);
+
+/**
+* Recomputes the extra aggregates which depend on the vertex
+* node of v after its value changed
+* Only for a dense forest.
+* Complexity: O(log n)
+*/
+void update_vertex(int v);
+
+/**
+* Calls f(x) for the vertex node of v and each of its
+* ancestors, up to the root of its Euler tour, so that
+* invertible extra aggregates (e.g. sums or XORs) can be
+* changed in place when only the value of v changes
+* Only for a dense forest.
+* Complexity: O(log n)
+*/
+template <class F>
+void for_each_ancestor(int v, F f);
+
+/**
+* Returns the root of the Euler tour of the connected
+* component of v, which holds its aggregates
+* Only for a dense forest.
+* Complexity: O(log n)
+*/
+node_t tour_root(int v);
+
+/**
+* Reserves the nodes of a spanning tree of all the vertices,
+* so that the array of nodes of the Euler tours is never
+* reallocated (see concurrent_root)
+* Only for a dense forest.
+* Complexity: O(n)
+*/
+void reserve_spanning_forest();
+
+/**
+* Returns the root of the Euler tour of v like tour_root, but
+* without restructuring the tour and with atomic loads of the
+* parent pointers, for readers running concurrently with the
+* thread updating the forest (which must have reserved the
+* spanning forest). The result must be validated by the
+* reader; it is NIL if the walk gave up.
+* Only for a dense forest.
+* Complexity: O(depth of the node of v)
+*/
+node_t concurrent_root(int v) const;
+
+/**
+* Checks whether the invariants of the data structure hold
+* Complexity: O(n log n + m), where m is the number of edges
+* currently in the forest
+*/
+bool correct();
+
+void print();
+
+private:
+int n;
+bool sparse;
+
+/* the nodes of all Euler tours; in a dense forest vertex v is the node v+1 */
+Tree Tour;
+/* first node of the pair representing a tree edge, whose nodes hold its endpoints */
+EdgeIndex <node_t> TEdgeHooks;
+/* sparse forests: nodes of present vertices, keyed by the loop (v,v) */
+EdgeTable <node_t> VertexHooks;
+/* sparse forests: the nodes of all vertices (NIL if absent), once it replaces VertexHooks */
+vector <node_t> VertexNodes;
+
+/**
+* Pool of nontree edge records (see NontreeRecord). The handle
+* of an edge is the index k of its pair of records 2k, 2k+1.
+* Free pairs form a list linked through the next field of
+* their first record, starting at NTFree.
+*/
+vector <NontreeRecord> NTEdges;
+int NTFree;
+int nontree_edges;
+
+/* the threads of the batches */
+int threads;
+
+/**
+* The plan of plan_cuts: the first nodes of the planned edges
+* and the nodes of those cut in rounds, ordered by their tours
+* (the g-th tour from CutGroupStart[g]) and their places in
+* them, with the indices of their edges in CutOwner. The piece
+* of the g-th tour before its j-th node (or after the last one)
+* is CutPieces[CutGroupStart[g] + g + j] once split off.
+*/
+struct CutSegment {
+// the nodes lo..hi of the group form the tree being split
+int lo, hi, group;
+};
+vector <node_t> CutEdges, CutNodes, CutPieces;
+vector <int> CutOwner, CutGroupStart;
+vector <CutSegment> CutSegments, NextSegments;
+/* the pieces of each new tour at MergeList[MergeStart[t]..], merged at MergeTasks */
+bool merging;
+vector <int> MergeList, MergeStart, MergeTasks;
+
+node_t vertex_node(int v);
+auto edge_endpoints() const;
+node_t materialize(int v);
+void index_vertices();
+void release_if_isolated(int v);
+pair <int, int> cut_edge_nodes(node_t ab_edge);
+pair <int, int> link_edge_nodes(node_t ab_edge, node_t x, node_t y);
+template <class F>
+void for_each_by_tree(const vector <node_t> &xs, F f);
+void plan_merges();
+void push_nontree_record(int v, int r);
+void link_nontree_record(node_t x, int r);
+void erase_nontree_record(int v, int r);
+void release_nontree_edge(int handle);
+};
+
+template <class Tree>
+template <class F>
+void ETTForest<Tree>::for_each_vertex(int v, F f) {
+assert(!sparse);
+Tour.for_each_node(Tour.root(v + 1), [&](node_t x) {
+if (Tour[x].flags & VERTEX_NODE)
+f(int(x) - 1);
+});
+}
+
+/**
+* The edge nodes of an Euler tour form a closed walk, so the
+* source of an edge node is the target of the previous one (of
+* the last one for the first). Each edge is reported in the
+* direction in which its source is smaller.
+*/
+template <class Tree>
+template <class F>
+void ETTForest<Tree>::for_each_tree_edge(int v, F f) {
+node_t x = vertex_node(v);
+if (x == NIL)
+return;
+
+int first = -1, previous = -1;
+Tour.for_each_node(Tour.root(x), [&](node_t y) {
+if (Tour[y].flags & VERTEX_NODE)
+return;
+
+int target = Tour[y].aux;
+if (previous == -1)
+first = target;
+else if (previous < target)
+f(previous, target);
+previous = target;
+});
+
+if (first != -1 && previous < first)
+f(previous, first);
+}
+
+template <class Tree>
+template <class F>
+void ETTForest<Tree>::for_each_ancestor(int v, F f) {
+assert(!sparse);
+// a splay tree brings the node to the root first
+Tour.root(v + 1);
+for (node_t x = v + 1; x != NIL; x = Tour[x].parent)
+f(x);
+}
+
+template <class Tree>
+template <class F>
+void ETTForest<Tree>::promote_tree_edges(int a, F f) {
+node_t x = vertex_node(a);
+if (x != NIL)
+Tour.take_on_level(Tour.root(x), f);
+}
+
+/**
+* The traversal hands over the list of each vertex. Its records
+* are unlinked from the head of the list, while their twins are
+* erased from the lists of the other endpoints as usual.
+*/
+template <class Tree>
+template <class F>
+void ETTForest<Tree>::pop_nontree_edges(int a, F f) {
+node_t x = vertex_node(a);
+if (x == NIL)
+return;
+
+Tour.scan_nontree_heads(Tour.root(x), [&](node_t, int &head) {
+while (head != -1) {
+int r = head;
+head = NTEdges[r].next;
+if (head != -1)
+NTEdges[head].prev = -1;
+
+// the source of the record is the target of its twin
+pair <int, int> edge = {NTEdges[r ^ 1].to, NTEdges[r].to};
+erase_nontree_record(edge.second, r ^ 1);
+release_nontree_edge(r / 2);
+release_if_isolated(edge.second);
+
+if (!f(edge))
+return false;
+}
+return true;
+});
+
+release_if_isolated(a);
+}
+
+#endif
+#ifndef UNION_FIND_HPP
+#define UNION_FIND_HPP
+
+#include <utility>
+#include <vector>
+using namespace std;
+
+/**
+* Disjoint set union over n elements with union by size
+* and path halving
+* (https://en.wikipedia.org/wiki/Disjoint-set_data_structure).
+*/
+
+class UnionFind {
+public:
+
+UnionFind(int n) {
+Parent.resize(n);
+Size.assign(n, 1);
+for (int i = 0; i < n; i++)
+Parent[i] = i;
+}
+
+/**
+* Returns the representative of the set containing a
+* Complexity: O(alpha(n)) (amortized)
+*/
+int find(int a) {
+while (Parent[a] != a) {
+Parent[a] = Parent[Parent[a]];
+a = Parent[a];
+}
+return a;
+}
+
+/**
+* Merges the sets containing a and b
+* Returns false if they were already the same set
+* Complexity: O(alpha(n)) (amortized)
+*/
+bool unite(int a, int b) {
+a = find(a);
+b = find(b);
+if (a == b)
+return false;
+
+if (Size[a] < Size[b])
+swap(a, b);
+Parent[b] = a;
+Size[a] += Size[b];
+return true;
+}
+
+/**
+* Returns the size of the set containing a
+* Complexity: O(alpha(n)) (amortized)
+*/
+int size(int a) {
+return Size[find(a)];
+}
+
+private:
+vector <int> Parent;
+vector <int> Size;
+};
+
+/**
+* Disjoint set union over n elements with union by size and
+* no path compression, so that the unions can be undone in
+* the reverse order.
+*/
+
+class RollbackUnionFind {
+public:
+
+RollbackUnionFind(int n) {
+Parent.resize(n);
+Size.assign(n, 1);
+for (int i = 0; i < n; i++)
+Parent[i] = i;
+sets = n;
+}
+
+/**
+* Returns the representative of the set containing a
+* Complexity: O(log n)
+*/
+int find(int a) const {
+while (Parent[a] != a)
+a = Parent[a];
+return a;
+}
+
+/**
+* Merges the sets containing a and b
+* Returns false if they were already the same set
+* Complexity: O(log n)
+*/
+bool unite(int a, int b) {
+a = find(a);
+b = find(b);
+if (a == b)
+return false;
+
+if (Size[a] < Size[b])
+swap(a, b);
+Parent[b] = a;
+Size[a] += Size[b];
+History.push_back(b);
+sets--;
+return true;
+}
+
+/* Returns the number of sets */
+int count() const {
+return sets;
+}
+
+/**
+* Returns a checkpoint to roll back to, which stays valid
+* until the unions made before it are rolled back
+* Complexity: O(1)
+*/
+int checkpoint() const {
+return History.size();
+}
+
+/**
+* Undoes all unions made since the checkpoint
+* Complexity: O(1) per union undone
+*/
+void rollback(int checkpoint) {
+while ((int) History.size() > checkpoint) {
+int b = History.back(), a = Parent[b];
+History.pop_back();
+Parent[b] = b;
+Size[a] -= Size[b];
+sets++;
+}
+}
+
+private:
+vector <int> Parent;
+vector <int> Size;
+/* the roots which got a parent, in the order of the unions */
+vector <int> History;
+int sets;
+};
+
+#endif
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+/**
+* Threads kept for parallel_for across its calls, so that a call
+* only wakes them up instead of starting new threads. The workers
+* are started when a call first needs them and sleep between the
+* calls; they are stopped at the exit of the program.
+*
+* The pool runs one job at a time. A job handed to it while it
+* runs another (from another thread, or from a job itself) is
+* refused and its caller runs it alone.
+*/
+
+class WorkerPool {
+public:
+
+/* Returns the pool shared by all calls of parallel_for */
+static WorkerPool &instance() {
+static WorkerPool pool;
+return pool;
+}
+
+~WorkerPool() {
+{
+lock_guard <mutex> lock(state);
+stop = true;
+}
+wake.notify_all();
+for (thread &worker: workers)
+worker.join();
+}
+
+/**
+* Calls f(i) for every i in [0, k) on the calling thread and
+* the given number of workers, and returns when all calls
+* have finished; returns false without calling f if the pool
+* is running another job
+* Complexity: O(k) calls of f plus O(helpers) to wake up the
+* workers (and to start those which do not exist yet)
+*/
+template <class F>
+bool run(int helpers, int k, F &f) {
+unique_lock <mutex> own(busy, try_to_lock);
+if (!own.owns_lock())
+return false;
+
+{
+lock_guard <mutex> lock(state);
+while ((int) workers.size() < helpers)
+workers.emplace_back(&WorkerPool::work_loop, this, int(workers.size()));
+
+job = &f;
+call = [](void *g, int i) { (*static_cast<F*>(g))(i); };
+total = k;
+next = 0;
+wanted = helpers;
+active = helpers;
+generation++;
+}
+wake.notify_all();
+
+work();
+unique_lock <mutex> lock(state);
+done.wait(lock, [&]() { return active == 0; });
+return true;
+}
+
+private:
+/* held by the thread whose job the pool runs */
+mutex busy;
+
+/* guards the fields below, except next */
+mutex state;
+condition_variable wake, done;
+vector <thread> workers;
+bool stop = false;
+/* the number of jobs so far, so that a worker joins each one once */
+uint64_t generation = 0;
+/* the workers 0..wanted-1 take part in the job; active have not finished it */
+int wanted = 0, active = 0;
+
+/* the job: call(job, i) for i in [0, total), handed out by next */
+void *job = NULL;
+void (*call)(void *, int) = NULL;
+int total = 0;
+atomic <int> next;
+
+WorkerPool() : next(0) {}
+
+void work() {
+for (int i = next++; i < total; i = next++)
+call(job, i);
+}
+
+void work_loop(int id) {
+uint64_t seen = 0;
+unique_lock <mutex> lock(state);
+while (true) {
+wake.wait(lock, [&]() {
+return stop || (generation != seen && id < wanted);
+});
+if (stop)
+return;
+seen = generation;
+
+lock.unlock();
+work();
+lock.lock();
+if (--active == 0)
+done.notify_one();
+}
+}
+};
+
+/**
+* Calls f(i) for every i in [0, k) on up to the given number of
+* threads (the calling one included) and returns when all calls
+* have finished. The indices are handed out one by one, so calls
+* of different costs are balanced between the threads. The calls
+* must be independent of each other.
+* The other threads come from WorkerPool; if it is busy (e.g. f
+* calls parallel_for itself), f runs on the calling thread only.
+* Complexity: O(k) calls of f plus O(threads) to wake up the
+* workers; with threads <= 1 or k <= 1, f runs on the calling
+* thread only
+*/
+template <class F>
+void parallel_for(int threads, int k, F f) {
+threads = min(threads, k);
+if (threads > 1 && WorkerPool::instance().run(threads - 1, k, f))
+return;
+
+for (int i = 0; i < k; i++)
+f(i);
+}
+
+#endif
+
+template <class Tree>
+ETTForest<Tree>::ETTForest(int _n, bool _sparse) {
+n = _n;
+sparse = _sparse;
+NTFree = -1;
+nontree_edges = 0;
+threads = 1;
+merging = false;
+
+if (!sparse) {
+for (int i = 0; i < n; i++) {
+Tour.new_vertex_node();
+}
+}
+}
+
+template <class Tree>
+bool ETTForest<Tree>::empty() {
+return TEdgeHooks.size() == 0 && nontree_edges == 0;
+}
+
+/* Returns the endpoints of a tree edge given by its first node (for TEdgeHooks) */
+template <class Tree>
+auto ETTForest<Tree>::edge_endpoints() const {
+return [this](node_t e) {
+return pair <int, int> (Tour[e + 1].aux, Tour[e].aux);
+};
+}
+
+/* Returns the node of v or NIL if v has none */
+template <class Tree>
+node_t ETTForest<Tree>::vertex_node(int v) {
+if (!sparse)
+return v + 1;
+if (!VertexNodes.empty())
+return VertexNodes[v];
+
+node_t *hook = VertexHooks.find(v, v);
+return hook == NULL ? NIL : *hook;
+}
+
+/* Returns the node of v, creating it if v has none */
+template <class Tree>
+node_t ETTForest<Tree>::materialize(int v) {
+if (!sparse)
+return v + 1;
+
+if (!VertexNodes.empty()) {
+if (VertexNodes[v] == NIL)
+VertexNodes[v] = Tour.new_vertex_node();
+return VertexNodes[v];
+}
+
+node_t *hook = VertexHooks.insert(v, v);
+node_t x = *hook;
+if (x == NIL) {
+x = *hook = Tour.new_vertex_node();
+// an entry of the table takes at least 24 bytes (a 12-byte
+// slot at load factor up to 1/2), the array 4 per vertex
+if (6 * size_t(VertexHooks.size()) > size_t(n))
+index_vertices();
+}
+return x;
+}
+
+/**
+* Moves the nodes of the present vertices from VertexHooks to
+* VertexNodes, which is used from then on; the table is freed.
+* As it happens once a sixth of the vertices are present, its
+* O(n) time is amortized over the nodes created before.
+*/
+template <class Tree>
+void ETTForest<Tree>::index_vertices() {
+VertexNodes.assign(n, NIL);
+VertexHooks.for_each([&](int v, int, node_t x) {
+VertexNodes[v] = x;
+});
+VertexHooks = EdgeTable <node_t>();
+}
+
+/* Releases the node of v if no edge of the forest is incident to v */
+template <class Tree>
+void ETTForest<Tree>::release_if_isolated(int v) {
+if (!sparse)
+return;
+
+node_t x = vertex_node(v);
+const TourNode &node = Tour[x];
+if (node.parent == NIL && node.left == NIL && node.right == NIL &&
+node.aux == -1) {
+Tour.free_vertex_node(x);
+if (!VertexNodes.empty())
+VertexNodes[v] = NIL;
+else
+VertexHooks.erase(VertexHooks.find(v, v));
+}
+}
+
+template <class Tree>
+pair <int, int> ETTForest<Tree>::insert_tree_edge(int a, int b, bool on_level) {
+node_t ab_edge = Tour.new_edge_nodes(a, b, on_level);
+TEdgeHooks.insert(ab_edge, edge_endpoints());
+node_t x = materialize(a), y = materialize(b);
+return link_edge_nodes(ab_edge, x, y);
+}
+
+/**
+* Links the pair of edge nodes starting at ab_edge, (a,b) and
+* (b,a), between the nodes x of a and y of b, which are in
+* different trees, and returns the sizes of the trees it joined.
+* Touches only the nodes of the two tours (and the hook).
+*/
+template <class Tree>
+pair <int, int> ETTForest<Tree>::link_edge_nodes(node_t ab_edge, node_t x, node_t y) {
+node_t ba_edge = ab_edge + 1;
+
+// split the Euler tour to the part up to a and after a
+auto [left_a, right_a] = Tour.split(x);
+// do the same for b
+auto [left_b, right_b] = Tour.split(y);
+
+pair <int, int> sizes = {Tour[left_a].size + Tour[right_a].size,
+Tour[left_b].size + Tour[right_b].size};
+
+// create the new Euler tour placing the new edge
+// between vertices a and b or edges with them as endpoints
+Tour.merge(Tour.merge(left_a, ab_edge, right_b),
+NIL,
+Tour.merge(left_b, ba_edge, right_a));
+
+return sizes;
+}
+
+/**
+* The trees joined by the batch are numbered by their roots,
+* found before any of them changes, and grouped with union-find:
+* the edges of a group build a single tree, so they stay on one
+* thread, while different groups touch disjoint trees.
+*/
+template <class Tree>
+void ETTForest<Tree>::insert_tree_edges(const vector <pair <int, int> > &edges, bool on_level) {
+int k = edges.size();
+vector <node_t> nodes(k), ends(2 * k);
+for (int i = 0; i < k; i++) {
+auto [a, b] = edges[i];
+nodes[i] = Tour.new_edge_nodes(a, b, on_level);
+TEdgeHooks.insert(nodes[i], edge_endpoints());
+ends[2 * i] = materialize(a);
+ends[2 * i + 1] = materialize(b);
+}
+
+vector <node_t> roots(2 * k);
+parallel_for(threads, 2 * k, [&](int j) {
+roots[j] = Tour.find_root(ends[j]);
+});
+
+EdgeTable <int> TreeIds;
+vector <int> tree_of(2 * k);
+for (int j = 0; j < 2 * k; j++) {
+int *p = TreeIds.insert(roots[j], roots[j]);
+if (*p == 0)
+*p = TreeIds.size();
+tree_of[j] = *p - 1;
+}
+int t_cnt = TreeIds.size();
+UnionFind Groups(t_cnt);
+for (int i = 0; i < k; i++)
+Groups.unite(tree_of[2 * i], tree_of[2 * i + 1]);
+
+// the edges of each group (CSR)
+vector <int> start(t_cnt + 1, 0), order(k);
+for (int i = 0; i < k; i++)
+start[Groups.find(tree_of[2 * i]) + 1]++;
+for (int t = 0; t < t_cnt; t++)
+start[t + 1] += start[t];
+vector <int> next(start.begin(), start.end() - 1);
+for (int i = 0; i < k; i++)
+order[next[Groups.find(tree_of[2 * i])]++] = i;
+
+parallel_for(threads, t_cnt, [&](int g) {
+for (int j = start[g]; j < start[g + 1]; j++) {
+int i = order[j];
+link_edge_nodes(nodes[i], ends[2 * i], ends[2 * i + 1]);
+}
+});
+}
+
+template <class Tree>
+void ETTForest<Tree>::build_trees(const vector <pair <int, int> > &edges) {
+// adjacency lists in the compressed sparse row format
+vector <int> start(n + 1, 0), adjacent(2 * edges.size());
+for (auto [a, b]: edges) {
+start[a + 1]++;
+start[b + 1]++;
+}
+for (int v = 0; v < n; v++)
+start[v + 1] += start[v];
+
+vector <int> pos(start.begin(), start.end() - 1);
+for (auto [a, b]: edges) {
+adjacent[pos[a]++] = b;
+adjacent[pos[b]++] = a;
+}
+
+TEdgeHooks.reserve(TEdgeHooks.size() + edges.size(), edge_endpoints());
+
+// DFS stack: a vertex, the next position in its adjacency
+// list and the edge node through which it was entered
+struct Frame {
+int v, next;
+node_t in;
+};
+vector <Frame> stack;
+vector <bool> visited(n, false);
+vector <node_t> tour;
+
+for (int r = 0; r < n; r++) {
+if (visited[r] || start[r] == start[r + 1])
+continue;
+
+visited[r] = true;
+tour.clear();
+tour.push_back(materialize(r));
+stack.push_back(Frame{r, start[r], NIL});
+
+while (!stack.empty()) {
+Frame &top = stack.back();
+
+if (top.next == start[top.v + 1]) {
+// return to the parent through the opposite edge
+if (top.in != NIL)
+tour.push_back(top.in + 1);
+stack.pop_back();
+continue;
+}
+
+int v = top.v, u = adjacent[top.next++];
+if (visited[u])
+continue;
+
+visited[u] = true;
+node_t e = Tour.new_edge_nodes(v, u, true);
+TEdgeHooks.insert(e, edge_endpoints());
+
+tour.push_back(e);
+tour.push_back(materialize(u));
+stack.push_back(Frame{u, start[u], e});
+}
+
+Tour.build(tour.data(), tour.size());
+}
+}
+
+template <class Tree>
+node_t ETTForest<Tree>::tree_id(int v) {
+node_t x = vertex_node(v);
+return x == NIL ? NIL : Tour.find_root(x);
+}
+
+template <class Tree>
+void ETTForest<Tree>::set_aggregate_hook(typename Tree::hook_type *hook) {
+Tour.set_aggregate_hook(hook);
+}
+
+template <class Tree>
+void ETTForest<Tree>::set_threads(int _threads) {
+threads = max(_threads, 1);
+}
+
+template <class Tree>
+void ETTForest<Tree>::update_vertex(int v) {
+assert(!sparse);
+// a splay tree brings the node to the root first
+Tour.root(v + 1);
+Tour.update_path(v + 1);
+}
+
+template <class Tree>
+node_t ETTForest<Tree>::tour_root(int v) {
+assert(!sparse);
+return Tour.root(v + 1);
+}
+
+template <class Tree>
+void ETTForest<Tree>::reserve_spanning_forest() {
+assert(!sparse);
+// NIL, the vertices and a pair of nodes per tree edge
+Tour.reserve(1 + n + 2 * max(n - 1, 0));
+}
+
+template <class Tree>
+node_t ETTForest<Tree>::concurrent_root(int v) const {
+assert(!sparse);
+// no path in a tree is longer than the number of its nodes
+return Tour.find_root_concurrent(v + 1, 3 * n);
+}
+
+template <class Tree>
+int ETTForest<Tree>::tree_size(node_t id) const {
+return id == NIL ? 1 : Tour[id].size;
+}
+
+/**
+* The trees hit by the batch and the batch edges form a forest
+* (of trees). Each of its components is laid out by a DFS from
+* its largest tree (the anchor). At every anchor vertex with
+* batch edges, the tours of the attached subtrees are emitted
+* into one sequence: for an edge (v,w), the node (v,w), then
+* the tour of the tree of w rotated to start at w, with the
+* subtrees attached to its vertices spliced in after their
+* vertex nodes, then the node (w,v). The sequence is built into
+* a tree and inserted after v in the tour of the anchor.
+*/
+template <class Tree>
+void ETTForest<Tree>::link_batch(const vector <pair <int, int> > &edges) {
+if (edges.empty())
+return;
+
+// compact ids of the endpoints, keyed by their vertex nodes
+EdgeTable <int> Ids;
+vector <node_t> vertices;
+auto id = [&](int v) {
+node_t x = materialize(v);
+int *p = Ids.insert(x, x);
+if (*p == 0) {
+vertices.push_back(x);
+*p = vertices.size();
+}
+return *p - 1;
+};
+
+// batch edges incident to each endpoint (CSR): the other
+// endpoint, the node leaving this endpoint and the node
+// coming back to it
+struct Arc {
+int to;
+node_t out, back;
+};
+vector <pair <int, int> > ends(edges.size());
+for (size_t i = 0; i < edges.size(); i++)
+ends[i] = {id(edges[i].first), id(edges[i].second)};
+
+int k = vertices.size();
+vector <int> start(k + 1, 0);
+for (auto [a, b]: ends) {
+start[a + 1]++;
+start[b + 1]++;
+}
+for (int v = 0; v < k; v++)
+start[v + 1] += start[v];
+
+vector <Arc> arcs(2 * edges.size());
+vector <int> pos(start.begin(), start.end() - 1);
+for (size_t i = 0; i < edges.size(); i++) {
+auto [a, b] = edges[i];
+node_t e = Tour.new_edge_nodes(a, b, true);
+TEdgeHooks.insert(e, edge_endpoints());
+arcs[pos[ends[i].first]++] = Arc{ends[i].second, e, e + 1};
+arcs[pos[ends[i].second]++] = Arc{ends[i].first, e + 1, e};
+}
+
+// the trees containing the endpoints
+EdgeTable <int> TreeIds;
+vector <node_t> roots;
+vector <int> tree_of(k);
+for (int v = 0; v < k; v++) {
+node_t r = Tour.find_root(vertices[v]);
+int *p = TreeIds.insert(r, r);
+if (*p == 0) {
+roots.push_back(r);
+*p = roots.size();
+}
+tree_of[v] = *p - 1;
+}
+
+// the largest tree of each group is the anchor
+int t_cnt = roots.size();
+UnionFind Groups(t_cnt);
+for (auto [a, b]: ends)
+Groups.unite(tree_of[a], tree_of[b]);
+
+vector <int> anchor(t_cnt, -1);
+for (int t = 0; t < t_cnt; t++) {
+int &g = anchor[Groups.find(t)];
+if (g == -1 || Tour[roots[t]].size > Tour[roots[g]].size)
+g = t;
+}
+
+// the places of the flattened tours of all the other trees
+// (a tree of s vertices has 3s - 2 nodes) and the trees of
+// each group, which are flattened by the thread of the group
+vector <int> anchor_of(t_cnt);
+vector <int> flat_start(t_cnt, -1), flat_len(t_cnt, 0);
+vector <int> member_start(t_cnt + 1, 0), members;
+size_t flat_size = 0;
+for (int t = 0; t < t_cnt; t++) {
+anchor_of[t] = anchor[Groups.find(t)];
+if (anchor_of[t] == t)
+continue;
+
+flat_start[t] = flat_size;
+flat_len[t] = 3 * Tour[roots[t]].size - 2;
+flat_size += flat_len[t];
+member_start[anchor_of[t] + 1]++;
+}
+for (int t = 0; t < t_cnt; t++)
+member_start[t + 1] += member_start[t];
+members.resize(member_start[t_cnt]);
+vector <int> next_member(member_start.begin(), member_start.end() - 1);
+for (int t = 0; t < t_cnt; t++) {
+if (anchor_of[t] != t)
+members[next_member[anchor_of[t]]++] = t;
+}
+vector <node_t> flat(flat_size);
+// the positions of the endpoints in the tours of their trees
+vector <int> offset(k, -1);
+
+// the anchor vertices of each group, which are split off
+// the same tree and so stay on the same thread
+vector <int> group_start(t_cnt + 1, 0), group_vertices;
+for (int v = 0; v < k; v++) {
+int t = tree_of[v];
+if (anchor_of[t] == t)
+group_start[t + 1]++;
+}
+for (int t = 0; t < t_cnt; t++)
+group_start[t + 1] += group_start[t];
+group_vertices.resize(group_start[t_cnt]);
+vector <int> next(group_start.begin(), group_start.end() - 1);
+for (int v = 0; v < k; v++) {
+int t = tree_of[v];
+if (anchor_of[t] == t)
+group_vertices[next[t]++] = v;
+}
+
+// emission of the subtrees attached to the anchor vertices
+struct Frame {
+int t, done, first;
+node_t back;
+// the endpoint whose arcs are being followed (or -1)
+int v, next_arc;
+};
+
+// the groups touch disjoint trees and nodes
+parallel_for(threads, t_cnt, [&](int g) {
+vector <Frame> stack;
+vector <node_t> seq;
+
+for (int i = member_start[g]; i < member_start[g + 1]; i++) {
+int t = members[i];
+seq.clear();
+Tour.flatten(roots[t], seq);
+assert((int) seq.size() == flat_len[t]);
+copy(seq.begin(), seq.end(), flat.begin() + flat_start[t]);
+
+for (int j = 0; j < flat_len[t]; j++) {
+int *p = Ids.find(seq[j], seq[j]);
+if (p != NULL)
+offset[*p - 1] = j;
+}
+}
+
+for (int i = group_start[g]; i < group_start[g + 1]; i++) {
+int v = group_vertices[i];
+seq.clear();
+// a pseudo-frame following the arcs of the anchor vertex
+stack.push_back(Frame{-1, 0, 0, NIL, v, start[v]});
+
+while (!stack.empty()) {
+Frame &top = stack.back();
+
+if (top.v != -1) {
+if (top.next_arc == start[top.v + 1]) {
+top.v = -1;
+continue;
+}
+
+Arc arc = arcs[top.next_arc++];
+// the arc back to the parent tree
+if (arc.out == top.back)
+continue;
+
+seq.push_back(arc.out);
+int u = tree_of[arc.to];
+stack.push_back(Frame{u, 0, offset[arc.to], arc.back, -1, 0});
+continue;
+}
+
+if (top.t == -1 || top.done == flat_len[top.t]) {
+if (top.back != NIL)
+seq.push_back(top.back);
+stack.pop_back();
+continue;
+}
+
+int j = (top.first + top.done++) % flat_len[top.t];
+node_t x = flat[flat_start[top.t] + j];
+seq.push_back(x);
+
+int *p = Ids.find(x, x);
+if (p != NULL) {
+top.v = *p - 1;
+top.next_arc = start[top.v];
+}
+}
+
+// insert the subtrees right after v in the anchor's tour
+node_t subtrees = Tour.build(seq.data(), seq.size());
+auto [left, right] = Tour.split(vertices[v]);
+Tour.merge(Tour.merge(left, NIL, subtrees), NIL, right);
+}
+});
+}
+
+template <class Tree>
+pair <int, int> ETTForest<Tree>::remove_tree_edge(int a, int b) {
+// the pair may have been created as (b,a), but the
+// procedure below is symmetric
+node_t ab_edge = TEdgeHooks.find(a, b, edge_endpoints());
+TEdgeHooks.erase(ab_edge, edge_endpoints());
+
+pair <int, int> sizes = cut_edge_nodes(ab_edge);
+// the node ab_edge leads to its target
+if (Tour[ab_edge].aux != b)
+swap(sizes.first, sizes.second);
+
+Tour.free_edge_nodes(ab_edge);
+
+release_if_isolated(a);
+release_if_isolated(b);
+return sizes;
+}
+
+/**
+* Cuts the pair of edge nodes starting at ab_edge, (a,b) and
+* (b,a), out of their Euler tour and returns the sizes of the
+* resulting trees of a and b. Touches only the nodes of the
+* tour (and the hook).
+*/
+template <class Tree>
+pair <int, int> ETTForest<Tree>::cut_edge_nodes(node_t ab_edge) {
+node_t ba_edge = ab_edge + 1;
+
+// the edge nodes do not count towards the sizes, and both
+// of them are left out of the Euler tours right away
+auto [l, r] = Tour.split_around(ab_edge);
+if (l != NIL && Tour.same_tree(l, ba_edge)) {
+
+// the tour routed in lr starts after (b,a) and finishes
+// before (a,b), so it describes the new connected
+// component of the vertex a
+auto [ll, lr] = Tour.split_around(ba_edge);
+
+// the rest of the tour describes b's connected component
+node_t rest = Tour.merge(ll, NIL, r);
+return {Tour[lr].size, Tour[rest].size};
+
+} else {
+assert(r != NIL && Tour.same_tree(r, ba_edge));
+
+// the tour routed in rl starts after (a,b) and finishes
+// before (b,a), so it describes the new connected
+// component of the vertex b
+auto [rl, rr] = Tour.split_around(ba_edge);
+
+// the rest of the tour describes a's connected component
+node_t rest = Tour.merge(l, NIL, rr);
+return {Tour[rest].size, Tour[rl].size};
+}
+}
+
+/**
+* The edges leave the index right away, while their nodes still
+* hold the endpoints; the nodes are released by finish_cuts, as
+* the free lists are shared by all the trees.
+*/
+template <class Tree>
+void ETTForest<Tree>::plan_cuts(const vector <pair <int, int> > &edges, size_t k) {
+CutEdges.resize(k);
+for (size_t i = 0; i < k; i++) {
+auto [a, b] = edges[i];
+node_t e = TEdgeHooks.find(a, b, edge_endpoints());
+TEdgeHooks.erase(e, edge_endpoints());
+CutEdges[i] = e;
+}
+
+CutNodes.clear();
+CutOwner.clear();
+CutGroupStart.assign(1, 0);
+CutSegments.clear();
+NextSegments.clear();
+CutPieces.clear();
+MergeTasks.clear();
+merging = false;
+// on one thread, the rounds would only add to the cuts
+if (threads <= 1) {
+for (node_t e: CutEdges)
+cut_edge_nodes(e);
+return;
+}
+
+// the places of the nodes e, e+1 of the i-th edge (the
+// entries 2i and 2i+1) in their tours
+struct Place {
+node_t root;
+uint64_t key;
+int node;
+};
+vector <Place> places(2 * k, Place{NIL, 0, 0});
+vector <char> keyed(2 * k);
+parallel_for(threads, 2 * k, [&](int j) {
+places[j].node = j;
+keyed[j] = Tour.order_key(CutEdges[j / 2] + j % 2, places[j].key,
+places[j].root);
+});
+sort(places.begin(), places.end(), [](const Place &x, const Place &y) {
+return x.root != y.root ? x.root < y.root : x.key < y.key;
+});
+
+for (size_t i = 0, j = 0; i < 2 * k; i = j) {
+bool deep = false;
+for (; j < 2 * k && places[j].root == places[i].root; j++)
+deep |= !keyed[places[j].node];
+
+if (deep) {
+for (size_t t = i; t < j; t++) {
+if (places[t].node % 2 == 0)
+cut_edge_nodes(CutEdges[places[t].node / 2]);
+}
+continue;
+}
+
+int g = CutGroupStart.size() - 1;
+CutSegments.push_back(CutSegment{int(CutNodes.size()),
+int(CutNodes.size() + j - i) - 1, g});
+for (size_t t = i; t < j; t++) {
+CutNodes.push_back(CutEdges[places[t].node / 2] + places[t].node % 2);
+CutOwner.push_back(places[t].node / 2);
+}
+CutGroupStart.push_back(CutNodes.size());
+}
+
+CutPieces.assign(CutNodes.size() + CutGroupStart.size() - 1, NIL);
+NextSegments.assign(2 * CutSegments.size(), CutSegment{0, -1, -1});
+}
+
+template <class Tree>
+int ETTForest<Tree>::cut_tasks() const {
+return merging ? MergeTasks.size() : CutSegments.size();
+}
+
+/**
+* A split task halves the segment of planned nodes forming its
+* tree; a side with no planned nodes is a final piece. A merge
+* task joins two consecutive pieces of a new tour.
+*/
+template <class Tree>
+void ETTForest<Tree>::cut_task(int i) {
+if (merging) {
+int x = MergeList[MergeTasks[i]], y = MergeList[MergeTasks[i] + 1];
+CutPieces[x] = Tour.merge(CutPieces[x], NIL, CutPieces[y]);
+return;
+}
+
+CutSegment seg = CutSegments[i];
+int mid = (seg.lo + seg.hi) / 2;
+auto [l, r] = Tour.split_around(CutNodes[mid]);
+
+if (mid == seg.lo)
+CutPieces[mid + seg.group] = l;
+else
+NextSegments[2 * i] = CutSegment{seg.lo, mid - 1, seg.group};
+
+if (mid == seg.hi)
+CutPieces[mid + 1 + seg.group] = r;
+else
+NextSegments[2 * i + 1] = CutSegment{mid + 1, seg.hi, seg.group};
+}
+
+template <class Tree>
+void ETTForest<Tree>::next_cut_round() {
+if (!merging) {
+CutSegments.clear();
+for (CutSegment seg: NextSegments) {
+if (seg.group != -1)
+CutSegments.push_back(seg);
+}
+NextSegments.assign(2 * CutSegments.size(), CutSegment{0, -1, -1});
+if (!CutSegments.empty())
+return;
+
+plan_merges();
+merging = true;
+
+} else {
+// the first piece of every merged pair holds the result
+int t_cnt = MergeStart.size() - 1, size = 0;
+for (int t = 0; t < t_cnt; t++) {
+int first = size;
+for (int i = MergeStart[t]; i < MergeStart[t + 1]; i += 2)
+MergeList[size++] = MergeList[i];
+MergeStart[t] = first;
+}
+MergeStart[t_cnt] = size;
+MergeList.resize(size);
+}
+
+MergeTasks.clear();
+for (size_t t = 0; t + 1 < MergeStart.size(); t++) {
+for (int i = MergeStart[t]; i + 1 < MergeStart[t + 1]; i += 2)
+MergeTasks.push_back(i);
+}
+}
+
+/**
+* The pairs of nodes of the edges of a tree are nested in its
+* tour like parentheses (also in a rotated one). Every edge cuts
+* out the part of the tour between its nodes, except for the
+* parts cut out by the edges nested in it, so a piece belongs to
+* the new tour of the innermost edge around it, or to the rest of
+* the old tour outside all the edges. The pieces of each new tour
+* are listed in their order.
+*/
+template <class Tree>
+void ETTForest<Tree>::plan_merges() {
+// the tour inside the p-th edge is p, the rest of the g-th
+// old tour is E + g
+int E = CutEdges.size(), G = CutGroupStart.size() - 1;
+vector <int> tour_of(CutPieces.size());
+vector <int> open;
+for (int g = 0; g < G; g++) {
+for (int j = CutGroupStart[g]; j < CutGroupStart[g + 1]; j++) {
+tour_of[j + g] = open.empty() ? E + g : open.back();
+if (!open.empty() && open.back() == CutOwner[j])
+open.pop_back();
+else
+open.push_back(CutOwner[j]);
+}
+assert(open.empty());
+tour_of[CutGroupStart[g + 1] + g] = E + g;
+}
+
+MergeStart.assign(E + G + 1, 0);
+for (size_t x = 0; x < CutPieces.size(); x++) {
+if (CutPieces[x] != NIL)
+MergeStart[tour_of[x] + 1]++;
+}
+for (int t = 0; t < E + G; t++)
+MergeStart[t + 1] += MergeStart[t];
+
+MergeList.resize(MergeStart[E + G]);
+vector <int> next(MergeStart.begin(), MergeStart.end() - 1);
+for (size_t x = 0; x < CutPieces.size(); x++) {
+if (CutPieces[x] != NIL)
+MergeList[next[tour_of[x]]++] = x;
+}
+}
+
+template <class Tree>
+void ETTForest<Tree>::finish_cuts() {
+for (node_t e: CutEdges) {
+int a = Tour[e + 1].aux, b = Tour[e].aux;
+Tour.free_edge_nodes(e);
+release_if_isolated(a);
+release_if_isolated(b);
+}
+CutEdges.clear();
+CutNodes.clear();
+CutPieces.clear();
+CutOwner.clear();
+CutGroupStart.clear();
+CutSegments.clear();
+MergeList.clear();
+MergeStart.clear();
+MergeTasks.clear();
+merging = false;
+}
+
+template <class Tree>
+void ETTForest<Tree>::push_nontree_record(int v, int r) {
+link_nontree_record(materialize(v), r);
+}
+
+/* Pushes the record r on the list headed in the vertex node x */
+template <class Tree>
+void ETTForest<Tree>::link_nontree_record(node_t x, int r) {
+int head = Tour[x].aux;
+NTEdges[r].prev = -1;
+NTEdges[r].next = head;
+if (head != -1)
+NTEdges[head].prev = r;
+
+Tour.set_nontree_head(x, r);
+}
+
+template <class Tree>
+void ETTForest<Tree>::erase_nontree_record(int v, int r) {
+if (NTEdges[r].prev != -1)
+NTEdges[NTEdges[r].prev].next = NTEdges[r].next;
+else
+Tour.set_nontree_head(vertex_node(v), NTEdges[r].next);
+
+if (NTEdges[r].next != -1)
+NTEdges[NTEdges[r].next].prev = NTEdges[r].prev;
+}
+
+template <class Tree>
+int ETTForest<Tree>::insert_nontree_edge(int a, int b) {
+int handle = NTFree;
+if (handle != -1) {
+NTFree = NTEdges[2*handle].next;
+
+} else {
+handle = NTEdges.size() / 2;
+NTEdges.resize(NTEdges.size() + 2);
+}
+
+NTEdges[2*handle].to = b;
+NTEdges[2*handle + 1].to = a;
+push_nontree_record(a, 2*handle);
+push_nontree_record(b, 2*handle + 1);
+nontree_edges++;
+return handle;
+}
+
+/**
+* The handles are allocated as in insert_nontree_edge. A record
+* only changes the list of its source, the records next to it on
+* the list and the aggregates of the tree of its source, so the
+* records of different trees are pushed in parallel.
+*/
+template <class Tree>
+void ETTForest<Tree>::insert_nontree_edges(const vector <pair <int, int> > &edges,
+vector <int> &handles) {
+int k = edges.size();
+handles.resize(k);
+vector <node_t> sources(2 * k);
+for (int i = 0; i < k; i++) {
+int handle = NTFree;
+if (handle != -1) {
+NTFree = NTEdges[2*handle].next;
+
+} else {
+handle = NTEdges.size() / 2;
+NTEdges.resize(NTEdges.size() + 2);
+}
+
+auto [a, b] = edges[i];
+NTEdges[2*handle].to = b;
+NTEdges[2*handle + 1].to = a;
+sources[2 * i] = materialize(a);
+sources[2 * i + 1] = materialize(b);
+handles[i] = handle;
+}
+nontree_edges += k;
+
+for_each_by_tree(sources, [&](int j) {
+link_nontree_record(sources[j], 2 * handles[j / 2] + j % 2);
+});
+}
+
+/* The records are erased like those of insert_nontree_edges are pushed */
+template <class Tree>
+void ETTForest<Tree>::remove_nontree_edges(const vector <int> &handles) {
+int k = handles.size();
+vector <int> records(2 * k);
+vector <node_t> sources(2 * k);
+for (int j = 0; j < 2 * k; j++) {
+records[j] = 2 * handles[j / 2] + j % 2;
+// the source of each record is the target of its twin
+sources[j] = vertex_node(NTEdges[records[j] ^ 1].to);
+}
+
+for_each_by_tree(sources, [&](int j) {
+erase_nontree_record(NTEdges[records[j] ^ 1].to, records[j]);
+});
+
+for (int handle: handles) {
+int a = NTEdges[2*handle + 1].to, b = NTEdges[2*handle].to;
+release_nontree_edge(handle);
+release_if_isolated(a);
+release_if_isolated(b);
+}
+}
+
+/**
+* Calls f(i) for every i < xs.size(): the indices of the nodes
+* of one tree one after another on one thread, those of
+* different trees in parallel
+*/
+template <class Tree>
+template <class F>
+void ETTForest<Tree>::for_each_by_tree(const vector <node_t> &xs, F f) {
+int k = xs.size();
+vector <pair <node_t, int> > order(k);
+parallel_for(threads, k, [&](int i) {
+order[i] = {Tour.find_root(xs[i]), i};
+});
+sort(order.begin(), order.end());
+
+vector <int> start;
+for (int i = 0; i < k; i++) {
+if (i == 0 || order[i].first != order[i - 1].first)
+start.push_back(i);
+}
+start.push_back(k);
+
+parallel_for(threads, start.size() - 1, [&](int g) {
+for (int i = start[g]; i < start[g + 1]; i++)
+f(order[i].second);
+});
+}
+
+template <class Tree>
+void ETTForest<Tree>::release_nontree_edge(int handle) {
+NTEdges[2*handle].next = NTFree;
+NTFree = handle;
+nontree_edges--;
+}
+
+template <class Tree>
+void ETTForest<Tree>::remove_nontree_edge(int handle) {
+// the source of each record is the target of its twin
+int a = NTEdges[2*handle + 1].to;
+int b = NTEdges[2*handle].to;
+erase_nontree_record(a, 2*handle);
+erase_nontree_record(b, 2*handle + 1);
+release_nontree_edge(handle);
+
+release_if_isolated(a);
+release_if_isolated(b);
+}
+
+template <class Tree>
+int ETTForest<Tree>::sample_nontree_edge(int a, uint32_t r, pair <int, int> &edge) {
+node_t x = vertex_node(a);
+if (x == NIL)
+return -1;
+
+node_t root = Tour.root(x);
+int k = Tour[root].nontree_cnt;
+if (k == 0)
+return -1;
+
+node_t vertex = Tour.find_nontree_edge(root, r % k);
+int record = Tour[vertex].aux;
+edge = {NTEdges[record ^ 1].to, NTEdges[record].to};
+return record / 2;
+}
+
+template <class Tree>
+int ETTForest<Tree>::next_nontree_edge(NontreeCursor &cursor, pair <int, int> &edge) {
+if (cursor.record != -1)
+cursor.record = NTEdges[cursor.record].next;
+
+if (cursor.record == -1) {
+node_t x = vertex_node(cursor.vertex);
+if (x == NIL)
+return -1;
+
+node_t root = Tour.root(x);
+if (cursor.rank >= Tour[root].nontree_cnt)
+return -1;
+
+node_t vertex = Tour.find_nontree_edge(root, cursor.rank++);
+cursor.record = Tour[vertex].aux;
+}
+
+int record = cursor.record;
+edge = {NTEdges[record ^ 1].to, NTEdges[record].to};
+return record / 2;
+}
+
+template <class Tree>
+bool ETTForest<Tree>::connected(int a, int b) {
+if (a == b)
+return true;
+
+node_t x = vertex_node(a), y = vertex_node(b);
+if (x == NIL || y == NIL)
+return false;
+
+return Tour.same_tree(x, y);
+}
+
+template <class Tree>
+void ETTForest<Tree>::connected_batch(const vector <pair <int, int> > &queries,
+vector <bool> &answers) {
+int k = queries.size();
+answers.resize(k);
+
+if (Tree::self_adjusting) {
+for (int i = 0; i < k; i++)
+answers[i] = connected(queries[i].first, queries[i].second);
+return;
+}
+
+// a vertex without a node has NIL as its root
+vector <node_t> nodes(2 * k), roots(2 * k);
+for (int i = 0; i < k; i++) {
+nodes[2 * i] = vertex_node(queries[i].first);
+nodes[2 * i + 1] = vertex_node(queries[i].second);
+}
+Tour.find_roots(nodes.data(), 2 * k, roots.data());
+
+for (int i = 0; i < k; i++) {
+answers[i] = queries[i].first == queries[i].second ||
+(roots[2 * i] != NIL && roots[2 * i] == roots[2 * i + 1]);
+}
+}
+
+template <class Tree>
+int ETTForest<Tree>::size(int a) {
+node_t x = vertex_node(a);
+if (x == NIL)
+return 1;
+
+return Tour[Tour.root(x)].size;
+}
+
+template <class Tree>
+void ETTForest<Tree>::print() {
+#ifdef DBG
+debug ("Print the forest:\n");
+set <node_t> processed;
+for (int v = 0; v < n; v++) {
+node_t x = vertex_node(v);
+if (x == NIL)
+continue;
+
+node_t root = Tour.find_root(x);
+if (processed.find(root) == processed.end()) {
+processed.insert(root);
+Tour.print_tree(root);
+debug("\n");
+}
+}
+#endif
+}
+
+template <class Tree>
+bool ETTForest<Tree>::correct() {
+
+// every list links records of its own vertex in both directions
+int records = 0;
+for (int v = 0; v < n; v++) {
+node_t x = vertex_node(v);
+if (x == NIL)
+continue;
+
+// a sparse forest stores only the vertices with edges
+const TourNode &node = Tour[x];
+if (sparse && node.parent == NIL && node.left == NIL &&
+node.right == NIL && node.aux == -1)
+return false;
+
+int prev = -1;
+for (int r = Tour[x].aux; r != -1; r = NTEdges[r].next) {
+if (NTEdges[r].prev != prev || NTEdges[r ^ 1].to != v)
+return false;
+prev = r;
+records++;
+}
+}
+if (records != 2 * nontree_edges)
+return false;
+
+set <node_t> processed;
+for (int v = 0; v < n; v++) {
+node_t x = vertex_node(v);
+if (x == NIL)
+continue;
+
+node_t root = Tour.find_root(x);
+
+if (processed.count(root) > 0)
+continue;
+
+processed.insert(root);
+
+if (!Tour.correct_tree(root, NIL)) {
+return false;
+}
+}
+return true;
+}
+
+template class ETTForest<AVLTree>;
+template class ETTForest<SplayTree>;
+template class ETTForest<Treap>;
+template class ETTForest<HookedTree<AVLTree> >;
+template class ETTForest<HookedTree<SplayTree> >;
+template class ETTForest<HookedTree<Treap> >;
+#include <cassert>
+#ifndef TOUR_TREE_HPP
+#define TOUR_TREE_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <cassert>
+using namespace std;
+
+// A switch for managing debug output
+// #define DBG
+#ifdef DBG
+#define debug(...) fprintf(stderr, __VA_ARGS__), fflush(stderr)
+#else
+#define debug(...) {}
+#endif
+
+/* Nodes are addressed by 32-bit indices into the node array */
+typedef uint32_t node_t;
+
+/* Index of the sentinel node, which stands for an empty tree */
+const node_t NIL = 0;
+
+enum NodeFlags : uint8_t {
+/* the node represents a vertex (otherwise a tree edge) */
+VERTEX_NODE = 1,
+/* the node is a tree edge on the level of the forest */
+ON_LEVEL = 2
+};
+
+/**
+* A node of an Euler tour: either a vertex or one direction
+* of a tree edge (see et_trees.hpp). All the fields used while
+* restructuring the tree are packed into 32 bytes, so two nodes
+* share a cache line.
+*/
+struct TourNode {
+node_t left, right, parent;
+
+/* number of vertex nodes in the subtree of this node */
+int size;
+/* number of vertex nodes in the subtree storing nontree edges */
+int nontree_cnt;
+/* number of ON_LEVEL edge nodes in the subtree */
+int on_level_cnt;
+
+/**
+* Vertex nodes: the first record of the list of nontree
+* edges of the vertex (-1 if it is empty, see et_trees.hpp)
+* Edge nodes: the vertex the edge leads to
+*/
+int aux;
+
+/* height of the subtree (maintained only by AVLTree) */
+uint8_t height;
+uint8_t flags;
+};
+
+/**
+* Extra aggregates of the subtrees, maintained outside of the
+* nodes on behalf of a user of a forest: update(x, left, right)
+* is called whenever the aggregates of the node x are recomputed
+* from those of its children (NIL for a missing child).
+* Before a node past the array of nodes is updated, resize(k)
+* tells that the forest has grown to k nodes; update itself must
+* not grow the storage, as a forest may recompute the nodes of
+* different trees on several threads at once (see ETTForest::
+* link_batch and ETTForest::plan_cuts) and update may only write
+* the aggregates of x.
+*
+* The hook is a policy of the sequence trees (see TourTree):
+* only the trees instantiated with AggregateHook call it.
+*/
+class AggregateHook {
+public:
+static constexpr bool enabled = true;
+
+virtual void update(node_t x, node_t left, node_t right) = 0;
+virtual void resize(size_t) {}
+virtual ~AggregateHook() {}
+};
+
+/* The hook policy of the trees without extra aggregates */
+struct NoHook {
+static constexpr bool enabled = false;
+};
+
+/**
+* The part of a balanced sequence tree which does not depend on
+* the balancing scheme: the array of TourNodes owned by a forest,
+* allocation of nodes and the aggregates stored in them.
+*
+* Node 0 is a sentinel (NIL) whose aggregates are all zero, so
+* they can be summed without checking for missing children. Edge
+* nodes are allocated in pairs (e, e+1), one for each direction
+* of the edge; released nodes are reused before the array grows.
+*
+* ETTForest (et_trees.hpp) takes the sequence tree as a template
+* parameter. Besides the methods below, a sequence tree provides:
+*
+*   pair <node_t, node_t> split(node_t x);
+*   pair <node_t, node_t> split_around(node_t x);
+*   node_t merge(node_t left, node_t middle, node_t right);
+*   node_t root(node_t x);
+*   bool same_tree(node_t x, node_t y);
+*   void unlink(node_t x);
+*   node_t build(const node_t *seq, int k);
+*   bool correct_tree(node_t x, node_t correct_parent) const;
+*
+* with the semantics documented in avl_tree.hpp, and the alias
+*
+*   template <class OtherHook> using with_hook = ...;
+*
+* for the same tree with another hook policy. A sequence tree
+* may restructure the tree in any of them (even in root), so a
+* root returned by one call is only valid until the next one.
+* Only a tree which sets self_adjusting does so in root,
+* same_tree and find_nontree_edge; in the others, these only
+* read the tree and may run on several threads at once.
+* Implementations: AVLTree (avl_tree.hpp), SplayTree
+* (splay_tree.hpp) and Treap (treap.hpp).
+*
+* The Hook parameter is NoHook or AggregateHook. With NoHook,
+* the call of the hook is compiled out of every recomputation
+* of the aggregates; the trees are compiled for both policies
+* and HookedTree below names the one calling a hook.
+*/
+
+template <class Hook>
+class TourTree {
+public:
+typedef Hook hook_type;
+
+/* whether the queries restructure the tree (see above) */
+static constexpr bool self_adjusting = false;
+
+/* the number of walks of find_roots in flight */
+static constexpr int ROOT_WALKS = 32;
+
+TourTree();
+
+/**
+* Creates a new single-node tree representing a vertex
+* Complexity: O(1) (amortized)
+*/
+node_t new_vertex_node();
+
+/**
+* Releases the vertex node x, which must form
+* a single-node tree
+* Complexity: O(1)
+*/
+void free_vertex_node(node_t x);
+
+/**
+* Creates two single-node trees: e representing the edge
+* (a,b) (on the level if on_level is set) and e+1
+* representing the edge (b,a). Returns e.
+* Complexity: O(1) (amortized)
+*/
+node_t new_edge_nodes(int a, int b, bool on_level);
+
+/**
+* Releases the pair of edge nodes starting at e
+* Both of them must already be unlinked
+* Complexity: O(1)
+*/
+void free_edge_nodes(node_t e);
+
+const TourNode &operator[](node_t x) const {
+return Nodes[x];
+}
+
+/**
+* Sets the hook maintaining extra aggregates (or turns them
+* off if hook is NULL) and tells it the number of nodes.
+* The aggregates of the existing nodes are not recomputed.
+* With NoHook, the hook is never called.
+* Complexity: O(1) besides the resize of the hook
+*/
+void set_aggregate_hook(Hook *_hook);
+
+/**
+* Sets key to a number ordering x among the nodes of its
+* tree as the sequence does and root to the root of the
+* tree, without restructuring the tree. Returns false (and
+* no key) if x is deeper than MAX_KEY_DEPTH, as its path from
+* the root does not fit in the key then.
+* Complexity: O(depth of x)
+*/
+bool order_key(node_t x, uint64_t &key, node_t &root) const;
+static constexpr int MAX_KEY_DEPTH = 62;
+
+/**
+* Recomputes the aggregates of x and all its ancestors
+* Complexity: O(depth of x)
+*/
+void update_path(node_t x);
+
+/**
+* Returns the root of the tree containing x without
+* restructuring the tree (for diagnostics)
+*
+* Complexity: O(depth of x)
+*/
+node_t find_root(node_t x) const;
+
+/**
+* Like find_root, but loads the parent pointers atomically
+* (see set_parent), so that it may run while another thread
+* restructures the tree. The result is then meaningless and
+* must be validated by the caller (see SeqLock in
+* seqlock.hpp). Gives up and
+* returns NIL after limit steps, as a concurrent rotation may
+* close a cycle of parent pointers for a moment.
+*
+* Complexity: O(min(depth of x, limit))
+*/
+node_t find_root_concurrent(node_t x, int limit) const;
+
+/**
+* Sets roots[i] to find_root(xs[i]) for all i < k. Up to
+* ROOT_WALKS walks advance in lock-step, each prefetching
+* the next node on its path, so that the cache misses of
+* different walks overlap; a finished walk is replaced by
+* the next one right away.
+*
+* Complexity: O(sum of the depths of the nodes)
+*/
+void find_roots(const node_t *xs, int k, node_t *roots) const;
+
+/**
+* Reserves memory for k nodes (including NIL), so that the
+* array of nodes is not reallocated while it holds at most
+* k of them
+*
+* Complexity: O(k)
+*/
+void reserve(int k);
+
+/**
+* Appends the nodes of the tree rooted in x to seq (in
+* order) and turns each of them into a single-node tree
+* (to be reassembled with build)
+*
+* Complexity: O(size of the tree)
+*/
+void flatten(node_t x, vector <node_t> &seq);
+
+/**
+* Calls f(y) for every node y of the tree rooted in x, in
+* order, walking the parent pointers (without restructuring
+* the tree or allocating memory)
+*
+* Complexity: O(size of the tree)
+*/
+template <class F>
+void for_each_node(node_t x, F f) const;
+
+/**
+* Returns the r-th (from 0, in order) vertex node storing
+* nontree edges in the tree rooted in x or NIL if there are
+* at most r of them
+*
+* Complexity: O(height of the tree)
+*/
+node_t find_nontree_edge(node_t x, int r);
+
+/**
+* Calls f(v, head) for the vertex nodes v storing nontree
+* edges in the tree rooted in x, in order. head is the list
+* of v, which f may shorten by setting it to its remaining
+* part; f returns false to end the traversal. f must not
+* restructure the tree, but it may set the lists of other
+* vertex nodes (with set_nontree_head).
+*
+* The counters of the nodes above the lists emptied by f
+* are recomputed once, when the traversal leaves them.
+*
+* Complexity: O(k log(n/k)) plus the time of f, where k is
+* the number of vertex nodes visited
+*/
+template <class F>
+void scan_nontree_heads(node_t x, F f);
+
+/**
+* Sets the head of the list of nontree edges stored in
+* the vertex node x
+*
+* Complexity: O(depth of x) if the list becomes empty or
+* stops being empty, O(1) otherwise
+*/
+void set_nontree_head(node_t x, int head);
+
+/**
+* Unmarks the edge nodes marked as on_level in the tree
+* rooted in x and calls f(edge) with the edge (a,b) of each
+* of them, until f returns false. A single traversal, pruned
+* by the counters, visits only the marked nodes and their
+* ancestors and clears the counters on its way back up.
+* f must not modify the tree.
+*
+* Complexity: O(k log(n/k)) plus the time of f, where k is
+* the number of marked nodes
+*/
+template <class F>
+void take_on_level(node_t x, F f);
+
+void print_tree(node_t x, int indent = 0) const;
+void print_node(node_t x, int indent = 0) const;
+
+protected:
+vector <TourNode> Nodes;
+/* first released edge pair and vertex node (or NIL) */
+node_t free_pairs, free_vertices;
+Hook *hook;
+
+void set_parent(node_t x, node_t parent);
+void init_node(node_t x, const TourNode &init);
+void replace_child(node_t x, node_t old_child, node_t new_child);
+node_t build_balanced(const node_t *seq, int k);
+
+node_t descend_to_nontree_edge(node_t x, int r = 0) const;
+node_t descend_to_on_level(node_t x) const;
+pair <int, int> unmark_on_level(node_t x);
+
+void update_on_level_cnt(node_t x, int dx);
+void update_nontree_cnt(node_t x, int dx);
+void update_aggregates(node_t x);
+void grow_nodes(size_t k);
+
+bool correct_node(node_t x, node_t correct_parent) const;
+};
+
+/**
+* Every write of a parent goes through here: find_root_concurrent
+* loads the parents while the tree changes, so the stores must be
+* atomic. A store releases the node it links to, so that a walk
+* which reaches a newly allocated node also sees it initialized;
+* on x86 both sides are plain moves.
+*/
+template <class Hook>
+inline void TourTree<Hook>::set_parent(node_t x, node_t parent) {
+__atomic_store_n(&Nodes[x].parent, parent, __ATOMIC_RELEASE);
+}
+
+template <class Hook>
+inline void TourTree<Hook>::update_aggregates(node_t x) {
+TourNode &node = Nodes[x];
+const TourNode &l = Nodes[node.left];
+const TourNode &r = Nodes[node.right];
+bool vertex = node.flags & VERTEX_NODE;
+
+node.size = l.size + r.size + (vertex ? 1 : 0);
+node.on_level_cnt = l.on_level_cnt + r.on_level_cnt +
+((node.flags & ON_LEVEL) ? 1 : 0);
+node.nontree_cnt = l.nontree_cnt + r.nontree_cnt +
+((vertex && node.aux != -1) ? 1 : 0);
+
+if constexpr (Hook::enabled) {
+if (hook != NULL)
+hook->update(x, node.left, node.right);
+}
+}
+
+template <class Hook>
+template <class F>
+void TourTree<Hook>::for_each_node(node_t x, F f) const {
+if (x == NIL)
+return;
+
+node_t cur = x;
+while (Nodes[cur].left != NIL)
+cur = Nodes[cur].left;
+
+while (true) {
+f(cur);
+
+if (Nodes[cur].right != NIL) {
+// the successor is the first node of the right subtree
+cur = Nodes[cur].right;
+while (Nodes[cur].left != NIL)
+cur = Nodes[cur].left;
+
+} else {
+// the successor is the first ancestor entered from the left
+while (cur != x && Nodes[Nodes[cur].parent].right == cur)
+cur = Nodes[cur].parent;
+if (cur == x)
+return;
+cur = Nodes[cur].parent;
+}
+}
+}
+
+/**
+* Walks down into the subtrees with marked nodes first, then
+* unmarks the node itself and goes right. A node is left (with
+* its counter zeroed) only when nothing below it is marked, so
+* the walk comes back to every node at most twice. When f asks
+* to stop, only the counters on the path back to x are stale.
+*/
+template <class Hook>
+template <class F>
+void TourTree<Hook>::take_on_level(node_t x, F f) {
+node_t cur = x;
+
+while (Nodes[x].on_level_cnt > 0) {
+TourNode &node = Nodes[cur];
+
+if (Nodes[node.left].on_level_cnt > 0) {
+cur = node.left;
+continue;
+}
+if (node.flags & ON_LEVEL) {
+node.flags &= ~ON_LEVEL;
+if (!f(pair <int, int> (Nodes[cur+1].aux, node.aux))) {
+for (node_t y = cur; y != Nodes[x].parent; y = Nodes[y].parent) {
+Nodes[y].on_level_cnt = Nodes[Nodes[y].left].on_level_cnt +
+Nodes[Nodes[y].right].on_level_cnt +
+((Nodes[y].flags & ON_LEVEL) ? 1 : 0);
+}
+return;
+}
+}
+if (Nodes[node.right].on_level_cnt > 0) {
+cur = node.right;
+continue;
+}
+
+node.on_level_cnt = 0;
+cur = node.parent;
+}
+}
+
+/**
+* An in-order walk through the nodes with nontree edges below
+* them. The node the walk came from tells which part of a node
+* comes next. Once f asks to stop, the walk only goes back up to
+* the root, fixing the counters.
+*/
+template <class Hook>
+template <class F>
+void TourTree<Hook>::scan_nontree_heads(node_t x, F f) {
+node_t cur = x, prv = Nodes[x].parent;
+bool more = true;
+
+while (cur != Nodes[x].parent) {
+node_t left = Nodes[cur].left, right = Nodes[cur].right;
+
+if (prv == Nodes[cur].parent) {
+if (more && Nodes[left].nontree_cnt > 0) {
+prv = cur;
+cur = left;
+continue;
+}
+prv = left;
+}
+
+if (prv == left) {
+if (more && (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1) {
+int head = Nodes[cur].aux;
+more = f(cur, head);
+Nodes[cur].aux = head;
+}
+if (more && Nodes[right].nontree_cnt > 0) {
+prv = cur;
+cur = right;
+continue;
+}
+}
+
+bool own = (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1;
+Nodes[cur].nontree_cnt = Nodes[left].nontree_cnt +
+Nodes[right].nontree_cnt + (own ? 1 : 0);
+prv = cur;
+cur = Nodes[cur].parent;
+}
+}
+
+/* The sequence tree Tree calling an AggregateHook */
+template <class Tree>
+using HookedTree = typename Tree::template with_hook <AggregateHook>;
+
+#endif
+
+template <class Hook>
+TourTree<Hook>::TourTree() {
+// the sentinel: all aggregates and the height are zero
+Nodes.push_back(TourNode{NIL, NIL, NIL, 0, 0, 0, 0, 0, 0});
+free_pairs = free_vertices = NIL;
+hook = NULL;
+}
+
+template <class Hook>
+void TourTree<Hook>::set_aggregate_hook(Hook *_hook) {
+hook = _hook;
+if constexpr (Hook::enabled) {
+if (hook != NULL)
+hook->resize(Nodes.size());
+}
+}
+
+/**
+* With b_1 .. b_d the path from the root to x (1 for a step to
+* the right child), the key is the binary fraction 0.b_1 .. b_d 1
+* scaled by 2^63: the nodes in the left subtree of x continue the
+* path with a 0 and those in the right one with a 1, so they get
+* smaller and greater keys respectively.
+*/
+template <class Hook>
+bool TourTree<Hook>::order_key(node_t x, uint64_t &key, node_t &root) const {
+uint64_t path = 0;
+int depth = 0;
+node_t cur = x;
+while (Nodes[cur].parent != NIL) {
+node_t parent = Nodes[cur].parent;
+if (depth < MAX_KEY_DEPTH && Nodes[parent].right == cur)
+path |= uint64_t(1) << depth;
+depth++;
+cur = parent;
+}
+
+root = cur;
+if (depth > MAX_KEY_DEPTH)
+return false;
+key = (2 * path + 1) << (MAX_KEY_DEPTH - depth);
+return true;
+}
+
+template <class Hook>
+void TourTree<Hook>::update_path(node_t x) {
+for (node_t cur = x; cur != NIL; cur = Nodes[cur].parent)
+update_aggregates(cur);
+}
+
+/**
+* Copies init into the node x field by field, so that the parent
+* is stored with set_parent (a released node may still be on the
+* path of a concurrent walk)
+*/
+template <class Hook>
+void TourTree<Hook>::init_node(node_t x, const TourNode &init) {
+TourNode &node = Nodes[x];
+node.left = init.left;
+node.right = init.right;
+set_parent(x, init.parent);
+node.size = init.size;
+node.nontree_cnt = init.nontree_cnt;
+node.on_level_cnt = init.on_level_cnt;
+node.aux = init.aux;
+node.height = init.height;
+node.flags = init.flags;
+}
+
+template <class Hook>
+node_t TourTree<Hook>::new_vertex_node() {
+node_t x = free_vertices;
+if (x != NIL) {
+free_vertices = Nodes[x].parent;
+
+} else {
+x = Nodes.size();
+grow_nodes(Nodes.size() + 1);
+}
+
+init_node(x, TourNode{NIL, NIL, NIL, 1, 0, 0, -1, 1, VERTEX_NODE});
+// a reused node may still hold stale extra aggregates
+if (Hook::enabled && hook != NULL)
+update_aggregates(x);
+return x;
+}
+
+template <class Hook>
+void TourTree<Hook>::grow_nodes(size_t k) {
+Nodes.resize(k);
+if constexpr (Hook::enabled) {
+if (hook != NULL)
+hook->resize(k);
+}
+}
+
+template <class Hook>
+void TourTree<Hook>::free_vertex_node(node_t x) {
+// released nodes are linked through the parent field
+set_parent(x, free_vertices);
+free_vertices = x;
+}
+
+template <class Hook>
+node_t TourTree<Hook>::new_edge_nodes(int a, int b, bool on_level) {
+node_t e = free_pairs;
+if (e != NIL) {
+free_pairs = Nodes[e].parent;
+
+} else {
+e = Nodes.size();
+grow_nodes(Nodes.size() + 2);
+}
+
+// it's enough to mark only one of the copies as on the level
+init_node(e, TourNode{NIL, NIL, NIL, 0, 0, on_level ? 1 : 0, b, 1,
+uint8_t(on_level ? ON_LEVEL : 0)});
+init_node(e+1, TourNode{NIL, NIL, NIL, 0, 0, 0, a, 1, 0});
+// a reused pair may still hold stale extra aggregates
+if (Hook::enabled && hook != NULL) {
+update_aggregates(e);
+update_aggregates(e+1);
+}
+return e;
+}
+
+template <class Hook>
+void TourTree<Hook>::free_edge_nodes(node_t e) {
+// released pairs are linked through the parent field
+set_parent(e, free_pairs);
+free_pairs = e;
+}
+
+template <class Hook>
+node_t TourTree<Hook>::find_root(node_t x) const {
+node_t cur = x;
+while (Nodes[cur].parent != NIL) {
+cur = Nodes[cur].parent;
+}
+return cur;
+}
+
+template <class Hook>
+node_t TourTree<Hook>::find_root_concurrent(node_t x, int limit) const {
+node_t cur = x;
+for (int steps = 0; steps <= limit; steps++) {
+node_t parent = __atomic_load_n(&Nodes[cur].parent, __ATOMIC_ACQUIRE);
+if (parent == NIL)
+return cur;
+cur = parent;
+}
+return NIL;
+}
+
+template <class Hook>
+void TourTree<Hook>::find_roots(const node_t *xs, int k, node_t *roots) const {
+// the walks in flight: the index of the query and the node reached
+int query[ROOT_WALKS];
+node_t cur[ROOT_WALKS];
+int active = 0, next = 0;
+
+for (; active < ROOT_WALKS && next < k; active++, next++) {
+query[active] = next;
+cur[active] = xs[next];
+__builtin_prefetch(&Nodes[cur[active]]);
+}
+
+while (active > 0) {
+for (int i = 0; i < active; ) {
+node_t parent = Nodes[cur[i]].parent;
+if (parent != NIL) {
+cur[i] = parent;
+__builtin_prefetch(&Nodes[parent]);
+i++;
+continue;
+}
+
+roots[query[i]] = cur[i];
+if (next < k) {
+query[i] = next;
+cur[i] = xs[next++];
+__builtin_prefetch(&Nodes[cur[i]]);
+i++;
+} else {
+// the last walk takes the place of the finished one
+active--;
+query[i] = query[active];
+cur[i] = cur[active];
+}
+}
+}
+}
+
+template <class Hook>
+void TourTree<Hook>::reserve(int k) {
+Nodes.reserve(k);
+}
+
+template <class Hook>
+void TourTree<Hook>::replace_child(node_t x, node_t old_child, node_t new_child) {
+
+if (Nodes[x].left == old_child) {
+Nodes[x].left = new_child;
+
+} else if (Nodes[x].right == old_child) {
+Nodes[x].right = new_child;
+
+} else {
+assert(0);
+}
+}
+
+/**
+* Builds a perfectly balanced tree (the heights of the subtrees
+* of every node differ by at most one) over the single-node
+* trees seq[0..k-1] and returns its root
+*/
+template <class Hook>
+node_t TourTree<Hook>::build_balanced(const node_t *seq, int k) {
+if (k == 0)
+return NIL;
+
+int mid = k / 2;
+node_t x = seq[mid];
+node_t left = build_balanced(seq, mid);
+node_t right = build_balanced(seq + mid + 1, k - mid - 1);
+
+Nodes[x].left = left;
+Nodes[x].right = right;
+if (left != NIL)
+set_parent(left, x);
+if (right != NIL)
+set_parent(right, x);
+
+Nodes[x].height = max(Nodes[left].height, Nodes[right].height) + 1;
+update_aggregates(x);
+return x;
+}
+
+template <class Hook>
+void TourTree<Hook>::flatten(node_t x, vector <node_t> &seq) {
+size_t first = seq.size();
+for_each_node(x, [&](node_t y) { seq.push_back(y); });
+
+for (size_t i = first; i < seq.size(); i++) {
+node_t y = seq[i];
+Nodes[y].left = Nodes[y].right = NIL;
+set_parent(y, NIL);
+Nodes[y].height = 1;
+update_aggregates(y);
+}
+}
+
+// Manage data stored in the nodes
+
+template <class Hook>
+void TourTree<Hook>::update_on_level_cnt(node_t x, int dx) {
+for (node_t cur = x; cur != NIL; cur = Nodes[cur].parent) {
+Nodes[cur].on_level_cnt += dx;
+}
+}
+
+template <class Hook>
+void TourTree<Hook>::set_nontree_head(node_t x, int head) {
+bool had_edges = (Nodes[x].aux != -1);
+Nodes[x].aux = head;
+
+if (had_edges != (head != -1))
+update_nontree_cnt(x, had_edges ? -1 : 1);
+}
+
+template <class Hook>
+void TourTree<Hook>::update_nontree_cnt(node_t x, int dx) {
+for (node_t cur = x; cur != NIL; cur = Nodes[cur].parent) {
+Nodes[cur].nontree_cnt += dx;
+}
+}
+
+/**
+* Descends to the r-th (from 0, in order) vertex node holding
+* nontree edges, choosing the subtree by the counters, so the
+* descent never backtracks.
+*/
+template <class Hook>
+node_t TourTree<Hook>::descend_to_nontree_edge(node_t x, int r) const {
+if (r >= Nodes[x].nontree_cnt)
+return NIL;
+
+node_t cur = x;
+while (true) {
+node_t left = Nodes[cur].left;
+if (r < Nodes[left].nontree_cnt) {
+cur = left;
+continue;
+}
+
+r -= Nodes[left].nontree_cnt;
+if ((Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1) {
+if (r == 0)
+return cur;
+r--;
+}
+cur = Nodes[cur].right;
+}
+}
+
+/* Same as above, for the edge nodes marked as ON_LEVEL */
+template <class Hook>
+node_t TourTree<Hook>::descend_to_on_level(node_t x) const {
+if (Nodes[x].on_level_cnt == 0)
+return NIL;
+
+node_t cur = x;
+while (!(Nodes[cur].flags & ON_LEVEL)) {
+node_t left = Nodes[cur].left;
+if (Nodes[left].on_level_cnt > 0)
+cur = left;
+else
+cur = Nodes[cur].right;
+}
+
+return cur;
+}
+
+template <class Hook>
+pair <int, int> TourTree<Hook>::unmark_on_level(node_t x) {
+// only the first node of a pair is ever marked as on the level
+Nodes[x].flags &= ~ON_LEVEL;
+update_on_level_cnt(x, -1);
+return {Nodes[x+1].aux, Nodes[x].aux};
+}
+
+template <class Hook>
+node_t TourTree<Hook>::find_nontree_edge(node_t x, int r) {
+return descend_to_nontree_edge(x, r);
+}
+
+// diagnostic methods:
+
+template <class Hook>
+void TourTree<Hook>::print_tree(node_t x, int indent) const {
+#ifdef DBG
+if (Nodes[x].left != NIL)
+print_tree(Nodes[x].left, indent + 3);
+print_node(x, indent);
+if (Nodes[x].right != NIL)
+print_tree(Nodes[x].right, indent + 3);
+#else
+(void) x;
+(void) indent;
+#endif
+}
+
+template <class Hook>
+void TourTree<Hook>::print_node(node_t x, int indent) const {
+#ifdef DBG
+char spaces[20] = "                   ";
+spaces[min(19, indent)] = 0;
+const TourNode &node = Nodes[x];
+
+if (node.flags & VERTEX_NODE)
+debug("%sVertexNode: nontree edges from %d\n", spaces, node.aux);
+else
+debug("%sEdgeNode: to %d%s\n", spaces, node.aux,
+(node.flags & ON_LEVEL) ? " (on level)" : "");
+
+debug("%s%u: left = %u, right = %u, parent = %u,\n \
+%sheight = %d, nontree_cnt = %d, on_level_cnt = %d, size = %d\n",
+spaces, x, node.left, node.right, node.parent, spaces,
+node.height, node.nontree_cnt, node.on_level_cnt, node.size);
+#else
+(void) x;
+(void) indent;
+#endif
+}
+
+/**
+* Checks the invariants of x which do not depend on the
+* balancing scheme: the links and the aggregates
+* (assuming those of its children are correct)
+*/
+template <class Hook>
+bool TourTree<Hook>::correct_node(node_t x, node_t correct_parent) const {
+const TourNode &node = Nodes[x];
+const TourNode &left = Nodes[node.left];
+const TourNode &right = Nodes[node.right];
+bool vertex = node.flags & VERTEX_NODE;
+
+if (vertex && (node.flags & ON_LEVEL)) {
+debug ("a vertex node is marked as on the level\n");
+return false;
+}
+
+if (node.parent != correct_parent) {
+debug ("parent does not match: %u vs %u\n",
+node.parent, correct_parent);
+return false;
+}
+
+if (node.left != NIL && node.left == node.right) {
+debug ("left and right children are the same!\n");
+return false;
+}
+
+if (node.size != left.size + right.size + (vertex ? 1 : 0)) {
+debug ("size does not match\n");
+return false;
+}
+if (node.nontree_cnt != left.nontree_cnt + right.nontree_cnt +
+((vertex && node.aux != -1) ? 1 : 0)) {
+debug ("nontree_cnt does not match\n");
+return false;
+}
+if (node.on_level_cnt != left.on_level_cnt + right.on_level_cnt +
+((node.flags & ON_LEVEL) ? 1 : 0)) {
+debug ("on_level_cnt does not match\n");
+return false;
+}
+
+return true;
+}
+
+template class TourTree<NoHook>;
+template class TourTree<AggregateHook>;
+#include <cassert>
+#include <cstdlib>
+#ifndef AVL_TREE_HPP
+#define AVL_TREE_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <cassert>
+#ifndef TOUR_TREE_HPP
+#define TOUR_TREE_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <cassert>
+using namespace std;
+
+// A switch for managing debug output
+// #define DBG
+#ifdef DBG
+#define debug(...) fprintf(stderr, __VA_ARGS__), fflush(stderr)
+#else
+#define debug(...) {}
+#endif
+
+/* Nodes are addressed by 32-bit indices into the node array */
+typedef uint32_t node_t;
+
+/* Index of the sentinel node, which stands for an empty tree */
+const node_t NIL = 0;
+
+enum NodeFlags : uint8_t {
+/* the node represents a vertex (otherwise a tree edge) */
+VERTEX_NODE = 1,
+/* the node is a tree edge on the level of the forest */
+ON_LEVEL = 2
+};
+
+/**
+* A node of an Euler tour: either a vertex or one direction
+* of a tree edge (see et_trees.hpp). All the fields used while
+* restructuring the tree are packed into 32 bytes, so two nodes
+* share a cache line.
+*/
+struct TourNode {
+node_t left, right, parent;
+
+/* number of vertex nodes in the subtree of this node */
+int size;
+/* number of vertex nodes in the subtree storing nontree edges */
+int nontree_cnt;
+/* number of ON_LEVEL edge nodes in the subtree */
+int on_level_cnt;
+
+/**
+* Vertex nodes: the first record of the list of nontree
+* edges of the vertex (-1 if it is empty, see et_trees.hpp)
+* Edge nodes: the vertex the edge leads to
+*/
+int aux;
+
+/* height of the subtree (maintained only by AVLTree) */
+uint8_t height;
+uint8_t flags;
+};
+
+/**
+* Extra aggregates of the subtrees, maintained outside of the
+* nodes on behalf of a user of a forest: update(x, left, right)
+* is called whenever the aggregates of the node x are recomputed
+* from those of its children (NIL for a missing child).
+* Before a node past the array of nodes is updated, resize(k)
+* tells that the forest has grown to k nodes; update itself must
+* not grow the storage, as a forest may recompute the nodes of
+* different trees on several threads at once (see ETTForest::
+* link_batch and ETTForest::plan_cuts) and update may only write
+* the aggregates of x.
+*
+* The hook is a policy of the sequence trees (see TourTree):
+* only the trees instantiated with AggregateHook call it.
+*/
+class AggregateHook {
+public:
+static constexpr bool enabled = true;
+
+virtual void update(node_t x, node_t left, node_t right) = 0;
+virtual void resize(size_t) {}
+virtual ~AggregateHook() {}
+};
+
+/* The hook policy of the trees without extra aggregates */
+struct NoHook {
+static constexpr bool enabled = false;
+};
+
+/**
+* The part of a balanced sequence tree which does not depend on
+* the balancing scheme: the array of TourNodes owned by a forest,
+* allocation of nodes and the aggregates stored in them.
+*
+* Node 0 is a sentinel (NIL) whose aggregates are all zero, so
+* they can be summed without checking for missing children. Edge
+* nodes are allocated in pairs (e, e+1), one for each direction
+* of the edge; released nodes are reused before the array grows.
+*
+* ETTForest (et_trees.hpp) takes the sequence tree as a template
+* parameter. Besides the methods below, a sequence tree provides:
+*
+*   pair <node_t, node_t> split(node_t x);
+*   pair <node_t, node_t> split_around(node_t x);
+*   node_t merge(node_t left, node_t middle, node_t right);
+*   node_t root(node_t x);
+*   bool same_tree(node_t x, node_t y);
+*   void unlink(node_t x);
+*   node_t build(const node_t *seq, int k);
+*   bool correct_tree(node_t x, node_t correct_parent) const;
+*
+* with the semantics documented in avl_tree.hpp, and the alias
+*
+*   template <class OtherHook> using with_hook = ...;
+*
+* for the same tree with another hook policy. A sequence tree
+* may restructure the tree in any of them (even in root), so a
+* root returned by one call is only valid until the next one.
+* Only a tree which sets self_adjusting does so in root,
+* same_tree and find_nontree_edge; in the others, these only
+* read the tree and may run on several threads at once.
+* Implementations: AVLTree (avl_tree.hpp), SplayTree
+* (splay_tree.hpp) and Treap (treap.hpp).
+*
+* The Hook parameter is NoHook or AggregateHook. With NoHook,
+* the call of the hook is compiled out of every recomputation
+* of the aggregates; the trees are compiled for both policies
+* and HookedTree below names the one calling a hook.
+*/
+
+template <class Hook>
+class TourTree {
+public:
+typedef Hook hook_type;
+
+/* whether the queries restructure the tree (see above) */
+static constexpr bool self_adjusting = false;
+
+/* the number of walks of find_roots in flight */
+static constexpr int ROOT_WALKS = 32;
+
+TourTree();
+
+/**
+* Creates a new single-node tree representing a vertex
+* Complexity: O(1) (amortized)
+*/
+node_t new_vertex_node();
+
+/**
+* Releases the vertex node x, which must form
+* a single-node tree
+* Complexity: O(1)
+*/
+void free_vertex_node(node_t x);
+
+/**
+* Creates two single-node trees: e representing the edge
+* (a,b) (on the level if on_level is set) and e+1
+* representing the edge (b,a). Returns e.
+* Complexity: O(1) (amortized)
+*/
+node_t new_edge_nodes(int a, int b, bool on_level);
+
+/**
+* Releases the pair of edge nodes starting at e
+* Both of them must already be unlinked
+* Complexity: O(1)
+*/
+void free_edge_nodes(node_t e);
+
+const TourNode &operator[](node_t x) const {
+return Nodes[x];
+}
+
+/**
+* Sets the hook maintaining extra aggregates (or turns them
+* off if hook is NULL) and tells it the number of nodes.
+* The aggregates of the existing nodes are not recomputed.
+* With NoHook, the hook is never called.
+* Complexity: O(1) besides the resize of the hook
+*/
+void set_aggregate_hook(Hook *_hook);
+
+/**
+* Sets key to a number ordering x among the nodes of its
+* tree as the sequence does and root to the root of the
+* tree, without restructuring the tree. Returns false (and
+* no key) if x is deeper than MAX_KEY_DEPTH, as its path from
+* the root does not fit in the key then.
+* Complexity: O(depth of x)
+*/
+bool order_key(node_t x, uint64_t &key, node_t &root) const;
+static constexpr int MAX_KEY_DEPTH = 62;
+
+/**
+* Recomputes the aggregates of x and all its ancestors
+* Complexity: O(depth of x)
+*/
+void update_path(node_t x);
+
+/**
+* Returns the root of the tree containing x without
+* restructuring the tree (for diagnostics)
+*
+* Complexity: O(depth of x)
+*/
+node_t find_root(node_t x) const;
+
+/**
+* Like find_root, but loads the parent pointers atomically
+* (see set_parent), so that it may run while another thread
+* restructures the tree. The result is then meaningless and
+* must be validated by the caller (see SeqLock in
+* seqlock.hpp). Gives up and
+* returns NIL after limit steps, as a concurrent rotation may
+* close a cycle of parent pointers for a moment.
+*
+* Complexity: O(min(depth of x, limit))
+*/
+node_t find_root_concurrent(node_t x, int limit) const;
+
+/**
+* Sets roots[i] to find_root(xs[i]) for all i < k. Up to
+* ROOT_WALKS walks advance in lock-step, each prefetching
+* the next node on its path, so that the cache misses of
+* different walks overlap; a finished walk is replaced by
+* the next one right away.
+*
+* Complexity: O(sum of the depths of the nodes)
+*/
+void find_roots(const node_t *xs, int k, node_t *roots) const;
+
+/**
+* Reserves memory for k nodes (including NIL), so that the
+* array of nodes is not reallocated while it holds at most
+* k of them
+*
+* Complexity: O(k)
+*/
+void reserve(int k);
+
+/**
+* Appends the nodes of the tree rooted in x to seq (in
+* order) and turns each of them into a single-node tree
+* (to be reassembled with build)
+*
+* Complexity: O(size of the tree)
+*/
+void flatten(node_t x, vector <node_t> &seq);
+
+/**
+* Calls f(y) for every node y of the tree rooted in x, in
+* order, walking the parent pointers (without restructuring
+* the tree or allocating memory)
+*
+* Complexity: O(size of the tree)
+*/
+template <class F>
+void for_each_node(node_t x, F f) const;
+
+/**
+* Returns the r-th (from 0, in order) vertex node storing
+* nontree edges in the tree rooted in x or NIL if there are
+* at most r of them
+*
+* Complexity: O(height of the tree)
+*/
+node_t find_nontree_edge(node_t x, int r);
+
+/**
+* Calls f(v, head) for the vertex nodes v storing nontree
+* edges in the tree rooted in x, in order. head is the list
+* of v, which f may shorten by setting it to its remaining
+* part; f returns false to end the traversal. f must not
+* restructure the tree, but it may set the lists of other
+* vertex nodes (with set_nontree_head).
+*
+* The counters of the nodes above the lists emptied by f
+* are recomputed once, when the traversal leaves them.
+*
+* Complexity: O(k log(n/k)) plus the time of f, where k is
+* the number of vertex nodes visited
+*/
+template <class F>
+void scan_nontree_heads(node_t x, F f);
+
+/**
+* Sets the head of the list of nontree edges stored in
+* the vertex node x
+*
+* Complexity: O(depth of x) if the list becomes empty or
+* stops being empty, O(1) otherwise
+*/
+void set_nontree_head(node_t x, int head);
+
+/**
+* Unmarks the edge nodes marked as on_level in the tree
+* rooted in x and calls f(edge) with the edge (a,b) of each
+* of them, until f returns false. A single traversal, pruned
+* by the counters, visits only the marked nodes and their
+* ancestors and clears the counters on its way back up.
+* f must not modify the tree.
+*
+* Complexity: O(k log(n/k)) plus the time of f, where k is
+* the number of marked nodes
+*/
+template <class F>
+void take_on_level(node_t x, F f);
+
+void print_tree(node_t x, int indent = 0) const;
+void print_node(node_t x, int indent = 0) const;
+
+protected:
+vector <TourNode> Nodes;
+/* first released edge pair and vertex node (or NIL) */
+node_t free_pairs, free_vertices;
+Hook *hook;
+
+void set_parent(node_t x, node_t parent);
+void init_node(node_t x, const TourNode &init);
+void replace_child(node_t x, node_t old_child, node_t new_child);
+node_t build_balanced(const node_t *seq, int k);
+
+node_t descend_to_nontree_edge(node_t x, int r = 0) const;
+node_t descend_to_on_level(node_t x) const;
+pair <int, int> unmark_on_level(node_t x);
+
+void update_on_level_cnt(node_t x, int dx);
+void update_nontree_cnt(node_t x, int dx);
+void update_aggregates(node_t x);
+void grow_nodes(size_t k);
+
+bool correct_node(node_t x, node_t correct_parent) const;
+};
+
+/**
+* Every write of a parent goes through here: find_root_concurrent
+* loads the parents while the tree changes, so the stores must be
+* atomic. A store releases the node it links to, so that a walk
+* which reaches a newly allocated node also sees it initialized;
+* on x86 both sides are plain moves.
+*/
+template <class Hook>
+inline void TourTree<Hook>::set_parent(node_t x, node_t parent) {
+__atomic_store_n(&Nodes[x].parent, parent, __ATOMIC_RELEASE);
+}
+
+template <class Hook>
+inline void TourTree<Hook>::update_aggregates(node_t x) {
+TourNode &node = Nodes[x];
+const TourNode &l = Nodes[node.left];
+const TourNode &r = Nodes[node.right];
+bool vertex = node.flags & VERTEX_NODE;
+
+node.size = l.size + r.size + (vertex ? 1 : 0);
+node.on_level_cnt = l.on_level_cnt + r.on_level_cnt +
+((node.flags & ON_LEVEL) ? 1 : 0);
+node.nontree_cnt = l.nontree_cnt + r.nontree_cnt +
+((vertex && node.aux != -1) ? 1 : 0);
+
+if constexpr (Hook::enabled) {
+if (hook != NULL)
+hook->update(x, node.left, node.right);
+}
+}
+
+template <class Hook>
+template <class F>
+void TourTree<Hook>::for_each_node(node_t x, F f) const {
+if (x == NIL)
+return;
+
+node_t cur = x;
+while (Nodes[cur].left != NIL)
+cur = Nodes[cur].left;
+
+while (true) {
+f(cur);
+
+if (Nodes[cur].right != NIL) {
+// the successor is the first node of the right subtree
+cur = Nodes[cur].right;
+while (Nodes[cur].left != NIL)
+cur = Nodes[cur].left;
+
+} else {
+// the successor is the first ancestor entered from the left
+while (cur != x && Nodes[Nodes[cur].parent].right == cur)
+cur = Nodes[cur].parent;
+if (cur == x)
+return;
+cur = Nodes[cur].parent;
+}
+}
+}
+
+/**
+* Walks down into the subtrees with marked nodes first, then
+* unmarks the node itself and goes right. A node is left (with
+* its counter zeroed) only when nothing below it is marked, so
+* the walk comes back to every node at most twice. When f asks
+* to stop, only the counters on the path back to x are stale.
+*/
+template <class Hook>
+template <class F>
+void TourTree<Hook>::take_on_level(node_t x, F f) {
+node_t cur = x;
+
+while (Nodes[x].on_level_cnt > 0) {
+TourNode &node = Nodes[cur];
+
+if (Nodes[node.left].on_level_cnt > 0) {
+cur = node.left;
+continue;
+}
+if (node.flags & ON_LEVEL) {
+node.flags &= ~ON_LEVEL;
+if (!f(pair <int, int> (Nodes[cur+1].aux, node.aux))) {
+for (node_t y = cur; y != Nodes[x].parent; y = Nodes[y].parent) {
+Nodes[y].on_level_cnt = Nodes[Nodes[y].left].on_level_cnt +
+Nodes[Nodes[y].right].on_level_cnt +
+((Nodes[y].flags & ON_LEVEL) ? 1 : 0);
+}
+return;
+}
+}
+if (Nodes[node.right].on_level_cnt > 0) {
+cur = node.right;
+continue;
+}
+
+node.on_level_cnt = 0;
+cur = node.parent;
+}
+}
+
+/**
+* An in-order walk through the nodes with nontree edges below
+* them. The node the walk came from tells which part of a node
+* comes next. Once f asks to stop, the walk only goes back up to
+* the root, fixing the counters.
+*/
+template <class Hook>
+template <class F>
+void TourTree<Hook>::scan_nontree_heads(node_t x, F f) {
+node_t cur = x, prv = Nodes[x].parent;
+bool more = true;
+
+while (cur != Nodes[x].parent) {
+node_t left = Nodes[cur].left, right = Nodes[cur].right;
+
+if (prv == Nodes[cur].parent) {
+if (more && Nodes[left].nontree_cnt > 0) {
+prv = cur;
+cur = left;
+continue;
+}
+prv = left;
+}
+
+if (prv == left) {
+if (more && (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1) {
+int head = Nodes[cur].aux;
+more = f(cur, head);
+Nodes[cur].aux = head;
+}
+if (more && Nodes[right].nontree_cnt > 0) {
+prv = cur;
+cur = right;
+continue;
+}
+}
+
+bool own = (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1;
+Nodes[cur].nontree_cnt = Nodes[left].nontree_cnt +
+Nodes[right].nontree_cnt + (own ? 1 : 0);
+prv = cur;
+cur = Nodes[cur].parent;
+}
+}
+
+/* The sequence tree Tree calling an AggregateHook */
+template <class Tree>
+using HookedTree = typename Tree::template with_hook <AggregateHook>;
+
+#endif
+using namespace std;
+
+/**
+* AVL Binary Search Tree implementation
+* (https://en.wikipedia.org/wiki/AVL_tree)
+* over an array of TourNodes.
+*
+* The object owns the nodes of all the trees of a forest and
+* every operation takes node indices (see tour_tree.hpp).
+* Hook is the policy of the extra aggregates (see TourTree).
+*/
+
+template <class Hook = NoHook>
+class BasicAVLTree : public TourTree <Hook> {
+typedef TourTree <Hook> Base;
+
+public:
+template <class OtherHook>
+using with_hook = BasicAVLTree <OtherHook>;
+
+using Base::find_root;
+
+/**
+* Splits the tree into two parts and returns their roots.
+* The first part contains all nodes to the left of x
+* (inclusive), the second part contains all nodes to the
+* right of it (exclusive).
+*
+* Complexity: O(log n)
+*/
+pair <node_t, node_t> split(node_t x);
+
+/**
+* Removes x from its tree and splits the rest of it into
+* the nodes to the left of x and the nodes to the right of
+* it (both exclusive). Returns the roots of the two parts.
+* This is split followed by unlink in a single pass.
+*
+* Complexity: O(log n)
+*/
+pair <node_t, node_t> split_around(node_t x);
+
+/**
+* Merges two trees (left and right) into one (the middle
+* node is optional) and returns the its root.
+* The order of nodes is as follows:
+* left(unchanged), middle, right(unchanged).
+*
+* Complexity if middle is NIL: O(max(h_l, h_r))
+* Complexity if middle is not NIL: O(abs(h_l - h_r))
+* Here h_l and h_r are the heights of left and right trees
+*/
+node_t merge(node_t left, node_t middle, node_t right);
+
+/**
+* Returns the root of the tree containing x
+*
+* Complexity: O(log n)
+*/
+node_t root(node_t x) const;
+
+/**
+* Checks whether x and y belong to the same tree
+*
+* Complexity: O(log n)
+*/
+bool same_tree(node_t x, node_t y) const;
+
+/**
+* Removes x from the tree it belongs to
+*
+* Complexity: O(log n)
+*/
+void unlink(node_t x);
+
+/**
+* Builds a tree from the single-node trees seq[0..k-1]
+* (in this order) and returns its root
+*
+* Complexity: O(k)
+*/
+node_t build(const node_t *seq, int k);
+
+/**
+* Checks if the invariants hold in the subtree of x
+*
+* Complexity: linear in the size of the tree
+*/
+bool correct_tree(node_t x, node_t correct_parent) const;
+
+private:
+using Base::Nodes;
+using Base::set_parent;
+using Base::update_aggregates;
+using Base::replace_child;
+using Base::build_balanced;
+using Base::correct_node;
+
+node_t balance(node_t x);
+node_t rebalance_path(node_t x, node_t top);
+node_t rotate_left(node_t x);
+node_t rotate_right(node_t x);
+node_t remove(node_t x);
+void detach(node_t x);
+pair <node_t, node_t> split_path(node_t x, node_t cur,
+node_t left_tree, node_t right_tree);
+
+void update_statistics(node_t x);
+};
+
+template <class Hook>
+inline void BasicAVLTree<Hook>::update_statistics(node_t x) {
+TourNode &node = Nodes[x];
+node.height = max(Nodes[node.left].height, Nodes[node.right].height) + 1;
+update_aggregates(x);
+}
+
+typedef BasicAVLTree <> AVLTree;
+
+#endif
+
+// BST operations:
+
+/* Detaches the children of x without updating its statistics */
+template <class Hook>
+void BasicAVLTree<Hook>::detach(node_t x) {
+TourNode &node = Nodes[x];
+if (node.left != NIL) {
+set_parent(node.left, NIL);
+node.left = NIL;
+}
+if (node.right != NIL) {
+set_parent(node.right, NIL);
+node.right = NIL;
+}
+}
+
+template <class Hook>
+node_t BasicAVLTree<Hook>::root(node_t x) const {
+return find_root(x);
+}
+
+template <class Hook>
+bool BasicAVLTree<Hook>::same_tree(node_t x, node_t y) const {
+return find_root(x) == find_root(y);
+}
+
+/**
+* Split the tree into two trees, one containing all nodes to the
+* left of x (inclusive), and the ones to the righ (exclusive)
+* in the other tree.
+*
+* Starting from x, we process all the nodes on the path to
+* the root. Each such node has two (possibly NIL) children
+* -- one has already been processed, the subtree of the other
+* is either fully to the left or to the right of x and
+* should be added to the respective tree
+* (left_tree or right_tree).
+*
+* This creates a series of merge operations with non-NIL middle
+* node. Note that all subtrees being merged to left_tree
+* (and right_tree) have nondecreasing heights. Also, at the
+* point of each such merge, the left_tree (and right_tree) can
+* have height at most 1 greater than tree being merged to it
+* (by the AVL conditions). Thus, the total cost of running all
+* these merge operations (sum of absolute differences of
+* heights of the subtrees being merged at each step)
+* is O(log n). This gives us the complexity O(log n).
+*/
+template <class Hook>
+pair <node_t, node_t> BasicAVLTree<Hook>::split(node_t x) {
+node_t left = Nodes[x].left, right = Nodes[x].right;
+node_t parent = Nodes[x].parent;
+
+detach(x);
+return split_path(x, parent, merge(left, x, NIL), right);
+}
+
+/**
+* The same walk as in split, except that x itself is
+* not added to any of the trees
+*/
+template <class Hook>
+pair <node_t, node_t> BasicAVLTree<Hook>::split_around(node_t x) {
+node_t left = Nodes[x].left, right = Nodes[x].right;
+node_t parent = Nodes[x].parent;
+
+detach(x);
+set_parent(x, NIL);
+update_statistics(x);
+return split_path(x, parent, left, right);
+}
+
+/**
+* Distributes the ancestors of x (starting from its former
+* parent cur) and their other subtrees between left_tree and
+* right_tree. The child pointers on the path still lead to x.
+*/
+template <class Hook>
+pair <node_t, node_t> BasicAVLTree<Hook>::split_path(node_t x, node_t cur,
+node_t left_tree, node_t right_tree) {
+node_t prv = x;
+
+while (cur != NIL) {
+node_t nxt = Nodes[cur].parent;
+bool was_right = (Nodes[cur].right == prv);
+node_t child = was_right ? Nodes[cur].left : Nodes[cur].right;
+
+// cur is merged as a middle node, which recomputes
+// its statistics
+if (child != NIL)
+set_parent(child, NIL);
+Nodes[cur].left = Nodes[cur].right = NIL;
+set_parent(cur, NIL);
+
+if (was_right) {
+left_tree = merge(child, cur, left_tree);
+
+} else {
+right_tree = merge(right_tree, cur, child);
+}
+
+prv = cur;
+cur = nxt;
+}
+
+return {left_tree, right_tree};
+}
+
+/**
+* Merges two trees into one (optionally also inserting
+* a middle vertex).
+*
+* With a middle vertex, the procedure descends along the inner
+* spine of the higher tree to the first subtree whose height
+* is close to the height of the other tree, puts both of them
+* as children of the middle vertex in its place and rebalances
+* the path back to the root. This costs
+* O(abs(left->height - right->height)).
+*
+* Without it, the last node of the left tree (or the first one
+* of the right tree, whichever tree is lower) is removed and
+* used as the middle vertex. This costs O(log n).
+*/
+template <class Hook>
+node_t BasicAVLTree<Hook>::merge(node_t left, node_t middle, node_t right) {
+
+if (middle == NIL) {
+if (left == NIL)
+return right;
+if (right == NIL)
+return left;
+
+if (Nodes[left].height <= Nodes[right].height) {
+node_t last = left;
+while (Nodes[last].right != NIL)
+last = Nodes[last].right;
+left = remove(last);
+middle = last;
+
+} else {
+node_t first = right;
+while (Nodes[first].left != NIL)
+first = Nodes[first].left;
+right = remove(first);
+middle = first;
+}
+}
+
+int hl = Nodes[left].height, hr = Nodes[right].height;
+node_t parent = NIL;
+
+if (hl > hr + 1) {
+// middle replaces a subtree on the right spine of left
+node_t cur = left;
+while (Nodes[cur].height > hr + 1) {
+parent = cur;
+cur = Nodes[cur].right;
+}
+Nodes[parent].right = middle;
+left = cur;
+
+} else if (hr > hl + 1) {
+// or on the left spine of right
+node_t cur = right;
+while (Nodes[cur].height > hl + 1) {
+parent = cur;
+cur = Nodes[cur].left;
+}
+Nodes[parent].left = middle;
+right = cur;
+}
+
+set_parent(middle, parent);
+Nodes[middle].left = left;
+Nodes[middle].right = right;
+if (left != NIL)
+set_parent(left, middle);
+if (right != NIL)
+set_parent(right, middle);
+update_statistics(middle);
+
+return rebalance_path(parent, middle);
+}
+
+/**
+* Rebalances x and all its ancestors, one of whose subtrees
+* (rooted in top) changed, and returns the root of the tree
+*/
+template <class Hook>
+node_t BasicAVLTree<Hook>::rebalance_path(node_t x, node_t top) {
+while (x != NIL) {
+top = balance(x);
+x = Nodes[top].parent;
+}
+
+return top;
+}
+
+/**
+* Replaces x with the merge of its subtrees and returns the root
+* of the remaining tree (NIL if x was the only node)
+*/
+template <class Hook>
+node_t BasicAVLTree<Hook>::remove(node_t x) {
+node_t left = Nodes[x].left, right = Nodes[x].right;
+node_t parent = Nodes[x].parent;
+
+detach(x);
+set_parent(x, NIL);
+update_statistics(x);
+
+node_t subtree = merge(left, NIL, right);
+if (parent != NIL) {
+replace_child(parent, x, subtree);
+if (subtree != NIL)
+set_parent(subtree, parent);
+}
+
+return rebalance_path(parent, subtree);
+}
+
+template <class Hook>
+void BasicAVLTree<Hook>::unlink(node_t x) {
+remove(x);
+}
+
+template <class Hook>
+node_t BasicAVLTree<Hook>::build(const node_t *seq, int k) {
+return build_balanced(seq, k);
+}
+
+template <class Hook>
+node_t BasicAVLTree<Hook>::rotate_right(node_t x) {
+assert(Nodes[x].left != NIL);
+node_t l_node = Nodes[x].left, lr_node = Nodes[l_node].right;
+
+set_parent(x, l_node);
+Nodes[l_node].right = x;
+set_parent(l_node, NIL);
+
+Nodes[x].left = lr_node;
+if (lr_node != NIL)
+set_parent(lr_node, x);
+
+update_statistics(x);
+update_statistics(l_node);
+return l_node;
+}
+
+template <class Hook>
+node_t BasicAVLTree<Hook>::rotate_left(node_t x) {
+assert(Nodes[x].right != NIL);
+node_t r_node = Nodes[x].right, rl_node = Nodes[r_node].left;
+
+set_parent(x, r_node);
+Nodes[r_node].left = x;
+set_parent(r_node, NIL);
+
+Nodes[x].right = rl_node;
+if (rl_node != NIL)
+set_parent(rl_node, x);
+
+update_statistics(x);
+update_statistics(r_node);
+return r_node;
+}
+
+/**
+* Rebalances the tree rooted in x assuming that the subtrees
+* of x are balanced.
+* This is done by performing (possibly many) rotations from
+* a higher subtree to the lower one.
+*/
+template <class Hook>
+node_t BasicAVLTree<Hook>::balance(node_t x) {
+node_t left = Nodes[x].left, right = Nodes[x].right;
+int hl = Nodes[left].height;
+int hr = Nodes[right].height;
+node_t root, parent_node = Nodes[x].parent;
+
+assert(abs(hl - hr) <= 3);
+
+if (hl > hr + 1) {
+int hll = Nodes[Nodes[left].left].height;
+int hlr = Nodes[Nodes[left].right].height;
+
+if (hll >= hlr) {
+root = rotate_right(x);
+
+if (Nodes[root].right != NIL)
+balance(Nodes[root].right);
+
+} else {
+left = rotate_left(left);
+Nodes[x].left = left;
+set_parent(left, x);
+root = rotate_right(x);
+}
+} else if (hr > hl + 1) {
+int hrr = Nodes[Nodes[right].right].height;
+int hrl = Nodes[Nodes[right].left].height;
+
+if (hrr >= hrl) {
+root = rotate_left(x);
+
+if (Nodes[root].left != NIL)
+balance(Nodes[root].left);
+
+} else {
+right = rotate_right(right);
+Nodes[x].right = right;
+set_parent(right, x);
+root = rotate_left(x);
+}
+} else {
+// no rebalancing needed at this level
+root = x;
+update_statistics(x);
+}
+
+set_parent(root, parent_node);
+if (parent_node != NIL)
+replace_child(parent_node, x, root);
+
+return root;
+}
+
+template <class Hook>
+bool BasicAVLTree<Hook>::correct_tree(node_t x, node_t correct_parent) const {
+const TourNode &node = Nodes[x];
+
+if (!correct_node(x, correct_parent))
+return false;
+
+if (node.left != NIL && !correct_tree(node.left, x))
+return false;
+if (node.right != NIL && !correct_tree(node.right, x))
+return false;
+
+int hl = Nodes[node.left].height, hr = Nodes[node.right].height;
+if (node.height != max(hl, hr) + 1) {
+debug ("height does not match\n");
+return false;
+}
+if (abs(hl - hr) > 1) {
+debug ("height invariant violated\n");
+return false;
+}
+
+return true;
+}
+
+template class BasicAVLTree<NoHook>;
+template class BasicAVLTree<AggregateHook>;
+#ifndef SPLAY_TREE_HPP
+#define SPLAY_TREE_HPP
+
+#include <utility>
+#ifndef TOUR_TREE_HPP
+#define TOUR_TREE_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <cassert>
+using namespace std;
+
+// A switch for managing debug output
+// #define DBG
+#ifdef DBG
+#define debug(...) fprintf(stderr, __VA_ARGS__), fflush(stderr)
+#else
+#define debug(...) {}
+#endif
+
+/* Nodes are addressed by 32-bit indices into the node array */
+typedef uint32_t node_t;
+
+/* Index of the sentinel node, which stands for an empty tree */
+const node_t NIL = 0;
+
+enum NodeFlags : uint8_t {
+/* the node represents a vertex (otherwise a tree edge) */
+VERTEX_NODE = 1,
+/* the node is a tree edge on the level of the forest */
+ON_LEVEL = 2
+};
+
+/**
+* A node of an Euler tour: either a vertex or one direction
+* of a tree edge (see et_trees.hpp). All the fields used while
+* restructuring the tree are packed into 32 bytes, so two nodes
+* share a cache line.
+*/
+struct TourNode {
+node_t left, right, parent;
+
+/* number of vertex nodes in the subtree of this node */
+int size;
+/* number of vertex nodes in the subtree storing nontree edges */
+int nontree_cnt;
+/* number of ON_LEVEL edge nodes in the subtree */
+int on_level_cnt;
+
+/**
+* Vertex nodes: the first record of the list of nontree
+* edges of the vertex (-1 if it is empty, see et_trees.hpp)
+* Edge nodes: the vertex the edge leads to
+*/
+int aux;
+
+/* height of the subtree (maintained only by AVLTree) */
+uint8_t height;
+uint8_t flags;
+};
+
+/**
+* Extra aggregates of the subtrees, maintained outside of the
+* nodes on behalf of a user of a forest: update(x, left, right)
+* is called whenever the aggregates of the node x are recomputed
+* from those of its children (NIL for a missing child).
+* Before a node past the array of nodes is updated, resize(k)
+* tells that the forest has grown to k nodes; update itself must
+* not grow the storage, as a forest may recompute the nodes of
+* different trees on several threads at once (see ETTForest::
+* link_batch and ETTForest::plan_cuts) and update may only write
+* the aggregates of x.
+*
+* The hook is a policy of the sequence trees (see TourTree):
+* only the trees instantiated with AggregateHook call it.
+*/
+class AggregateHook {
+public:
+static constexpr bool enabled = true;
+
+virtual void update(node_t x, node_t left, node_t right) = 0;
+virtual void resize(size_t) {}
+virtual ~AggregateHook() {}
+};
+
+/* The hook policy of the trees without extra aggregates */
+struct NoHook {
+static constexpr bool enabled = false;
+};
+
+/**
+* The part of a balanced sequence tree which does not depend on
+* the balancing scheme: the array of TourNodes owned by a forest,
+* allocation of nodes and the aggregates stored in them.
+*
+* Node 0 is a sentinel (NIL) whose aggregates are all zero, so
+* they can be summed without checking for missing children. Edge
+* nodes are allocated in pairs (e, e+1), one for each direction
+* of the edge; released nodes are reused before the array grows.
+*
+* ETTForest (et_trees.hpp) takes the sequence tree as a template
+* parameter. Besides the methods below, a sequence tree provides:
+*
+*   pair <node_t, node_t> split(node_t x);
+*   pair <node_t, node_t> split_around(node_t x);
+*   node_t merge(node_t left, node_t middle, node_t right);
+*   node_t root(node_t x);
+*   bool same_tree(node_t x, node_t y);
+*   void unlink(node_t x);
+*   node_t build(const node_t *seq, int k);
+*   bool correct_tree(node_t x, node_t correct_parent) const;
+*
+* with the semantics documented in avl_tree.hpp, and the alias
+*
+*   template <class OtherHook> using with_hook = ...;
+*
+* for the same tree with another hook policy. A sequence tree
+* may restructure the tree in any of them (even in root), so a
+* root returned by one call is only valid until the next one.
+* Only a tree which sets self_adjusting does so in root,
+* same_tree and find_nontree_edge; in the others, these only
+* read the tree and may run on several threads at once.
+* Implementations: AVLTree (avl_tree.hpp), SplayTree
+* (splay_tree.hpp) and Treap (treap.hpp).
+*
+* The Hook parameter is NoHook or AggregateHook. With NoHook,
+* the call of the hook is compiled out of every recomputation
+* of the aggregates; the trees are compiled for both policies
+* and HookedTree below names the one calling a hook.
+*/
+
+template <class Hook>
+class TourTree {
+public:
+typedef Hook hook_type;
+
+/* whether the queries restructure the tree (see above) */
+static constexpr bool self_adjusting = false;
+
+/* the number of walks of find_roots in flight */
+static constexpr int ROOT_WALKS = 32;
+
+TourTree();
+
+/**
+* Creates a new single-node tree representing a vertex
+* Complexity: O(1) (amortized)
+*/
+node_t new_vertex_node();
+
+/**
+* Releases the vertex node x, which must form
+* a single-node tree
+* Complexity: O(1)
+*/
+void free_vertex_node(node_t x);
+
+/**
+* Creates two single-node trees: e representing the edge
+* (a,b) (on the level if on_level is set) and e+1
+* representing the edge (b,a). Returns e.
+* Complexity: O(1) (amortized)
+*/
+node_t new_edge_nodes(int a, int b, bool on_level);
+
+/**
+* Releases the pair of edge nodes starting at e
+* Both of them must already be unlinked
+* Complexity: O(1)
+*/
+void free_edge_nodes(node_t e);
+
+const TourNode &operator[](node_t x) const {
+return Nodes[x];
+}
+
+/**
+* Sets the hook maintaining extra aggregates (or turns them
+* off if hook is NULL) and tells it the number of nodes.
+* The aggregates of the existing nodes are not recomputed.
+* With NoHook, the hook is never called.
+* Complexity: O(1) besides the resize of the hook
+*/
+void set_aggregate_hook(Hook *_hook);
+
+/**
+* Sets key to a number ordering x among the nodes of its
+* tree as the sequence does and root to the root of the
+* tree, without restructuring the tree. Returns false (and
+* no key) if x is deeper than MAX_KEY_DEPTH, as its path from
+* the root does not fit in the key then.
+* Complexity: O(depth of x)
+*/
+bool order_key(node_t x, uint64_t &key, node_t &root) const;
+static constexpr int MAX_KEY_DEPTH = 62;
+
+/**
+* Recomputes the aggregates of x and all its ancestors
+* Complexity: O(depth of x)
+*/
+void update_path(node_t x);
+
+/**
+* Returns the root of the tree containing x without
+* restructuring the tree (for diagnostics)
+*
+* Complexity: O(depth of x)
+*/
+node_t find_root(node_t x) const;
+
+/**
+* Like find_root, but loads the parent pointers atomically
+* (see set_parent), so that it may run while another thread
+* restructures the tree. The result is then meaningless and
+* must be validated by the caller (see SeqLock in
+* seqlock.hpp). Gives up and
+* returns NIL after limit steps, as a concurrent rotation may
+* close a cycle of parent pointers for a moment.
+*
+* Complexity: O(min(depth of x, limit))
+*/
+node_t find_root_concurrent(node_t x, int limit) const;
+
+/**
+* Sets roots[i] to find_root(xs[i]) for all i < k. Up to
+* ROOT_WALKS walks advance in lock-step, each prefetching
+* the next node on its path, so that the cache misses of
+* different walks overlap; a finished walk is replaced by
+* the next one right away.
+*
+* Complexity: O(sum of the depths of the nodes)
+*/
+void find_roots(const node_t *xs, int k, node_t *roots) const;
+
+/**
+* Reserves memory for k nodes (including NIL), so that the
+* array of nodes is not reallocated while it holds at most
+* k of them
+*
+* Complexity: O(k)
+*/
+void reserve(int k);
+
+/**
+* Appends the nodes of the tree rooted in x to seq (in
+* order) and turns each of them into a single-node tree
+* (to be reassembled with build)
+*
+* Complexity: O(size of the tree)
+*/
+void flatten(node_t x, vector <node_t> &seq);
+
+/**
+* Calls f(y) for every node y of the tree rooted in x, in
+* order, walking the parent pointers (without restructuring
+* the tree or allocating memory)
+*
+* Complexity: O(size of the tree)
+*/
+template <class F>
+void for_each_node(node_t x, F f) const;
+
+/**
+* Returns the r-th (from 0, in order) vertex node storing
+* nontree edges in the tree rooted in x or NIL if there are
+* at most r of them
+*
+* Complexity: O(height of the tree)
+*/
+node_t find_nontree_edge(node_t x, int r);
+
+/**
+* Calls f(v, head) for the vertex nodes v storing nontree
+* edges in the tree rooted in x, in order. head is the list
+* of v, which f may shorten by setting it to its remaining
+* part; f returns false to end the traversal. f must not
+* restructure the tree, but it may set the lists of other
+* vertex nodes (with set_nontree_head).
+*
+* The counters of the nodes above the lists emptied by f
+* are recomputed once, when the traversal leaves them.
+*
+* Complexity: O(k log(n/k)) plus the time of f, where k is
+* the number of vertex nodes visited
+*/
+template <class F>
+void scan_nontree_heads(node_t x, F f);
+
+/**
+* Sets the head of the list of nontree edges stored in
+* the vertex node x
+*
+* Complexity: O(depth of x) if the list becomes empty or
+* stops being empty, O(1) otherwise
+*/
+void set_nontree_head(node_t x, int head);
+
+/**
+* Unmarks the edge nodes marked as on_level in the tree
+* rooted in x and calls f(edge) with the edge (a,b) of each
+* of them, until f returns false. A single traversal, pruned
+* by the counters, visits only the marked nodes and their
+* ancestors and clears the counters on its way back up.
+* f must not modify the tree.
+*
+* Complexity: O(k log(n/k)) plus the time of f, where k is
+* the number of marked nodes
+*/
+template <class F>
+void take_on_level(node_t x, F f);
+
+void print_tree(node_t x, int indent = 0) const;
+void print_node(node_t x, int indent = 0) const;
+
+protected:
+vector <TourNode> Nodes;
+/* first released edge pair and vertex node (or NIL) */
+node_t free_pairs, free_vertices;
+Hook *hook;
+
+void set_parent(node_t x, node_t parent);
+void init_node(node_t x, const TourNode &init);
+void replace_child(node_t x, node_t old_child, node_t new_child);
+node_t build_balanced(const node_t *seq, int k);
+
+node_t descend_to_nontree_edge(node_t x, int r = 0) const;
+node_t descend_to_on_level(node_t x) const;
+pair <int, int> unmark_on_level(node_t x);
+
+void update_on_level_cnt(node_t x, int dx);
+void update_nontree_cnt(node_t x, int dx);
+void update_aggregates(node_t x);
+void grow_nodes(size_t k);
+
+bool correct_node(node_t x, node_t correct_parent) const;
+};
+
+/**
+* Every write of a parent goes through here: find_root_concurrent
+* loads the parents while the tree changes, so the stores must be
+* atomic. A store releases the node it links to, so that a walk
+* which reaches a newly allocated node also sees it initialized;
+* on x86 both sides are plain moves.
+*/
+template <class Hook>
+inline void TourTree<Hook>::set_parent(node_t x, node_t parent) {
+__atomic_store_n(&Nodes[x].parent, parent, __ATOMIC_RELEASE);
+}
+
+template <class Hook>
+inline void TourTree<Hook>::update_aggregates(node_t x) {
+TourNode &node = Nodes[x];
+const TourNode &l = Nodes[node.left];
+const TourNode &r = Nodes[node.right];
+bool vertex = node.flags & VERTEX_NODE;
+
+node.size = l.size + r.size + (vertex ? 1 : 0);
+node.on_level_cnt = l.on_level_cnt + r.on_level_cnt +
+((node.flags & ON_LEVEL) ? 1 : 0);
+node.nontree_cnt = l.nontree_cnt + r.nontree_cnt +
+((vertex && node.aux != -1) ? 1 : 0);
+
+if constexpr (Hook::enabled) {
+if (hook != NULL)
+hook->update(x, node.left, node.right);
+}
+}
+
+template <class Hook>
+template <class F>
+void TourTree<Hook>::for_each_node(node_t x, F f) const {
+if (x == NIL)
+return;
+
+node_t cur = x;
+while (Nodes[cur].left != NIL)
+cur = Nodes[cur].left;
+
+while (true) {
+f(cur);
+
+if (Nodes[cur].right != NIL) {
+// the successor is the first node of the right subtree
+cur = Nodes[cur].right;
+while (Nodes[cur].left != NIL)
+cur = Nodes[cur].left;
+
+} else {
+// the successor is the first ancestor entered from the left
+while (cur != x && Nodes[Nodes[cur].parent].right == cur)
+cur = Nodes[cur].parent;
+if (cur == x)
+return;
+cur = Nodes[cur].parent;
+}
+}
+}
+
+/**
+* Walks down into the subtrees with marked nodes first, then
+* unmarks the node itself and goes right. A node is left (with
+* its counter zeroed) only when nothing below it is marked, so
+* the walk comes back to every node at most twice. When f asks
+* to stop, only the counters on the path back to x are stale.
+*/
+template <class Hook>
+template <class F>
+void TourTree<Hook>::take_on_level(node_t x, F f) {
+node_t cur = x;
+
+while (Nodes[x].on_level_cnt > 0) {
+TourNode &node = Nodes[cur];
+
+if (Nodes[node.left].on_level_cnt > 0) {
+cur = node.left;
+continue;
+}
+if (node.flags & ON_LEVEL) {
+node.flags &= ~ON_LEVEL;
+if (!f(pair <int, int> (Nodes[cur+1].aux, node.aux))) {
+for (node_t y = cur; y != Nodes[x].parent; y = Nodes[y].parent) {
+Nodes[y].on_level_cnt = Nodes[Nodes[y].left].on_level_cnt +
+Nodes[Nodes[y].right].on_level_cnt +
+((Nodes[y].flags & ON_LEVEL) ? 1 : 0);
+}
+return;
+}
+}
+if (Nodes[node.right].on_level_cnt > 0) {
+cur = node.right;
+continue;
+}
+
+node.on_level_cnt = 0;
+cur = node.parent;
+}
+}
+
+/**
+* An in-order walk through the nodes with nontree edges below
+* them. The node the walk came from tells which part of a node
+* comes next. Once f asks to stop, the walk only goes back up to
+* the root, fixing the counters.
+*/
+template <class Hook>
+template <class F>
+void TourTree<Hook>::scan_nontree_heads(node_t x, F f) {
+node_t cur = x, prv = Nodes[x].parent;
+bool more = true;
+
+while (cur != Nodes[x].parent) {
+node_t left = Nodes[cur].left, right = Nodes[cur].right;
+
+if (prv == Nodes[cur].parent) {
+if (more && Nodes[left].nontree_cnt > 0) {
+prv = cur;
+cur = left;
+continue;
+}
+prv = left;
+}
+
+if (prv == left) {
+if (more && (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1) {
+int head = Nodes[cur].aux;
+more = f(cur, head);
+Nodes[cur].aux = head;
+}
+if (more && Nodes[right].nontree_cnt > 0) {
+prv = cur;
+cur = right;
+continue;
+}
+}
+
+bool own = (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1;
+Nodes[cur].nontree_cnt = Nodes[left].nontree_cnt +
+Nodes[right].nontree_cnt + (own ? 1 : 0);
+prv = cur;
+cur = Nodes[cur].parent;
+}
+}
+
+/* The sequence tree Tree calling an AggregateHook */
+template <class Tree>
+using HookedTree = typename Tree::template with_hook <AggregateHook>;
+
+#endif
+using namespace std;
+
+/**
+* Splay tree implementation
+* (https://en.wikipedia.org/wiki/Splay_tree)
+* over an array of TourNodes.
+*
+* Every operation splays the node it accesses to the root, so
+* recently used parts of the Euler tours stay near the roots.
+* A merge with a middle node and a split take just a splay and
+* O(1) relinking, which makes link and cut cheap. All the bounds
+* below are amortized over a sequence of operations.
+* Hook is the policy of the extra aggregates (see TourTree).
+*/
+
+template <class Hook = NoHook>
+class BasicSplayTree : public TourTree <Hook> {
+typedef TourTree <Hook> Base;
+
+public:
+template <class OtherHook>
+using with_hook = BasicSplayTree <OtherHook>;
+
+/* every access splays the node it reaches */
+static constexpr bool self_adjusting = true;
+
+/**
+* Splits the tree into two parts and returns their roots.
+* The first part contains all nodes to the left of x
+* (inclusive), the second part contains all nodes to the
+* right of it (exclusive).
+*
+* Complexity: O(log n) (amortized)
+*/
+pair <node_t, node_t> split(node_t x);
+
+/**
+* Removes x from its tree and splits the rest of it into
+* the nodes to the left and to the right of x (exclusive)
+*
+* Complexity: O(log n) (amortized)
+*/
+pair <node_t, node_t> split_around(node_t x);
+
+/**
+* Merges two trees (left and right) into one (the middle
+* node is optional) and returns its root.
+* The order of nodes is as follows:
+* left(unchanged), middle, right(unchanged).
+*
+* Complexity if middle is NIL: O(log n) (amortized)
+* Complexity if middle is not NIL: O(1)
+*/
+node_t merge(node_t left, node_t middle, node_t right);
+
+/**
+* Splays x to the root of its tree and returns it
+*
+* Complexity: O(log n) (amortized)
+*/
+node_t root(node_t x);
+
+/**
+* Checks whether x and y belong to the same tree
+*
+* Complexity: O(log n) (amortized)
+*/
+bool same_tree(node_t x, node_t y);
+
+/**
+* Removes x from the tree it belongs to
+*
+* Complexity: O(log n) (amortized)
+*/
+void unlink(node_t x);
+
+/**
+* Builds a tree from the single-node trees seq[0..k-1]
+* (in this order) and returns its root
+*
+* Complexity: O(k)
+*/
+node_t build(const node_t *seq, int k);
+
+/**
+* As in TourTree, but every node found is splayed to the root
+* (which pays for the descent to it) and the next one is
+* looked for from there
+*/
+node_t find_nontree_edge(node_t x, int r);
+template <class F>
+void scan_nontree_heads(node_t x, F f);
+template <class F>
+void take_on_level(node_t x, F f);
+void set_nontree_head(node_t x, int head);
+
+/**
+* Checks if the invariants hold in the subtree of x
+*
+* Complexity: linear in the size of the tree
+*/
+bool correct_tree(node_t x, node_t correct_parent) const;
+
+private:
+using Base::Nodes;
+using Base::set_parent;
+using Base::update_aggregates;
+using Base::replace_child;
+using Base::build_balanced;
+using Base::correct_node;
+using Base::descend_to_nontree_edge;
+using Base::descend_to_on_level;
+using Base::unmark_on_level;
+
+void rotate(node_t x);
+void splay(node_t x);
+};
+
+template <class Hook>
+template <class F>
+void BasicSplayTree<Hook>::scan_nontree_heads(node_t x, F f) {
+node_t v = descend_to_nontree_edge(x);
+while (v != NIL) {
+splay(v);
+int head = Nodes[v].aux;
+bool more = f(v, head);
+
+// f may have splayed other nodes
+set_nontree_head(v, head);
+if (!more)
+return;
+v = descend_to_nontree_edge(v);
+}
+}
+
+template <class Hook>
+template <class F>
+void BasicSplayTree<Hook>::take_on_level(node_t x, F f) {
+node_t cur = descend_to_on_level(x);
+while (cur != NIL) {
+splay(cur);
+if (!f(unmark_on_level(cur)))
+return;
+cur = descend_to_on_level(cur);
+}
+}
+
+typedef BasicSplayTree <> SplayTree;
+
+#endif
+
+/**
+* Rotates x above its parent, keeping the order of the nodes
+*/
+template <class Hook>
+void BasicSplayTree<Hook>::rotate(node_t x) {
+node_t p = Nodes[x].parent, g = Nodes[p].parent, middle;
+
+if (Nodes[p].left == x) {
+middle = Nodes[x].right;
+Nodes[p].left = middle;
+Nodes[x].right = p;
+
+} else {
+middle = Nodes[x].left;
+Nodes[p].right = middle;
+Nodes[x].left = p;
+}
+
+if (middle != NIL)
+set_parent(middle, p);
+
+set_parent(p, x);
+set_parent(x, g);
+if (g != NIL)
+replace_child(g, p, x);
+
+update_aggregates(p);
+update_aggregates(x);
+}
+
+/**
+* Moves x to the root with the zig-zig and zig-zag steps
+*/
+template <class Hook>
+void BasicSplayTree<Hook>::splay(node_t x) {
+while (Nodes[x].parent != NIL) {
+node_t p = Nodes[x].parent, g = Nodes[p].parent;
+
+if (g != NIL) {
+bool zig_zig = (Nodes[g].left == p) == (Nodes[p].left == x);
+rotate(zig_zig ? p : x);
+}
+rotate(x);
+}
+}
+
+template <class Hook>
+node_t BasicSplayTree<Hook>::root(node_t x) {
+splay(x);
+return x;
+}
+
+/**
+* After splaying y, x is the root of its tree
+* only if it belongs to a different tree than y
+*/
+template <class Hook>
+bool BasicSplayTree<Hook>::same_tree(node_t x, node_t y) {
+if (x == y)
+return true;
+
+splay(x);
+splay(y);
+return Nodes[x].parent != NIL;
+}
+
+template <class Hook>
+pair <node_t, node_t> BasicSplayTree<Hook>::split(node_t x) {
+splay(x);
+
+node_t right = Nodes[x].right;
+if (right != NIL) {
+set_parent(right, NIL);
+Nodes[x].right = NIL;
+update_aggregates(x);
+}
+
+return {x, right};
+}
+
+template <class Hook>
+pair <node_t, node_t> BasicSplayTree<Hook>::split_around(node_t x) {
+splay(x);
+
+node_t left = Nodes[x].left, right = Nodes[x].right;
+if (left != NIL)
+set_parent(left, NIL);
+if (right != NIL)
+set_parent(right, NIL);
+
+Nodes[x].left = Nodes[x].right = NIL;
+update_aggregates(x);
+return {left, right};
+}
+
+template <class Hook>
+node_t BasicSplayTree<Hook>::merge(node_t left, node_t middle, node_t right) {
+
+if (middle != NIL) {
+Nodes[middle].left = left;
+Nodes[middle].right = right;
+if (left != NIL)
+set_parent(left, middle);
+if (right != NIL)
+set_parent(right, middle);
+
+update_aggregates(middle);
+return middle;
+}
+
+if (left == NIL)
+return right;
+if (right == NIL)
+return left;
+
+// the last node of left becomes the root without a right child
+node_t last = left;
+while (Nodes[last].right != NIL) {
+last = Nodes[last].right;
+}
+splay(last);
+
+Nodes[last].right = right;
+set_parent(right, last);
+update_aggregates(last);
+return last;
+}
+
+template <class Hook>
+void BasicSplayTree<Hook>::unlink(node_t x) {
+splay(x);
+
+node_t left = Nodes[x].left, right = Nodes[x].right;
+if (left != NIL)
+set_parent(left, NIL);
+if (right != NIL)
+set_parent(right, NIL);
+
+merge(left, NIL, right);
+
+Nodes[x].left = Nodes[x].right = NIL;
+update_aggregates(x);
+}
+
+template <class Hook>
+node_t BasicSplayTree<Hook>::build(const node_t *seq, int k) {
+return build_balanced(seq, k);
+}
+
+template <class Hook>
+node_t BasicSplayTree<Hook>::find_nontree_edge(node_t x, int r) {
+node_t vertex = descend_to_nontree_edge(x, r);
+if (vertex != NIL)
+splay(vertex);
+return vertex;
+}
+
+template <class Hook>
+void BasicSplayTree<Hook>::set_nontree_head(node_t x, int head) {
+// as the root, x is the only node whose counter changes
+splay(x);
+Base::set_nontree_head(x, head);
+}
+
+template <class Hook>
+bool BasicSplayTree<Hook>::correct_tree(node_t x, node_t correct_parent) const {
+const TourNode &node = Nodes[x];
+
+if (!correct_node(x, correct_parent))
+return false;
+
+if (node.left != NIL && !correct_tree(node.left, x))
+return false;
+if (node.right != NIL && !correct_tree(node.right, x))
+return false;
+
+return true;
+}
+
+template class BasicSplayTree<NoHook>;
+template class BasicSplayTree<AggregateHook>;
+#include <vector>
+#ifndef TREAP_HPP
+#define TREAP_HPP
+
+#include <utility>
+#ifndef TOUR_TREE_HPP
+#define TOUR_TREE_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <cassert>
+using namespace std;
+
+// A switch for managing debug output
+// #define DBG
+#ifdef DBG
+#define debug(...) fprintf(stderr, __VA_ARGS__), fflush(stderr)
+#else
+#define debug(...) {}
+#endif
+
+/* Nodes are addressed by 32-bit indices into the node array */
+typedef uint32_t node_t;
+
+/* Index of the sentinel node, which stands for an empty tree */
+const node_t NIL = 0;
+
+enum NodeFlags : uint8_t {
+/* the node represents a vertex (otherwise a tree edge) */
+VERTEX_NODE = 1,
+/* the node is a tree edge on the level of the forest */
+ON_LEVEL = 2
+};
+
+/**
+* A node of an Euler tour: either a vertex or one direction
+* of a tree edge (see et_trees.hpp). All the fields used while
+* restructuring the tree are packed into 32 bytes, so two nodes
+* share a cache line.
+*/
+struct TourNode {
+node_t left, right, parent;
+
+/* number of vertex nodes in the subtree of this node */
+int size;
+/* number of vertex nodes in the subtree storing nontree edges */
+int nontree_cnt;
+/* number of ON_LEVEL edge nodes in the subtree */
+int on_level_cnt;
+
+/**
+* Vertex nodes: the first record of the list of nontree
+* edges of the vertex (-1 if it is empty, see et_trees.hpp)
+* Edge nodes: the vertex the edge leads to
+*/
+int aux;
+
+/* height of the subtree (maintained only by AVLTree) */
+uint8_t height;
+uint8_t flags;
+};
+
+/**
+* Extra aggregates of the subtrees, maintained outside of the
+* nodes on behalf of a user of a forest: update(x, left, right)
+* is called whenever the aggregates of the node x are recomputed
+* from those of its children (NIL for a missing child).
+* Before a node past the array of nodes is updated, resize(k)
+* tells that the forest has grown to k nodes; update itself must
+* not grow the storage, as a forest may recompute the nodes of
+* different trees on several threads at once (see ETTForest::
+* link_batch and ETTForest::plan_cuts) and update may only write
+* the aggregates of x.
+*
+* The hook is a policy of the sequence trees (see TourTree):
+* only the trees instantiated with AggregateHook call it.
+*/
+class AggregateHook {
+public:
+static constexpr bool enabled = true;
+
+virtual void update(node_t x, node_t left, node_t right) = 0;
+virtual void resize(size_t) {}
+virtual ~AggregateHook() {}
+};
+
+/* The hook policy of the trees without extra aggregates */
+struct NoHook {
+static constexpr bool enabled = false;
+};
+
+/**
+* The part of a balanced sequence tree which does not depend on
+* the balancing scheme: the array of TourNodes owned by a forest,
+* allocation of nodes and the aggregates stored in them.
+*
+* Node 0 is a sentinel (NIL) whose aggregates are all zero, so
+* they can be summed without checking for missing children. Edge
+* nodes are allocated in pairs (e, e+1), one for each direction
+* of the edge; released nodes are reused before the array grows.
+*
+* ETTForest (et_trees.hpp) takes the sequence tree as a template
+* parameter. Besides the methods below, a sequence tree provides:
+*
+*   pair <node_t, node_t> split(node_t x);
+*   pair <node_t, node_t> split_around(node_t x);
+*   node_t merge(node_t left, node_t middle, node_t right);
+*   node_t root(node_t x);
+*   bool same_tree(node_t x, node_t y);
+*   void unlink(node_t x);
+*   node_t build(const node_t *seq, int k);
+*   bool correct_tree(node_t x, node_t correct_parent) const;
+*
+* with the semantics documented in avl_tree.hpp, and the alias
+*
+*   template <class OtherHook> using with_hook = ...;
+*
+* for the same tree with another hook policy. A sequence tree
+* may restructure the tree in any of them (even in root), so a
+* root returned by one call is only valid until the next one.
+* Only a tree which sets self_adjusting does so in root,
+* same_tree and find_nontree_edge; in the others, these only
+* read the tree and may run on several threads at once.
+* Implementations: AVLTree (avl_tree.hpp), SplayTree
+* (splay_tree.hpp) and Treap (treap.hpp).
+*
+* The Hook parameter is NoHook or AggregateHook. With NoHook,
+* the call of the hook is compiled out of every recomputation
+* of the aggregates; the trees are compiled for both policies
+* and HookedTree below names the one calling a hook.
+*/
+
+template <class Hook>
+class TourTree {
+public:
+typedef Hook hook_type;
+
+/* whether the queries restructure the tree (see above) */
+static constexpr bool self_adjusting = false;
+
+/* the number of walks of find_roots in flight */
+static constexpr int ROOT_WALKS = 32;
+
+TourTree();
+
+/**
+* Creates a new single-node tree representing a vertex
+* Complexity: O(1) (amortized)
+*/
+node_t new_vertex_node();
+
+/**
+* Releases the vertex node x, which must form
+* a single-node tree
+* Complexity: O(1)
+*/
+void free_vertex_node(node_t x);
+
+/**
+* Creates two single-node trees: e representing the edge
+* (a,b) (on the level if on_level is set) and e+1
+* representing the edge (b,a). Returns e.
+* Complexity: O(1) (amortized)
+*/
+node_t new_edge_nodes(int a, int b, bool on_level);
+
+/**
+* Releases the pair of edge nodes starting at e
+* Both of them must already be unlinked
+* Complexity: O(1)
+*/
+void free_edge_nodes(node_t e);
+
+const TourNode &operator[](node_t x) const {
+return Nodes[x];
+}
+
+/**
+* Sets the hook maintaining extra aggregates (or turns them
+* off if hook is NULL) and tells it the number of nodes.
+* The aggregates of the existing nodes are not recomputed.
+* With NoHook, the hook is never called.
+* Complexity: O(1) besides the resize of the hook
+*/
+void set_aggregate_hook(Hook *_hook);
+
+/**
+* Sets key to a number ordering x among the nodes of its
+* tree as the sequence does and root to the root of the
+* tree, without restructuring the tree. Returns false (and
+* no key) if x is deeper than MAX_KEY_DEPTH, as its path from
+* the root does not fit in the key then.
+* Complexity: O(depth of x)
+*/
+bool order_key(node_t x, uint64_t &key, node_t &root) const;
+static constexpr int MAX_KEY_DEPTH = 62;
+
+/**
+* Recomputes the aggregates of x and all its ancestors
+* Complexity: O(depth of x)
+*/
+void update_path(node_t x);
+
+/**
+* Returns the root of the tree containing x without
+* restructuring the tree (for diagnostics)
+*
+* Complexity: O(depth of x)
+*/
+node_t find_root(node_t x) const;
+
+/**
+* Like find_root, but loads the parent pointers atomically
+* (see set_parent), so that it may run while another thread
+* restructures the tree. The result is then meaningless and
+* must be validated by the caller (see SeqLock in
+* seqlock.hpp). Gives up and
+* returns NIL after limit steps, as a concurrent rotation may
+* close a cycle of parent pointers for a moment.
+*
+* Complexity: O(min(depth of x, limit))
+*/
+node_t find_root_concurrent(node_t x, int limit) const;
+
+/**
+* Sets roots[i] to find_root(xs[i]) for all i < k. Up to
+* ROOT_WALKS walks advance in lock-step, each prefetching
+* the next node on its path, so that the cache misses of
+* different walks overlap; a finished walk is replaced by
+* the next one right away.
+*
+* Complexity: O(sum of the depths of the nodes)
+*/
+void find_roots(const node_t *xs, int k, node_t *roots) const;
+
+/**
+* Reserves memory for k nodes (including NIL), so that the
+* array of nodes is not reallocated while it holds at most
+* k of them
+*
+* Complexity: O(k)
+*/
+void reserve(int k);
+
+/**
+* Appends the nodes of the tree rooted in x to seq (in
+* order) and turns each of them into a single-node tree
+* (to be reassembled with build)
+*
+* Complexity: O(size of the tree)
+*/
+void flatten(node_t x, vector <node_t> &seq);
+
+/**
+* Calls f(y) for every node y of the tree rooted in x, in
+* order, walking the parent pointers (without restructuring
+* the tree or allocating memory)
+*
+* Complexity: O(size of the tree)
+*/
+template <class F>
+void for_each_node(node_t x, F f) const;
+
+/**
+* Returns the r-th (from 0, in order) vertex node storing
+* nontree edges in the tree rooted in x or NIL if there are
+* at most r of them
+*
+* Complexity: O(height of the tree)
+*/
+node_t find_nontree_edge(node_t x, int r);
+
+/**
+* Calls f(v, head) for the vertex nodes v storing nontree
+* edges in the tree rooted in x, in order. head is the list
+* of v, which f may shorten by setting it to its remaining
+* part; f returns false to end the traversal. f must not
+* restructure the tree, but it may set the lists of other
+* vertex nodes (with set_nontree_head).
+*
+* The counters of the nodes above the lists emptied by f
+* are recomputed once, when the traversal leaves them.
+*
+* Complexity: O(k log(n/k)) plus the time of f, where k is
+* the number of vertex nodes visited
+*/
+template <class F>
+void scan_nontree_heads(node_t x, F f);
+
+/**
+* Sets the head of the list of nontree edges stored in
+* the vertex node x
+*
+* Complexity: O(depth of x) if the list becomes empty or
+* stops being empty, O(1) otherwise
+*/
+void set_nontree_head(node_t x, int head);
+
+/**
+* Unmarks the edge nodes marked as on_level in the tree
+* rooted in x and calls f(edge) with the edge (a,b) of each
+* of them, until f returns false. A single traversal, pruned
+* by the counters, visits only the marked nodes and their
+* ancestors and clears the counters on its way back up.
+* f must not modify the tree.
+*
+* Complexity: O(k log(n/k)) plus the time of f, where k is
+* the number of marked nodes
+*/
+template <class F>
+void take_on_level(node_t x, F f);
+
+void print_tree(node_t x, int indent = 0) const;
+void print_node(node_t x, int indent = 0) const;
+
+protected:
+vector <TourNode> Nodes;
+/* first released edge pair and vertex node (or NIL) */
+node_t free_pairs, free_vertices;
+Hook *hook;
+
+void set_parent(node_t x, node_t parent);
+void init_node(node_t x, const TourNode &init);
+void replace_child(node_t x, node_t old_child, node_t new_child);
+node_t build_balanced(const node_t *seq, int k);
+
+node_t descend_to_nontree_edge(node_t x, int r = 0) const;
+node_t descend_to_on_level(node_t x) const;
+pair <int, int> unmark_on_level(node_t x);
+
+void update_on_level_cnt(node_t x, int dx);
+void update_nontree_cnt(node_t x, int dx);
+void update_aggregates(node_t x);
+void grow_nodes(size_t k);
+
+bool correct_node(node_t x, node_t correct_parent) const;
+};
+
+/**
+* Every write of a parent goes through here: find_root_concurrent
+* loads the parents while the tree changes, so the stores must be
+* atomic. A store releases the node it links to, so that a walk
+* which reaches a newly allocated node also sees it initialized;
+* on x86 both sides are plain moves.
+*/
+template <class Hook>
+inline void TourTree<Hook>::set_parent(node_t x, node_t parent) {
+__atomic_store_n(&Nodes[x].parent, parent, __ATOMIC_RELEASE);
+}
+
+template <class Hook>
+inline void TourTree<Hook>::update_aggregates(node_t x) {
+TourNode &node = Nodes[x];
+const TourNode &l = Nodes[node.left];
+const TourNode &r = Nodes[node.right];
+bool vertex = node.flags & VERTEX_NODE;
+
+node.size = l.size + r.size + (vertex ? 1 : 0);
+node.on_level_cnt = l.on_level_cnt + r.on_level_cnt +
+((node.flags & ON_LEVEL) ? 1 : 0);
+node.nontree_cnt = l.nontree_cnt + r.nontree_cnt +
+((vertex && node.aux != -1) ? 1 : 0);
+
+if constexpr (Hook::enabled) {
+if (hook != NULL)
+hook->update(x, node.left, node.right);
+}
+}
+
+template <class Hook>
+template <class F>
+void TourTree<Hook>::for_each_node(node_t x, F f) const {
+if (x == NIL)
+return;
+
+node_t cur = x;
+while (Nodes[cur].left != NIL)
+cur = Nodes[cur].left;
+
+while (true) {
+f(cur);
+
+if (Nodes[cur].right != NIL) {
+// the successor is the first node of the right subtree
+cur = Nodes[cur].right;
+while (Nodes[cur].left != NIL)
+cur = Nodes[cur].left;
+
+} else {
+// the successor is the first ancestor entered from the left
+while (cur != x && Nodes[Nodes[cur].parent].right == cur)
+cur = Nodes[cur].parent;
+if (cur == x)
+return;
+cur = Nodes[cur].parent;
+}
+}
+}
+
+/**
+* Walks down into the subtrees with marked nodes first, then
+* unmarks the node itself and goes right. A node is left (with
+* its counter zeroed) only when nothing below it is marked, so
+* the walk comes back to every node at most twice. When f asks
+* to stop, only the counters on the path back to x are stale.
+*/
+template <class Hook>
+template <class F>
+void TourTree<Hook>::take_on_level(node_t x, F f) {
+node_t cur = x;
+
+while (Nodes[x].on_level_cnt > 0) {
+TourNode &node = Nodes[cur];
+
+if (Nodes[node.left].on_level_cnt > 0) {
+cur = node.left;
+continue;
+}
+if (node.flags & ON_LEVEL) {
+node.flags &= ~ON_LEVEL;
+if (!f(pair <int, int> (Nodes[cur+1].aux, node.aux))) {
+for (node_t y = cur; y != Nodes[x].parent; y = Nodes[y].parent) {
+Nodes[y].on_level_cnt = Nodes[Nodes[y].left].on_level_cnt +
+Nodes[Nodes[y].right].on_level_cnt +
+((Nodes[y].flags & ON_LEVEL) ? 1 : 0);
+}
+return;
+}
+}
+if (Nodes[node.right].on_level_cnt > 0) {
+cur = node.right;
+continue;
+}
+
+node.on_level_cnt = 0;
+cur = node.parent;
+}
+}
+
+/**
+* An in-order walk through the nodes with nontree edges below
+* them. The node the walk came from tells which part of a node
+* comes next. Once f asks to stop, the walk only goes back up to
+* the root, fixing the counters.
+*/
+template <class Hook>
+template <class F>
+void TourTree<Hook>::scan_nontree_heads(node_t x, F f) {
+node_t cur = x, prv = Nodes[x].parent;
+bool more = true;
+
+while (cur != Nodes[x].parent) {
+node_t left = Nodes[cur].left, right = Nodes[cur].right;
+
+if (prv == Nodes[cur].parent) {
+if (more && Nodes[left].nontree_cnt > 0) {
+prv = cur;
+cur = left;
+continue;
+}
+prv = left;
+}
+
+if (prv == left) {
+if (more && (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1) {
+int head = Nodes[cur].aux;
+more = f(cur, head);
+Nodes[cur].aux = head;
+}
+if (more && Nodes[right].nontree_cnt > 0) {
+prv = cur;
+cur = right;
+continue;
+}
+}
+
+bool own = (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1;
+Nodes[cur].nontree_cnt = Nodes[left].nontree_cnt +
+Nodes[right].nontree_cnt + (own ? 1 : 0);
+prv = cur;
+cur = Nodes[cur].parent;
+}
+}
+
+/* The sequence tree Tree calling an AggregateHook */
+template <class Tree>
+using HookedTree = typename Tree::template with_hook <AggregateHook>;
+
+#endif
+using namespace std;
+
+/**
+* Treap implementation (https://en.wikipedia.org/wiki/Treap)
+* over an array of TourNodes.
+*
+* The tree is a binary search tree by the order of nodes and
+* a max-heap by their priorities. Priorities are computed by
+* hashing node indices, so they take no space in the nodes.
+* Split and merge never rotate: they only relink the nodes on
+* the paths they walk. All the bounds below are expected.
+* Hook is the policy of the extra aggregates (see TourTree).
+*/
+
+template <class Hook = NoHook>
+class BasicTreap : public TourTree <Hook> {
+typedef TourTree <Hook> Base;
+
+public:
+template <class OtherHook>
+using with_hook = BasicTreap <OtherHook>;
+
+using Base::find_root;
+
+/**
+* Splits the tree into two parts and returns their roots.
+* The first part contains all nodes to the left of x
+* (inclusive), the second part contains all nodes to the
+* right of it (exclusive).
+*
+* Complexity: O(log n)
+*/
+pair <node_t, node_t> split(node_t x);
+
+/**
+* Removes x from its tree and splits the rest of it into
+* the nodes to the left and to the right of x (exclusive)
+*
+* Complexity: O(log n)
+*/
+pair <node_t, node_t> split_around(node_t x);
+
+/**
+* Merges two trees (left and right) into one (the middle
+* node is optional) and returns its root.
+* The order of nodes is as follows:
+* left(unchanged), middle, right(unchanged).
+*
+* Complexity: O(log n)
+*/
+node_t merge(node_t left, node_t middle, node_t right);
+
+/**
+* Returns the root of the tree containing x
+*
+* Complexity: O(log n)
+*/
+node_t root(node_t x) const;
+
+/**
+* Checks whether x and y belong to the same tree
+*
+* Complexity: O(log n)
+*/
+bool same_tree(node_t x, node_t y) const;
+
+/**
+* Removes x from the tree it belongs to
+*
+* Complexity: O(log n)
+*/
+void unlink(node_t x);
+
+/**
+* Builds a tree from the single-node trees seq[0..k-1]
+* (in this order) and returns its root
+*
+* Complexity: O(k)
+*/
+node_t build(const node_t *seq, int k);
+
+/**
+* Checks if the invariants hold in the subtree of x
+*
+* Complexity: linear in the size of the tree
+*/
+bool correct_tree(node_t x, node_t correct_parent) const;
+
+private:
+using Base::Nodes;
+using Base::set_parent;
+using Base::update_aggregates;
+using Base::replace_child;
+using Base::correct_node;
+
+static uint32_t priority(node_t x);
+node_t join(node_t left, node_t right);
+pair <node_t, node_t> split_path(node_t x, node_t left_tree,
+node_t right_tree);
+};
+
+/* The finalizer of MurmurHash3, which mixes consecutive indices well */
+template <class Hook>
+inline uint32_t BasicTreap<Hook>::priority(node_t x) {
+uint32_t h = x;
+h ^= h >> 16;
+h *= 0x85ebca6b;
+h ^= h >> 13;
+h *= 0xc2b2ae35;
+h ^= h >> 16;
+return h;
+}
+
+typedef BasicTreap <> Treap;
+
+#endif
+
+template <class Hook>
+node_t BasicTreap<Hook>::root(node_t x) const {
+return find_root(x);
+}
+
+template <class Hook>
+bool BasicTreap<Hook>::same_tree(node_t x, node_t y) const {
+return find_root(x) == find_root(y);
+}
+
+/**
+* Joins two trees whose roots have no parents, placing all
+* nodes of left before those of right. The root with the
+* higher priority stays on top and the other tree is
+* joined recursively with its inner subtree.
+*/
+template <class Hook>
+node_t BasicTreap<Hook>::join(node_t left, node_t right) {
+if (left == NIL)
+return right;
+if (right == NIL)
+return left;
+
+if (priority(left) > priority(right)) {
+node_t left_right = Nodes[left].right;
+if (left_right != NIL)
+set_parent(left_right, NIL);
+
+left_right = join(left_right, right);
+Nodes[left].right = left_right;
+set_parent(left_right, left);
+update_aggregates(left);
+return left;
+
+} else {
+node_t right_left = Nodes[right].left;
+if (right_left != NIL)
+set_parent(right_left, NIL);
+
+right_left = join(left, right_left);
+Nodes[right].left = right_left;
+set_parent(right_left, right);
+update_aggregates(right);
+return right;
+}
+}
+
+template <class Hook>
+node_t BasicTreap<Hook>::merge(node_t left, node_t middle, node_t right) {
+return join(join(left, middle), right);
+}
+
+/**
+* Walks from x to the root. Every node on the path keeps the
+* subtree which is on its own side of x and adopts the part
+* of the path below it which is on the same side, so the
+* heap order is preserved without any rotations.
+*/
+template <class Hook>
+pair <node_t, node_t> BasicTreap<Hook>::split(node_t x) {
+node_t right = Nodes[x].right;
+
+Nodes[x].right = NIL;
+update_aggregates(x);
+return split_path(x, x, right);
+}
+
+template <class Hook>
+pair <node_t, node_t> BasicTreap<Hook>::split_around(node_t x) {
+node_t left = Nodes[x].left, right = Nodes[x].right;
+
+// x is left out of both trees, but the walk starts at it
+Nodes[x].left = Nodes[x].right = NIL;
+pair <node_t, node_t> trees = split_path(x, left, right);
+
+set_parent(x, NIL);
+update_aggregates(x);
+return trees;
+}
+
+/**
+* The walk of split from x, which has already been cut into
+* the (possibly empty) trees left_tree and right_tree
+*/
+template <class Hook>
+pair <node_t, node_t> BasicTreap<Hook>::split_path(node_t x, node_t left_tree,
+node_t right_tree) {
+node_t prv, cur = x, nxt = Nodes[x].parent;
+
+while (nxt != NIL) {
+prv = cur;
+cur = nxt;
+nxt = Nodes[cur].parent;
+
+if (Nodes[cur].right == prv) {
+Nodes[cur].right = left_tree;
+if (left_tree != NIL)
+set_parent(left_tree, cur);
+left_tree = cur;
+
+} else {
+Nodes[cur].left = right_tree;
+if (right_tree != NIL)
+set_parent(right_tree, cur);
+right_tree = cur;
+}
+
+update_aggregates(cur);
+}
+
+if (left_tree != NIL)
+set_parent(left_tree, NIL);
+if (right_tree != NIL)
+set_parent(right_tree, NIL);
+
+return {left_tree, right_tree};
+}
+
+template <class Hook>
+void BasicTreap<Hook>::unlink(node_t x) {
+node_t left = Nodes[x].left, right = Nodes[x].right;
+node_t parent = Nodes[x].parent;
+
+// replace this node with its subtree
+if (left != NIL)
+set_parent(left, NIL);
+if (right != NIL)
+set_parent(right, NIL);
+
+node_t subtree = join(left, right);
+if (parent != NIL) {
+replace_child(parent, x, subtree);
+if (subtree != NIL)
+set_parent(subtree, parent);
+}
+
+for (node_t cur = parent; cur != NIL; cur = Nodes[cur].parent) {
+update_aggregates(cur);
+}
+
+Nodes[x].left = Nodes[x].right = NIL;
+set_parent(x, NIL);
+update_aggregates(x);
+}
+
+/**
+* Builds the Cartesian tree of the sequence by priorities: the
+* stack holds the right spine of the tree built so far, and
+* every node popped from it is complete, so its aggregates
+* can be computed right away.
+*/
+template <class Hook>
+node_t BasicTreap<Hook>::build(const node_t *seq, int k) {
+vector <node_t> spine;
+
+for (int i = 0; i < k; i++) {
+node_t x = seq[i], last = NIL;
+while (!spine.empty() && priority(spine.back()) < priority(x)) {
+last = spine.back();
+spine.pop_back();
+update_aggregates(last);
+}
+
+Nodes[x].left = last;
+if (last != NIL)
+set_parent(last, x);
+if (!spine.empty()) {
+Nodes[spine.back()].right = x;
+set_parent(x, spine.back());
+}
+spine.push_back(x);
+}
+
+node_t root = spine.empty() ? NIL : spine.front();
+while (!spine.empty()) {
+update_aggregates(spine.back());
+spine.pop_back();
+}
+
+return root;
+}
+
+template <class Hook>
+bool BasicTreap<Hook>::correct_tree(node_t x, node_t correct_parent) const {
+const TourNode &node = Nodes[x];
+
+if (!correct_node(x, correct_parent))
+return false;
+
+if ((node.left != NIL && priority(node.left) > priority(x)) ||
+(node.right != NIL && priority(node.right) > priority(x))) {
+debug ("heap invariant violated\n");
+return false;
+}
+
+if (node.left != NIL && !correct_tree(node.left, x))
+return false;
+if (node.right != NIL && !correct_tree(node.right, x))
+return false;
+
+return true;
+}
+
+template class BasicTreap<NoHook>;
+template class BasicTreap<AggregateHook>;
+
+/**
+* Solution to the problem Disconnected Graph:
+* First read in the graph G, then asnwers k queries.
+* In each query we would like to know if G is connected
+* after a few edges have been removed.
+*/
+
+const int K = 1e5;
+int Res[K];
+
+static inline bool in(int x, vector <int> &v) {
+for (int y: v) {
+if (x == y) {
+return true;
+}
+}
+return false;
+}
+
+int main(int argc, char **argv)
+{
+if (argc > 1) {
+freopen(argv[1], "r", stdin);
+} else {
+freopen("disconnected.in", "r", stdin);
+freopen("disconnected.out", "w", stdout);
+}
+
+int n, m;
+scanf ("%d %d", &n, &m);
+vector <pair <int, int> > edges(m);
+
+for (auto &e: edges) {
+scanf ("%d %d", &e.first, &e.second);
+e.first--;
+e.second--;
+}
+DynamicConnectivity DC(n, edges);
+
+int k;
+scanf ("%d", &k);
+vector <vector <int> > Q(k);
+int id = 0;
+for (auto &v: Q) {
+int c;
+scanf ("%d", &c);
+v.resize(c);
+
+for (int &i: v) {
+scanf ("%d", &i);
+i--;
+}
+sort(v.begin(), v.end());
+v.push_back(K + id++);
+}
+
+Q.push_back(vector<int>());
+sort(Q.begin(), Q.end());
+
+for (int i = 1; i <= k; i++) {
+int q = Q[i].back() - K;
+Q[i].pop_back();
+
+for (int e: Q[i-1]) if (!in(e, Q[i])) {
+DC.insert(edges[e].first, edges[e].second);
+}
+
+for (int e: Q[i]) if (!in(e, Q[i-1])) {
+DC.remove(edges[e].first, edges[e].second);
+}
+
+Res[q] = DC.count_components();
+}
+
+for (int i = 0; i < k; i++) {
+if (Res[i] == 1) printf ("Connected\n");
+else printf ("Disconnected\n");
+}
+}
@@ -1,15 +1,63 @@
 #include <bits/stdc++.h>
 #include "dc.hpp"
+#include "parallel.hpp"
 
-static pair <int, int> ordered_pair(int a, int b) {
-    return {min(a,b), max(a,b)};
-}
-
-DynamicConnectivity::DynamicConnectivity(int n) {
+template <class Tree>
+BasicDynamicConnectivity<Tree>::BasicDynamicConnectivity(int _n) {
+    n = _n;
     L = 0;
     while (n > (1<<L)) L++;
 
-    Forests.resize(L+1, ETTForest(n));
+    // higher levels are created when the first edge reaches them
+    Forests.emplace_back(n);
+
+    components = n;
+    if (n > 0)
+        ComponentSizes[1] = n;
+
+    random_state = 0x9e3779b97f4a7c15ULL;
+}
+
+template <class Tree>
+BasicDynamicConnectivity<Tree>::BasicDynamicConnectivity(int _n,
+        const vector <pair <int, int> > &edges)
+    : BasicDynamicConnectivity(_n) {
+
+    UnionFind UF(n);
+    vector <pair <int, int> > tree_edges;
+    Edges.reserve(edges.size());
+
+    for (auto [a, b]: edges) {
+        if (a == b)
+            continue;
+
+        EdgeInfo *info = Edges.insert(a, b);
+        if (info->cnt++ > 0)
+            continue;
+
+        // nontree edges are stored while all the vertices are
+        // still isolated, which makes it O(1) per edge
+        info->tree = UF.unite(a, b);
+        if (info->tree)
+            tree_edges.push_back({a, b});
+        else
+            info->nontree_hook = Forests[0].insert_nontree_edge(a, b);
+    }
+
+    Forests[0].build_trees(tree_edges);
+
+    vector <int> sizes(n, 0);
+    for (int v = 0; v < n; v++)
+        sizes[UF.find(v)]++;
+
+    components = 0;
+    ComponentSizes.clear();
+    for (int v = 0; v < n; v++) {
+        if (sizes[v] > 0) {
+            components++;
+            ComponentSizes[sizes[v]]++;
+        }
+    }
 }
 
 /**
@@ -19,48 +67,228 @@ DynamicConnectivity::DynamicConnectivity(int n) {
  * 
  * Extra amortization cost: O(log^2 n) (a new edge is inserted)
 */
-void DynamicConnectivity::insert(int a, int b) {
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::insert(int a, int b) {
+
+    // loops never affect connectivity
+    if (a == b)
+        return;
 
-    if (EdgeCnt[ordered_pair(a,b)]++ == 0)
-        insert_edge(a, b, 0);
+    SeqLock::WriteGuard guard(write_lock());
+    finish_pending();
 
+    EdgeInfo *info = Edges.insert(a, b);
+    if (info->cnt++ == 0) {
+        auto sizes = insert_edge(a, b, 0, info);
+        if (info->tree)
+            join_components(a, b, sizes);
+    }
 }
 
 /**
  * Inserts an unique (a,b) edge to the graph with the given level
+ * and records the level and the kind of the edge in its entry
+ * of the edge table
  * 
- * If a and b are not connected, it's added to the forest.
+ * If a and b are not connected, it's added to the forest and
+ * the sizes of the trees of F_0 it joined are returned.
  * Otherwise it is added to the list of nontree edges to be
  * accessed later when we'll be looking for replacement edges.
  * 
  * Complexity: O((level+1) * log n) -- O(log^2 n)
 */
-void DynamicConnectivity::insert_edge(int a, int b, int level) {
+template <class Tree>
+pair <int, int> BasicDynamicConnectivity<Tree>::insert_edge(int a, int b, int level, EdgeInfo *info) {
 
-    EdgeLevels[ordered_pair(a,b)] = level;
+    info->level = level;
+    info->tree = !Forests[level].connected(a,b);
+    pair <int, int> sizes = {0, 0};
 
-    if (!Forests[level].connected(a,b)) {
+    if (info->tree) {
 
-        for (int l = 0; l <= level; l++)
-            Forests[l].insert_tree_edge(a, b, (level == l));
+        for (int l = 0; l <= level; l++) {
+            auto joined = Forests[l].insert_tree_edge(a, b, (level == l));
+            if (l == 0)
+                sizes = joined;
+        }
 
     } else {
-        Forests[level].insert_nontree_edge(a,b);
+        info->nontree_hook = Forests[level].insert_nontree_edge(a,b);
+    }
+    return sizes;
+}
+
+/**
+ * Records that the components of a and b (of the given sizes)
+ * were joined and reports it to the event handler
+ */
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::join_components(int a, int b, pair <int, int> sizes) {
+    for (int size: {sizes.first, sizes.second}) {
+        auto it = ComponentSizes.find(size);
+        if (--it->second == 0)
+            ComponentSizes.erase(it);
+    }
+    ComponentSizes[sizes.first + sizes.second]++;
+    components--;
+
+    if (EventHandler)
+        EventHandler({ComponentEvent::MERGE, a, b, sizes.first, sizes.second});
+}
+
+/**
+ * Records that a component was split into the components of a
+ * and b (of the given sizes) and reports it to the event handler
+ */
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::split_component(int a, int b, pair <int, int> sizes) {
+    auto it = ComponentSizes.find(sizes.first + sizes.second);
+    if (--it->second == 0)
+        ComponentSizes.erase(it);
+    ComponentSizes[sizes.first]++;
+    ComponentSizes[sizes.second]++;
+    components++;
+
+    if (EventHandler)
+        EventHandler({ComponentEvent::SPLIT, a, b, sizes.first, sizes.second});
+}
+
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::set_aggregate_hook(typename Tree::hook_type *hook) {
+    Forests[0].set_aggregate_hook(hook);
+}
+
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::update_vertex(int v) {
+    SeqLock::WriteGuard guard(write_lock());
+    Forests[0].update_vertex(v);
+}
+
+template <class Tree>
+node_t BasicDynamicConnectivity<Tree>::component_root(int v) {
+    SeqLock::WriteGuard guard(query_lock());
+    finish_pending();
+    return Forests[0].tour_root(v);
+}
+
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::set_options(const ConnectivityOptions &_options) {
+    assert(valid(_options));
+    SeqLock::WriteGuard guard(write_lock());
+    finish_pending();
+
+    if (_options.concurrent_reads && !Options.concurrent_reads) {
+        Forests[0].reserve_spanning_forest();
+        // F_0 must not move either when a level is added
+        Forests.reserve(L + 1);
     }
+    for (auto &forest: Forests)
+        forest.set_threads(_options.threads);
+    Options = _options;
+}
+
+template <class Tree>
+const ConnectivityOptions &BasicDynamicConnectivity<Tree>::options() const {
+    return Options;
+}
+
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::valid(const ConnectivityOptions &options) {
+    if (options.samples < 0 || options.interleaved_budget < 0 ||
+        options.threads < 1)
+        return false;
+
+    return !options.concurrent_reads ||
+           (options.remove_budget < 0 && !Tree::self_adjusting);
+}
+
+template <class Tree>
+const SamplingStats &BasicDynamicConnectivity<Tree>::sampling_stats() const {
+    return Sampling;
+}
+
+template <class Tree>
+const InterleavedStats &BasicDynamicConnectivity<Tree>::interleaved_stats() const {
+    return Interleaved;
+}
+
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::set_event_handler(
+        function <void(const ComponentEvent &)> handler) {
+    EventHandler = handler;
 }
 
 /**
  * Checks whether vertices a and b are connected
  * Complexity: O(log n)
 */
-bool DynamicConnectivity::connected(int a, int b) {
-    return Forests[0].connected(a, b);
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::connected(int a, int b) {
+    SeqLock::WriteGuard guard(query_lock());
+    if (Forests[0].connected(a, b))
+        return true;
+
+    // only the two sides of a pending cut may still be connected
+    if (Pending.active &&
+        ((Forests[0].connected(a, Pending.a) && Forests[0].connected(b, Pending.b)) ||
+         (Forests[0].connected(a, Pending.b) && Forests[0].connected(b, Pending.a)))) {
+        finish_pending();
+        return Forests[0].connected(a, b);
+    }
+
+    return false;
+}
+
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::connected_batch(const vector <pair <int, int> > &queries,
+                                                    vector <bool> &answers) {
+    SeqLock::WriteGuard guard(query_lock());
+    finish_pending();
+    Forests[0].connected_batch(queries, answers);
+}
+
+template <class Tree>
+int BasicDynamicConnectivity<Tree>::count_components() {
+    SeqLock::WriteGuard guard(query_lock());
+    finish_pending();
+    return components;
+}
+
+template <class Tree>
+int BasicDynamicConnectivity<Tree>::component_size(int v) {
+    SeqLock::WriteGuard guard(query_lock());
+    finish_pending();
+    return Forests[0].size(v);
+}
+
+template <class Tree>
+int BasicDynamicConnectivity<Tree>::largest_component() {
+    SeqLock::WriteGuard guard(query_lock());
+    finish_pending();
+    return ComponentSizes.empty() ? 0 : ComponentSizes.rbegin()->first;
+}
+
+template <class Tree>
+vector <int> BasicDynamicConnectivity<Tree>::largest_components(int k) {
+    SeqLock::WriteGuard guard(query_lock());
+    finish_pending();
+
+    vector <int> sizes;
+    for (auto it = ComponentSizes.rbegin(); it != ComponentSizes.rend(); it++) {
+        for (int i = 0; i < it->second && (int) sizes.size() < k; i++)
+            sizes.push_back(it->first);
+        if ((int) sizes.size() == k)
+            break;
+    }
+    return sizes;
 }
 
 /**
- * Looks for a replacement of edge (a,b) among nontree edges on
- * the specified level.
- * Returns true on success and false on failure.
+ * Looks for a replacement of the edge (a,b) of the pending
+ * remove among nontree edges on its current level.
+ * Returns true if the search on this level ended, with found
+ * telling whether a replacement was found, and false if it ran
+ * out of the budget (work counts the units spent so far).
  * 
  * Let A and B be the trees containing a and b (w.l.o.g let A_l
  * be the smaller one). In order to reconnect A and B suffices
@@ -76,39 +304,181 @@ bool DynamicConnectivity::connected(int a, int b) {
  * needed to process it. When we encounter a nontree edge with
  * one endpoint in A and another in B, we stop the procedure.
  * 
+ * Every promotion keeps the invariants, so the search can stop
+ * after any edge and continue later: the tree edges of A which
+ * are still on the level and the nontree edges which are still
+ * stored in A are exactly those not processed yet. The nontree
+ * edges are moved only once all the tree edges of A are, so that
+ * their endpoints are connected on the next level.
+ * 
  * Complexity: O(log n) per each edge whose level grows by one
  * (amortized) plus O(log n) (not amortized)
  * 
 */
-bool DynamicConnectivity::find_replacement(int a, int b, int level, pair <int, int> &replacement) {
-    
-    if (Forests[level].size(a) > Forests[level].size(b))
-        swap(a, b);
-    
-    // Promote tree edges from A to the next level:
-    auto promoted = Forests[level].promote_tree_edges(a);
-    for (auto e: promoted) {
-        EdgeLevels[ordered_pair(e.first, e.second)] = level+1;
-        Forests[level+1].insert_tree_edge(e.first, e.second, true);
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::find_replacement(int &work, int budget,
+        pair <int, int> &replacement, bool &found) {
+    PendingRemove &p = Pending;
+    int level = p.level;
+    found = false;
+
+    if (p.stage == SEARCH_START) {
+        // the sampling and the interleaved search run whole, so
+        // they start only within the budget
+        if (work >= budget)
+            return false;
+
+        p.small = p.a;
+        p.large = p.b;
+        if (Forests[level].size(p.small) > Forests[level].size(p.large))
+            swap(p.small, p.large);
+
+        if (Options.samples > 0 &&
+            sample_replacement(p.small, p.large, level, work, replacement))
+            return found = true;
+
+        if (Options.interleaved_budget > 0 &&
+            search_both_sides(p.small, p.large, level, work, replacement, found))
+            return true;
+
+        add_level(level+1);
+        p.stage = SEARCH_PROMOTE;
+    }
+
+    if (p.stage == SEARCH_PROMOTE) {
+        // Promote tree edges from A to the next level:
+        if (work < budget)
+            promote_tree_edges(p.small, level, work, budget);
+        if (work >= budget)
+            return false;
+        p.stage = SEARCH_SCAN;
     }
 
     // Browse through all nontree edges with one endpoint in A:
-    pair <int, int> edge;
-    while (Forests[level].pop_nontree_edge(a, edge)) {
+    bool stopped = false;
+    Forests[level].pop_nontree_edges(p.small, [&](pair <int, int> edge) {
+        work++;
+        if (Forests[level].connected(edge.second, p.large)) {
+            replacement = edge;
+            found = true;
+            return false;
+        }
+
+        EdgeInfo *info = Edges.find(edge.first, edge.second);
+        info->level = level+1;
+        info->nontree_hook =
+            Forests[level+1].insert_nontree_edge(edge.first, edge.second);
+
+        stopped = work >= budget;
+        return !stopped;
+    });
 
+    return found || !stopped;
+}
+
+/**
+ * Samples nontree edges of the component of a in F_level and
+ * returns true when one of them leads to the component of b.
+ * Such an edge is removed from F_level, like the replacement
+ * found by the full search. Nothing else changes, so a miss
+ * leaves the structure as it was.
+ */
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::sample_replacement(int a, int b, int level,
+        int &work, pair <int, int> &replacement) {
+    for (int i = 0; i < Options.samples; i++) {
+        pair <int, int> edge;
+        int handle = Forests[level].sample_nontree_edge(a, next_random(), edge);
+        if (handle == -1)
+            return false;
+
+        // searches without any candidates are not counted
+        if (i == 0)
+            Sampling.searches++;
+        Sampling.samples++;
+        work++;
         if (Forests[level].connected(edge.second, b)) {
+            Forests[level].remove_nontree_edge(handle);
             replacement = edge;
+            Sampling.hits++;
             return true;
+        }
+    }
 
-        } else {
-            Forests[level+1].insert_nontree_edge(edge.first, edge.second);
-            EdgeLevels[ordered_pair(edge.first, edge.second)] = level+1;
+    return false;
+}
+
+/**
+ * Looks at the nontree edges of the components of a (the
+ * smaller one) and b in F_level in turns, within the budget.
+ * Returns true if the search was decided: found tells if a
+ * replacement was found (and removed from F_level like in the
+ * full search) and false means that one side has no edges
+ * leading to the other. The edges of a side are visited in the
+ * order of its Euler tour, so the walks are never repeated.
+ */
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::search_both_sides(int a, int b, int level,
+        int &work, pair <int, int> &replacement, bool &found) {
+    NontreeCursor cursors[2] = {{a}, {b}};
+    int other[2] = {b, a};
+    found = false;
+
+    for (int i = 0; i < Options.interleaved_budget; i++) {
+        int side = i % 2;
+        pair <int, int> edge;
+        int handle = Forests[level].next_nontree_edge(cursors[side], edge);
+        if (handle == -1) {
+            // a search which looked at nothing is not counted
+            if (i > 0)
+                Interleaved.no_replacement++;
+            return true;
+        }
+
+        if (i == 0)
+            Interleaved.searches++;
+        Interleaved.edges++;
+        work++;
+
+        if (Forests[level].connected(edge.second, other[side])) {
+            Forests[level].remove_nontree_edge(handle);
+            replacement = edge;
+            found = true;
+            if (side == 0)
+                Interleaved.hits_smaller++;
+            else
+                Interleaved.hits_larger++;
+            return true;
         }
     }
 
     return false;
 }
 
+/* xorshift64* (https://en.wikipedia.org/wiki/Xorshift) */
+template <class Tree>
+uint32_t BasicDynamicConnectivity<Tree>::next_random() {
+    random_state ^= random_state >> 12;
+    random_state ^= random_state << 25;
+    random_state ^= random_state >> 27;
+    return (random_state * 0x2545f4914f6cdd1dULL) >> 32;
+}
+
+/**
+ * Moves the tree edges of the component of a in F_level to the
+ * next level, streaming them from the traversal of F_level,
+ * until work reaches the budget
+ */
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::promote_tree_edges(int a, int level,
+                                                        int &work, int budget) {
+    Forests[level].promote_tree_edges(a, [&](pair <int, int> e) {
+        Edges.find(e.first, e.second)->level = level+1;
+        Forests[level+1].insert_tree_edge(e.first, e.second, true);
+        return ++work < budget;
+    });
+}
+
 /**
  * Removes an (a,b) edge from the graph and looks for its
  * replacement
@@ -122,56 +492,516 @@ bool DynamicConnectivity::find_replacement(int a, int b, int level, pair <int, i
  * Complexity: O(log^2 n) (not amortized) and O(log n) 
  * per each edge whose level grows by one (amortized)
  */ 
-void DynamicConnectivity::remove(int a, int b) {
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::remove(int a, int b) {
+
+    SeqLock::WriteGuard guard(write_lock());
+    finish_pending();
 
     // Check if the edge exists
-    if (EdgeCnt[ordered_pair(a,b)] == 0)
+    EdgeInfo *info = Edges.find(a, b);
+    if (info == NULL)
         return;
     
-    if (--EdgeCnt[ordered_pair(a,b)] > 0)
+    if (--info->cnt > 0)
         return;
 
     // Remove the edge:
-    int level = EdgeLevels[ordered_pair(a,b)];
-    EdgeLevels.erase(ordered_pair(a,b));
+    int level = info->level;
+    bool tree = info->tree;
+    int nontree_hook = info->nontree_hook;
+    Edges.erase(info);
 
-    if (!Forests[level].is_tree_edge(a, b)) {
-        Forests[level].remove_nontree_edge(a, b);
+    if (!tree) {
+        Forests[level].remove_nontree_edge(nontree_hook);
+        release_empty_levels();
         return;
+    }
 
-    } else {
-        
-        for (int l = 0; l <= level; l++) {
-            Forests[l].remove_tree_edge(a,b);
-        }
+    // the sizes of the trees of F_0, which stay split if no
+    // replacement is found on any level
+    pair <int, int> sizes;
+    for (int l = 0; l <= level; l++) {
+        auto split = Forests[l].remove_tree_edge(a,b);
+        if (l == 0)
+            sizes = split;
     }
 
     // Look for a replacement of the removed edge:
+    Pending = {true, a, b, sizes, level, SEARCH_START, a, b};
+    continue_remove(search_budget());
+}
+
+/**
+ * Continues the search of the pending remove from the top level
+ * down, until it finds a replacement, shows that there is none
+ * or runs out of the budget. Returns whether it is still pending.
+ */
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::continue_remove(int budget) {
+    PendingRemove &p = Pending;
     pair <int, int> replacement;
-    while (level >= 0 and
-           !find_replacement(a, b, level, replacement)) {
-        level--;
+    bool found = false;
+    int work = 0;
+
+    while (p.level >= 0) {
+        if (!find_replacement(work, budget, replacement, found))
+            return true;
+        if (found)
+            break;
+
+        p.level--;
+        p.stage = SEARCH_START;
+    }
+
+    p.active = false;
+    if (found)
+        insert_edge(replacement.first, replacement.second, p.level,
+                    Edges.find(replacement.first, replacement.second));
+    else
+        split_component(p.a, p.b, p.sizes);
+
+    release_empty_levels();
+    return false;
+}
+
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::finish_pending() {
+    if (Pending.active)
+        continue_remove(INT_MAX);
+}
+
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::step() {
+    SeqLock::WriteGuard guard(write_lock());
+    return Pending.active && continue_remove(max(search_budget(), 1));
+}
+
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::pending() const {
+    return Pending.active;
+}
+
+/* The work a remove or a step may do before the search is left pending */
+template <class Tree>
+int BasicDynamicConnectivity<Tree>::search_budget() const {
+    return Options.remove_budget >= 0 ? Options.remove_budget : INT_MAX;
+}
+
+template <class Tree>
+SeqLock *BasicDynamicConnectivity<Tree>::write_lock() {
+    return Options.concurrent_reads ? &ReadLock : NULL;
+}
+
+/**
+ * A query writes F_0 only if it finishes a pending remove (the
+ * sequence trees of the concurrent reads do not restructure
+ * themselves on access); otherwise it only reads, and marking
+ * a write would make the readers retry
+ */
+template <class Tree>
+SeqLock *BasicDynamicConnectivity<Tree>::query_lock() {
+    return Pending.active ? write_lock() : NULL;
+}
+
+/**
+ * Walks from a and b to the roots of their Euler tours in F_0
+ * and retries until no update overlapped the walks. A walk
+ * which gave up (NIL) or any other torn result of an overlap
+ * is discarded by the validation.
+ */
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::concurrent_connected(int a, int b) const {
+    if (a == b)
+        return true;
+
+    while (true) {
+        uint64_t s = ReadLock.read_begin();
+        node_t root_a = Forests[0].concurrent_root(a);
+        node_t root_b = Forests[0].concurrent_root(b);
+        if (ReadLock.read_validate(s))
+            return root_a == root_b;
+    }
+}
+
+/* Creates the (empty) forest of the given level if there is none yet */
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::add_level(int level) {
+    if ((int) Forests.size() == level) {
+        Forests.emplace_back(n, true);
+        Forests.back().set_threads(Options.threads);
+    }
+}
+
+/**
+ * Drops the empty forests from the top of the hierarchy
+ * (if F_i is empty, so are all the forests above it)
+ * Complexity: O(1) per each dropped level plus the cost of
+ * freeing its memory
+ */
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::release_empty_levels() {
+    while (Forests.size() > 1 && Forests.back().empty())
+        Forests.pop_back();
+}
+
+/**
+ * Classifies the new edges in one sweep: an edge is a tree edge
+ * if it joins two trees of F_0 which are not joined yet by
+ * the tree edges of the batch seen so far.
+ */
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::insert_batch(const vector <pair <int, int> > &edges) {
+    SeqLock::WriteGuard guard(write_lock());
+    finish_pending();
+
+    vector <pair <int, int> > links, nontree;
+
+    // union-find over the trees of F_0 hit by the batch,
+    // with the sizes of the components they form
+    EdgeTable <int> TreeIds;
+    UnionFind UF(2 * edges.size());
+    vector <int> sizes;
+    auto tree_index = [&](int v) {
+        node_t t = Forests[0].tree_id(v);
+        int *p = TreeIds.insert(t, t);
+        if (*p == 0) {
+            *p = TreeIds.size();
+            sizes.push_back(Forests[0].tree_size(t));
+        }
+        return UF.find(*p - 1);
+    };
+
+    Edges.reserve(Edges.size() + edges.size());
+    for (auto [a, b]: edges) {
+        if (a == b)
+            continue;
+
+        EdgeInfo *info = Edges.insert(a, b);
+        if (info->cnt++ > 0)
+            continue;
+
+        info->level = 0;
+        int ta = tree_index(a), tb = tree_index(b);
+        info->tree = UF.unite(ta, tb);
+        if (info->tree) {
+            links.push_back({a, b});
+            join_components(a, b, {sizes[ta], sizes[tb]});
+            sizes[UF.find(ta)] = sizes[ta] + sizes[tb];
+
+        } else {
+            nontree.push_back({a, b});
+        }
+    }
+
+    // the tree ids are only valid until the forest is modified
+    Forests[0].link_batch(links);
+
+    for (auto [a, b]: nontree)
+        Edges.find(a, b)->nontree_hook = Forests[0].insert_nontree_edge(a, b);
+}
+
+/**
+ * Searches the component of v in F_level for edges leaving it,
+ * as long as it is small enough (at most n / 2^{level+1}
+ * vertices) to have its edges promoted to the next level and
+ * it is not connected to the vertex largest.
+ * Every edge found reconnects two fragments and becomes a tree
+ * edge on the level.
+ * Returns true if the search stopped because the component
+ * became too large while still separate from largest.
+ */
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::reconnect_fragment(int v, int level,
+                                                        int largest) {
+    if (v != largest && Forests[level].connected(v, largest))
+        return false;
+
+    while (((long long) Forests[level].size(v) << (level+1)) <= n) {
+
+        add_level(level+1);
+
+        // the fragment may have grown since the last promotion
+        int work = 0;
+        promote_tree_edges(v, level, work, INT_MAX);
+
+        // the nontree edges inside the fragment go to the next
+        // level, up to the first one leaving it
+        pair <int, int> edge;
+        bool leaving = false;
+        Forests[level].pop_nontree_edges(v, [&](pair <int, int> e) {
+            if (!Forests[level].connected(e.second, v)) {
+                edge = e;
+                leaving = true;
+                return false;
+            }
+
+            EdgeInfo *info = Edges.find(e.first, e.second);
+            info->level = level+1;
+            info->nontree_hook =
+                Forests[level+1].insert_nontree_edge(e.first, e.second);
+            return true;
+        });
+        if (!leaving)
+            return false;
+
+        insert_edge(edge.first, edge.second, level,
+                    Edges.find(edge.first, edge.second));
+        if (v != largest && Forests[level].connected(v, largest))
+            return false;
+    }
+
+    return v != largest;
+}
+
+/**
+ * Reconnects the fragments of the trees of F_level split by the
+ * first k cuts, like the search for a replacement edge in remove
+ * does for the smaller side of a single cut.
+ *
+ * Every fragment except the largest one of its original tree is
+ * searched until it is connected to the largest one. Searches
+ * end early only when a component becomes too large to have its
+ * edges promoted, and as the original tree has at most
+ * n / 2^level vertices, such a component is the only large one.
+ * The largest fragment is then small and is searched itself,
+ * so every edge between two fragments is found.
+ */
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::reconnect_fragments(
+        const vector <pair <int, pair <int, int> > > &cuts, size_t k,
+        int level) {
+    Fragments F;
+    find_fragments(cuts, k, level, F);
+    int f_cnt = F.vertices.size();
+
+    vector <bool> search_largest(f_cnt, false);
+    for (int f = 0; f < f_cnt; f++) {
+        int t = F.Trees.find(f), l = F.largest[t];
+        if (f != l && reconnect_fragment(F.vertices[f], level, F.vertices[l]))
+            search_largest[t] = true;
+    }
+
+    for (int t = 0; t < f_cnt; t++) {
+        if (search_largest[t]) {
+            int v = F.vertices[F.largest[t]];
+            reconnect_fragment(v, level, v);
+        }
+    }
+
+    if (level == 0)
+        split_components(F);
+}
+
+/**
+ * Finds the fragments of the trees of F_level split by the first
+ * k cuts, with the original trees joining them and the largest
+ * fragment of each
+ */
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::find_fragments(
+        const vector <pair <int, pair <int, int> > > &cuts, size_t k,
+        int level, Fragments &F) {
+    ETTForest <Tree> &Forest = Forests[level];
+
+    // an isolated vertex (with no node) is a fragment by itself
+    auto fragment_index = [&](int v) {
+        node_t t = Forest.tree_id(v);
+        int *p = t == NIL ? F.Ids.insert(NIL, v) : F.Ids.insert(t, t);
+        if (*p == 0) {
+            F.vertices.push_back(v);
+            *p = F.vertices.size();
+        }
+        return *p - 1;
+    };
+
+    // the cut edges join the fragments of an original tree
+    F.Trees = UnionFind(2 * k);
+    for (size_t i = 0; i < k; i++) {
+        F.Trees.unite(fragment_index(cuts[i].second.first),
+                      fragment_index(cuts[i].second.second));
+    }
+
+    int f_cnt = F.vertices.size();
+    F.largest.assign(f_cnt, -1);
+    F.sizes.resize(f_cnt);
+    for (int f = 0; f < f_cnt; f++) {
+        int t = F.Trees.find(f);
+        F.sizes[f] = Forest.size(F.vertices[f]);
+        if (F.largest[t] == -1 || F.sizes[f] > F.sizes[F.largest[t]])
+            F.largest[t] = f;
+    }
+}
+
+/**
+ * Records the net effect of a batch of removals on the
+ * components: the fragments of every original component of F_0
+ * which are still apart after the reconnection split off it one
+ * by one (transient splits reconnected by the batch are never
+ * reported)
+ */
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::split_components(Fragments &F) {
+    const vector <int> &fragments = F.vertices, &sizes = F.sizes;
+    UnionFind &Trees = F.Trees;
+    // the size of every original component which is left and
+    // its first fragment found to be apart
+    vector <int> left(fragments.size(), 0), first(fragments.size(), -1);
+    for (size_t f = 0; f < fragments.size(); f++)
+        left[Trees.find(f)] += sizes[f];
+
+    EdgeTable <bool> Seen;
+    for (size_t f = 0; f < fragments.size(); f++) {
+        node_t id = Forests[0].tree_id(fragments[f]);
+        bool *seen = Seen.insert(id, id);
+        if (*seen)
+            continue;
+        *seen = true;
+
+        int t = Trees.find(f);
+        if (first[t] == -1) {
+            first[t] = f;
+            continue;
+        }
+
+        int size = Forests[0].tree_size(id);
+        left[t] -= size;
+        split_component(fragments[first[t]], fragments[f], {left[t], size});
     }
+}
 
-    if (level >= 0)
-        insert_edge(replacement.first, replacement.second, level);
+/**
+ * Removes the edges and cuts the tree edges among them (see
+ * cut_batch). Then the fragments are reconnected from the top
+ * level down, so that edges found on a level are already in
+ * place when the level below is searched.
+ */
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::remove_batch(const vector <pair <int, int> > &edges) {
+    SeqLock::WriteGuard guard(write_lock());
+    finish_pending();
+
+    vector <pair <int, pair <int, int> > > cuts;
+    cut_batch(edges, cuts);
+
+    size_t on_level = 0;
+    for (int l = cuts.empty() ? -1 : cuts[0].first; l >= 0; l--) {
+        while (on_level < cuts.size() && cuts[on_level].first >= l)
+            on_level++;
+        reconnect_fragments(cuts, on_level, l);
+    }
 
+    release_empty_levels();
 }
 
-void DynamicConnectivity::print() {
+/**
+ * Removes the edges in a single sweep over the batch and cuts the
+ * tree edges among them from all their levels. Sets cuts to these
+ * edges with their levels, from the top level down, so that the
+ * edges cut from a level form a prefix.
+ */
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::cut_batch(const vector <pair <int, int> > &edges,
+        vector <pair <int, pair <int, int> > > &cuts) {
+    for (auto [a, b]: edges) {
+        EdgeInfo *info = Edges.find(a, b);
+        if (info == NULL || --info->cnt > 0)
+            continue;
+
+        if (info->tree)
+            cuts.push_back({info->level, {a, b}});
+        else
+            Forests[info->level].remove_nontree_edge(info->nontree_hook);
+        Edges.erase(info);
+    }
+
+    if (cuts.empty())
+        return;
+
+    sort(cuts.rbegin(), cuts.rend());
+    int top = cuts[0].first;
+    vector <pair <int, int> > cut_edges;
+    for (auto &cut: cuts)
+        cut_edges.push_back(cut.second);
+
+    // the forests of the levels share no memory, so the rounds
+    // of cuts of all the levels run together (see plan_cuts)
+    size_t on_level = 0;
+    for (int l = top; l >= 0; l--) {
+        while (on_level < cuts.size() && cuts[on_level].first >= l)
+            on_level++;
+        Forests[l].plan_cuts(cut_edges, on_level);
+    }
+    vector <pair <int, int> > tasks;
+    while (true) {
+        tasks.clear();
+        for (int l = 0; l <= top; l++) {
+            for (int i = 0; i < Forests[l].cut_tasks(); i++)
+                tasks.push_back({l, i});
+        }
+        if (tasks.empty())
+            break;
+
+        parallel_for(Options.threads, tasks.size(), [&](int i) {
+            Forests[tasks[i].first].cut_task(tasks[i].second);
+        });
+        for (int l = 0; l <= top; l++)
+            Forests[l].next_cut_round();
+    }
+    for (int l = 0; l <= top; l++)
+        Forests[l].finish_cuts();
+}
+
+template <class Tree>
+void BasicDynamicConnectivity<Tree>::print() {
     #ifdef DBG
-    for (int i = 0; i <= L; i++) {
+    for (int i = 0; i < (int) Forests.size(); i++) {
         debug ("--------------Level %d-------------------\n", i);
         Forests[i].print();
     }
     #endif
 }
 
-bool DynamicConnectivity::correct() {
-    for (int l = 0; l <= L; l++) {
+template <class Tree>
+bool BasicDynamicConnectivity<Tree>::correct() {
+    SeqLock::WriteGuard guard(write_lock());
+    finish_pending();
+
+    if ((int) Forests.size() > L + 1)
+        return false;
+
+    // the statistics of the components
+    vector <node_t> ids(n);
+    for (int v = 0; v < n; v++)
+        ids[v] = Forests[0].tree_id(v);
+    sort(ids.begin(), ids.end());
+
+    map <int, int> sizes;
+    for (int i = 0, j = 0; i < n; i = j) {
+        while (j < n && ids[j] == ids[i])
+            j++;
+        sizes[j - i]++;
+    }
+    if (sizes != ComponentSizes)
+        return false;
+
+    int count = 0;
+    for (auto [size, cnt]: sizes)
+        count += cnt;
+    if (count != components)
+        return false;
+
+    for (int l = 0; l < (int) Forests.size(); l++) {
         if (!Forests[l].correct()) {
             return false;
         }
     }
-    return true;
-}
\ No newline at end of file
+    return Forests.size() == 1 || !Forests.back().empty();
+}
+
+template class BasicDynamicConnectivity<AVLTree>;
+template class BasicDynamicConnectivity<SplayTree>;
+template class BasicDynamicConnectivity<Treap>;
+template class BasicDynamicConnectivity<HookedTree<AVLTree> >;
+template class BasicDynamicConnectivity<HookedTree<SplayTree> >;
+template class BasicDynamicConnectivity<HookedTree<Treap> >;
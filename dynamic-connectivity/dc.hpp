@@ -3,10 +3,144 @@
 
 #include <vector>
 #include <map>
+#include <functional>
 
 #include "et_trees.hpp"
+#include "edge_table.hpp"
+#include "union_find.hpp"
+#include "seqlock.hpp"
 using namespace std;
 
+/* Everything DynamicConnectivity knows about an undirected edge */
+struct EdgeInfo {
+    /* number of parallel copies of the edge in the graph */
+    int cnt = 0;
+    /* level of the edge (see below) */
+    int level = 0;
+    /* whether the edge belongs to the spanning forests */
+    bool tree = false;
+    /* handle of a nontree edge in the forest of its level */
+    int nontree_hook = -1;
+};
+
+/**
+ * A change of the connected components of the graph: the
+ * components of a and b were merged or a component was split
+ * into those of a and b. The sizes are those of the two
+ * components before the merge or after the split.
+ */
+struct ComponentEvent {
+    enum Type { MERGE, SPLIT } type;
+    int a, b;
+    int size_a, size_b;
+};
+
+/* Counters of the sampling of replacement edges in remove */
+struct SamplingStats {
+    /* searches on a level with some nontree edges to sample */
+    long long searches = 0;
+    /* searches ended by a sampled edge */
+    long long hits = 0;
+    /* nontree edges sampled */
+    long long samples = 0;
+};
+
+/* Counters of the interleaved search on both sides of a cut */
+struct InterleavedStats {
+    /* searches on a level with some nontree edges on the smaller side */
+    long long searches = 0;
+    /* replacements found on the smaller and on the larger side */
+    long long hits_smaller = 0, hits_larger = 0;
+    /* searches which showed that there is no replacement */
+    long long no_replacement = 0;
+    /* nontree edges looked at */
+    long long edges = 0;
+};
+
+/**
+ * The policies of the search for replacements, of the batches
+ * and of the readers of DynamicConnectivity, which are set
+ * together (see valid for the combinations allowed)
+ */
+struct ConnectivityOptions {
+    /**
+     * Number of nontree edges sampled before the search for a
+     * replacement of a removed tree edge on each level (0 turns
+     * the sampling off). The samples are taken at random from the
+     * smaller side of the cut, and the first one leading to the
+     * other side replaces the removed edge right away. Only if
+     * none does, the tree edges of the smaller side are promoted
+     * and all its nontree edges are scanned as usual. When most
+     * replacements are easy to find, this skips the promotions;
+     * a sampled edge which does not cross only costs O(log n).
+     */
+    int samples = 0;
+
+    /**
+     * Number of nontree edges looked at by the interleaved search
+     * for a replacement on each level (0 turns it off), after the
+     * sampling. The search alternates between the nontree edges
+     * of both sides of the cut, without moving any of them, and
+     * stops as soon as an edge crosses the cut or one side runs
+     * out of edges (then there is no replacement on this level).
+     * Only when the budget is used up, the smaller side is
+     * searched as usual, promoting its tree and nontree edges, so
+     * the amortized bound is kept. A crossing edge near the top
+     * of the lists of the larger side is found without scanning
+     * the whole smaller side.
+     */
+    int interleaved_budget = 0;
+
+    /**
+     * Units of work after which a remove leaves the rest of its
+     * search pending (negative means no bound, 0 that a remove
+     * only cuts the edge). A unit is a tree edge promoted or
+     * a nontree edge looked at (sampled, by the interleaved search
+     * or by the scan), at O(log n) each. The sampling and the
+     * interleaved search of a level run whole once started, so a
+     * call does at most budget + samples + interleaved_budget units.
+     * The search is continued by step(), and finished first by
+     * every other update and by the queries whose answers depend
+     * on it: connected(a, b) when a and b are on the two sides of
+     * the pending cut, component_size, the statistics of the
+     * components and the visitors.
+     */
+    int remove_budget = -1;
+
+    /**
+     * Number of threads the batches may use (1 runs them on the
+     * calling thread). remove_batch cuts the removed tree edges of
+     * all the levels in parallel rounds of splits and merges of the
+     * tours, also within one tree (see ETTForest::plan_cuts);
+     * insert_batch links the groups of trees of F_0 joined by the
+     * batch in parallel (see ETTForest::link_batch). The search
+     * for replacements of remove_batch is sequential here; see
+     * BatchDynamicConnectivity (batch_dc.hpp) for one which runs
+     * on the threads. The threads are kept across the batches
+     * (see WorkerPool in parallel.hpp).
+     */
+    int threads = 1;
+
+    /**
+     * Whether other threads may call concurrent_connected while
+     * the owner of the structure (the only writer) keeps calling
+     * the other methods. The connectivity is answered from the
+     * trees of F_0 by root walks validated with a sequence lock
+     * (seqlock.hpp): every method which may change F_0 marks
+     * a write, and a read which overlaps one is retried. The
+     * readers take no lock and do not write shared memory, so
+     * they scale with the number of threads, and the writer never
+     * waits for them. The nodes of F_0 are reserved up front, so
+     * they are never reallocated under the readers. The queries
+     * of the writer count as writes only if they finish a pending
+     * remove. Not allowed with a self-adjusting sequence tree
+     * (SplayTree), whose queries restructure it: every query of
+     * the writer would count as a write and the root walks of the
+     * readers would not be bounded by O(log n).
+     */
+    bool concurrent_reads = false;
+};
+
 /**
  * Dynamic Connectivity data structure as designed by
  * Jacob Holm, Kristian de Lichtenberg and Mikkel Thorup
@@ -49,17 +183,41 @@ using namespace std;
  * cost of looking for replacements (over the whole runtime) is
  * bounded by O(m * log^2 n) where m is the number of edge
  * insertions.
+ *
+ * The Tree parameter selects the sequence tree storing the Euler
+ * tours (AVLTree, SplayTree or Treap, see tour_tree.hpp); the
+ * bounds above hold for all of them (amortized for SplayTree,
+ * expected for Treap). DynamicConnectivity uses AVL trees.
 */
 
-class DynamicConnectivity {
+template <class Tree>
+class BasicDynamicConnectivity {
     public:
 
-    /* Initiates the data structure for a n-vertex graph */
-    DynamicConnectivity(int n);
+    /**
+     * Initiates the data structure for a n-vertex graph
+     * Only F_0 is built up front; the forests of higher levels
+     * are created when the first edge is promoted to them, store
+     * only the vertices with edges on their level and are freed
+     * once they become empty again.
+     * Complexity: O(n)
+     */
+    BasicDynamicConnectivity(int n);
+
+    /**
+     * Initiates the data structure for a n-vertex graph with
+     * the given edges (as if they were inserted one by one)
+     * A spanning forest is found with union-find and its Euler
+     * tours are built directly; the remaining edges are stored
+     * as nontree edges on level 0.
+     * Complexity: O(n + m) (expected), where m is the number
+     * of edges
+     */
+    BasicDynamicConnectivity(int n, const vector <pair <int, int> > &edges);
 
     /**
      * Inserts an undirected (a,b) edge to the graph
-     * (parallel edges are supported)
+     * (parallel edges are supported, loops are ignored)
      * Complexity (runtime): O(log n)
      * Complexity (cost accounting for amortization): O(log^2 n)
     */
@@ -71,17 +229,203 @@ class DynamicConnectivity {
      * Complexity (runtime): only bounded by the number of
      * edges added so far, but the total cost of all calls is
      * amortized over the whole lifetime of the structure
+     * (O(log^2 n + budget log n) with a remove budget, see
+     * ConnectivityOptions::remove_budget)
      * 
      * Complexity (cost accounting for amortization): O(log n) 
      */
     void remove(int a, int b);
 
+    /**
+     * Sets the policies of the structure, which must be valid
+     * (see valid), and finishes the pending remove (if any).
+     * Enabling the concurrent reads must happen before the
+     * readers start, and disabling them after they stop.
+     * Complexity: O(n) when the concurrent reads are enabled
+     * (the nodes of F_0 are reserved), O(1) otherwise, plus the
+     * cost of the pending remove
+     */
+    void set_options(const ConnectivityOptions &_options);
+
+    /**
+     * Returns the policies set by set_options
+     * Complexity: O(1)
+     */
+    const ConnectivityOptions &options() const;
+
+    /**
+     * Checks whether the policies may be combined. Every count
+     * must be non-negative and there must be at least one thread.
+     * Then:
+     *
+     *   remove_budget  samples / interleaved_budget  allowed
+     *   any            any                           yes
+     *
+     *   remove_budget  threads                       allowed
+     *   any            any                           yes (*)
+     *
+     *   remove_budget  concurrent_reads              allowed
+     *   negative       true                          yes (***)
+     *   >= 0           true                          no (**)
+     *
+     * (*) remove_batch finishes the pending remove first and is
+     * never left pending itself: the budget bounds only remove.
+     * (**) a pending remove would make the trees of F_0, which
+     * the readers walk, disagree with the graph.
+     * (***) unless the sequence tree is self adjusting.
+     * Complexity: O(1)
+     */
+    static bool valid(const ConnectivityOptions &options);
+
+    /**
+     * Continues the pending remove (if any) by at most the
+     * remove budget of work (at least one unit), e.g. when the
+     * caller is idle.
+     * Returns whether some of it is still pending.
+     * Complexity: O(log^2 n + budget log n)
+     */
+    bool step();
+
+    /**
+     * Checks whether the search of a remove is pending
+     * Complexity: O(1)
+     */
+    bool pending() const;
+
+    /**
+     * Inserts a batch of undirected edges, with the same result
+     * as inserting them one by one
+     * The edges are classified as tree and nontree edges in one
+     * sweep (with union-find over the trees of F_0 they hit) and
+     * all new tree edges are linked into F_0 together
+     * (see ETTForest::link_batch).
+     * Complexity: O(k log n + s) where k is the size of the batch
+     * and s is the total size of the trees of F_0 linked to
+     * a larger one
+     */
+    void insert_batch(const vector <pair <int, int> > &edges);
+
+    /**
+     * Removes a batch of undirected edges, with the same effect
+     * on connectivity as removing them one by one
+     * All removed tree edges are cut from each level at once.
+     * Then, from the top level down, the fragments of the trees
+     * they split are reconnected: every fragment but the largest
+     * one of its tree is searched for edges leaving it, once per
+     * level rather than once per removed edge.
+     * Complexity: O(k log^2 n) plus the cost of promotions,
+     * amortized as in remove
+     */
+    void remove_batch(const vector <pair <int, int> > &edges);
+
     /** 
      * Checks whether vertices a and b are connected in the graph
      * Complexity: O(log n)
      */
     bool connected(int a, int b);
 
+    /**
+     * Sets answers[i] to whether the vertices of the i-th query
+     * are connected in the graph
+     * The walks to the roots of the Euler tours in F_0 of all
+     * the queries advance in lock-step and prefetch their next
+     * nodes, so a batch waits for many cache misses at once
+     * instead of one after another (see TourTree::find_roots).
+     * A pending remove is finished first.
+     * Complexity: O(k log n) where k is the number of queries
+     */
+    void connected_batch(const vector <pair <int, int> > &queries,
+                         vector <bool> &answers);
+
+    /**
+     * Returns the number of connected components of the graph
+     * The statistics of the components are maintained by the
+     * links and cuts of F_0 which change the components, from
+     * the sizes of the trees they join or split.
+     * A pending remove is finished first.
+     * Complexity: O(1) plus the cost of the pending remove
+     */
+    int count_components();
+
+    /**
+     * Returns the number of vertices in the connected component
+     * of v
+     * Complexity: O(log n)
+     */
+    int component_size(int v);
+
+    /**
+     * Returns the size of the largest connected component
+     * A pending remove is finished first.
+     * Complexity: O(1) plus the cost of the pending remove
+     */
+    int largest_component();
+
+    /**
+     * Returns the sizes of the k largest connected components
+     * (or of all of them if there are fewer) in non-increasing
+     * order
+     * A pending remove is finished first.
+     * Complexity: O(k) plus the cost of the pending remove
+     */
+    vector <int> largest_components(int k);
+
+    /**
+     * Calls f(u) for every vertex u in the connected component
+     * of v, walking its Euler tour in F_0 (f must not modify
+     * the structure)
+     * Complexity: O(log n + k) where k is the size of the component
+     */
+    template <class F>
+    void for_each_vertex(int v, F f);
+
+    /**
+     * Calls f(a, b) for every edge (a,b) of the spanning tree of
+     * the connected component of v maintained in F_0, once per
+     * edge (f must not modify the structure)
+     * Complexity: O(log n + k) where k is the size of the component
+     */
+    template <class F>
+    void for_each_tree_edge(int v, F f);
+
+    /**
+     * Sets the function called on every merge and split of the
+     * components by the following updates (an empty function
+     * turns the events off). The handler is called during the
+     * update, so it must not modify the structure.
+     * A batch reports only its net effect: insert_batch reports
+     * a merge per new tree edge and remove_batch a split per
+     * component which stays apart from the rest of its former
+     * component.
+     * Complexity: O(1) per event on top of the handler
+     */
+    void set_event_handler(function <void(const ComponentEvent &)> handler);
+
+    /**
+     * Returns the counters of the sampling since the structure
+     * was created
+     * Complexity: O(1)
+     */
+    const SamplingStats &sampling_stats() const;
+
+    /**
+     * Returns the counters of the interleaved search since the
+     * structure was created
+     * Complexity: O(1)
+     */
+    const InterleavedStats &interleaved_stats() const;
+
+    /**
+     * Checks whether vertices a and b are connected, from any
+     * thread, concurrently with the writer (see
+     * ConnectivityOptions::concurrent_reads). The answer is that
+     * of the graph between two updates of the writer, from its
+     * own point of view of the updates (see SeqLock).
+     * Complexity: O(log n) per attempt; an attempt is repeated
+     * if it overlapped an update
+     */
+    bool concurrent_connected(int a, int b) const;
+
     /**
      *  Checks if the invariants of the data structure hold
      * Complexity: O(n log n)
@@ -91,14 +435,114 @@ class DynamicConnectivity {
     /* With DBG defined, prints the data structure to stderr */
     void print();
 
+    protected:
+    /* Access to the Euler tours of F_0 for the extra aggregates */
+    void set_aggregate_hook(typename Tree::hook_type *hook);
+    void update_vertex(int v);
+    node_t component_root(int v);
+
+    /**
+     * The fragments of the trees of a level split by a batch:
+     * a vertex and the size of every fragment, the original
+     * trees joining them (by the union-find Trees, whose
+     * representatives index largest) and the fragment of each
+     * original tree with the most vertices. Ids numbers the
+     * fragments by their tree_id (an isolated vertex v by
+     * (NIL,v)), from 1.
+     */
+    struct Fragments {
+        EdgeTable <int> Ids;
+        vector <int> vertices, sizes, largest;
+        UnionFind Trees = UnionFind(0);
+    };
+
+    /* The steps of remove_batch for the engines built on this one */
+    void cut_batch(const vector <pair <int, int> > &edges,
+                   vector <pair <int, pair <int, int> > > &cuts);
+    void find_fragments(const vector <pair <int, pair <int, int> > > &cuts,
+                        size_t k, int level, Fragments &F);
+    void split_components(Fragments &F);
+    void finish_pending();
+    void add_level(int level);
+    void release_empty_levels();
+    SeqLock *write_lock();
+
+    vector <ETTForest <Tree> > Forests;
+    EdgeTable <EdgeInfo> Edges;
+    int n, L;
+    ConnectivityOptions Options;
+
     private:
-    void insert_edge(int a, int b, int level);
-    bool find_replacement(int a, int b, int level,
-                          pair <int, int> &replacement);
-    vector <ETTForest> Forests;
-    map<pair<int, int>, int> EdgeLevels;
-    map<pair<int, int>, int> EdgeCnt;
-    int L;
+    pair <int, int> insert_edge(int a, int b, int level, EdgeInfo *info);
+    void join_components(int a, int b, pair <int, int> sizes);
+    void split_component(int a, int b, pair <int, int> sizes);
+    void promote_tree_edges(int a, int level, int &work, int budget);
+    bool sample_replacement(int a, int b, int level, int &work,
+                            pair <int, int> &replacement);
+    bool search_both_sides(int a, int b, int level, int &work,
+                           pair <int, int> &replacement, bool &found);
+    bool find_replacement(int &work, int budget,
+                          pair <int, int> &replacement, bool &found);
+    bool continue_remove(int budget);
+    bool reconnect_fragment(int v, int level, int largest);
+    void reconnect_fragments(const vector <pair <int, pair <int, int> > > &cuts,
+                             size_t k, int level);
+
+    /* the number of components and of components of each size */
+    int components;
+    map <int, int> ComponentSizes;
+    function <void(const ComponentEvent &)> EventHandler;
+
+    /* the counters of the searches */
+    SamplingStats Sampling;
+    InterleavedStats Interleaved;
+
+    /* the state of the generator of the samples */
+    uint64_t random_state;
+    uint32_t next_random();
+
+    /* the stages of the search for a replacement on a level */
+    enum SearchStage { SEARCH_START, SEARCH_PROMOTE, SEARCH_SCAN };
+
+    /**
+     * The search for a replacement of a removed tree edge (a,b)
+     * (which split the trees of F_0 into the given sizes): it
+     * has got down to the given level, where the component of
+     * small is searched for edges to that of large
+     */
+    struct PendingRemove {
+        bool active = false;
+        int a, b;
+        pair <int, int> sizes;
+        int level;
+        SearchStage stage;
+        int small, large;
+    };
+
+    PendingRemove Pending;
+    int search_budget() const;
+
+    /* marks the writes of F_0 for the concurrent readers */
+    SeqLock ReadLock;
+    SeqLock *query_lock();
 };
 
+template <class Tree>
+template <class F>
+void BasicDynamicConnectivity<Tree>::for_each_vertex(int v, F f) {
+    SeqLock::WriteGuard guard(query_lock());
+    finish_pending();
+    Forests[0].for_each_vertex(v, f);
+}
+
+template <class Tree>
+template <class F>
+void BasicDynamicConnectivity<Tree>::for_each_tree_edge(int v, F f) {
+    SeqLock::WriteGuard guard(query_lock());
+    finish_pending();
+    Forests[0].for_each_tree_edge(v, f);
+}
+
+typedef BasicDynamicConnectivity <AVLTree> DynamicConnectivity;
+
 #endif
\ No newline at end of file
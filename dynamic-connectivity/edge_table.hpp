@@ -0,0 +1,338 @@
+#ifndef EDGE_TABLE_HPP
+#define EDGE_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+using namespace std;
+
+/* Packs the undirected edge (a,b) into a 64-bit key */
+inline uint64_t edge_key(int a, int b) {
+    if (a > b)
+        swap(a, b);
+    return (uint64_t(uint32_t(a)) << 32) | uint32_t(b);
+}
+
+/* Fibonacci hashing: the top bits of the product are well mixed */
+inline size_t edge_hash(uint64_t key, int shift) {
+    return (key * 0x9E3779B97F4A7C15ULL) >> shift;
+}
+
+/**
+ * Hash table mapping undirected edges to values of type Info.
+ *
+ * Uses open addressing with linear probing over a single array
+ * of slots, each holding the edge together with its value, so a
+ * lookup touches one or two cache lines. The edge is stored as
+ * two 32-bit endpoints, so that a slot is aligned only as the
+ * value: with a 4-byte value, a slot takes 12 bytes instead of
+ * 16.
+ * Erased slots are filled by shifting the following entries
+ * back (no tombstones), so probe sequences stay short under
+ * any mix of insertions and deletions.
+ *
+ * Pointers returned by find and insert stay valid until the
+ * next call to insert or erase.
+ */
+
+template <class Info>
+class EdgeTable {
+    public:
+
+    EdgeTable() {
+        count = 0;
+        shift = 64 - 4;
+        Slots.assign(size_t(1) << (64 - shift), Slot(EMPTY));
+    }
+
+    /**
+     * Returns the value stored for the (a,b) edge
+     * or NULL if there is none
+     * Complexity: O(1) (expected)
+     */
+    Info *find(int a, int b) {
+        size_t i = probe(edge_key(a, b));
+        return Slots[i].key() == EMPTY ? NULL : &Slots[i].info;
+    }
+
+    /**
+     * Returns the value stored for the (a,b) edge, creating
+     * a value-initialized entry if there is none
+     * Complexity: O(1) (expected, amortized)
+     */
+    Info *insert(int a, int b) {
+        uint64_t key = edge_key(a, b);
+
+        // keep the load factor at most 1/2
+        if (2 * (size_t(count) + 1) > Slots.size())
+            rehash(shift - 1);
+
+        size_t i = probe(key);
+        if (Slots[i].key() == EMPTY) {
+            Slots[i] = Slot(key);
+            count++;
+        }
+        return &Slots[i].info;
+    }
+
+    /**
+     * Removes the entry pointed to by info (obtained from find
+     * or insert) from the table
+     * Complexity: O(1) (expected)
+     */
+    void erase(Info *info);
+
+    /**
+     * Makes room for the given number of edges, so that
+     * inserting them does not trigger any further rehashing
+     * Complexity: O(edges + size of the table)
+     */
+    void reserve(int edges) {
+        int new_shift = shift;
+        while (2 * size_t(edges) > (size_t(1) << (64 - new_shift)))
+            new_shift--;
+        if (new_shift != shift)
+            rehash(new_shift);
+    }
+
+    /* Returns the number of edges stored in the table */
+    int size() {
+        return count;
+    }
+
+    /**
+     * Calls f(a, b, info) for every entry, where (a,b) is the
+     * edge with a <= b
+     * Complexity: O(capacity of the table)
+     */
+    template <class F>
+    void for_each(F f) {
+        for (Slot &slot: Slots) {
+            if (slot.key() != EMPTY)
+                f(int(slot.a), int(slot.b), slot.info);
+        }
+    }
+
+    private:
+    struct Slot {
+        /* the endpoints a <= b, both UINT32_MAX in an empty slot */
+        uint32_t a, b;
+        Info info;
+
+        Slot(uint64_t key) : a(uint32_t(key >> 32)), b(uint32_t(key)), info() {}
+
+        uint64_t key() const {
+            return (uint64_t(a) << 32) | b;
+        }
+    };
+
+    static constexpr uint64_t EMPTY = UINT64_MAX;
+
+    vector <Slot> Slots;
+    int count;
+    int shift;
+
+    size_t home(uint64_t key) {
+        return edge_hash(key, shift);
+    }
+
+    /**
+     * Returns the index of the slot holding key or of the empty
+     * slot that ends its probe sequence.
+     */
+    size_t probe(uint64_t key) {
+        size_t mask = Slots.size() - 1;
+        size_t i = home(key);
+        while (Slots[i].key() != EMPTY && Slots[i].key() != key) {
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    void rehash(int new_shift);
+};
+
+/**
+ * Backward shift deletion: walks the cluster following the
+ * erased slot and moves back every entry whose home position
+ * does not lie cyclically between the hole and the entry.
+ */
+template <class Info>
+void EdgeTable<Info>::erase(Info *info) {
+    Slot *slot = reinterpret_cast<Slot*>(
+        reinterpret_cast<char*>(info) - offsetof(Slot, info));
+    size_t mask = Slots.size() - 1;
+    size_t hole = slot - Slots.data();
+
+    for (size_t j = (hole + 1) & mask; Slots[j].key() != EMPTY; j = (j + 1) & mask) {
+        size_t h = home(Slots[j].key());
+
+        bool movable = (hole <= j) ? (h <= hole || h > j)
+                                   : (h <= hole && h > j);
+        if (movable) {
+            Slots[hole] = Slots[j];
+            hole = j;
+        }
+    }
+
+    Slots[hole].a = Slots[hole].b = UINT32_MAX;
+    count--;
+}
+
+template <class Info>
+void EdgeTable<Info>::rehash(int new_shift) {
+    vector <Slot> old_slots;
+    old_slots.swap(Slots);
+
+    shift = new_shift;
+    Slots.assign(size_t(1) << (64 - shift), Slot(EMPTY));
+
+    for (Slot &slot: old_slots) {
+        if (slot.key() != EMPTY)
+            Slots[probe(slot.key())] = slot;
+    }
+}
+
+/**
+ * Hash index of edges stored outside of it, e.g. in the nodes
+ * of a forest. A slot holds only the handle of an edge (0 marks
+ * an empty slot and is never a handle), and the endpoints of a
+ * handle h are read from endpoints(h), a function passed to
+ * every call which needs them.
+ *
+ * The layout is that of EdgeTable, but a slot takes only the 4
+ * bytes of a handle; in exchange, every probe of a lookup reads
+ * the endpoints of the handle it passes. The endpoints of a
+ * handle must not change while it is in the index.
+ */
+
+template <class Handle>
+class EdgeIndex {
+    public:
+
+    EdgeIndex() {
+        count = 0;
+        shift = 64 - 4;
+        Slots.assign(size_t(1) << (64 - shift), 0);
+    }
+
+    /**
+     * Returns the handle of the (a,b) edge or 0 if there is none
+     * Complexity: O(1) (expected)
+     */
+    template <class F>
+    Handle find(int a, int b, F endpoints) const {
+        uint64_t key = edge_key(a, b);
+        size_t mask = Slots.size() - 1;
+        size_t i = edge_hash(key, shift);
+        while (Slots[i] != 0 && key_of(Slots[i], endpoints) != key)
+            i = (i + 1) & mask;
+        return Slots[i];
+    }
+
+    /**
+     * Adds the edge with handle h, which must not be in the
+     * index yet
+     * Complexity: O(1) (expected, amortized)
+     */
+    template <class F>
+    void insert(Handle h, F endpoints) {
+        // keep the load factor at most 1/2
+        if (2 * (size_t(count) + 1) > Slots.size())
+            rehash(shift - 1, endpoints);
+
+        Slots[free_slot(key_of(h, endpoints))] = h;
+        count++;
+    }
+
+    /**
+     * Removes the edge with handle h from the index
+     * Complexity: O(1) (expected)
+     */
+    template <class F>
+    void erase(Handle h, F endpoints);
+
+    /**
+     * Makes room for the given number of edges, so that
+     * inserting them does not trigger any further rehashing
+     * Complexity: O(edges + size of the index)
+     */
+    template <class F>
+    void reserve(int edges, F endpoints) {
+        int new_shift = shift;
+        while (2 * size_t(edges) > (size_t(1) << (64 - new_shift)))
+            new_shift--;
+        if (new_shift != shift)
+            rehash(new_shift, endpoints);
+    }
+
+    /* Returns the number of edges in the index */
+    int size() const {
+        return count;
+    }
+
+    private:
+    vector <Handle> Slots;
+    int count;
+    int shift;
+
+    template <class F>
+    static uint64_t key_of(Handle h, F endpoints) {
+        pair <int, int> edge = endpoints(h);
+        return edge_key(edge.first, edge.second);
+    }
+
+    /* Returns the first empty slot of the probe sequence of key */
+    size_t free_slot(uint64_t key) const {
+        size_t mask = Slots.size() - 1;
+        size_t i = edge_hash(key, shift);
+        while (Slots[i] != 0)
+            i = (i + 1) & mask;
+        return i;
+    }
+
+    template <class F>
+    void rehash(int new_shift, F endpoints);
+};
+
+/* Backward shift deletion, as in EdgeTable::erase */
+template <class Handle>
+template <class F>
+void EdgeIndex<Handle>::erase(Handle h, F endpoints) {
+    size_t mask = Slots.size() - 1;
+    size_t hole = edge_hash(key_of(h, endpoints), shift);
+    while (Slots[hole] != h)
+        hole = (hole + 1) & mask;
+
+    for (size_t j = (hole + 1) & mask; Slots[j] != 0; j = (j + 1) & mask) {
+        size_t home = edge_hash(key_of(Slots[j], endpoints), shift);
+
+        bool movable = (hole <= j) ? (home <= hole || home > j)
+                                   : (home <= hole && home > j);
+        if (movable) {
+            Slots[hole] = Slots[j];
+            hole = j;
+        }
+    }
+
+    Slots[hole] = 0;
+    count--;
+}
+
+template <class Handle>
+template <class F>
+void EdgeIndex<Handle>::rehash(int new_shift, F endpoints) {
+    vector <Handle> old_slots;
+    old_slots.swap(Slots);
+
+    shift = new_shift;
+    Slots.assign(size_t(1) << (64 - shift), 0);
+
+    for (Handle h: old_slots) {
+        if (h != 0)
+            Slots[free_slot(key_of(h, endpoints))] = h;
+    }
+}
+
+#endif
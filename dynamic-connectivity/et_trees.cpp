@@ -1,160 +1,1100 @@
+#include <algorithm>
 #include <cstdint>
 #include <set>
 #include "et_trees.hpp"
+#include "union_find.hpp"
+#include "parallel.hpp"
 
-static int64_t edge_id(int a, int b) {
-    return (int64_t(a) << 32) | b;
+template <class Tree>
+ETTForest<Tree>::ETTForest(int _n, bool _sparse) {
+    n = _n;
+    sparse = _sparse;
+    NTFree = -1;
+    nontree_edges = 0;
+    threads = 1;
+    merging = false;
+
+    if (!sparse) {
+        for (int i = 0; i < n; i++) {
+            Tour.new_vertex_node();
+        }
+    }
+}
+
+template <class Tree>
+bool ETTForest<Tree>::empty() {
+    return TEdgeHooks.size() == 0 && nontree_edges == 0;
+}
+
+/* Returns the endpoints of a tree edge given by its first node (for TEdgeHooks) */
+template <class Tree>
+auto ETTForest<Tree>::edge_endpoints() const {
+    return [this](node_t e) {
+        return pair <int, int> (Tour[e + 1].aux, Tour[e].aux);
+    };
 }
 
-ETTForest::ETTForest(int n) {
-    for (int i = 0; i < n; i++) {
-        Vertices.push_back(VertexNode(i));
+/* Returns the node of v or NIL if v has none */
+template <class Tree>
+node_t ETTForest<Tree>::vertex_node(int v) {
+    if (!sparse)
+        return v + 1;
+    if (!VertexNodes.empty())
+        return VertexNodes[v];
+
+    node_t *hook = VertexHooks.find(v, v);
+    return hook == NULL ? NIL : *hook;
+}
+
+/* Returns the node of v, creating it if v has none */
+template <class Tree>
+node_t ETTForest<Tree>::materialize(int v) {
+    if (!sparse)
+        return v + 1;
+
+    if (!VertexNodes.empty()) {
+        if (VertexNodes[v] == NIL)
+            VertexNodes[v] = Tour.new_vertex_node();
+        return VertexNodes[v];
+    }
+
+    node_t *hook = VertexHooks.insert(v, v);
+    node_t x = *hook;
+    if (x == NIL) {
+        x = *hook = Tour.new_vertex_node();
+        // an entry of the table takes at least 24 bytes (a 12-byte
+        // slot at load factor up to 1/2), the array 4 per vertex
+        if (6 * size_t(VertexHooks.size()) > size_t(n))
+            index_vertices();
     }
+    return x;
 }
 
-ETTForest::~ETTForest() {
-    set <AVLNode *> processed;
-    vector <AVLNode *> unused;
+/**
+ * Moves the nodes of the present vertices from VertexHooks to
+ * VertexNodes, which is used from then on; the table is freed.
+ * As it happens once a sixth of the vertices are present, its
+ * O(n) time is amortized over the nodes created before.
+ */
+template <class Tree>
+void ETTForest<Tree>::index_vertices() {
+    VertexNodes.assign(n, NIL);
+    VertexHooks.for_each([&](int v, int, node_t x) {
+        VertexNodes[v] = x;
+    });
+    VertexHooks = EdgeTable <node_t>();
+}
+
+/* Releases the node of v if no edge of the forest is incident to v */
+template <class Tree>
+void ETTForest<Tree>::release_if_isolated(int v) {
+    if (!sparse)
+        return;
 
-    for (auto edge: TEdgeHooks) {        
-        delete edge.second;
+    node_t x = vertex_node(v);
+    const TourNode &node = Tour[x];
+    if (node.parent == NIL && node.left == NIL && node.right == NIL &&
+        node.aux == -1) {
+        Tour.free_vertex_node(x);
+        if (!VertexNodes.empty())
+            VertexNodes[v] = NIL;
+        else
+            VertexHooks.erase(VertexHooks.find(v, v));
     }
 }
 
-void ETTForest::insert_tree_edge(int a, int b, bool on_level) {
-    // it's enough to mark only one of the copies as on the level
-    EdgeNode *ab_edge = new EdgeNode(a,b, on_level);
-    EdgeNode *ba_edge = new EdgeNode(b,a, false);
+template <class Tree>
+pair <int, int> ETTForest<Tree>::insert_tree_edge(int a, int b, bool on_level) {
+    node_t ab_edge = Tour.new_edge_nodes(a, b, on_level);
+    TEdgeHooks.insert(ab_edge, edge_endpoints());
+    node_t x = materialize(a), y = materialize(b);
+    return link_edge_nodes(ab_edge, x, y);
+}
 
-    TEdgeHooks[edge_id(a,b)] = ab_edge;
-    TEdgeHooks[edge_id(b,a)] = ba_edge;
+/**
+ * Links the pair of edge nodes starting at ab_edge, (a,b) and
+ * (b,a), between the nodes x of a and y of b, which are in
+ * different trees, and returns the sizes of the trees it joined.
+ * Touches only the nodes of the two tours (and the hook).
+ */
+template <class Tree>
+pair <int, int> ETTForest<Tree>::link_edge_nodes(node_t ab_edge, node_t x, node_t y) {
+    node_t ba_edge = ab_edge + 1;
 
     // split the Euler tour to the part up to a and after a
-    auto [left_a, right_a] = Vertices[a].split();
+    auto [left_a, right_a] = Tour.split(x);
     // do the same for b
-    auto [left_b, right_b] = Vertices[b].split();    
+    auto [left_b, right_b] = Tour.split(y);
+
+    pair <int, int> sizes = {Tour[left_a].size + Tour[right_a].size,
+                             Tour[left_b].size + Tour[right_b].size};
 
     // create the new Euler tour placing the new edge
     // between vertices a and b or edges with them as endpoints
-    AVLNode::merge(AVLNode::merge(left_a, ab_edge, right_b),
-                   NULL, 
-                   AVLNode::merge(left_b, ba_edge, right_a));
+    Tour.merge(Tour.merge(left_a, ab_edge, right_b),
+               NIL,
+               Tour.merge(left_b, ba_edge, right_a));
+
+    return sizes;
+}
+
+/**
+ * The trees joined by the batch are numbered by their roots,
+ * found before any of them changes, and grouped with union-find:
+ * the edges of a group build a single tree, so they stay on one
+ * thread, while different groups touch disjoint trees.
+ */
+template <class Tree>
+void ETTForest<Tree>::insert_tree_edges(const vector <pair <int, int> > &edges, bool on_level) {
+    int k = edges.size();
+    vector <node_t> nodes(k), ends(2 * k);
+    for (int i = 0; i < k; i++) {
+        auto [a, b] = edges[i];
+        nodes[i] = Tour.new_edge_nodes(a, b, on_level);
+        TEdgeHooks.insert(nodes[i], edge_endpoints());
+        ends[2 * i] = materialize(a);
+        ends[2 * i + 1] = materialize(b);
+    }
+
+    vector <node_t> roots(2 * k);
+    parallel_for(threads, 2 * k, [&](int j) {
+        roots[j] = Tour.find_root(ends[j]);
+    });
+
+    EdgeTable <int> TreeIds;
+    vector <int> tree_of(2 * k);
+    for (int j = 0; j < 2 * k; j++) {
+        int *p = TreeIds.insert(roots[j], roots[j]);
+        if (*p == 0)
+            *p = TreeIds.size();
+        tree_of[j] = *p - 1;
+    }
+    int t_cnt = TreeIds.size();
+    UnionFind Groups(t_cnt);
+    for (int i = 0; i < k; i++)
+        Groups.unite(tree_of[2 * i], tree_of[2 * i + 1]);
+
+    // the edges of each group (CSR)
+    vector <int> start(t_cnt + 1, 0), order(k);
+    for (int i = 0; i < k; i++)
+        start[Groups.find(tree_of[2 * i]) + 1]++;
+    for (int t = 0; t < t_cnt; t++)
+        start[t + 1] += start[t];
+    vector <int> next(start.begin(), start.end() - 1);
+    for (int i = 0; i < k; i++)
+        order[next[Groups.find(tree_of[2 * i])]++] = i;
+
+    parallel_for(threads, t_cnt, [&](int g) {
+        for (int j = start[g]; j < start[g + 1]; j++) {
+            int i = order[j];
+            link_edge_nodes(nodes[i], ends[2 * i], ends[2 * i + 1]);
+        }
+    });
+}
+
+template <class Tree>
+void ETTForest<Tree>::build_trees(const vector <pair <int, int> > &edges) {
+    // adjacency lists in the compressed sparse row format
+    vector <int> start(n + 1, 0), adjacent(2 * edges.size());
+    for (auto [a, b]: edges) {
+        start[a + 1]++;
+        start[b + 1]++;
+    }
+    for (int v = 0; v < n; v++)
+        start[v + 1] += start[v];
+
+    vector <int> pos(start.begin(), start.end() - 1);
+    for (auto [a, b]: edges) {
+        adjacent[pos[a]++] = b;
+        adjacent[pos[b]++] = a;
+    }
+
+    TEdgeHooks.reserve(TEdgeHooks.size() + edges.size(), edge_endpoints());
+
+    // DFS stack: a vertex, the next position in its adjacency
+    // list and the edge node through which it was entered
+    struct Frame {
+        int v, next;
+        node_t in;
+    };
+    vector <Frame> stack;
+    vector <bool> visited(n, false);
+    vector <node_t> tour;
+
+    for (int r = 0; r < n; r++) {
+        if (visited[r] || start[r] == start[r + 1])
+            continue;
+
+        visited[r] = true;
+        tour.clear();
+        tour.push_back(materialize(r));
+        stack.push_back(Frame{r, start[r], NIL});
+
+        while (!stack.empty()) {
+            Frame &top = stack.back();
+
+            if (top.next == start[top.v + 1]) {
+                // return to the parent through the opposite edge
+                if (top.in != NIL)
+                    tour.push_back(top.in + 1);
+                stack.pop_back();
+                continue;
+            }
+
+            int v = top.v, u = adjacent[top.next++];
+            if (visited[u])
+                continue;
+
+            visited[u] = true;
+            node_t e = Tour.new_edge_nodes(v, u, true);
+            TEdgeHooks.insert(e, edge_endpoints());
+
+            tour.push_back(e);
+            tour.push_back(materialize(u));
+            stack.push_back(Frame{u, start[u], e});
+        }
+
+        Tour.build(tour.data(), tour.size());
+    }
+}
+
+template <class Tree>
+node_t ETTForest<Tree>::tree_id(int v) {
+    node_t x = vertex_node(v);
+    return x == NIL ? NIL : Tour.find_root(x);
+}
+
+template <class Tree>
+void ETTForest<Tree>::set_aggregate_hook(typename Tree::hook_type *hook) {
+    Tour.set_aggregate_hook(hook);
+}
+
+template <class Tree>
+void ETTForest<Tree>::set_threads(int _threads) {
+    threads = max(_threads, 1);
+}
 
+template <class Tree>
+void ETTForest<Tree>::update_vertex(int v) {
+    assert(!sparse);
+    // a splay tree brings the node to the root first
+    Tour.root(v + 1);
+    Tour.update_path(v + 1);
 }
 
-void ETTForest::remove_tree_edge(int a, int b) {
-    EdgeNode *ab_edge = TEdgeHooks[edge_id(a,b)];
-    EdgeNode *ba_edge = TEdgeHooks[edge_id(b,a)];
-    TEdgeHooks.erase(edge_id(a,b));
-    TEdgeHooks.erase(edge_id(b,a));
+template <class Tree>
+node_t ETTForest<Tree>::tour_root(int v) {
+    assert(!sparse);
+    return Tour.root(v + 1);
+}
+
+template <class Tree>
+void ETTForest<Tree>::reserve_spanning_forest() {
+    assert(!sparse);
+    // NIL, the vertices and a pair of nodes per tree edge
+    Tour.reserve(1 + n + 2 * max(n - 1, 0));
+}
+
+template <class Tree>
+node_t ETTForest<Tree>::concurrent_root(int v) const {
+    assert(!sparse);
+    // no path in a tree is longer than the number of its nodes
+    return Tour.find_root_concurrent(v + 1, 3 * n);
+}
+
+template <class Tree>
+int ETTForest<Tree>::tree_size(node_t id) const {
+    return id == NIL ? 1 : Tour[id].size;
+}
+
+/**
+ * The trees hit by the batch and the batch edges form a forest
+ * (of trees). Each of its components is laid out by a DFS from
+ * its largest tree (the anchor). At every anchor vertex with
+ * batch edges, the tours of the attached subtrees are emitted
+ * into one sequence: for an edge (v,w), the node (v,w), then
+ * the tour of the tree of w rotated to start at w, with the
+ * subtrees attached to its vertices spliced in after their
+ * vertex nodes, then the node (w,v). The sequence is built into
+ * a tree and inserted after v in the tour of the anchor.
+ */
+template <class Tree>
+void ETTForest<Tree>::link_batch(const vector <pair <int, int> > &edges) {
+    if (edges.empty())
+        return;
+
+    // compact ids of the endpoints, keyed by their vertex nodes
+    EdgeTable <int> Ids;
+    vector <node_t> vertices;
+    auto id = [&](int v) {
+        node_t x = materialize(v);
+        int *p = Ids.insert(x, x);
+        if (*p == 0) {
+            vertices.push_back(x);
+            *p = vertices.size();
+        }
+        return *p - 1;
+    };
+
+    // batch edges incident to each endpoint (CSR): the other
+    // endpoint, the node leaving this endpoint and the node
+    // coming back to it
+    struct Arc {
+        int to;
+        node_t out, back;
+    };
+    vector <pair <int, int> > ends(edges.size());
+    for (size_t i = 0; i < edges.size(); i++)
+        ends[i] = {id(edges[i].first), id(edges[i].second)};
+
+    int k = vertices.size();
+    vector <int> start(k + 1, 0);
+    for (auto [a, b]: ends) {
+        start[a + 1]++;
+        start[b + 1]++;
+    }
+    for (int v = 0; v < k; v++)
+        start[v + 1] += start[v];
+
+    vector <Arc> arcs(2 * edges.size());
+    vector <int> pos(start.begin(), start.end() - 1);
+    for (size_t i = 0; i < edges.size(); i++) {
+        auto [a, b] = edges[i];
+        node_t e = Tour.new_edge_nodes(a, b, true);
+        TEdgeHooks.insert(e, edge_endpoints());
+        arcs[pos[ends[i].first]++] = Arc{ends[i].second, e, e + 1};
+        arcs[pos[ends[i].second]++] = Arc{ends[i].first, e + 1, e};
+    }
+
+    // the trees containing the endpoints
+    EdgeTable <int> TreeIds;
+    vector <node_t> roots;
+    vector <int> tree_of(k);
+    for (int v = 0; v < k; v++) {
+        node_t r = Tour.find_root(vertices[v]);
+        int *p = TreeIds.insert(r, r);
+        if (*p == 0) {
+            roots.push_back(r);
+            *p = roots.size();
+        }
+        tree_of[v] = *p - 1;
+    }
+
+    // the largest tree of each group is the anchor
+    int t_cnt = roots.size();
+    UnionFind Groups(t_cnt);
+    for (auto [a, b]: ends)
+        Groups.unite(tree_of[a], tree_of[b]);
+
+    vector <int> anchor(t_cnt, -1);
+    for (int t = 0; t < t_cnt; t++) {
+        int &g = anchor[Groups.find(t)];
+        if (g == -1 || Tour[roots[t]].size > Tour[roots[g]].size)
+            g = t;
+    }
+
+    // the places of the flattened tours of all the other trees
+    // (a tree of s vertices has 3s - 2 nodes) and the trees of
+    // each group, which are flattened by the thread of the group
+    vector <int> anchor_of(t_cnt);
+    vector <int> flat_start(t_cnt, -1), flat_len(t_cnt, 0);
+    vector <int> member_start(t_cnt + 1, 0), members;
+    size_t flat_size = 0;
+    for (int t = 0; t < t_cnt; t++) {
+        anchor_of[t] = anchor[Groups.find(t)];
+        if (anchor_of[t] == t)
+            continue;
+
+        flat_start[t] = flat_size;
+        flat_len[t] = 3 * Tour[roots[t]].size - 2;
+        flat_size += flat_len[t];
+        member_start[anchor_of[t] + 1]++;
+    }
+    for (int t = 0; t < t_cnt; t++)
+        member_start[t + 1] += member_start[t];
+    members.resize(member_start[t_cnt]);
+    vector <int> next_member(member_start.begin(), member_start.end() - 1);
+    for (int t = 0; t < t_cnt; t++) {
+        if (anchor_of[t] != t)
+            members[next_member[anchor_of[t]]++] = t;
+    }
+    vector <node_t> flat(flat_size);
+    // the positions of the endpoints in the tours of their trees
+    vector <int> offset(k, -1);
 
-    auto [l, r] = ab_edge->split();
-    if (l == ba_edge->root()) {
+    // the anchor vertices of each group, which are split off
+    // the same tree and so stay on the same thread
+    vector <int> group_start(t_cnt + 1, 0), group_vertices;
+    for (int v = 0; v < k; v++) {
+        int t = tree_of[v];
+        if (anchor_of[t] == t)
+            group_start[t + 1]++;
+    }
+    for (int t = 0; t < t_cnt; t++)
+        group_start[t + 1] += group_start[t];
+    group_vertices.resize(group_start[t_cnt]);
+    vector <int> next(group_start.begin(), group_start.end() - 1);
+    for (int v = 0; v < k; v++) {
+        int t = tree_of[v];
+        if (anchor_of[t] == t)
+            group_vertices[next[t]++] = v;
+    }
+
+    // emission of the subtrees attached to the anchor vertices
+    struct Frame {
+        int t, done, first;
+        node_t back;
+        // the endpoint whose arcs are being followed (or -1)
+        int v, next_arc;
+    };
+
+    // the groups touch disjoint trees and nodes
+    parallel_for(threads, t_cnt, [&](int g) {
+        vector <Frame> stack;
+        vector <node_t> seq;
+
+        for (int i = member_start[g]; i < member_start[g + 1]; i++) {
+            int t = members[i];
+            seq.clear();
+            Tour.flatten(roots[t], seq);
+            assert((int) seq.size() == flat_len[t]);
+            copy(seq.begin(), seq.end(), flat.begin() + flat_start[t]);
+
+            for (int j = 0; j < flat_len[t]; j++) {
+                int *p = Ids.find(seq[j], seq[j]);
+                if (p != NULL)
+                    offset[*p - 1] = j;
+            }
+        }
+
+        for (int i = group_start[g]; i < group_start[g + 1]; i++) {
+            int v = group_vertices[i];
+            seq.clear();
+            // a pseudo-frame following the arcs of the anchor vertex
+            stack.push_back(Frame{-1, 0, 0, NIL, v, start[v]});
+
+            while (!stack.empty()) {
+                Frame &top = stack.back();
+
+                if (top.v != -1) {
+                    if (top.next_arc == start[top.v + 1]) {
+                        top.v = -1;
+                        continue;
+                    }
+
+                    Arc arc = arcs[top.next_arc++];
+                    // the arc back to the parent tree
+                    if (arc.out == top.back)
+                        continue;
+
+                    seq.push_back(arc.out);
+                    int u = tree_of[arc.to];
+                    stack.push_back(Frame{u, 0, offset[arc.to], arc.back, -1, 0});
+                    continue;
+                }
+
+                if (top.t == -1 || top.done == flat_len[top.t]) {
+                    if (top.back != NIL)
+                        seq.push_back(top.back);
+                    stack.pop_back();
+                    continue;
+                }
+
+                int j = (top.first + top.done++) % flat_len[top.t];
+                node_t x = flat[flat_start[top.t] + j];
+                seq.push_back(x);
+
+                int *p = Ids.find(x, x);
+                if (p != NULL) {
+                    top.v = *p - 1;
+                    top.next_arc = start[top.v];
+                }
+            }
+
+            // insert the subtrees right after v in the anchor's tour
+            node_t subtrees = Tour.build(seq.data(), seq.size());
+            auto [left, right] = Tour.split(vertices[v]);
+            Tour.merge(Tour.merge(left, NIL, subtrees), NIL, right);
+        }
+    });
+}
+
+template <class Tree>
+pair <int, int> ETTForest<Tree>::remove_tree_edge(int a, int b) {
+    // the pair may have been created as (b,a), but the
+    // procedure below is symmetric
+    node_t ab_edge = TEdgeHooks.find(a, b, edge_endpoints());
+    TEdgeHooks.erase(ab_edge, edge_endpoints());
+
+    pair <int, int> sizes = cut_edge_nodes(ab_edge);
+    // the node ab_edge leads to its target
+    if (Tour[ab_edge].aux != b)
+        swap(sizes.first, sizes.second);
+
+    Tour.free_edge_nodes(ab_edge);
+
+    release_if_isolated(a);
+    release_if_isolated(b);
+    return sizes;
+}
+
+/**
+ * Cuts the pair of edge nodes starting at ab_edge, (a,b) and
+ * (b,a), out of their Euler tour and returns the sizes of the
+ * resulting trees of a and b. Touches only the nodes of the
+ * tour (and the hook).
+ */
+template <class Tree>
+pair <int, int> ETTForest<Tree>::cut_edge_nodes(node_t ab_edge) {
+    node_t ba_edge = ab_edge + 1;
+
+    // the edge nodes do not count towards the sizes, and both
+    // of them are left out of the Euler tours right away
+    auto [l, r] = Tour.split_around(ab_edge);
+    if (l != NIL && Tour.same_tree(l, ba_edge)) {
 
         // the tour routed in lr starts after (b,a) and finishes
-        // at (a,b), so it describes the new connected component
-        // of the vertex a
-        auto [ll, lr] = ba_edge->split();
+        // before (a,b), so it describes the new connected
+        // component of the vertex a
+        auto [ll, lr] = Tour.split_around(ba_edge);
 
         // the rest of the tour describes b's connected component
-        AVLNode::merge(ll, NULL, r);
+        node_t rest = Tour.merge(ll, NIL, r);
+        return {Tour[lr].size, Tour[rest].size};
 
     } else {
-        assert(r == ba_edge->root());
+        assert(r != NIL && Tour.same_tree(r, ba_edge));
 
         // the tour routed in rl starts after (a,b) and finishes
-        // at (b,a), so it describes the new connected component
-        // of the vertex b
-        auto [rl, rr] = ba_edge->split();
+        // before (b,a), so it describes the new connected
+        // component of the vertex b
+        auto [rl, rr] = Tour.split_around(ba_edge);
 
         // the rest of the tour describes a's connected component
-        AVLNode::merge(l, NULL, rr);
+        node_t rest = Tour.merge(l, NIL, rr);
+        return {Tour[rest].size, Tour[rl].size};
+    }
+}
+
+/**
+ * The edges leave the index right away, while their nodes still
+ * hold the endpoints; the nodes are released by finish_cuts, as
+ * the free lists are shared by all the trees.
+ */
+template <class Tree>
+void ETTForest<Tree>::plan_cuts(const vector <pair <int, int> > &edges, size_t k) {
+    CutEdges.resize(k);
+    for (size_t i = 0; i < k; i++) {
+        auto [a, b] = edges[i];
+        node_t e = TEdgeHooks.find(a, b, edge_endpoints());
+        TEdgeHooks.erase(e, edge_endpoints());
+        CutEdges[i] = e;
+    }
+
+    CutNodes.clear();
+    CutOwner.clear();
+    CutGroupStart.assign(1, 0);
+    CutSegments.clear();
+    NextSegments.clear();
+    CutPieces.clear();
+    MergeTasks.clear();
+    merging = false;
+    // on one thread, the rounds would only add to the cuts
+    if (threads <= 1) {
+        for (node_t e: CutEdges)
+            cut_edge_nodes(e);
+        return;
+    }
+
+    // the places of the nodes e, e+1 of the i-th edge (the
+    // entries 2i and 2i+1) in their tours
+    struct Place {
+        node_t root;
+        uint64_t key;
+        int node;
+    };
+    vector <Place> places(2 * k, Place{NIL, 0, 0});
+    vector <char> keyed(2 * k);
+    parallel_for(threads, 2 * k, [&](int j) {
+        places[j].node = j;
+        keyed[j] = Tour.order_key(CutEdges[j / 2] + j % 2, places[j].key,
+                                  places[j].root);
+    });
+    sort(places.begin(), places.end(), [](const Place &x, const Place &y) {
+        return x.root != y.root ? x.root < y.root : x.key < y.key;
+    });
+
+    for (size_t i = 0, j = 0; i < 2 * k; i = j) {
+        bool deep = false;
+        for (; j < 2 * k && places[j].root == places[i].root; j++)
+            deep |= !keyed[places[j].node];
+
+        if (deep) {
+            for (size_t t = i; t < j; t++) {
+                if (places[t].node % 2 == 0)
+                    cut_edge_nodes(CutEdges[places[t].node / 2]);
+            }
+            continue;
+        }
+
+        int g = CutGroupStart.size() - 1;
+        CutSegments.push_back(CutSegment{int(CutNodes.size()),
+                                         int(CutNodes.size() + j - i) - 1, g});
+        for (size_t t = i; t < j; t++) {
+            CutNodes.push_back(CutEdges[places[t].node / 2] + places[t].node % 2);
+            CutOwner.push_back(places[t].node / 2);
+        }
+        CutGroupStart.push_back(CutNodes.size());
+    }
+
+    CutPieces.assign(CutNodes.size() + CutGroupStart.size() - 1, NIL);
+    NextSegments.assign(2 * CutSegments.size(), CutSegment{0, -1, -1});
+}
+
+template <class Tree>
+int ETTForest<Tree>::cut_tasks() const {
+    return merging ? MergeTasks.size() : CutSegments.size();
+}
+
+/**
+ * A split task halves the segment of planned nodes forming its
+ * tree; a side with no planned nodes is a final piece. A merge
+ * task joins two consecutive pieces of a new tour.
+ */
+template <class Tree>
+void ETTForest<Tree>::cut_task(int i) {
+    if (merging) {
+        int x = MergeList[MergeTasks[i]], y = MergeList[MergeTasks[i] + 1];
+        CutPieces[x] = Tour.merge(CutPieces[x], NIL, CutPieces[y]);
+        return;
     }
 
-    // remove both copies of this edge from the Euler tours
-    ab_edge->unlink();
-    ba_edge->unlink();
-    delete ab_edge;
-    delete ba_edge;
+    CutSegment seg = CutSegments[i];
+    int mid = (seg.lo + seg.hi) / 2;
+    auto [l, r] = Tour.split_around(CutNodes[mid]);
+
+    if (mid == seg.lo)
+        CutPieces[mid + seg.group] = l;
+    else
+        NextSegments[2 * i] = CutSegment{seg.lo, mid - 1, seg.group};
+
+    if (mid == seg.hi)
+        CutPieces[mid + 1 + seg.group] = r;
+    else
+        NextSegments[2 * i + 1] = CutSegment{mid + 1, seg.hi, seg.group};
 }
 
-void ETTForest::insert_nontree_edge(int a, int b) {
-    NTEdgeHooks[edge_id(a,b)] = Vertices[a].push_nontree_edge(b);
-    NTEdgeHooks[edge_id(b,a)] = Vertices[b].push_nontree_edge(a);
+template <class Tree>
+void ETTForest<Tree>::next_cut_round() {
+    if (!merging) {
+        CutSegments.clear();
+        for (CutSegment seg: NextSegments) {
+            if (seg.group != -1)
+                CutSegments.push_back(seg);
+        }
+        NextSegments.assign(2 * CutSegments.size(), CutSegment{0, -1, -1});
+        if (!CutSegments.empty())
+            return;
+
+        plan_merges();
+        merging = true;
+
+    } else {
+        // the first piece of every merged pair holds the result
+        int t_cnt = MergeStart.size() - 1, size = 0;
+        for (int t = 0; t < t_cnt; t++) {
+            int first = size;
+            for (int i = MergeStart[t]; i < MergeStart[t + 1]; i += 2)
+                MergeList[size++] = MergeList[i];
+            MergeStart[t] = first;
+        }
+        MergeStart[t_cnt] = size;
+        MergeList.resize(size);
+    }
+
+    MergeTasks.clear();
+    for (size_t t = 0; t + 1 < MergeStart.size(); t++) {
+        for (int i = MergeStart[t]; i + 1 < MergeStart[t + 1]; i += 2)
+            MergeTasks.push_back(i);
+    }
 }
 
-vector <pair <int, int> > ETTForest::promote_tree_edges(int a) {
-    vector <pair <int, int> > edges;
-    pair <int, int> edge;
-    AVLNode *root = Vertices[a].root();
+/**
+ * The pairs of nodes of the edges of a tree are nested in its
+ * tour like parentheses (also in a rotated one). Every edge cuts
+ * out the part of the tour between its nodes, except for the
+ * parts cut out by the edges nested in it, so a piece belongs to
+ * the new tour of the innermost edge around it, or to the rest of
+ * the old tour outside all the edges. The pieces of each new tour
+ * are listed in their order.
+ */
+template <class Tree>
+void ETTForest<Tree>::plan_merges() {
+    // the tour inside the p-th edge is p, the rest of the g-th
+    // old tour is E + g
+    int E = CutEdges.size(), G = CutGroupStart.size() - 1;
+    vector <int> tour_of(CutPieces.size());
+    vector <int> open;
+    for (int g = 0; g < G; g++) {
+        for (int j = CutGroupStart[g]; j < CutGroupStart[g + 1]; j++) {
+            tour_of[j + g] = open.empty() ? E + g : open.back();
+            if (!open.empty() && open.back() == CutOwner[j])
+                open.pop_back();
+            else
+                open.push_back(CutOwner[j]);
+        }
+        assert(open.empty());
+        tour_of[CutGroupStart[g + 1] + g] = E + g;
+    }
 
-    while (root->promote_tree_edge(edge)) {
-        edges.push_back(edge);
+    MergeStart.assign(E + G + 1, 0);
+    for (size_t x = 0; x < CutPieces.size(); x++) {
+        if (CutPieces[x] != NIL)
+            MergeStart[tour_of[x] + 1]++;
+    }
+    for (int t = 0; t < E + G; t++)
+        MergeStart[t + 1] += MergeStart[t];
+
+    MergeList.resize(MergeStart[E + G]);
+    vector <int> next(MergeStart.begin(), MergeStart.end() - 1);
+    for (size_t x = 0; x < CutPieces.size(); x++) {
+        if (CutPieces[x] != NIL)
+            MergeList[next[tour_of[x]]++] = x;
     }
-    return edges;
 }
 
-void ETTForest::remove_nontree_edge(int a, int b) {
-    Vertices[a].erase_nontree_edge(NTEdgeHooks[edge_id(a,b)]);
-    Vertices[b].erase_nontree_edge(NTEdgeHooks[edge_id(b,a)]);
-    NTEdgeHooks.erase(edge_id(a,b));
-    NTEdgeHooks.erase(edge_id(b,a));
+template <class Tree>
+void ETTForest<Tree>::finish_cuts() {
+    for (node_t e: CutEdges) {
+        int a = Tour[e + 1].aux, b = Tour[e].aux;
+        Tour.free_edge_nodes(e);
+        release_if_isolated(a);
+        release_if_isolated(b);
+    }
+    CutEdges.clear();
+    CutNodes.clear();
+    CutPieces.clear();
+    CutOwner.clear();
+    CutGroupStart.clear();
+    CutSegments.clear();
+    MergeList.clear();
+    MergeStart.clear();
+    MergeTasks.clear();
+    merging = false;
 }
 
-bool ETTForest::pop_nontree_edge(int a, pair <int, int> &edge) {
-    AVLNode *root = Vertices[a].root();
+template <class Tree>
+void ETTForest<Tree>::push_nontree_record(int v, int r) {
+    link_nontree_record(materialize(v), r);
+}
 
-    if (!root->pop_nontree_edge(edge))
-        return false;
+/* Pushes the record r on the list headed in the vertex node x */
+template <class Tree>
+void ETTForest<Tree>::link_nontree_record(node_t x, int r) {
+    int head = Tour[x].aux;
+    NTEdges[r].prev = -1;
+    NTEdges[r].next = head;
+    if (head != -1)
+        NTEdges[head].prev = r;
+
+    Tour.set_nontree_head(x, r);
+}
 
-    Vertices[edge.second].erase_nontree_edge(
-        NTEdgeHooks[edge_id(edge.second, edge.first)]);
-    NTEdgeHooks.erase(edge_id(edge.first, edge.second));
-    NTEdgeHooks.erase(edge_id(edge.second, edge.first));
+template <class Tree>
+void ETTForest<Tree>::erase_nontree_record(int v, int r) {
+    if (NTEdges[r].prev != -1)
+        NTEdges[NTEdges[r].prev].next = NTEdges[r].next;
+    else
+        Tour.set_nontree_head(vertex_node(v), NTEdges[r].next);
 
-    return true;
+    if (NTEdges[r].next != -1)
+        NTEdges[NTEdges[r].next].prev = NTEdges[r].prev;
+}
+
+template <class Tree>
+int ETTForest<Tree>::insert_nontree_edge(int a, int b) {
+    int handle = NTFree;
+    if (handle != -1) {
+        NTFree = NTEdges[2*handle].next;
+
+    } else {
+        handle = NTEdges.size() / 2;
+        NTEdges.resize(NTEdges.size() + 2);
+    }
+
+    NTEdges[2*handle].to = b;
+    NTEdges[2*handle + 1].to = a;
+    push_nontree_record(a, 2*handle);
+    push_nontree_record(b, 2*handle + 1);
+    nontree_edges++;
+    return handle;
+}
+
+/**
+ * The handles are allocated as in insert_nontree_edge. A record
+ * only changes the list of its source, the records next to it on
+ * the list and the aggregates of the tree of its source, so the
+ * records of different trees are pushed in parallel.
+ */
+template <class Tree>
+void ETTForest<Tree>::insert_nontree_edges(const vector <pair <int, int> > &edges,
+                                          vector <int> &handles) {
+    int k = edges.size();
+    handles.resize(k);
+    vector <node_t> sources(2 * k);
+    for (int i = 0; i < k; i++) {
+        int handle = NTFree;
+        if (handle != -1) {
+            NTFree = NTEdges[2*handle].next;
+
+        } else {
+            handle = NTEdges.size() / 2;
+            NTEdges.resize(NTEdges.size() + 2);
+        }
+
+        auto [a, b] = edges[i];
+        NTEdges[2*handle].to = b;
+        NTEdges[2*handle + 1].to = a;
+        sources[2 * i] = materialize(a);
+        sources[2 * i + 1] = materialize(b);
+        handles[i] = handle;
+    }
+    nontree_edges += k;
+
+    for_each_by_tree(sources, [&](int j) {
+        link_nontree_record(sources[j], 2 * handles[j / 2] + j % 2);
+    });
+}
+
+/* The records are erased like those of insert_nontree_edges are pushed */
+template <class Tree>
+void ETTForest<Tree>::remove_nontree_edges(const vector <int> &handles) {
+    int k = handles.size();
+    vector <int> records(2 * k);
+    vector <node_t> sources(2 * k);
+    for (int j = 0; j < 2 * k; j++) {
+        records[j] = 2 * handles[j / 2] + j % 2;
+        // the source of each record is the target of its twin
+        sources[j] = vertex_node(NTEdges[records[j] ^ 1].to);
+    }
+
+    for_each_by_tree(sources, [&](int j) {
+        erase_nontree_record(NTEdges[records[j] ^ 1].to, records[j]);
+    });
+
+    for (int handle: handles) {
+        int a = NTEdges[2*handle + 1].to, b = NTEdges[2*handle].to;
+        release_nontree_edge(handle);
+        release_if_isolated(a);
+        release_if_isolated(b);
+    }
+}
+
+/**
+ * Calls f(i) for every i < xs.size(): the indices of the nodes
+ * of one tree one after another on one thread, those of
+ * different trees in parallel
+ */
+template <class Tree>
+template <class F>
+void ETTForest<Tree>::for_each_by_tree(const vector <node_t> &xs, F f) {
+    int k = xs.size();
+    vector <pair <node_t, int> > order(k);
+    parallel_for(threads, k, [&](int i) {
+        order[i] = {Tour.find_root(xs[i]), i};
+    });
+    sort(order.begin(), order.end());
+
+    vector <int> start;
+    for (int i = 0; i < k; i++) {
+        if (i == 0 || order[i].first != order[i - 1].first)
+            start.push_back(i);
+    }
+    start.push_back(k);
+
+    parallel_for(threads, start.size() - 1, [&](int g) {
+        for (int i = start[g]; i < start[g + 1]; i++)
+            f(order[i].second);
+    });
+}
+
+template <class Tree>
+void ETTForest<Tree>::release_nontree_edge(int handle) {
+    NTEdges[2*handle].next = NTFree;
+    NTFree = handle;
+    nontree_edges--;
+}
+
+template <class Tree>
+void ETTForest<Tree>::remove_nontree_edge(int handle) {
+    // the source of each record is the target of its twin
+    int a = NTEdges[2*handle + 1].to;
+    int b = NTEdges[2*handle].to;
+    erase_nontree_record(a, 2*handle);
+    erase_nontree_record(b, 2*handle + 1);
+    release_nontree_edge(handle);
+
+    release_if_isolated(a);
+    release_if_isolated(b);
+}
+
+template <class Tree>
+int ETTForest<Tree>::sample_nontree_edge(int a, uint32_t r, pair <int, int> &edge) {
+    node_t x = vertex_node(a);
+    if (x == NIL)
+        return -1;
+
+    node_t root = Tour.root(x);
+    int k = Tour[root].nontree_cnt;
+    if (k == 0)
+        return -1;
+
+    node_t vertex = Tour.find_nontree_edge(root, r % k);
+    int record = Tour[vertex].aux;
+    edge = {NTEdges[record ^ 1].to, NTEdges[record].to};
+    return record / 2;
+}
+
+template <class Tree>
+int ETTForest<Tree>::next_nontree_edge(NontreeCursor &cursor, pair <int, int> &edge) {
+    if (cursor.record != -1)
+        cursor.record = NTEdges[cursor.record].next;
+
+    if (cursor.record == -1) {
+        node_t x = vertex_node(cursor.vertex);
+        if (x == NIL)
+            return -1;
+
+        node_t root = Tour.root(x);
+        if (cursor.rank >= Tour[root].nontree_cnt)
+            return -1;
+
+        node_t vertex = Tour.find_nontree_edge(root, cursor.rank++);
+        cursor.record = Tour[vertex].aux;
+    }
+
+    int record = cursor.record;
+    edge = {NTEdges[record ^ 1].to, NTEdges[record].to};
+    return record / 2;
 }
 
-bool ETTForest::connected(int a, int b) {
-    return Vertices[a].root() == Vertices[b].root();
+template <class Tree>
+bool ETTForest<Tree>::connected(int a, int b) {
+    if (a == b)
+        return true;
+
+    node_t x = vertex_node(a), y = vertex_node(b);
+    if (x == NIL || y == NIL)
+        return false;
+
+    return Tour.same_tree(x, y);
 }
 
-bool ETTForest::is_tree_edge(int a, int b) {
-    return TEdgeHooks.count(edge_id(a,b)) > 0;
+template <class Tree>
+void ETTForest<Tree>::connected_batch(const vector <pair <int, int> > &queries,
+                                     vector <bool> &answers) {
+    int k = queries.size();
+    answers.resize(k);
+
+    if (Tree::self_adjusting) {
+        for (int i = 0; i < k; i++)
+            answers[i] = connected(queries[i].first, queries[i].second);
+        return;
+    }
+
+    // a vertex without a node has NIL as its root
+    vector <node_t> nodes(2 * k), roots(2 * k);
+    for (int i = 0; i < k; i++) {
+        nodes[2 * i] = vertex_node(queries[i].first);
+        nodes[2 * i + 1] = vertex_node(queries[i].second);
+    }
+    Tour.find_roots(nodes.data(), 2 * k, roots.data());
+
+    for (int i = 0; i < k; i++) {
+        answers[i] = queries[i].first == queries[i].second ||
+                     (roots[2 * i] != NIL && roots[2 * i] == roots[2 * i + 1]);
+    }
 }
 
-int ETTForest::size(int a) {
-    return Vertices[a].root()->size;
+template <class Tree>
+int ETTForest<Tree>::size(int a) {
+    node_t x = vertex_node(a);
+    if (x == NIL)
+        return 1;
+
+    return Tour[Tour.root(x)].size;
 }
 
-void ETTForest::print() {
+template <class Tree>
+void ETTForest<Tree>::print() {
 #ifdef DBG
     debug ("Print the forest:\n");
-    set <AVLNode*> processed;
-    for (auto &v: Vertices) {
-        auto root = v.root();
+    set <node_t> processed;
+    for (int v = 0; v < n; v++) {
+        node_t x = vertex_node(v);
+        if (x == NIL)
+            continue;
+
+        node_t root = Tour.find_root(x);
         if (processed.find(root) == processed.end()) {
             processed.insert(root);
-            root->print_tree();
+            Tour.print_tree(root);
             debug("\n");
         }
     }
 #endif
 }
 
-bool ETTForest::correct() {
-    set<AVLNode *> processed;
-    for (VertexNode &node: Vertices) {
-        AVLNode *root = node.root();
+template <class Tree>
+bool ETTForest<Tree>::correct() {
+
+    // every list links records of its own vertex in both directions
+    int records = 0;
+    for (int v = 0; v < n; v++) {
+        node_t x = vertex_node(v);
+        if (x == NIL)
+            continue;
+
+        // a sparse forest stores only the vertices with edges
+        const TourNode &node = Tour[x];
+        if (sparse && node.parent == NIL && node.left == NIL &&
+            node.right == NIL && node.aux == -1)
+            return false;
+
+        int prev = -1;
+        for (int r = Tour[x].aux; r != -1; r = NTEdges[r].next) {
+            if (NTEdges[r].prev != prev || NTEdges[r ^ 1].to != v)
+                return false;
+            prev = r;
+            records++;
+        }
+    }
+    if (records != 2 * nontree_edges)
+        return false;
+
+    set <node_t> processed;
+    for (int v = 0; v < n; v++) {
+        node_t x = vertex_node(v);
+        if (x == NIL)
+            continue;
+
+        node_t root = Tour.find_root(x);
 
         if (processed.count(root) > 0)
             continue;
 
         processed.insert(root);
-        
-        if (!root->correct_tree(nullptr)) {
+
+        if (!Tour.correct_tree(root, NIL)) {
             return false;
         }
     }
     return true;
-}
\ No newline at end of file
+}
+
+template class ETTForest<AVLTree>;
+template class ETTForest<SplayTree>;
+template class ETTForest<Treap>;
+template class ETTForest<HookedTree<AVLTree> >;
+template class ETTForest<HookedTree<SplayTree> >;
+template class ETTForest<HookedTree<Treap> >;
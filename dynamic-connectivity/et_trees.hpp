@@ -1,74 +1,277 @@
 #ifndef ET_TREES_HPP
 #define ET_TREES_HPP
 
-#include <unordered_map>
 #include <vector>
 #include <cstdint>
 #include <set>
 #include "avl_tree.hpp"
+#include "splay_tree.hpp"
+#include "treap.hpp"
+#include "edge_table.hpp"
 using namespace std;
 
+/**
+ * One direction of a nontree edge, stored in the list of its
+ * source vertex (headed in the vertex node). The lists are
+ * intrusive and index based: prev and next are indices of
+ * records in the same pool (-1 marks the ends of a list). The
+ * two directions of an edge are allocated together at indices
+ * 2k and 2k+1, so the record of the opposite direction is
+ * always at index r ^ 1 and its target is the source of r.
+ */
+struct NontreeRecord {
+    int to;
+    int prev, next;
+};
+
+/**
+ * Position of a walk over the nontree edges of the connected
+ * component of vertex (see next_nontree_edge): the number of
+ * vertices with nontree edges visited so far and the current
+ * record on the list of the last one (-1 before the first).
+ */
+struct NontreeCursor {
+    int vertex;
+    int rank = 0;
+    int record = -1;
+};
+
 /**
  * Euler Tour Tree Forest data structure for storing a forest
  * over n vertices.
  * 
- * Each tree is represented as an Euler tour stored on an AVL
- * tree (avl_tree.hpp). An Euler tour is formed by two EdgeNodes
+ * Each tree is represented as an Euler tour stored on a balanced
+ * sequence tree given by the Tree parameter: AVLTree, SplayTree
+ * or Treap (see tour_tree.hpp). An Euler tour is formed by two edge nodes
  * for every tree edge (one in each direction) and a single
- * VertexNode for each vertex. Since an Euler tour visits a
+ * vertex node for each vertex. Since an Euler tour visits a
  * vertex the same number of times as its degree, there may be
- * many possible positions for a VertexNode in the Euler tour.
+ * many possible positions for a vertex node in the Euler tour.
  * For example, the following a two Euler tours are equivalent:
  * (0,1) ~ (1) ~ (1, 4) ~ (4) ~ (4,1) ~ (1,0)
  * (0,1) ~ (1, 4) ~ (4) ~ (4,1) ~ (1) ~ (1,0)
+ *
+ * A sparse forest creates the node of a vertex only when the
+ * first edge incident to it is stored, and releases it as soon
+ * as the vertex is isolated again (a vertex without a node is
+ * a single-vertex tree). This keeps the memory of a forest
+ * proportional to the number of edges it stores. The nodes of
+ * the vertices are found through a hash table, until so many
+ * vertices have nodes that an array indexed by the vertices
+ * (4 bytes per vertex) takes less memory.
  */
 
+template <class Tree>
 class ETTForest {
     public:
 
-    /* Initializes the data structure for a n-vertex graph */
-    ETTForest(int _n);
+    /**
+     * Initializes the data structure for a n-vertex graph
+     * Complexity: O(n) for a dense forest, O(1) for a sparse one
+     */
+    ETTForest(int n, bool sparse = false);
 
-    ~ETTForest();
+    /**
+     * Checks whether the forest stores no edges
+     * Complexity: O(1)
+     */
+    bool empty();
 
     /**
-     * Stores a nontree edge (a,b)
-     * a and b already need to be in the same connected component
+     * Stores a nontree edge (a,b) and returns its handle, which
+     * identifies the edge in remove_nontree_edge
+     * a and b (a != b) already need to be in the same connected
+     * component
      * Complexity: O(log n)
      */
-    void insert_nontree_edge(int a, int b);
+    int insert_nontree_edge(int a, int b);
+
+    /**
+     * Stores a batch of nontree edges like insert_nontree_edge
+     * and sets handles[i] to the handle of the i-th one. The
+     * handles and the nodes of the endpoints are allocated on
+     * the calling thread; the records are then pushed on the
+     * lists of their vertices in parallel, one tree at a time
+     * per thread (see set_threads).
+     * Complexity: O(k (log n + log k)) where k is the number of
+     * edges; O(k log k) of it on the calling thread
+     */
+    void insert_nontree_edges(const vector <pair <int, int> > &edges,
+                              vector <int> &handles);
 
     /** 
      * Adds a tree edge (a,b) and marks it as being on the
      * level equal to the level of the forest (on_level == true)
      * or on a level above it (on_level == false)
+     * Returns the sizes of the trees of a and b it joined.
      * 
      * a and b need to be in different connected components
      * Compexity: O(log n)
      */
-    void insert_tree_edge(int a, int b, bool on_level);
+    pair <int, int> insert_tree_edge(int a, int b, bool on_level);
 
     /**
-     * Lists all tree edges on the level of the forest
-     * in the connected component containing a and
-     * marks them as being on a level above the forest
-     * 
-     * Complexity: O(k log n) where k is the number of tree edges
-     * being promoted
+     * Adds all edges of a forest as tree edges on the level of
+     * the forest, which must not store any tree edges yet.
+     * Each tree is laid out by a single DFS and its Euler tour
+     * is built bottom-up, without any splits or merges.
+     * Complexity: O(n + k) where k is the number of edges
+     */
+    void build_trees(const vector <pair <int, int> > &edges);
+
+    /**
+     * Adds a batch of tree edges on the level of the forest.
+     * Every edge must join two different trees and the edges
+     * must not form a cycle over the trees.
+     *
+     * In each group of trees joined by the batch, the largest
+     * tree stays in place and is split once per vertex where
+     * others are attached. All the other trees are flattened and
+     * their Euler tours are rebuilt together with the new edges,
+     * so no tree is split or merged more than once per batch.
+     * The groups are flattened, rebuilt and linked in parallel
+     * (see set_threads).
+     * Complexity: O(k log n + s) where k is the number of edges
+     * and s is the total size of the trees that are not the
+     * largest in their group
+     */
+    void link_batch(const vector <pair <int, int> > &edges);
+
+    /**
+     * Adds a batch of tree edges like insert_tree_edge, under the
+     * conditions of link_batch. The nodes of the edges are
+     * allocated and indexed on the calling thread. The edges are
+     * then grouped by the trees they join and the edges of each
+     * group are linked one by one, the groups in parallel (see
+     * set_threads). Unlike link_batch, an edge costs O(log n)
+     * whatever the sizes of the trees it joins, which suits
+     * many edges joining a few large trees.
+     * Complexity: O(k (log n + log k)) where k is the number of
+     * edges; O(k log k) of it on the calling thread
+     */
+    void insert_tree_edges(const vector <pair <int, int> > &edges, bool on_level);
+
+    /**
+     * Sets the number of threads the batches (link_batch,
+     * plan_cuts and the others) may use (1, the default, keeps
+     * them on the calling thread). The groups of trees joined by
+     * a batch share no nodes, so each of them is flattened,
+     * rebuilt and attached to its largest tree by one thread;
+     * plan_cuts places the nodes of the edges in their tours in
+     * parallel and plans the rounds only with more than one
+     * thread. The other batches work on different trees in
+     * parallel.
+     * Complexity: O(1)
+     */
+    void set_threads(int _threads);
+
+    /**
+     * Returns an identifier of the tree containing v which
+     * stays valid until the forest is modified, or NIL if v
+     * is isolated and has no node in a sparse forest
+     * Complexity: O(depth of the node of v)
+     */
+    node_t tree_id(int v);
+
+    /**
+     * Returns the number of vertices of the tree with the given
+     * identifier (see tree_id)
+     * Complexity: O(1)
+     */
+    int tree_size(node_t id) const;
+
+    /**
+     * Calls f(edge) for the tree edges on the level of the forest
+     * in the connected component containing a and marks them as
+     * being on a level above the forest, in a single traversal
+     * of its Euler tour, until f returns false (the edge passed
+     * to it is marked all the same). f must not modify the forest.
+     *
+     * Complexity: O(log n + k log(n/k)) where k is the number of
+     * tree edges being promoted
     */
-    vector <pair <int, int> > promote_tree_edges(int a);
+    template <class F>
+    void promote_tree_edges(int a, F f);
 
     /**
      * Removes a tree edge (a,b) from the forest
+     * Returns the sizes of the resulting trees of a and b.
+     * Complexity: O(log n)
+     */
+    pair <int, int> remove_tree_edge(int a, int b);
+
+    /**
+     * Plans the removal of the first k tree edges of the list,
+     * carried out in rounds: each round runs cut_task(i) for all
+     * i < cut_tasks() and is followed by next_cut_round, until
+     * there are no tasks left; finish_cuts completes the plan.
+     * No other calls may come in between.
+     *
+     * The nodes of the edges are ordered by their places in the
+     * tours (see TourTree::order_key) and every tour is split
+     * around all of them by halving: a task splits one piece of
+     * the tour around its middle planned node. The pieces are
+     * then assigned to the new tours by the nesting of the pairs
+     * of edge nodes, and the pieces of each new tour are merged
+     * pairwise, halving their number in every round. The tasks
+     * of a round touch disjoint trees, so they may run on
+     * different threads at once, also with an aggregate hook.
+     * A tour containing a node too deep for its key (possible in
+     * a splay tree) has its edges cut right away, one by one, and
+     * so have all the tours on one thread (see set_threads).
+     *
+     * Complexity: O(k (log n + log k)) in total, in O(log k)
+     * rounds of tasks of O(log n) each; the ordering of the nodes
+     * and the assignment of the pieces take O(k log k) and O(k)
+     * on one thread
+     */
+    void plan_cuts(const vector <pair <int, int> > &edges, size_t k);
+
+    /**
+     * Returns the number of tasks of the current round of the
+     * plan (0 when all the cuts are made)
+     * Complexity: O(1)
+     */
+    int cut_tasks() const;
+
+    /**
+     * Runs the i-th task of the current round of the plan
      * Complexity: O(log n)
      */
-    void remove_tree_edge(int a, int b);
+    void cut_task(int i);
+
+    /**
+     * Prepares the next round of the plan after all the tasks of
+     * the current one are done
+     * Complexity: O(t) where t is the number of tasks of the
+     * round, and O(k) after the last round of splits
+     */
+    void next_cut_round();
+
+    /**
+     * Releases the nodes of the edges of the plan (and of the
+     * vertices they left isolated in a sparse forest)
+     * Complexity: O(k) where k is the number of planned edges
+     */
+    void finish_cuts();
 
     /**
-     * Removes a nontree edge (a,b) from the forest
+     * Removes the nontree edge with the given handle
+     * from the forest
      * Complexity: O(log n)
      */
-    void remove_nontree_edge(int a, int b);
+    void remove_nontree_edge(int handle);
+
+    /**
+     * Removes the nontree edges with the given handles like
+     * remove_nontree_edge. The records are erased from the lists
+     * of their vertices in parallel, one tree at a time per
+     * thread (see set_threads); the handles are released on the
+     * calling thread.
+     * Complexity: O(k (log n + log k)) where k is the number of
+     * edges; O(k log k) of it on the calling thread
+     */
+    void remove_nontree_edges(const vector <int> &handles);
 
     /**
      * Checks whether vertices a and b are connected
@@ -76,15 +279,54 @@ class ETTForest {
      */
     bool connected(int a, int b);
 
-    bool is_tree_edge(int a, int b);
+    /**
+     * Sets answers[i] to connected(a, b) for the i-th query (a,b)
+     * The root walks of all the queries are interleaved (see
+     * TourTree::find_roots), unless the sequence tree is self
+     * adjusting, whose queries are answered one by one.
+     * Complexity: O(k log n) where k is the number of queries
+     */
+    void connected_batch(const vector <pair <int, int> > &queries,
+                         vector <bool> &answers);
 
     /**
-     * Pops any nontree edge stored in the connected component
-     * of a and returns it in edge parameter
-     * If no such edge exists, returns false, otherwise true
+     * Pops the nontree edges stored in the connected component
+     * of a one by one, in a single traversal of its Euler tour,
+     * and calls f(edge) for each of them (with the endpoint in
+     * the component first) until f returns false. f must not
+     * modify the forest.
+     *
+     * Complexity: O(log n + k log(n/k)) plus O(log n) per edge
+     * whose other endpoint stores no other nontree edge, where k
+     * is the number of vertices with nontree edges visited
+     */
+    template <class F>
+    void pop_nontree_edges(int a, F f);
+
+    /**
+     * Looks at a nontree edge stored in the connected component
+     * of a without removing it: the first edge of the
+     * (r mod k)-th vertex with nontree edges, out of k such
+     * vertices. Returns the handle of the edge and the edge
+     * itself (with the endpoint in the component first) in the
+     * edge parameter, or -1 if the component stores no nontree
+     * edges.
      * Complexity: O(log n)
      */
-    bool pop_nontree_edge(int a, pair <int, int> &edge);
+    int sample_nontree_edge(int a, uint32_t r, pair <int, int> &edge);
+
+    /**
+     * Advances the cursor to the next nontree edge stored in the
+     * connected component of cursor.vertex, visiting the vertices
+     * with nontree edges in the order of the Euler tour. Returns
+     * the handle of the edge and the edge itself (with the
+     * endpoint in the component first) in the edge parameter, or
+     * -1 after the last edge. Nothing is modified, and the cursor
+     * stays valid as long as no edge is inserted or removed.
+     * Complexity: O(1) within the list of a vertex, O(log n) to
+     * move to the next vertex
+     */
+    int next_nontree_edge(NontreeCursor &cursor, pair <int, int> &edge);
 
     /**
      * Returns the number of vertices in the connected component
@@ -93,6 +335,80 @@ class ETTForest {
      */
     int size(int a);
 
+    /**
+     * Calls f(u) for every vertex u in the connected component
+     * of v, in the order of its Euler tour
+     * Only for a dense forest, whose vertex nodes are numbered
+     * by the vertices.
+     * Complexity: O(log n + k) where k is the size of the component
+     */
+    template <class F>
+    void for_each_vertex(int v, F f);
+
+    /**
+     * Calls f(a, b) once for every tree edge (a,b), a < b, in
+     * the connected component of v
+     * Complexity: O(log n + k) where k is the size of the component
+     */
+    template <class F>
+    void for_each_tree_edge(int v, F f);
+
+    /**
+     * Sets the hook maintaining extra aggregates of the Euler
+     * tours (see AggregateHook in tour_tree.hpp); only a forest
+     * over a HookedTree calls it
+     * Complexity: O(1)
+     */
+    void set_aggregate_hook(typename Tree::hook_type *hook);
+
+    /**
+     * Recomputes the extra aggregates which depend on the vertex
+     * node of v after its value changed
+     * Only for a dense forest.
+     * Complexity: O(log n)
+     */
+    void update_vertex(int v);
+
+    /**
+     * Calls f(x) for the vertex node of v and each of its
+     * ancestors, up to the root of its Euler tour, so that
+     * invertible extra aggregates (e.g. sums or XORs) can be
+     * changed in place when only the value of v changes
+     * Only for a dense forest.
+     * Complexity: O(log n)
+     */
+    template <class F>
+    void for_each_ancestor(int v, F f);
+
+    /**
+     * Returns the root of the Euler tour of the connected
+     * component of v, which holds its aggregates
+     * Only for a dense forest.
+     * Complexity: O(log n)
+     */
+    node_t tour_root(int v);
+
+    /**
+     * Reserves the nodes of a spanning tree of all the vertices,
+     * so that the array of nodes of the Euler tours is never
+     * reallocated (see concurrent_root)
+     * Only for a dense forest.
+     * Complexity: O(n)
+     */
+    void reserve_spanning_forest();
+
+    /**
+     * Returns the root of the Euler tour of v like tour_root, but
+     * without restructuring the tour and with atomic loads of the
+     * parent pointers, for readers running concurrently with the
+     * thread updating the forest (which must have reserved the
+     * spanning forest). The result must be validated by the
+     * reader; it is NIL if the walk gave up.
+     * Only for a dense forest.
+     * Complexity: O(depth of the node of v)
+     */
+    node_t concurrent_root(int v) const;
+
     /**
      * Checks whether the invariants of the data structure hold
      * Complexity: O(n log n + m), where m is the number of edges
@@ -103,9 +419,156 @@ class ETTForest {
     void print();
 
     private:
-    unordered_map <int64_t, EdgeNode*> TEdgeHooks;
-    unordered_map <int64_t, list<int>::iterator> NTEdgeHooks;
-    vector <VertexNode> Vertices;
+    int n;
+    bool sparse;
+
+    /* the nodes of all Euler tours; in a dense forest vertex v is the node v+1 */
+    Tree Tour;
+    /* first node of the pair representing a tree edge, whose nodes hold its endpoints */
+    EdgeIndex <node_t> TEdgeHooks;
+    /* sparse forests: nodes of present vertices, keyed by the loop (v,v) */
+    EdgeTable <node_t> VertexHooks;
+    /* sparse forests: the nodes of all vertices (NIL if absent), once it replaces VertexHooks */
+    vector <node_t> VertexNodes;
+
+    /**
+     * Pool of nontree edge records (see NontreeRecord). The handle
+     * of an edge is the index k of its pair of records 2k, 2k+1.
+     * Free pairs form a list linked through the next field of
+     * their first record, starting at NTFree.
+     */
+    vector <NontreeRecord> NTEdges;
+    int NTFree;
+    int nontree_edges;
+
+    /* the threads of the batches */
+    int threads;
+
+    /**
+     * The plan of plan_cuts: the first nodes of the planned edges
+     * and the nodes of those cut in rounds, ordered by their tours
+     * (the g-th tour from CutGroupStart[g]) and their places in
+     * them, with the indices of their edges in CutOwner. The piece
+     * of the g-th tour before its j-th node (or after the last one)
+     * is CutPieces[CutGroupStart[g] + g + j] once split off.
+     */
+    struct CutSegment {
+        // the nodes lo..hi of the group form the tree being split
+        int lo, hi, group;
+    };
+    vector <node_t> CutEdges, CutNodes, CutPieces;
+    vector <int> CutOwner, CutGroupStart;
+    vector <CutSegment> CutSegments, NextSegments;
+    /* the pieces of each new tour at MergeList[MergeStart[t]..], merged at MergeTasks */
+    bool merging;
+    vector <int> MergeList, MergeStart, MergeTasks;
+
+    node_t vertex_node(int v);
+    auto edge_endpoints() const;
+    node_t materialize(int v);
+    void index_vertices();
+    void release_if_isolated(int v);
+    pair <int, int> cut_edge_nodes(node_t ab_edge);
+    pair <int, int> link_edge_nodes(node_t ab_edge, node_t x, node_t y);
+    template <class F>
+    void for_each_by_tree(const vector <node_t> &xs, F f);
+    void plan_merges();
+    void push_nontree_record(int v, int r);
+    void link_nontree_record(node_t x, int r);
+    void erase_nontree_record(int v, int r);
+    void release_nontree_edge(int handle);
 };
 
+template <class Tree>
+template <class F>
+void ETTForest<Tree>::for_each_vertex(int v, F f) {
+    assert(!sparse);
+    Tour.for_each_node(Tour.root(v + 1), [&](node_t x) {
+        if (Tour[x].flags & VERTEX_NODE)
+            f(int(x) - 1);
+    });
+}
+
+/**
+ * The edge nodes of an Euler tour form a closed walk, so the
+ * source of an edge node is the target of the previous one (of
+ * the last one for the first). Each edge is reported in the
+ * direction in which its source is smaller.
+ */
+template <class Tree>
+template <class F>
+void ETTForest<Tree>::for_each_tree_edge(int v, F f) {
+    node_t x = vertex_node(v);
+    if (x == NIL)
+        return;
+
+    int first = -1, previous = -1;
+    Tour.for_each_node(Tour.root(x), [&](node_t y) {
+        if (Tour[y].flags & VERTEX_NODE)
+            return;
+
+        int target = Tour[y].aux;
+        if (previous == -1)
+            first = target;
+        else if (previous < target)
+            f(previous, target);
+        previous = target;
+    });
+
+    if (first != -1 && previous < first)
+        f(previous, first);
+}
+
+template <class Tree>
+template <class F>
+void ETTForest<Tree>::for_each_ancestor(int v, F f) {
+    assert(!sparse);
+    // a splay tree brings the node to the root first
+    Tour.root(v + 1);
+    for (node_t x = v + 1; x != NIL; x = Tour[x].parent)
+        f(x);
+}
+
+template <class Tree>
+template <class F>
+void ETTForest<Tree>::promote_tree_edges(int a, F f) {
+    node_t x = vertex_node(a);
+    if (x != NIL)
+        Tour.take_on_level(Tour.root(x), f);
+}
+
+/**
+ * The traversal hands over the list of each vertex. Its records
+ * are unlinked from the head of the list, while their twins are
+ * erased from the lists of the other endpoints as usual.
+ */
+template <class Tree>
+template <class F>
+void ETTForest<Tree>::pop_nontree_edges(int a, F f) {
+    node_t x = vertex_node(a);
+    if (x == NIL)
+        return;
+
+    Tour.scan_nontree_heads(Tour.root(x), [&](node_t, int &head) {
+        while (head != -1) {
+            int r = head;
+            head = NTEdges[r].next;
+            if (head != -1)
+                NTEdges[head].prev = -1;
+
+            // the source of the record is the target of its twin
+            pair <int, int> edge = {NTEdges[r ^ 1].to, NTEdges[r].to};
+            erase_nontree_record(edge.second, r ^ 1);
+            release_nontree_edge(r / 2);
+            release_if_isolated(edge.second);
+
+            if (!f(edge))
+                return false;
+        }
+        return true;
+    });
+
+    release_if_isolated(a);
+}
+
 #endif
\ No newline at end of file
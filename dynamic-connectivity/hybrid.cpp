@@ -0,0 +1,81 @@
+#include <bits/stdc++.h>
+#include "hybrid.hpp"
+
+HybridConnectivity::HybridConnectivity(int _n) : Components(_n) {
+    n = _n;
+    components = n;
+}
+
+void HybridConnectivity::insert(int a, int b) {
+    if (DC) {
+        DC->insert(a, b);
+        return;
+    }
+
+    // loops never affect connectivity
+    if (a == b)
+        return;
+
+    Log.push_back({a, b});
+    if (Components.unite(a, b))
+        components--;
+}
+
+/**
+ * The first remove replays the log into the bulk load of
+ * DynamicConnectivity, which classifies the edges with its own
+ * union-find, so the one of the insert-only phase is dropped.
+ */
+void HybridConnectivity::remove(int a, int b) {
+    if (!DC) {
+        DC = make_unique <DynamicConnectivity> (n, Log);
+        vector <pair <int, int> >().swap(Log);
+        Components = UnionFind(0);
+    }
+
+    DC->remove(a, b);
+}
+
+bool HybridConnectivity::connected(int a, int b) {
+    if (DC)
+        return DC->connected(a, b);
+    return Components.find(a) == Components.find(b);
+}
+
+int HybridConnectivity::count_components() const {
+    return DC ? DC->count_components() : components;
+}
+
+int HybridConnectivity::component_size(int v) {
+    if (DC)
+        return DC->component_size(v);
+    return Components.size(v);
+}
+
+bool HybridConnectivity::dynamic() const {
+    return DC != nullptr;
+}
+
+bool HybridConnectivity::correct() {
+    if (DC)
+        return DC->correct();
+
+    // the components of the log
+    UnionFind Check(n);
+    int count = n;
+    for (auto [a, b]: Log) {
+        if (Check.unite(a, b))
+            count--;
+    }
+    if (count != components)
+        return false;
+
+    // the same sets: each vertex is with its representative
+    // and the sets are of the same sizes
+    for (int v = 0; v < n; v++) {
+        if (Check.find(v) != Check.find(Components.find(v)) ||
+            Check.size(v) != Components.size(v))
+            return false;
+    }
+    return true;
+}
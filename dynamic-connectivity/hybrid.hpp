@@ -0,0 +1,100 @@
+#ifndef HYBRID_HPP
+#define HYBRID_HPP
+
+#include <vector>
+#include <memory>
+#include "dc.hpp"
+#include "union_find.hpp"
+using namespace std;
+
+/**
+ * Dynamic connectivity for workloads which start with a long
+ * insert-only phase (e.g. ingestion), with the same interface
+ * as DynamicConnectivity.
+ *
+ * While no edge has been removed, the components are kept by
+ * a union-find and the inserted edges are only appended to a
+ * log, so an insertion costs O(alpha(n)) instead of the splits
+ * and merges of the Euler tours of HDT. The first remove builds
+ * DynamicConnectivity from the log with its bulk load (a single
+ * union-find pass and Euler tours built bottom-up) and frees the
+ * union-find and the log; from then on, every call goes to
+ * DynamicConnectivity.
+ *
+ * Memory: 8 bytes per vertex and per logged edge before the
+ * first remove, that of DynamicConnectivity after it.
+ */
+
+class HybridConnectivity {
+    public:
+
+    /**
+     * Initiates the data structure for a n-vertex graph
+     * Complexity: O(n)
+     */
+    HybridConnectivity(int _n);
+
+    /**
+     * Inserts an undirected (a,b) edge to the graph
+     * (parallel edges are supported, loops are ignored)
+     * Complexity: O(alpha(n)) (amortized) before the first
+     * remove, as DynamicConnectivity::insert after it
+     */
+    void insert(int a, int b);
+
+    /**
+     * Removes an undirected (a,b) edge from the graph
+     * If there are multiple such edges, removes only one
+     * Complexity: O(n + m) (expected) for the first remove, where
+     * m is the number of edges inserted so far; as
+     * DynamicConnectivity::remove after it
+     */
+    void remove(int a, int b);
+
+    /**
+     * Checks whether vertices a and b are connected in the graph
+     * Complexity: O(alpha(n)) (amortized) before the first
+     * remove, O(log n) after it
+     */
+    bool connected(int a, int b);
+
+    /**
+     * Returns the number of connected components of the graph
+     * Complexity: O(1)
+     */
+    int count_components() const;
+
+    /**
+     * Returns the number of vertices in the connected component
+     * of v
+     * Complexity: O(alpha(n)) (amortized) before the first
+     * remove, O(log n) after it
+     */
+    int component_size(int v);
+
+    /**
+     * Checks whether the structure has switched to
+     * DynamicConnectivity (after the first remove)
+     * Complexity: O(1)
+     */
+    bool dynamic() const;
+
+    /**
+     * Checks if the invariants of the data structure hold
+     * Complexity: O(n + m) before the first remove, as
+     * DynamicConnectivity::correct after it
+     */
+    bool correct();
+
+    private:
+    int n, components;
+
+    /* the insert-only phase */
+    UnionFind Components;
+    vector <pair <int, int> > Log;
+
+    /* the structure built on the first remove */
+    unique_ptr <DynamicConnectivity> DC;
+};
+
+#endif
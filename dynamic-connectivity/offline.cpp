@@ -0,0 +1,125 @@
+#include <cassert>
+#include "offline.hpp"
+
+OfflineConnectivity::OfflineConnectivity(int _n) {
+    n = _n;
+}
+
+void OfflineConnectivity::insert(int a, int b) {
+    // loops never affect connectivity
+    if (a == b)
+        return;
+
+    OpenEdge *edge = Open.insert(a, b);
+    if (edge->cnt++ == 0)
+        edge->since = Queries.size();
+}
+
+void OfflineConnectivity::remove(int a, int b) {
+    OpenEdge *edge = Open.find(a, b);
+    if (edge == NULL || --edge->cnt > 0)
+        return;
+
+    close(a, b, edge->since);
+    Open.erase(edge);
+}
+
+/* Records the lifetime of an edge, unless no query saw it */
+void OfflineConnectivity::close(int a, int b, int begin) {
+    int end = Queries.size();
+    if (begin < end)
+        Intervals.push_back({a, b, begin, end});
+}
+
+int OfflineConnectivity::connected(int a, int b) {
+    Queries.push_back({a, b});
+    return Queries.size() - 1;
+}
+
+int OfflineConnectivity::count_components() {
+    Queries.push_back({-1, -1});
+    return Queries.size() - 1;
+}
+
+/**
+ * The segment tree is a complete binary tree with the queries
+ * in the leaves; node i has children 2i and 2i+1. Its nodes
+ * store the edges in one array, grouped by a counting sort.
+ */
+void OfflineConnectivity::solve() {
+    Open.for_each([&](int a, int b, OpenEdge &edge) {
+        close(a, b, edge.since);
+    });
+    Open = EdgeTable <OpenEdge>();
+
+    int q = Queries.size();
+    Answers.assign(q, 0);
+    if (q == 0)
+        return;
+
+    int leaves = 1;
+    while (leaves < q)
+        leaves *= 2;
+
+    // the nodes covering [begin, end), bottom up
+    auto for_each_node = [&](const Interval &e, auto f) {
+        for (int l = e.begin + leaves, r = e.end + leaves; l < r; l /= 2, r /= 2) {
+            if (l & 1)
+                f(l++);
+            if (r & 1)
+                f(--r);
+        }
+    };
+
+    NodeStart.assign(2 * leaves + 1, 0);
+    for (const Interval &e: Intervals)
+        for_each_node(e, [&](int node) { NodeStart[node + 1]++; });
+    for (int i = 0; i < 2 * leaves; i++)
+        NodeStart[i + 1] += NodeStart[i];
+
+    NodeEdges.resize(NodeStart.back());
+    vector <int> fill(NodeStart.begin(), NodeStart.end() - 1);
+    for (const Interval &e: Intervals)
+        for_each_node(e, [&](int node) { NodeEdges[fill[node]++] = {e.a, e.b}; });
+    vector <Interval>().swap(Intervals);
+
+    RollbackUnionFind UF(n);
+    answer_queries(1, 0, leaves, UF);
+
+    vector <int>().swap(NodeStart);
+    vector <pair <int, int> >().swap(NodeEdges);
+}
+
+/**
+ * Joins the edges of the node covering the queries [lo, hi) and
+ * descends into its children, then rolls the joins back
+ */
+void OfflineConnectivity::answer_queries(int node, int lo, int hi,
+                                         RollbackUnionFind &UF) {
+    if (lo >= (int) Queries.size())
+        return;
+
+    int checkpoint = UF.checkpoint();
+    for (int i = NodeStart[node]; i < NodeStart[node + 1]; i++)
+        UF.unite(NodeEdges[i].first, NodeEdges[i].second);
+
+    if (hi - lo == 1) {
+        const Query &query = Queries[lo];
+        if (query.a == -1)
+            Answers[lo] = UF.count();
+        else
+            Answers[lo] = UF.find(query.a) == UF.find(query.b);
+
+    } else {
+        int mid = (lo + hi) / 2;
+        answer_queries(2 * node, lo, mid, UF);
+        answer_queries(2 * node + 1, mid, hi, UF);
+    }
+
+    UF.rollback(checkpoint);
+}
+
+int OfflineConnectivity::answer(int query) const {
+    assert(query < (int) Answers.size());
+    return Answers[query];
+}
@@ -0,0 +1,106 @@
+#ifndef OFFLINE_HPP
+#define OFFLINE_HPP
+
+#include <utility>
+#include <vector>
+#include "edge_table.hpp"
+#include "union_find.hpp"
+using namespace std;
+
+/**
+ * Offline dynamic connectivity for operation sequences known
+ * in advance. The operations are only recorded, and solve()
+ * answers all queries together: every edge is alive during an
+ * interval of the queries, which is split into O(log q) nodes
+ * of a segment tree over the queries. A DFS over the segment
+ * tree joins the edges of every node on the path from the root
+ * in a union-find with rollback, so at a leaf it holds exactly
+ * the graph at the time of its query.
+ *
+ * The queries give the same results as DynamicConnectivity
+ * given the same operations (parallel edges are counted and
+ * loops are ignored).
+ */
+
+class OfflineConnectivity {
+    public:
+
+    OfflineConnectivity(int _n);
+
+    /**
+     * Records an insertion of the undirected edge (a,b)
+     * Complexity: O(1) (expected)
+     */
+    void insert(int a, int b);
+
+    /**
+     * Records a removal of one copy of the undirected edge (a,b)
+     * Removing an edge which is not in the graph has no effect.
+     * Complexity: O(1) (expected)
+     */
+    void remove(int a, int b);
+
+    /**
+     * Records a query whether vertices a and b are connected
+     * and returns its index for answer()
+     * Complexity: O(1) (amortized)
+     */
+    int connected(int a, int b);
+
+    /**
+     * Records a query for the number of connected components
+     * and returns its index for answer()
+     * Complexity: O(1) (amortized)
+     */
+    int count_components();
+
+    /**
+     * Answers all queries recorded so far. After this call, no
+     * more operations can be recorded.
+     * Complexity: O(n + q log q log n) where q is the number of
+     * recorded operations, with O(n + q log q) memory
+     */
+    void solve();
+
+    /**
+     * Returns the answer to the query with the given index:
+     * 0 or 1 for connected, the number of components for
+     * count_components
+     * Complexity: O(1)
+     */
+    int answer(int query) const;
+
+    private:
+    struct Query {
+        /* a is -1 for count_components */
+        int a, b;
+    };
+
+    struct OpenEdge {
+        /* number of parallel copies of the edge in the graph */
+        int cnt = 0;
+        /* index of the first query after the edge appeared */
+        int since = 0;
+    };
+
+    struct Interval {
+        int a, b;
+        /* the edge is alive for the queries in [begin, end) */
+        int begin, end;
+    };
+
+    void close(int a, int b, int begin);
+    void answer_queries(int node, int lo, int hi, RollbackUnionFind &UF);
+
+    int n;
+    vector <Query> Queries;
+    vector <int> Answers;
+    vector <Interval> Intervals;
+    EdgeTable <OpenEdge> Open;
+
+    /* the edges of every segment tree node, stored contiguously */
+    vector <int> NodeStart;
+    vector <pair <int, int> > NodeEdges;
+};
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+/**
+ * Threads kept for parallel_for across its calls, so that a call
+ * only wakes them up instead of starting new threads. The workers
+ * are started when a call first needs them and sleep between the
+ * calls; they are stopped at the exit of the program.
+ *
+ * The pool runs one job at a time. A job handed to it while it
+ * runs another (from another thread, or from a job itself) is
+ * refused and its caller runs it alone.
+ */
+
+class WorkerPool {
+    public:
+
+    /* Returns the pool shared by all calls of parallel_for */
+    static WorkerPool &instance() {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    ~WorkerPool() {
+        {
+            lock_guard <mutex> lock(state);
+            stop = true;
+        }
+        wake.notify_all();
+        for (thread &worker: workers)
+            worker.join();
+    }
+
+    /**
+     * Calls f(i) for every i in [0, k) on the calling thread and
+     * the given number of workers, and returns when all calls
+     * have finished; returns false without calling f if the pool
+     * is running another job
+     * Complexity: O(k) calls of f plus O(helpers) to wake up the
+     * workers (and to start those which do not exist yet)
+     */
+    template <class F>
+    bool run(int helpers, int k, F &f) {
+        unique_lock <mutex> own(busy, try_to_lock);
+        if (!own.owns_lock())
+            return false;
+
+        {
+            lock_guard <mutex> lock(state);
+            while ((int) workers.size() < helpers)
+                workers.emplace_back(&WorkerPool::work_loop, this, int(workers.size()));
+
+            job = &f;
+            call = [](void *g, int i) { (*static_cast<F*>(g))(i); };
+            total = k;
+            next = 0;
+            wanted = helpers;
+            active = helpers;
+            generation++;
+        }
+        wake.notify_all();
+
+        work();
+        unique_lock <mutex> lock(state);
+        done.wait(lock, [&]() { return active == 0; });
+        return true;
+    }
+
+    private:
+    /* held by the thread whose job the pool runs */
+    mutex busy;
+
+    /* guards the fields below, except next */
+    mutex state;
+    condition_variable wake, done;
+    vector <thread> workers;
+    bool stop = false;
+    /* the number of jobs so far, so that a worker joins each one once */
+    uint64_t generation = 0;
+    /* the workers 0..wanted-1 take part in the job; active have not finished it */
+    int wanted = 0, active = 0;
+
+    /* the job: call(job, i) for i in [0, total), handed out by next */
+    void *job = NULL;
+    void (*call)(void *, int) = NULL;
+    int total = 0;
+    atomic <int> next;
+
+    WorkerPool() : next(0) {}
+
+    void work() {
+        for (int i = next++; i < total; i = next++)
+            call(job, i);
+    }
+
+    void work_loop(int id) {
+        uint64_t seen = 0;
+        unique_lock <mutex> lock(state);
+        while (true) {
+            wake.wait(lock, [&]() {
+                return stop || (generation != seen && id < wanted);
+            });
+            if (stop)
+                return;
+            seen = generation;
+
+            lock.unlock();
+            work();
+            lock.lock();
+            if (--active == 0)
+                done.notify_one();
+        }
+    }
+};
+
+/**
+ * Calls f(i) for every i in [0, k) on up to the given number of
+ * threads (the calling one included) and returns when all calls
+ * have finished. The indices are handed out one by one, so calls
+ * of different costs are balanced between the threads. The calls
+ * must be independent of each other.
+ * The other threads come from WorkerPool; if it is busy (e.g. f
+ * calls parallel_for itself), f runs on the calling thread only.
+ * Complexity: O(k) calls of f plus O(threads) to wake up the
+ * workers; with threads <= 1 or k <= 1, f runs on the calling
+ * thread only
+ */
+template <class F>
+void parallel_for(int threads, int k, F f) {
+    threads = min(threads, k);
+    if (threads > 1 && WorkerPool::instance().run(threads - 1, k, f))
+        return;
+
+    for (int i = 0; i < k; i++)
+        f(i);
+}
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+using namespace std;
+
+/**
+ * Sequence lock (https://en.wikipedia.org/wiki/Seqlock) for a
+ * single writer and any number of readers, in the form given by
+ * Boehm (https://www.hpl.hp.com/techreports/2012/HPL-2012-68.pdf).
+ *
+ * The sequence number is odd while the writer modifies the
+ * protected data. A reader remembers an even sequence number,
+ * reads the data without taking any lock and validates the
+ * number afterwards: if it changed, the reader saw a write in
+ * progress and must retry. Readers never write shared memory,
+ * so they do not slow each other down or block the writer.
+ *
+ * The readers must load the protected data with (relaxed)
+ * atomic loads and must not trust any of it before validation,
+ * e.g. they must be ready for pointers that lead nowhere. The
+ * writer must store the fields which the readers load with
+ * atomic stores too (see TourTree::set_parent); it may
+ * keep using plain stores for the fields which are never read
+ * concurrently.
+ */
+
+class SeqLock {
+    public:
+
+    SeqLock() : sequence(0) {}
+
+    /**
+     * Marks the beginning of a write (must not be nested)
+     * Complexity: O(1)
+     */
+    void write_begin() {
+        uint64_t s = __atomic_load_n(&sequence, __ATOMIC_RELAXED);
+        __atomic_store_n(&sequence, s + 1, __ATOMIC_RELAXED);
+        // the stores of the write may not be seen before the odd number
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+
+    /**
+     * Marks the end of a write
+     * Complexity: O(1)
+     */
+    void write_end() {
+        uint64_t s = __atomic_load_n(&sequence, __ATOMIC_RELAXED);
+        __atomic_store_n(&sequence, s + 1, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * Waits until no write is in progress and returns the
+     * sequence number to validate the read with
+     * After a short spin, the reader yields its processor, which
+     * may be the one the writer is waiting for.
+     * Complexity: O(1) unless a write is in progress
+     */
+    uint64_t read_begin() const {
+        uint64_t s;
+        for (int spins = 0; (s = __atomic_load_n(&sequence, __ATOMIC_ACQUIRE)) & 1; spins++) {
+            if (spins < 64)
+                pause();
+            else
+                this_thread::yield();
+        }
+        return s;
+    }
+
+    /**
+     * Checks whether no write started since read_begin returned s
+     * Complexity: O(1)
+     */
+    bool read_validate(uint64_t s) const {
+        // the loads of the read may not be seen after the number
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        return __atomic_load_n(&sequence, __ATOMIC_RELAXED) == s;
+    }
+
+    /* Holds the lock for writing (if it is not NULL) in a scope */
+    class WriteGuard {
+        public:
+        WriteGuard(SeqLock *_lock) : lock(_lock) {
+            if (lock != NULL)
+                lock->write_begin();
+        }
+        ~WriteGuard() {
+            if (lock != NULL)
+                lock->write_end();
+        }
+
+        private:
+        SeqLock *lock;
+    };
+
+    private:
+    uint64_t sequence;
+
+    static void pause() {
+        #if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+        #endif
+    }
+};
+
+#endif
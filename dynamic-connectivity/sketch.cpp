@@ -0,0 +1,277 @@
+#include <bits/stdc++.h>
+#include "sketch.hpp"
+
+SketchConnectivity::SketchConnectivity(int _n, int _copies, uint64_t _seed)
+    : Forest(_n), Hook(*this) {
+    n = _n;
+    components = n;
+    copies = _copies;
+    seed = _seed;
+
+    // 3^copies >= n
+    if (copies <= 0) {
+        copies = 1;
+        for (long long power = 3; power < n; power *= 3)
+            copies++;
+    }
+
+    // 2^(K-2) >= n^2 bounds the size of every cut
+    K = 4;
+    while (K < 63 && (1LL << (K - 2)) < (long long) n * n)
+        K++;
+    cells = K * copies;
+
+    // NIL, the vertices and a pair of nodes per tree edge
+    VertexSketches.assign(size_t(n) * cells, Cell{0, 0});
+    Aggregates.assign(size_t(1 + n + 2 * max(n - 1, 0)) * cells, Cell{0, 0});
+    Forest.set_aggregate_hook(&Hook);
+}
+
+uint64_t SketchConnectivity::random_seed() {
+    random_device device;
+    return (uint64_t(device()) << 32) | device();
+}
+
+/**
+ * The i-th hash function: splitmix64
+ * (https://prng.di.unimi.it/splitmix64.c) of the seeded input
+ */
+uint64_t SketchConnectivity::hash(uint64_t x, int i) const {
+    uint64_t z = x + seed + 0x9e3779b97f4a7c15ULL * (i + 1);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Adds the edge (a,b) to the sketches of a and b or removes it
+ * from them (both are the same XOR). The sketch c of an edge
+ * covers the levels up to the number of trailing zeros of the
+ * hash c+1 of its identifier, which is 1 level on average. As
+ * XOR is its own inverse, only these cells of the aggregates on
+ * the paths from a and b to the roots of their tours change
+ * (they are left as they are if tours is false).
+ */
+void SketchConnectivity::toggle(int a, int b, bool tours) {
+    if (a > b)
+        swap(a, b);
+
+    uint64_t id = (uint64_t(a) << 32) | uint64_t(b);
+    uint64_t check = hash(id, 0);
+
+    for (int c = 0; c < copies; c++) {
+        // the bit K-1 caps the levels and keeps the hash nonzero
+        int top = __builtin_ctzll(hash(id, c + 1) | (1ULL << (K - 1)));
+        auto apply = [&](Cell *sketch) {
+            for (int j = 0; j <= top; j++) {
+                sketch[c * K + j].id ^= id;
+                sketch[c * K + j].check ^= check;
+            }
+        };
+
+        for (int v: {a, b}) {
+            apply(&VertexSketches[size_t(v) * cells]);
+            if (tours) {
+                Forest.for_each_ancestor(v, [&](node_t x) {
+                    apply(&Aggregates[size_t(x) * cells]);
+                });
+            }
+        }
+    }
+}
+
+void SketchConnectivity::SketchHook::update(node_t x, node_t left, node_t right) {
+    vector <Cell> &Aggregates = owner.Aggregates;
+    int cells = owner.cells;
+
+    Cell *out = &Aggregates[size_t(x) * cells];
+    const Cell *l = &Aggregates[size_t(left) * cells];
+    const Cell *r = &Aggregates[size_t(right) * cells];
+
+    if (x != NIL && x <= (node_t) owner.n) {
+        const Cell *own = &owner.VertexSketches[size_t(x - 1) * cells];
+        for (int i = 0; i < cells; i++)
+            out[i] = {l[i].id ^ r[i].id ^ own[i].id, l[i].check ^ r[i].check ^ own[i].check};
+    } else {
+        for (int i = 0; i < cells; i++)
+            out[i] = {l[i].id ^ r[i].id, l[i].check ^ r[i].check};
+    }
+}
+
+/**
+ * Looks for a cell of the sketch of the component of a holding
+ * exactly one edge, i.e. one whose checksum is that of its
+ * identifier, starting from the sparsest level. The edge must
+ * still be a nontree edge of the graph leaving the component
+ * (a cell of several edges may pass the checksum by chance).
+ */
+bool SketchConnectivity::decode(const Cell *sketch, int a, pair <int, int> &edge) {
+    for (int c = 0; c < copies; c++) {
+        for (int j = K - 1; j >= 0; j--) {
+            const Cell &cell = sketch[c * K + j];
+            if (cell.id == 0 || cell.check != hash(cell.id, 0))
+                continue;
+
+            int u = cell.id >> 32, v = uint32_t(cell.id);
+            EdgeInfo *info = Edges.find(u, v);
+            if (info != NULL && !info->tree &&
+                Forest.connected(u, a) != Forest.connected(v, a)) {
+                edge = {u, v};
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Resamples the edges for the cuts which no copy of the sketches
+ * decodes: the hash functions get a new seed (derived from the
+ * old one), the sketches of the vertices are rebuilt from the
+ * edges and the aggregates of the Euler tours from them.
+ * Every node on the path from a vertex to its root is recomputed
+ * after the vertex; a node is last recomputed after the last
+ * vertex below it, so from children which are final already.
+ * Complexity: O((m + n log n) log n * copies)
+ */
+void SketchConnectivity::rebuild_sketches() {
+    seed = hash(seed, copies + 1);
+    Stats.rebuilds++;
+
+    VertexSketches.assign(size_t(n) * cells, Cell{0, 0});
+    Edges.for_each([&](int a, int b, EdgeInfo &) {
+        toggle(a, b, false);
+    });
+    for (int v = 0; v < n; v++)
+        Forest.update_vertex(v);
+}
+
+void SketchConnectivity::insert(int a, int b) {
+    // loops never affect connectivity
+    if (a == b)
+        return;
+
+    EdgeInfo *info = Edges.insert(a, b);
+    if (info->cnt++ > 0)
+        return;
+
+    toggle(a, b);
+    if (Forest.connected(a, b)) {
+        info->nontree_hook = Forest.insert_nontree_edge(a, b);
+    } else {
+        info->tree = true;
+        Forest.insert_tree_edge(a, b, false);
+        components--;
+    }
+}
+
+/**
+ * After the tree edge (a,b) is cut, the sketch of the tree of a
+ * holds exactly the edges between the trees of a and b
+ */
+void SketchConnectivity::remove(int a, int b) {
+    EdgeInfo *info = Edges.find(a, b);
+    if (info == NULL || --info->cnt > 0)
+        return;
+
+    bool tree = info->tree;
+    int nontree_hook = info->nontree_hook;
+    Edges.erase(info);
+    toggle(a, b);
+
+    if (!tree) {
+        Forest.remove_nontree_edge(nontree_hook);
+        return;
+    }
+
+    Forest.remove_tree_edge(a, b);
+    Stats.searches++;
+
+    // level 0 holds all the edges
+    const Cell *sketch = &Aggregates[size_t(Forest.tour_root(a)) * cells];
+    if (sketch[0].id == 0 && sketch[0].check == 0) {
+        Stats.empty++;
+        components++;
+        return;
+    }
+
+    // a nonempty cut is decoded with probability at least
+    // 1 - 3^-copies by every new set of hash functions
+    pair <int, int> edge;
+    while (!decode(sketch, a, edge)) {
+        rebuild_sketches();
+        sketch = &Aggregates[size_t(Forest.tour_root(a)) * cells];
+    }
+    Stats.decoded++;
+
+    EdgeInfo *replacement = Edges.find(edge.first, edge.second);
+    Forest.remove_nontree_edge(replacement->nontree_hook);
+    replacement->tree = true;
+    replacement->nontree_hook = -1;
+    Forest.insert_tree_edge(edge.first, edge.second, false);
+}
+
+bool SketchConnectivity::connected(int a, int b) {
+    return Forest.connected(a, b);
+}
+
+int SketchConnectivity::count_components() const {
+    return components;
+}
+
+int SketchConnectivity::component_size(int v) {
+    return Forest.size(v);
+}
+
+const SketchStats &SketchConnectivity::stats() const {
+    return Stats;
+}
+
+bool SketchConnectivity::correct() {
+    if (!Forest.correct())
+        return false;
+
+    // the sketches of the vertices, rebuilt from the edges
+    vector <Cell> vertex_sketches = VertexSketches;
+    VertexSketches.assign(size_t(n) * cells, Cell{0, 0});
+    Edges.for_each([&](int a, int b, EdgeInfo &) {
+        toggle(a, b, false);
+    });
+
+    for (size_t i = 0; i < VertexSketches.size(); i++) {
+        if (VertexSketches[i].id != vertex_sketches[i].id ||
+            VertexSketches[i].check != vertex_sketches[i].check) {
+            debug ("the sketch of vertex %d does not match its edges\n", int(i / cells));
+            return false;
+        }
+    }
+
+    // the sketches of the components and their number
+    map <node_t, vector <Cell> > sums;
+    for (int v = 0; v < n; v++) {
+        vector <Cell> &sum = sums[Forest.tour_root(v)];
+        sum.resize(cells, Cell{0, 0});
+        for (int i = 0; i < cells; i++) {
+            sum[i].id ^= VertexSketches[size_t(v) * cells + i].id;
+            sum[i].check ^= VertexSketches[size_t(v) * cells + i].check;
+        }
+    }
+
+    if ((int) sums.size() != components) {
+        debug ("wrong number of components\n");
+        return false;
+    }
+
+    for (auto &[root, sum]: sums) {
+        for (int i = 0; i < cells; i++) {
+            const Cell &cell = Aggregates[size_t(root) * cells + i];
+            if (cell.id != sum[i].id || cell.check != sum[i].check) {
+                debug ("the sketch of a component does not match its vertices\n");
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,182 @@
+#ifndef SKETCH_HPP
+#define SKETCH_HPP
+
+#include <vector>
+#include <cstdint>
+#include "et_trees.hpp"
+#include "edge_table.hpp"
+using namespace std;
+
+/* Counters of the searches for replacement edges of SketchConnectivity */
+struct SketchStats {
+    /* removed tree edges */
+    long long searches = 0;
+    /* replacements decoded from the sketch of a component */
+    long long decoded = 0;
+    /* searches ended by an empty sketch (no edge leaves the component) */
+    long long empty = 0;
+    /* rebuilds of the sketches with new hash functions after
+       a cut which no copy of them decoded */
+    long long rebuilds = 0;
+};
+
+/**
+ * Dynamic connectivity with cutset sketches, in the style of
+ * Kapron, King and Mountjoy
+ * (https://arxiv.org/abs/1202.4385), as an alternative to the
+ * amortized structure of dc.hpp. It implements the part of the
+ * interface of DynamicConnectivity shared by all the engines:
+ * insert, remove, connected, count_components, component_size
+ * and correct (there are no batches, visitors, events or
+ * policies).
+ *
+ * A single spanning forest is kept on an ETTForest. Every edge
+ * gets a 64-bit identifier and a checksum derived from it by a
+ * hash function, and belongs to the sampling levels 0..t, where
+ * t is the number of trailing zeros of another hash of it, so
+ * level j holds every edge with probability 2^-j. The sketch of
+ * a vertex keeps, for every level, the XOR of the identifiers
+ * and the XOR of the checksums of its edges on that level, and
+ * the Euler tours aggregate the sketches of the vertices.
+ *
+ * In the sketch of a component, an edge with both endpoints in
+ * it cancels out, so only the edges leaving the component
+ * remain. When a tree edge is removed, the sketch of either
+ * part tells that no edge crosses the cut (all cells are zero)
+ * or, on a level with exactly one crossing edge, which edge it
+ * is (its checksum matches). Only if no level holds exactly
+ * one, the sketches are rebuilt with new hash functions, which
+ * sample the edges anew, and decoded again.
+ *
+ * Each of the K = 2 log2(n) + 2 levels has `copies` independent
+ * sketches. A single one decodes a cut of at most 2^(K-2) >= n^2
+ * edges (any cut) unless the highest level of its edges is
+ * shared by two of them, i.e. with probability at least 2/3, so
+ * a rebuild is needed with probability at most 3^-copies. By
+ * default there are ceil(log3 n) copies, which makes the rebuild
+ * a failure path taken with probability at most 1/n per removed
+ * tree edge. The hash functions are seeded at random by default,
+ * so the rebuilds do not depend on the order of the updates;
+ * a fixed seed makes them reproducible (the seeds of the
+ * rebuilds are derived from it).
+ *
+ * Memory: O(K * copies) words per node of the Euler tours, i.e.
+ * per vertex and per tree edge; O(log^2 n) with the default
+ * number of copies.
+ */
+
+class SketchConnectivity {
+    public:
+
+    /**
+     * Initiates the data structure for a n-vertex graph with the
+     * given number of independent sketches on each level (or
+     * ceil(log3 n) of them if it is not positive) and the given
+     * seed of the hash functions
+     * Complexity: O(n log n * copies)
+     */
+    SketchConnectivity(int _n, int _copies = 0, uint64_t _seed = random_seed());
+
+    /**
+     * Returns a seed for the hash functions from random_device
+     * Complexity: O(1)
+     */
+    static uint64_t random_seed();
+
+    /**
+     * Inserts an undirected (a,b) edge to the graph
+     * (parallel edges are supported, loops are ignored)
+     * Complexity: O(log^2 n * copies)
+     */
+    void insert(int a, int b);
+
+    /**
+     * Removes an undirected (a,b) edge from the graph
+     * If there are multiple such edges, removes only one
+     * Complexity: O(log^2 n * copies) unless no level of the
+     * sketches decodes a crossing edge, which happens with
+     * probability at most 3^-copies (1/n by default); then
+     * O((m + n log n) log n * copies) more per rebuild of the
+     * sketches, where m is the number of edges, and the expected
+     * number of rebuilds is at most 1 / (3^copies - 1)
+     */
+    void remove(int a, int b);
+
+    /**
+     * Checks whether vertices a and b are connected in the graph
+     * Complexity: O(log n)
+     */
+    bool connected(int a, int b);
+
+    /**
+     * Returns the number of connected components of the graph
+     * Complexity: O(1)
+     */
+    int count_components() const;
+
+    /**
+     * Returns the number of vertices in the connected component
+     * of v
+     * Complexity: O(log n)
+     */
+    int component_size(int v);
+
+    /**
+     * Returns the counters of the searches for replacement edges
+     * since the structure was created
+     * Complexity: O(1)
+     */
+    const SketchStats &stats() const;
+
+    /**
+     * Checks if the invariants of the data structure hold,
+     * including the sketches of the vertices and components
+     * Complexity: O(n log n * copies + m)
+     */
+    bool correct();
+
+    private:
+    /* what the structure knows about an edge of the graph */
+    struct EdgeInfo {
+        int cnt = 0;
+        bool tree = false;
+        int nontree_hook = -1;
+    };
+
+    /* the XORs of the identifiers and of the checksums of the edges */
+    struct Cell {
+        uint64_t id, check;
+    };
+
+    /* aggregates the sketches of the vertices over the Euler tours */
+    class SketchHook : public AggregateHook {
+        public:
+        SketchHook(SketchConnectivity &_owner) : owner(_owner) {}
+        void update(node_t x, node_t left, node_t right);
+
+        private:
+        SketchConnectivity &owner;
+    };
+
+    int n, components;
+    /* the number of sampling levels and of sketches on each */
+    int K, copies, cells;
+    uint64_t seed;
+
+    ETTForest <HookedTree <AVLTree> > Forest;
+    EdgeTable <EdgeInfo> Edges;
+    SketchHook Hook;
+    SketchStats Stats;
+
+    /* cells of the vertex v at [v * cells, (v+1) * cells) */
+    vector <Cell> VertexSketches;
+    /* cells of the node x of the Euler tours at [x * cells, ...) */
+    vector <Cell> Aggregates;
+
+    uint64_t hash(uint64_t x, int i) const;
+    void toggle(int a, int b, bool tours = true);
+    bool decode(const Cell *sketch, int a, pair <int, int> &edge);
+    void rebuild_sketches();
+};
+
+#endif
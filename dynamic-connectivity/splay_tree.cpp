@@ -0,0 +1,183 @@
+#include "splay_tree.hpp"
+
+/**
+ * Rotates x above its parent, keeping the order of the nodes
+ */
+template <class Hook>
+void BasicSplayTree<Hook>::rotate(node_t x) {
+    node_t p = Nodes[x].parent, g = Nodes[p].parent, middle;
+
+    if (Nodes[p].left == x) {
+        middle = Nodes[x].right;
+        Nodes[p].left = middle;
+        Nodes[x].right = p;
+
+    } else {
+        middle = Nodes[x].left;
+        Nodes[p].right = middle;
+        Nodes[x].left = p;
+    }
+
+    if (middle != NIL)
+        set_parent(middle, p);
+
+    set_parent(p, x);
+    set_parent(x, g);
+    if (g != NIL)
+        replace_child(g, p, x);
+
+    update_aggregates(p);
+    update_aggregates(x);
+}
+
+/**
+ * Moves x to the root with the zig-zig and zig-zag steps
+ */
+template <class Hook>
+void BasicSplayTree<Hook>::splay(node_t x) {
+    while (Nodes[x].parent != NIL) {
+        node_t p = Nodes[x].parent, g = Nodes[p].parent;
+
+        if (g != NIL) {
+            bool zig_zig = (Nodes[g].left == p) == (Nodes[p].left == x);
+            rotate(zig_zig ? p : x);
+        }
+        rotate(x);
+    }
+}
+
+template <class Hook>
+node_t BasicSplayTree<Hook>::root(node_t x) {
+    splay(x);
+    return x;
+}
+
+/**
+ * After splaying y, x is the root of its tree
+ * only if it belongs to a different tree than y
+ */
+template <class Hook>
+bool BasicSplayTree<Hook>::same_tree(node_t x, node_t y) {
+    if (x == y)
+        return true;
+
+    splay(x);
+    splay(y);
+    return Nodes[x].parent != NIL;
+}
+
+template <class Hook>
+pair <node_t, node_t> BasicSplayTree<Hook>::split(node_t x) {
+    splay(x);
+
+    node_t right = Nodes[x].right;
+    if (right != NIL) {
+        set_parent(right, NIL);
+        Nodes[x].right = NIL;
+        update_aggregates(x);
+    }
+
+    return {x, right};
+}
+
+template <class Hook>
+pair <node_t, node_t> BasicSplayTree<Hook>::split_around(node_t x) {
+    splay(x);
+
+    node_t left = Nodes[x].left, right = Nodes[x].right;
+    if (left != NIL)
+        set_parent(left, NIL);
+    if (right != NIL)
+        set_parent(right, NIL);
+
+    Nodes[x].left = Nodes[x].right = NIL;
+    update_aggregates(x);
+    return {left, right};
+}
+
+template <class Hook>
+node_t BasicSplayTree<Hook>::merge(node_t left, node_t middle, node_t right) {
+
+    if (middle != NIL) {
+        Nodes[middle].left = left;
+        Nodes[middle].right = right;
+        if (left != NIL)
+            set_parent(left, middle);
+        if (right != NIL)
+            set_parent(right, middle);
+
+        update_aggregates(middle);
+        return middle;
+    }
+
+    if (left == NIL)
+        return right;
+    if (right == NIL)
+        return left;
+
+    // the last node of left becomes the root without a right child
+    node_t last = left;
+    while (Nodes[last].right != NIL) {
+        last = Nodes[last].right;
+    }
+    splay(last);
+
+    Nodes[last].right = right;
+    set_parent(right, last);
+    update_aggregates(last);
+    return last;
+}
+
+template <class Hook>
+void BasicSplayTree<Hook>::unlink(node_t x) {
+    splay(x);
+
+    node_t left = Nodes[x].left, right = Nodes[x].right;
+    if (left != NIL)
+        set_parent(left, NIL);
+    if (right != NIL)
+        set_parent(right, NIL);
+
+    merge(left, NIL, right);
+
+    Nodes[x].left = Nodes[x].right = NIL;
+    update_aggregates(x);
+}
+
+template <class Hook>
+node_t BasicSplayTree<Hook>::build(const node_t *seq, int k) {
+    return build_balanced(seq, k);
+}
+
+template <class Hook>
+node_t BasicSplayTree<Hook>::find_nontree_edge(node_t x, int r) {
+    node_t vertex = descend_to_nontree_edge(x, r);
+    if (vertex != NIL)
+        splay(vertex);
+    return vertex;
+}
+
+template <class Hook>
+void BasicSplayTree<Hook>::set_nontree_head(node_t x, int head) {
+    // as the root, x is the only node whose counter changes
+    splay(x);
+    Base::set_nontree_head(x, head);
+}
+
+template <class Hook>
+bool BasicSplayTree<Hook>::correct_tree(node_t x, node_t correct_parent) const {
+    const TourNode &node = Nodes[x];
+
+    if (!correct_node(x, correct_parent))
+        return false;
+
+    if (node.left != NIL && !correct_tree(node.left, x))
+        return false;
+    if (node.right != NIL && !correct_tree(node.right, x))
+        return false;
+
+    return true;
+}
+
+template class BasicSplayTree<NoHook>;
+template class BasicSplayTree<AggregateHook>;
@@ -0,0 +1,155 @@
+#ifndef SPLAY_TREE_HPP
+#define SPLAY_TREE_HPP
+
+#include <utility>
+#include "tour_tree.hpp"
+using namespace std;
+
+/**
+ * Splay tree implementation
+ * (https://en.wikipedia.org/wiki/Splay_tree)
+ * over an array of TourNodes.
+ *
+ * Every operation splays the node it accesses to the root, so
+ * recently used parts of the Euler tours stay near the roots.
+ * A merge with a middle node and a split take just a splay and
+ * O(1) relinking, which makes link and cut cheap. All the bounds
+ * below are amortized over a sequence of operations.
+ * Hook is the policy of the extra aggregates (see TourTree).
+ */
+
+template <class Hook = NoHook>
+class BasicSplayTree : public TourTree <Hook> {
+    typedef TourTree <Hook> Base;
+
+    public:
+    template <class OtherHook>
+    using with_hook = BasicSplayTree <OtherHook>;
+
+    /* every access splays the node it reaches */
+    static constexpr bool self_adjusting = true;
+
+    /**
+     * Splits the tree into two parts and returns their roots.
+     * The first part contains all nodes to the left of x
+     * (inclusive), the second part contains all nodes to the
+     * right of it (exclusive).
+     *
+     * Complexity: O(log n) (amortized)
+     */
+    pair <node_t, node_t> split(node_t x);
+
+    /**
+     * Removes x from its tree and splits the rest of it into
+     * the nodes to the left and to the right of x (exclusive)
+     *
+     * Complexity: O(log n) (amortized)
+     */
+    pair <node_t, node_t> split_around(node_t x);
+
+    /**
+     * Merges two trees (left and right) into one (the middle
+     * node is optional) and returns its root.
+     * The order of nodes is as follows:
+     * left(unchanged), middle, right(unchanged).
+     *
+     * Complexity if middle is NIL: O(log n) (amortized)
+     * Complexity if middle is not NIL: O(1)
+     */
+    node_t merge(node_t left, node_t middle, node_t right);
+
+    /**
+     * Splays x to the root of its tree and returns it
+     *
+     * Complexity: O(log n) (amortized)
+     */
+    node_t root(node_t x);
+
+    /**
+     * Checks whether x and y belong to the same tree
+     *
+     * Complexity: O(log n) (amortized)
+     */
+    bool same_tree(node_t x, node_t y);
+
+    /**
+     * Removes x from the tree it belongs to
+     *
+     * Complexity: O(log n) (amortized)
+     */
+    void unlink(node_t x);
+
+    /**
+     * Builds a tree from the single-node trees seq[0..k-1]
+     * (in this order) and returns its root
+     *
+     * Complexity: O(k)
+     */
+    node_t build(const node_t *seq, int k);
+
+    /**
+     * As in TourTree, but every node found is splayed to the root
+     * (which pays for the descent to it) and the next one is
+     * looked for from there
+     */
+    node_t find_nontree_edge(node_t x, int r);
+    template <class F>
+    void scan_nontree_heads(node_t x, F f);
+    template <class F>
+    void take_on_level(node_t x, F f);
+    void set_nontree_head(node_t x, int head);
+
+    /**
+     * Checks if the invariants hold in the subtree of x
+     *
+     * Complexity: linear in the size of the tree
+     */
+    bool correct_tree(node_t x, node_t correct_parent) const;
+
+    private:
+    using Base::Nodes;
+    using Base::set_parent;
+    using Base::update_aggregates;
+    using Base::replace_child;
+    using Base::build_balanced;
+    using Base::correct_node;
+    using Base::descend_to_nontree_edge;
+    using Base::descend_to_on_level;
+    using Base::unmark_on_level;
+
+    void rotate(node_t x);
+    void splay(node_t x);
+};
+
+template <class Hook>
+template <class F>
+void BasicSplayTree<Hook>::scan_nontree_heads(node_t x, F f) {
+    node_t v = descend_to_nontree_edge(x);
+    while (v != NIL) {
+        splay(v);
+        int head = Nodes[v].aux;
+        bool more = f(v, head);
+
+        // f may have splayed other nodes
+        set_nontree_head(v, head);
+        if (!more)
+            return;
+        v = descend_to_nontree_edge(v);
+    }
+}
+
+template <class Hook>
+template <class F>
+void BasicSplayTree<Hook>::take_on_level(node_t x, F f) {
+    node_t cur = descend_to_on_level(x);
+    while (cur != NIL) {
+        splay(cur);
+        if (!f(unmark_on_level(cur)))
+            return;
+        cur = descend_to_on_level(cur);
+    }
+}
+
+typedef BasicSplayTree <> SplayTree;
+
+#endif
@@ -2,8 +2,20 @@
 #include <cassert>
 #include <cstdio>
 #include <set>
+#include <map>
 #include <queue>
+#include <tuple>
+#include <algorithm>
+#include <climits>
+#include <atomic>
+#include <random>
+#include <thread>
 #include "dc.hpp"
+#include "offline.hpp"
+#include "aggregate.hpp"
+#include "sketch.hpp"
+#include "hybrid.hpp"
+#include "batch_dc.hpp"
 
 #define test_debug(...) {}
 //#define test_debug(...) fprintf(stderr, __VA_ARGS__), fflush(stderr)
@@ -29,6 +41,46 @@ class NaiveConnectivity {
             Edges[b].erase(a);
     }
 
+    set <int> component(int a) {
+        set <int> Visited = {a};
+        queue <int> Q;
+        Q.push(a);
+
+        while (!Q.empty()) {
+            int v = Q.front();
+            Q.pop();
+            for (auto it: Edges[v]) {
+                if (Visited.insert(it.first).second)
+                    Q.push(it.first);
+            }
+        }
+        return Visited;
+    }
+
+    int component_size(int a) {
+        return component(a).size();
+    }
+
+    /* the sizes of all the components in non-increasing order */
+    vector <int> component_sizes() {
+        vector <int> sizes;
+        vector <bool> seen(Edges.size(), false);
+        for (int v = 0; v < (int) Edges.size(); v++) {
+            if (seen[v])
+                continue;
+            set <int> C = component(v);
+            for (int u: C)
+                seen[u] = true;
+            sizes.push_back(C.size());
+        }
+        sort(sizes.rbegin(), sizes.rend());
+        return sizes;
+    }
+
+    bool has_edge(int a, int b) {
+        return Edges[a].count(b) > 0;
+    }
+
     bool connected(int a, int b) {
         set <int> Visited;
         queue <int> Q;
@@ -115,11 +167,64 @@ vector <pair <char, pair <int, int> > > gen_test(int n, int q, int seed) {
     return test;
 }
 
-bool check_correctness(int n, vector <pair <char, pair <int, int> > > test) {
+/**
+ * Generates alternating runs of insertions and removals (of
+ * random lengths, at most k) separated by a few queries; the
+ * runs form the batches in check_batches
+ */
+vector <pair <char, pair <int, int> > > gen_batch_test(int n, int rounds, int k, int seed) {
+    srand(seed);
+    vector <pair <char, pair <int, int> > > test;
+    vector <pair <int, int> > edges;
+
+    for (int i = 0; i < rounds; i++) {
+        int cnt = 1 + rand() % k;
+        if (i % 2 == 0) {
+            for (int j = 0; j < cnt && (int) edges.size() < 2 * n; j++) {
+                int a = rand() % n, b = rand() % n;
+                // repeat some edges to get parallel ones
+                if (!edges.empty() && rand() % 8 == 0)
+                    tie(a, b) = edges[rand() % edges.size()];
+                if (a == b)
+                    continue;
+                edges.push_back({a, b});
+                test.push_back({'I', {a, b}});
+            }
+        } else {
+            for (int j = 0; j < cnt && !edges.empty(); j++) {
+                swap(edges[rand() % edges.size()], edges.back());
+                test.push_back({'R', edges.back()});
+                edges.pop_back();
+            }
+        }
+
+        for (int j = 0; j < 5; j++)
+            test.push_back({'Q', {rand() % n, rand() % n}});
+    }
+    return test;
+}
+
+/* Random edges (including loops and parallel edges) */
+vector <pair <int, int> > gen_edges(int n, int m, int seed) {
+    srand(seed);
+    vector <pair <int, int> > edges(m);
+    for (auto &e: edges)
+        e = {rand() % n, rand() % n};
+    return edges;
+}
+
+template <class Tree = AVLTree>
+bool check_correctness(int n, vector <pair <char, pair <int, int> > > test,
+                       const vector <pair <int, int> > &initial = {}) {
     NaiveConnectivity NC(n);
-    DynamicConnectivity DC(n);
+    BasicDynamicConnectivity <Tree> DC(n, initial);
     int idx = 0;
 
+    for (auto e: initial) {
+        if (e.first != e.second)
+            NC.insert(e.first, e.second);
+    }
+
     for (auto p: test) {
         idx++;
         if (p.first == 'I') {
@@ -151,8 +256,10 @@ bool check_correctness(int n, vector <pair <char, pair <int, int> > > test) {
     return true;
 }
 
-bool verify_execution(int n, vector <pair <char, pair <int, int> > > test) {
-    DynamicConnectivity DC(n);
+template <class Tree = AVLTree>
+bool verify_execution(int n, vector <pair <char, pair <int, int> > > test,
+                      const vector <pair <int, int> > &initial = {}) {
+    BasicDynamicConnectivity <Tree> DC(n, initial);
     int idx = 0;
 
     if (!DC.correct())
@@ -177,9 +284,989 @@ bool verify_execution(int n, vector <pair <char, pair <int, int> > > test) {
     return true;
 }
 
+/* The callbacks of run_test which do nothing */
+struct NoConfigure {
+    template <class Engine>
+    void operator()(Engine &) const {}
+};
+
+struct NoCheck {
+    bool operator()(size_t) const {
+        return true;
+    }
+};
+
+/* A configure callback of run_test setting the given options */
+auto with_options(const ConnectivityOptions &options) {
+    return [options](auto &E) { E.set_options(options); };
+}
+
+/**
+ * The fixture shared by the tests of the engines below: calls
+ * configure(E) and then applies the operations of the test to
+ * the engine E and to the naive structure NC, which must hold
+ * the same graph, comparing the answers of connected at every
+ * query. After the i-th operation, check(i) may compare anything
+ * else or make the engine do more work; the test fails as soon
+ * as it returns false.
+ */
+template <class Engine, class Configure = NoConfigure, class Check = NoCheck>
+bool run_test(Engine &E, NaiveConnectivity &NC,
+              const vector <pair <char, pair <int, int> > > &test,
+              Configure configure = Configure(), Check check = Check()) {
+    configure(E);
+
+    for (size_t i = 0; i < test.size(); i++) {
+        int a = test[i].second.first, b = test[i].second.second;
+        if (test[i].first == 'I') {
+            NC.insert(a, b);
+            E.insert(a, b);
+        }
+
+        if (test[i].first == 'R') {
+            NC.remove(a, b);
+            E.remove(a, b);
+        }
+
+        if (test[i].first == 'Q' && NC.connected(a, b) != E.connected(a, b))
+            return false;
+
+        if (!check(i))
+            return false;
+    }
+    return true;
+}
+
+/* The counters of the search of remove_batch, where it has them */
+template <class DC>
+bool check_batch_search(DC &) {
+    return true;
+}
+
+template <class Tree>
+bool check_batch_search(BasicBatchDynamicConnectivity <Tree> &DC) {
+    const BatchSearchStats &stats = DC.batch_search_stats();
+    return stats.hits > 0 && stats.hits <= stats.searches &&
+           stats.rounds <= stats.searches;
+}
+
+/**
+ * Applies the operations of the test in batches: maximal runs of
+ * insertions (and of removals) form a single batch. Checks the
+ * invariants after every batch and the answers to the queries.
+ * The batches use the given number of threads; with the batch
+ * engine, some fragments must be joined by its probes.
+ */
+template <class DC = DynamicConnectivity>
+bool check_batches(int n, vector <pair <char, pair <int, int> > > test,
+                   int threads = 1) {
+    NaiveConnectivity NC(n);
+    DC D(n);
+    ConnectivityOptions options;
+    options.threads = threads;
+    D.set_options(options);
+    vector <pair <int, int> > batch;
+
+    for (size_t i = 0; i < test.size(); i++) {
+        char type = test[i].first;
+        auto e = test[i].second;
+
+        if (type == 'Q') {
+            if (NC.connected(e.first, e.second) != D.connected(e.first, e.second))
+                return false;
+            continue;
+        }
+
+        batch.push_back(e);
+        if (type == 'I')
+            NC.insert(e.first, e.second);
+        else
+            NC.remove(e.first, e.second);
+
+        if (i + 1 == test.size() || test[i + 1].first != type) {
+            if (type == 'I')
+                D.insert_batch(batch);
+            else
+                D.remove_batch(batch);
+            batch.clear();
+
+            if (!D.correct() ||
+                (int) NC.component_sizes().size() != D.count_components())
+                return false;
+        }
+    }
+
+    return check_batch_search(D);
+}
+
+/**
+ * Records the operations in OfflineConnectivity and compares its
+ * answers with those of DynamicConnectivity, together with the
+ * number of components maintained from the online answers
+ * (which DynamicConnectivity also reports itself)
+ */
+bool check_offline(int n, vector <pair <char, pair <int, int> > > test) {
+    DynamicConnectivity DC(n);
+    OfflineConnectivity OC(n);
+    // query indices with the expected answers
+    vector <pair <int, int> > expected;
+    int components = n;
+
+    for (auto p: test) {
+        int a = p.second.first, b = p.second.second;
+        if (p.first == 'I') {
+            if (!DC.connected(a, b))
+                components--;
+            DC.insert(a, b);
+            OC.insert(a, b);
+        }
+
+        if (p.first == 'R') {
+            bool was_connected = DC.connected(a, b);
+            DC.remove(a, b);
+            OC.remove(a, b);
+            if (was_connected && !DC.connected(a, b))
+                components++;
+        }
+
+        if (p.first == 'Q') {
+            if (DC.count_components() != components)
+                return false;
+            expected.push_back({OC.connected(a, b), DC.connected(a, b)});
+            expected.push_back({OC.count_components(), components});
+        }
+    }
+
+    OC.solve();
+    for (auto [query, answer]: expected) {
+        if (OC.answer(query) != answer) {
+            test_debug ("Error: query %d answered %d instead of %d\n", query, OC.answer(query), answer);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Checks the statistics of the components on a small graph */
+bool check_components() {
+    DynamicConnectivity DC(6, {{0, 1}, {1, 2}, {3, 4}});
+    if (DC.count_components() != 3 || DC.component_size(2) != 3 ||
+        DC.largest_component() != 3 ||
+        DC.largest_components(10) != vector <int> {3, 2, 1})
+        return false;
+
+    DC.insert(0, 2);
+    DC.remove(0, 1);
+    DC.remove(3, 4);
+    if (DC.count_components() != 4 || DC.component_size(1) != 3 ||
+        DC.largest_components(2) != vector <int> {3, 1})
+        return false;
+
+    DC.remove_batch({{0, 2}, {1, 2}});
+    DC.insert_batch({{3, 4}, {4, 5}, {3, 5}});
+    return DC.count_components() == 4 && DC.largest_component() == 3 &&
+           DC.largest_components(4) == vector <int> {3, 1, 1, 1} &&
+           DC.correct();
+}
+
+/**
+ * Runs the test with the sampling of replacement edges and the
+ * interleaved search turned on as given, comparing the answers
+ * with the naive structure and checking the invariants, and
+ * checks that the strategy enabled first found some replacements
+ */
+template <class Tree = AVLTree>
+bool check_replacement_search(int n, vector <pair <char, pair <int, int> > > test,
+                              int samples, int budget) {
+    NaiveConnectivity NC(n);
+    BasicDynamicConnectivity <Tree> DC(n);
+    ConnectivityOptions options;
+    options.samples = samples;
+    options.interleaved_budget = budget;
+    bool passed = run_test(DC, NC, test, with_options(options), [&](size_t i) {
+        return test[i].first != 'R' || DC.correct();
+    });
+    if (!passed)
+        return false;
+
+    const SamplingStats &sampling = DC.sampling_stats();
+    if (samples > 0 && (sampling.hits == 0 || sampling.hits > sampling.searches ||
+                        sampling.samples > (long long) samples * sampling.searches))
+        return false;
+
+    // the sampling leaves few searches to the interleaved one
+    const InterleavedStats &interleaved = DC.interleaved_stats();
+    long long hits = interleaved.hits_smaller + interleaved.hits_larger;
+    if (budget > 0 && ((samples == 0 && hits == 0) ||
+                       hits + interleaved.no_replacement > interleaved.searches ||
+                       interleaved.edges > (long long) budget * interleaved.searches))
+        return false;
+
+    return true;
+}
+
+/**
+ * Runs the test with the given remove budget (and the sampling
+ * and the interleaved search turned on as given), continuing the
+ * pending removes by a step after every other operation, and
+ * compares the answers, the component sizes and the statistics
+ * of the components (also while a remove is pending) with the
+ * naive structure. Checks that some removes were left pending.
+ */
+template <class Tree = AVLTree>
+bool check_bounded_remove(int n, vector <pair <char, pair <int, int> > > test, int budget,
+                          int samples = 0, int interleaved_budget = 0) {
+    NaiveConnectivity NC(n);
+    BasicDynamicConnectivity <Tree> DC(n);
+    ConnectivityOptions options;
+    options.remove_budget = budget;
+    options.samples = samples;
+    options.interleaved_budget = interleaved_budget;
+    int pending = 0;
+
+    bool passed = run_test(DC, NC, test, with_options(options), [&](size_t i) {
+        int a = test[i].second.first;
+        if (test[i].first == 'R')
+            pending += DC.pending();
+
+        if (test[i].first == 'Q' && i % 4 == 0 &&
+            (int) NC.component(a).size() != DC.component_size(a))
+            return false;
+
+        if (test[i].first == 'R' && i % 4 == 1) {
+            vector <int> sizes = NC.component_sizes();
+            if (DC.count_components() != (int) sizes.size() ||
+                DC.largest_component() != sizes[0] ||
+                DC.largest_components(n) != sizes)
+                return false;
+        }
+
+        if (i % 2 == 0)
+            DC.step();
+        return true;
+    });
+
+    return passed && DC.correct() && !DC.pending() && pending > 0;
+}
+
+/**
+ * With a remove budget of 0, cuts the cycle 0 - 1 - 2 - 3 - 0 at
+ * (1,2), so that the search for the replacement (3,0) is left
+ * pending. A query within a side of the cut must not finish it;
+ * a query across the cut must, and must see the replacement.
+ * Then the same with no replacement left.
+ */
+template <class Tree = AVLTree>
+bool check_zero_budget() {
+    BasicDynamicConnectivity <Tree> DC(4, {{0, 1}, {1, 2}, {2, 3}, {3, 0}});
+    ConnectivityOptions options;
+    options.remove_budget = 0;
+    DC.set_options(options);
+
+    DC.remove(1, 2);
+    if (!DC.pending() || !DC.connected(0, 1) || !DC.pending() ||
+        !DC.connected(1, 2) || DC.pending() || DC.count_components() != 1)
+        return false;
+
+    DC.remove(3, 0);
+    if (!DC.pending() || DC.connected(1, 2) || DC.pending())
+        return false;
+    return DC.count_components() == 2 && DC.component_size(0) == 2 && DC.correct();
+}
+
+/**
+ * Checks which combinations of the policies are accepted (see
+ * BasicDynamicConnectivity::valid)
+ */
+template <class Tree = AVLTree>
+bool check_options() {
+    typedef BasicDynamicConnectivity <Tree> DC;
+    ConnectivityOptions options;
+    if (!DC::valid(options))
+        return false;
+
+    // the searches of remove combine with its budget
+    for (int budget: {-1, 0, 1, 16}) {
+        options.remove_budget = budget;
+        options.samples = 4;
+        options.interleaved_budget = 8;
+        options.threads = 4;
+        if (!DC::valid(options))
+            return false;
+    }
+
+    // the readers need F_0 to match the graph and to keep
+    // its shape during their walks
+    options = ConnectivityOptions();
+    options.concurrent_reads = true;
+    if (DC::valid(options) == Tree::self_adjusting)
+        return false;
+    for (int budget: {0, 1, 16}) {
+        options.remove_budget = budget;
+        if (DC::valid(options))
+            return false;
+    }
+
+    // the counts must not be negative and a thread is needed
+    ConnectivityOptions samples, interleaved, threads;
+    samples.samples = -1;
+    interleaved.interleaved_budget = -1;
+    threads.threads = 0;
+    return !DC::valid(samples) && !DC::valid(interleaved) && !DC::valid(threads);
+}
+
+/**
+ * Runs the test on SketchConnectivity, comparing the answers
+ * with the naive structure and checking the invariants after
+ * every remove. Checks that some replacements were decoded from
+ * the sketches and, with a single copy of them, that some cuts
+ * needed a rebuild of the sketches (copies = 0 selects the
+ * default number of copies). The hash functions get a fixed
+ * seed, so that the test is reproducible.
+ */
+bool check_sketch(int n, vector <pair <char, pair <int, int> > > test, int copies, uint64_t seed) {
+    NaiveConnectivity NC(n);
+    SketchConnectivity SC(n, copies, seed);
+    bool passed = run_test(SC, NC, test, NoConfigure(), [&](size_t i) {
+        return test[i].first != 'R' || SC.correct();
+    });
+    if (!passed)
+        return false;
+
+    const SketchStats &stats = SC.stats();
+    return stats.decoded > 0 && stats.empty > 0 &&
+           (copies != 1 || stats.rebuilds > 0) &&
+           stats.decoded + stats.empty == stats.searches;
+}
+
+/**
+ * Runs the test on any engine through the interface shared by
+ * all of them (insert, remove, connected, count_components,
+ * component_size and correct), comparing the answers with the
+ * naive structure
+ */
+template <class Engine>
+bool check_engine(int n, vector <pair <char, pair <int, int> > > test) {
+    NaiveConnectivity NC(n);
+    Engine E(n);
+    bool passed = run_test(E, NC, test, NoConfigure(), [&](size_t i) {
+        int a = test[i].second.first;
+        if (test[i].first != 'Q')
+            return true;
+        return NC.component_size(a) == E.component_size(a) &&
+               (i % 8 != 0 || (int) NC.component_sizes().size() == E.count_components());
+    });
+
+    return passed && E.correct();
+}
+
+/**
+ * Cuts the path 0 - 1 - 2 - 3 with the nontree edges (0,2) and
+ * (1,3) in the middle, with a single copy of the sketches and
+ * each of the given seeds. Both edges cross the cut, so the
+ * sketch of a side decodes neither of them when their highest
+ * levels are equal (with probability 1/3). Checks that some
+ * seeds needed a rebuild and that the cut is always reconnected.
+ */
+bool check_sketch_collision(int seeds) {
+    long long rebuilds = 0;
+    for (int seed = 0; seed < seeds; seed++) {
+        SketchConnectivity SC(4, 1, seed);
+        for (auto [a, b]: {make_pair(0, 1), {1, 2}, {2, 3}, {0, 2}, {1, 3}})
+            SC.insert(a, b);
+
+        SC.remove(1, 2);
+        if (!SC.connected(0, 3) || SC.count_components() != 1 || !SC.correct())
+            return false;
+        rebuilds += SC.stats().rebuilds;
+    }
+
+    return rebuilds > 0;
+}
+
+/**
+ * Runs the test with the queries between two updates answered
+ * by a single connected_batch and compares the answers with the
+ * naive structure. A random pair is added to every batch, so
+ * that the batches are not too short.
+ */
+template <class Tree = AVLTree>
+bool check_connected_batch(int n, vector <pair <char, pair <int, int> > > test) {
+    NaiveConnectivity NC(n);
+    BasicDynamicConnectivity <Tree> DC(n);
+    vector <pair <int, int> > queries;
+    vector <bool> answers;
+
+    return run_test(DC, NC, test, NoConfigure(), [&](size_t i) {
+        if (test[i].first == 'Q')
+            queries.push_back(test[i].second);
+        if (i + 1 < test.size() && test[i + 1].first == 'Q')
+            return true;
+
+        queries.push_back({rand() % n, rand() % n});
+        DC.connected_batch(queries, answers);
+        for (size_t j = 0; j < queries.size(); j++) {
+            if (answers[j] != NC.connected(queries[j].first, queries[j].second))
+                return false;
+        }
+        queries.clear();
+        return true;
+    });
+}
+
+/**
+ * Updates a graph with n vertices from this thread while the
+ * given number of reader threads call concurrent_connected.
+ * Each half of the vertices has a core, a quarter of the
+ * vertices spanned by a star of edges which are never removed,
+ * and random edges are inserted and removed (one by one and in
+ * batches) within the halves. The readers check that any two
+ * vertices of a core are connected and that no two vertices of
+ * different halves are. At the end, the answers of the readers
+ * are compared with connected() on random pairs. Nothing may
+ * be left pending.
+ */
+template <class Tree = AVLTree>
+bool check_concurrent_reads(int n, int updates, int readers, int seed) {
+    BasicDynamicConnectivity <Tree> DC(n);
+    ConnectivityOptions options;
+    options.concurrent_reads = true;
+    DC.set_options(options);
+
+    int half = n / 2, core = n / 4;
+    for (int v = 1; v < core; v++) {
+        DC.insert(0, v);
+        DC.insert(half, half + v);
+    }
+
+    atomic <bool> done(false);
+    atomic <long long> reads(0), errors(0);
+    vector <thread> threads;
+    for (int r = 0; r < readers; r++) {
+        threads.emplace_back([&, r]() {
+            minstd_rand gen(seed * 64 + r);
+            long long cnt = 0;
+            do {
+                int a = gen() % n, b = gen() % n;
+                bool same_half = (a < half) == (b < half);
+                bool same_core = same_half && a % half < core && b % half < core;
+                bool connected = DC.concurrent_connected(a, b);
+                if ((same_core && !connected) || (!same_half && connected))
+                    errors++;
+                cnt++;
+            } while (!done);
+            reads += cnt;
+        });
+    }
+
+    srand(seed);
+    vector <pair <int, int> > edges;
+    bool pending = false;
+    for (int i = 0; i < updates; i++) {
+        int offset = rand() % 2 * half;
+        int t = rand() % 16;
+
+        if (t < 7) {
+            edges.push_back({offset + rand() % half, offset + rand() % half});
+            DC.insert(edges.back().first, edges.back().second);
+        } else if (t < 14 && !edges.empty()) {
+            swap(edges[rand() % edges.size()], edges.back());
+            DC.remove(edges.back().first, edges.back().second);
+            edges.pop_back();
+        } else if (edges.size() >= 8) {
+            vector <pair <int, int> > batch(edges.end() - 8, edges.end());
+            edges.resize(edges.size() - 8);
+            DC.remove_batch(batch);
+            DC.insert_batch({batch.begin(), batch.begin() + 4});
+            edges.insert(edges.end(), batch.begin(), batch.begin() + 4);
+        }
+
+        pending |= DC.pending();
+    }
+
+    done = true;
+    for (thread &t: threads)
+        t.join();
+
+    for (int i = 0; i < 1000; i++) {
+        int a = rand() % n, b = rand() % n;
+        if (DC.concurrent_connected(a, b) != DC.connected(a, b))
+            return false;
+    }
+
+    return errors == 0 && reads > 0 && !pending && DC.correct();
+}
+
+/**
+ * Inserts the initial edges into HybridConnectivity one by one,
+ * checking the connectivity and the component sizes on the way,
+ * and then runs the test, which switches it to
+ * DynamicConnectivity at its first removal
+ */
+bool check_hybrid(int n, const vector <pair <int, int> > &initial,
+                  vector <pair <char, pair <int, int> > > test) {
+    NaiveConnectivity NC(n);
+    HybridConnectivity HC(n);
+
+    for (size_t i = 0; i < initial.size(); i++) {
+        auto [a, b] = initial[i];
+        NC.insert(a, b);
+        HC.insert(a, b);
+        if (NC.connected(a, (a + b) % n) != HC.connected(a, (a + b) % n) ||
+            (int) NC.component(b).size() != HC.component_size(b))
+            return false;
+    }
+    if (HC.dynamic() || !HC.correct())
+        return false;
+
+    bool removed = false;
+    bool passed = run_test(HC, NC, test, NoConfigure(), [&](size_t i) {
+        removed |= test[i].first == 'R';
+        return true;
+    });
+    if (!passed)
+        return false;
+
+    int components = 0;
+    for (int v = 0; v < n; v++)
+        components += *NC.component(v).begin() == v;
+    return HC.dynamic() == removed && HC.correct() &&
+           HC.count_components() == components;
+}
+
+/**
+ * Makes a remove of an edge which was never inserted the first
+ * remove of HybridConnectivity, on the empty graph and after some
+ * insertions: it switches to DynamicConnectivity without changing
+ * the graph
+ */
+bool check_hybrid_missing_remove() {
+    HybridConnectivity Empty(3);
+    Empty.remove(0, 1);
+    if (!Empty.dynamic() || Empty.count_components() != 3 ||
+        Empty.connected(0, 1) || !Empty.correct())
+        return false;
+
+    HybridConnectivity HC(5);
+    for (auto [a, b]: {make_pair(0, 1), {1, 2}, {3, 4}})
+        HC.insert(a, b);
+    HC.remove(0, 2);
+    HC.remove(2, 2);
+    if (!HC.dynamic() || HC.count_components() != 2 || !HC.connected(0, 2) ||
+        HC.component_size(3) != 2 || !HC.correct())
+        return false;
+
+    HC.remove(1, 2);
+    HC.insert(2, 3);
+    return HC.count_components() == 2 && HC.connected(2, 4) &&
+           !HC.connected(0, 2) && HC.correct();
+}
+
+/**
+ * Checks the merge and split events: a single update reports
+ * exactly the change of the components seen by the naive
+ * structure, and the events of a batch add up to the change
+ * of the number of components
+ */
+template <class Tree = AVLTree>
+bool check_events(int n, vector <pair <char, pair <int, int> > > test, bool batches) {
+    NaiveConnectivity NC(n);
+    BasicDynamicConnectivity <Tree> DC(n);
+    vector <ComponentEvent> events;
+    DC.set_event_handler([&](const ComponentEvent &e) { events.push_back(e); });
+    vector <pair <int, int> > batch;
+    int components = n;
+
+    for (size_t i = 0; i < test.size(); i++) {
+        char type = test[i].first;
+        int a = test[i].second.first, b = test[i].second.second;
+        if (type == 'Q')
+            continue;
+
+        events.clear();
+        if (batches) {
+            batch.push_back({a, b});
+            if (type == 'I')
+                NC.insert(a, b);
+            else
+                NC.remove(a, b);
+            if (i + 1 < test.size() && test[i + 1].first == type)
+                continue;
+
+            if (type == 'I')
+                DC.insert_batch(batch);
+            else
+                DC.remove_batch(batch);
+            batch.clear();
+
+            for (auto e: events) {
+                if (e.type == ComponentEvent::SPLIT &&
+                    NC.component_size(e.b) != e.size_b)
+                    return false;
+                components += e.type == ComponentEvent::SPLIT ? 1 : -1;
+            }
+            if (components != DC.count_components())
+                return false;
+            continue;
+        }
+
+        pair <int, int> sizes = {NC.component_size(a), NC.component_size(b)};
+        bool merge = type == 'I' && !NC.connected(a, b);
+        if (type == 'I') {
+            NC.insert(a, b);
+            DC.insert(a, b);
+        } else {
+            NC.remove(a, b);
+            DC.remove(a, b);
+        }
+        bool split = type == 'R' && !NC.connected(a, b);
+        if (split)
+            sizes = {NC.component_size(a), NC.component_size(b)};
+
+        if (events.size() != size_t(merge || split))
+            return false;
+        if (!events.empty()) {
+            ComponentEvent e = events[0];
+            if (e.type != (merge ? ComponentEvent::MERGE : ComponentEvent::SPLIT) ||
+                make_pair(e.a, e.b) != make_pair(a, b) ||
+                make_pair(e.size_a, e.size_b) != sizes)
+                return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * At every query, checks that the vertices listed for the
+ * component of a are exactly those found by the naive structure
+ * and that the tree edges listed form its spanning tree
+ */
+template <class Tree = AVLTree>
+bool check_enumeration(int n, vector <pair <char, pair <int, int> > > test) {
+    NaiveConnectivity NC(n);
+    BasicDynamicConnectivity <Tree> DC(n);
+
+    return run_test(DC, NC, test, NoConfigure(), [&](size_t i) {
+        int a = test[i].second.first;
+        if (test[i].first != 'Q')
+            return true;
+
+        set <int> component = NC.component(a), vertices;
+        DC.for_each_vertex(a, [&](int v) { vertices.insert(v); });
+        if (vertices != component)
+            return false;
+
+        UnionFind UF(n);
+        int edges = 0;
+        bool ok = true;
+        DC.for_each_tree_edge(a, [&](int u, int v) {
+            ok &= NC.has_edge(u, v) && component.count(u) && UF.unite(u, v);
+            edges++;
+        });
+        return ok && edges == (int) component.size() - 1;
+    });
+}
+
+/* The sum, minimum and maximum of the values at once */
+struct SumMinMax {
+    typedef tuple <long long, int, int> value_type;
+
+    static value_type identity() {
+        return {0, INT_MAX, INT_MIN};
+    }
+
+    static value_type combine(const value_type &a, const value_type &b) {
+        return {get<0>(a) + get<0>(b), min(get<1>(a), get<1>(b)),
+                max(get<2>(a), get<2>(b))};
+    }
+};
+
+/**
+ * Sets a random value of a vertex at every query and compares the
+ * aggregate over the component of the other one with the values
+ * summed up over the component found by the naive structure
+ */
+template <class Tree = AVLTree>
+bool check_aggregates(int n, vector <pair <char, pair <int, int> > > test,
+                      const vector <pair <int, int> > &initial = {}) {
+    NaiveConnectivity NC(n);
+    AggregatedDynamicConnectivity <Tree, SumMinMax> DC(n, initial);
+    vector <int> values(n, 0);
+
+    for (auto e: initial) {
+        if (e.first != e.second)
+            NC.insert(e.first, e.second);
+    }
+    for (int v = 0; v < n; v++) {
+        values[v] = rand() % 1000;
+        DC.set_vertex_value(v, {values[v], values[v], values[v]});
+    }
+
+    return run_test(DC, NC, test, NoConfigure(), [&](size_t i) {
+        int a = test[i].second.first, b = test[i].second.second;
+        if (test[i].first != 'Q')
+            return true;
+
+        values[b] = rand() % 1000 - 500;
+        DC.set_vertex_value(b, {values[b], values[b], values[b]});
+
+        SumMinMax::value_type expected = SumMinMax::identity();
+        for (int v: NC.component(a)) {
+            expected = SumMinMax::combine(expected,
+                                          {values[v], values[v], values[v]});
+        }
+        return DC.component_aggregate(a) == expected;
+    });
+}
+
+/**
+ * Builds a random spanning tree with a few more edges and removes
+ * the tree edges in a few large batches with the given number of
+ * threads, so that many cuts of a batch fall into one Euler tour.
+ * Compares the connectivity and the aggregates of the components
+ * (kept by a hook of F_0) with a union-find of the other edges.
+ */
+template <class Tree = AVLTree>
+bool check_bulk_cuts(int n, int batches, int threads, int seed) {
+    srand(seed);
+    vector <pair <int, int> > tree, extra;
+    for (int v = 1; v < n; v++)
+        tree.push_back({rand() % v, v});
+    for (int i = 0; i < n / 8; i++)
+        extra.push_back({rand() % n, rand() % n});
+    shuffle(tree.begin(), tree.end(), mt19937(seed));
+
+    AggregatedDynamicConnectivity <Tree, SumMinMax> DC(n, tree);
+    ConnectivityOptions options;
+    options.threads = threads;
+    DC.set_options(options);
+    for (auto [a, b]: extra)
+        DC.insert(a, b);
+
+    vector <int> values(n);
+    for (int v = 0; v < n; v++) {
+        values[v] = rand() % 1000;
+        DC.set_vertex_value(v, {values[v], values[v], values[v]});
+    }
+
+    size_t removed = 0;
+    for (int i = 1; i <= batches; i++) {
+        size_t until = tree.size() * i / (batches + 1);
+        DC.remove_batch(vector <pair <int, int> > (tree.begin() + removed,
+                                                   tree.begin() + until));
+        removed = until;
+        if (!DC.correct())
+            return false;
+
+        UnionFind UF(n);
+        for (size_t j = removed; j < tree.size(); j++)
+            UF.unite(tree[j].first, tree[j].second);
+        for (auto [a, b]: extra)
+            UF.unite(a, b);
+
+        vector <SumMinMax::value_type> expected(n, SumMinMax::identity());
+        for (int v = 0; v < n; v++) {
+            auto &sum = expected[UF.find(v)];
+            sum = SumMinMax::combine(sum, {values[v], values[v], values[v]});
+        }
+        for (int v = 0; v < n; v++) {
+            int u = rand() % n;
+            if (DC.connected(u, v) != (UF.find(u) == UF.find(v)) ||
+                DC.component_aggregate(v) != expected[UF.find(v)])
+                return false;
+        }
+    }
+    return true;
+}
+
+/* Checks that the tree rooted in root holds exactly seq */
+template <class Tree>
+bool check_sequence(Tree &tree, node_t root, const vector <node_t> &seq) {
+    vector <node_t> nodes;
+    tree.for_each_node(root, [&](node_t x) { nodes.push_back(x); });
+    if (root != NIL && !tree.correct_tree(root, NIL))
+        return false;
+    return nodes == seq;
+}
+
+/**
+ * Splits random sequences of nodes (also around a node or by
+ * unlinking it) and merges random pairs of them (with or without
+ * a middle node), comparing the trees with vectors
+ */
+template <class Tree = AVLTree>
+bool check_sequence_tree(int n, int q, int seed) {
+    srand(seed);
+    Tree tree;
+    vector <vector <node_t> > seqs(n);
+    for (auto &seq: seqs)
+        seq.push_back(tree.new_vertex_node());
+
+    for (int i = 0; i < q; i++) {
+        int s = rand() % seqs.size(), type = rand() % 4;
+        vector <node_t> seq = seqs[s];
+        int p = rand() % seq.size();
+        node_t x = seq[p];
+
+        if (type == 0) {
+            // merge with another sequence, possibly
+            // through a single node
+            int t = rand() % seqs.size(), m = rand() % seqs.size();
+            if (t == s)
+                continue;
+            if (m == s || m == t || seqs[m].size() != 1 || rand() % 2)
+                m = -1;
+
+            vector <node_t> merged = seq;
+            if (m != -1)
+                merged.push_back(seqs[m][0]);
+            merged.insert(merged.end(), seqs[t].begin(), seqs[t].end());
+
+            node_t root = tree.merge(tree.root(seq[0]),
+                                     m == -1 ? NIL : seqs[m][0],
+                                     tree.root(seqs[t][0]));
+            if (!check_sequence(tree, root, merged))
+                return false;
+
+            seqs[s] = merged;
+            seqs[t].clear();
+            if (m != -1)
+                seqs[m].clear();
+
+        } else {
+            vector <node_t> left(seq.begin(), seq.begin() + p);
+            vector <node_t> right(seq.begin() + p + 1, seq.end());
+            node_t left_root, right_root;
+
+            if (type == 1) {
+                tie(left_root, right_root) = tree.split(x);
+                left.push_back(x);
+            } else if (type == 2) {
+                tie(left_root, right_root) = tree.split_around(x);
+            } else {
+                tree.unlink(x);
+                left.insert(left.end(), right.begin(), right.end());
+                right.clear();
+                left_root = left.empty() ? NIL : tree.root(left[0]);
+                right_root = NIL;
+            }
+
+            if (!check_sequence(tree, left_root, left) ||
+                !check_sequence(tree, right_root, right))
+                return false;
+
+            seqs[s] = left;
+            seqs.push_back(right);
+            if (type != 1)
+                seqs.push_back({x});
+        }
+
+        // drop the empty sequences
+        seqs.erase(remove_if(seqs.begin(), seqs.end(),
+                             [](const vector <node_t> &v) { return v.empty(); }),
+                   seqs.end());
+    }
+
+    for (auto &seq: seqs) {
+        if (!check_sequence(tree, tree.root(seq[0]), seq))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Applies random insertions, lookups and deletions to an
+ * EdgeTable and compares the results with std::map
+ */
+bool check_edge_table(int n, int q, int seed) {
+    srand(seed);
+    EdgeTable <int> table;
+    map <pair <int, int>, int> reference;
+
+    for (int i = 0; i < q; i++) {
+        int a = rand() % n;
+        int b = rand() % n;
+        auto key = make_pair(min(a,b), max(a,b));
+        int *value = table.find(a, b);
+
+        if ((value == NULL) != (reference.count(key) == 0))
+            return false;
+        if (value && *value != reference[key])
+            return false;
+
+        if (rand() % 3 == 0) {
+            if (value) {
+                table.erase(value);
+                reference.erase(key);
+            }
+        } else {
+            value = table.insert(b, a);
+            *value = i;
+            reference[key] = i;
+        }
+
+        if (table.size() != (int) reference.size())
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Applies random insertions, lookups and deletions to an
+ * EdgeIndex over the edges of a vector and compares the results
+ * with std::map
+ */
+bool check_edge_index(int n, int q, int seed) {
+    srand(seed);
+    // handle h is the edge stored at index h (0 is never a handle)
+    vector <pair <int, int> > stored(1);
+    auto endpoints = [&](uint32_t h) { return stored[h]; };
+    EdgeIndex <uint32_t> index;
+    map <pair <int, int>, uint32_t> reference;
+
+    for (int i = 0; i < q; i++) {
+        int a = rand() % n;
+        int b = rand() % n;
+        auto key = make_pair(min(a,b), max(a,b));
+        uint32_t h = index.find(a, b, endpoints);
+
+        if ((h == 0) != (reference.count(key) == 0))
+            return false;
+        if (h != 0 && h != reference[key])
+            return false;
+
+        if (rand() % 3 == 0) {
+            if (h != 0) {
+                index.erase(h, endpoints);
+                reference.erase(key);
+            }
+        } else if (h == 0) {
+            stored.push_back({b, a});
+            index.insert(stored.size() - 1, endpoints);
+            reference[key] = stored.size() - 1;
+        }
+
+        if (index.size() != (int) reference.size())
+            return false;
+    }
+    return true;
+}
+
 int main()
 {
+    assert(check_edge_table(10, 1000, 0));
+    assert(check_edge_table(1000, 100000, 1));
+    assert(check_edge_index(10, 1000, 0));
+    assert(check_edge_index(1000, 100000, 1));
+
+    for (int i = 0; i < 10; i++) {
+        assert(check_sequence_tree(50, 2000, i));
+        assert(check_sequence_tree <SplayTree> (50, 2000, i));
+        assert(check_sequence_tree <Treap> (50, 2000, i));
+    }
+
     assert(verify_execution(3, {{'I', {0, 1}}, {'I', {1, 2}}, {'Q', {0, 2}}}));
+    assert(check_components());
     
     assert(check_correctness(3, {{'I', {0, 1}}, {'I', {1, 2}}, {'Q', {0, 2}}}));
     assert(verify_execution(3, {{'I', {0, 1}}, {'I', {1, 2}}, {'Q', {0, 2}}}));
@@ -194,6 +1281,158 @@ int main()
         assert(check_correctness(500, gen_test(500, 10000, i)));
     }
 
+    assert(check_options());
+    assert(check_options <SplayTree> ());
+    assert(check_options <Treap> ());
+
+    // the other sequence trees
+    for (int i = 0; i < 10; i++) {
+        printf ("Test splay/treap %d\n", i);
+        assert(verify_execution <SplayTree> (100, gen_test(100, 2000, i)));
+        assert(verify_execution <Treap> (100, gen_test(100, 2000, i)));
+        assert(check_correctness <SplayTree> (500, gen_test(500, 10000, i)));
+        assert(check_correctness <Treap> (500, gen_test(500, 10000, i)));
+    }
+
+    // bulk-loaded initial graphs
+    for (int i = 0; i < 10; i++) {
+        printf ("Test bulk load %d\n", i);
+        auto initial = gen_edges(100, 150, i);
+        assert(verify_execution(100, gen_test(100, 2000, i), initial));
+        assert(verify_execution <SplayTree> (100, gen_test(100, 2000, i), initial));
+        assert(verify_execution <Treap> (100, gen_test(100, 2000, i), initial));
+        assert(check_correctness(500, gen_test(500, 10000, i), gen_edges(500, 600, i)));
+    }
+
+    // batched updates
+    for (int i = 0; i < 10; i++) {
+        printf ("Test batches %d\n", i);
+        assert(check_batches(100, gen_batch_test(100, 200, 40, i)));
+        assert(check_batches <BasicDynamicConnectivity <SplayTree> > (100, gen_batch_test(100, 200, 40, i)));
+        assert(check_batches <BasicDynamicConnectivity <Treap> > (100, gen_batch_test(100, 200, 40, i)));
+        assert(check_batches(1000, gen_batch_test(1000, 200, 500, i)));
+        assert(check_batches(1000, gen_batch_test(1000, 200, 500, i), 4));
+        assert(check_batches <BasicDynamicConnectivity <SplayTree> > (1000, gen_batch_test(1000, 200, 500, i), 4));
+        assert(check_batches <BatchDynamicConnectivity> (100, gen_batch_test(100, 200, 40, i)));
+        assert(check_batches <BatchDynamicConnectivity> (1000, gen_batch_test(1000, 200, 500, i), 4));
+        assert(check_batches <BasicBatchDynamicConnectivity <SplayTree> > (1000, gen_batch_test(1000, 200, 500, i), 4));
+        assert(check_batches <BasicBatchDynamicConnectivity <Treap> > (1000, gen_batch_test(1000, 200, 500, i), 4));
+    }
+
+    // many cuts within one tour, also with a hook
+    for (int i = 0; i < 10; i++) {
+        printf ("Test bulk cuts %d\n", i);
+        assert(check_bulk_cuts(2000, 3, 4, i));
+        assert(check_bulk_cuts(2000, 3, 1, i));
+        assert(check_bulk_cuts <SplayTree> (2000, 3, 4, i));
+        assert(check_bulk_cuts <Treap> (2000, 3, 4, i));
+    }
+
+    // sampling of replacement edges and the interleaved search
+    for (int i = 0; i < 10; i++) {
+        printf ("Test replacement search %d\n", i);
+        assert(check_replacement_search(100, gen_test(100, 2000, i), 1, 0));
+        assert(check_replacement_search(100, gen_test(100, 2000, i), 8, 0));
+        assert(check_replacement_search <SplayTree> (100, gen_test(100, 2000, i), 8, 0));
+        assert(check_replacement_search <Treap> (100, gen_test(100, 2000, i), 8, 0));
+        assert(check_replacement_search(100, gen_test(100, 2000, i), 0, 2));
+        assert(check_replacement_search(100, gen_test(100, 2000, i), 0, 16));
+        assert(check_replacement_search <SplayTree> (100, gen_test(100, 2000, i), 0, 16));
+        assert(check_replacement_search <Treap> (100, gen_test(100, 2000, i), 4, 16));
+    }
+
+    // removes with bounded work
+    for (int i = 0; i < 10; i++) {
+        printf ("Test bounded remove %d\n", i);
+        assert(check_bounded_remove(100, gen_test(100, 2000, i), 1));
+        assert(check_bounded_remove(100, gen_test(100, 2000, i), 4));
+        assert(check_bounded_remove <SplayTree> (100, gen_test(100, 2000, i), 2));
+        assert(check_bounded_remove <Treap> (100, gen_test(100, 2000, i), 2));
+        assert(check_bounded_remove(100, gen_test(100, 2000, i), 2, 1, 0));
+        assert(check_bounded_remove(100, gen_test(100, 2000, i), 1, 0, 2));
+        assert(check_bounded_remove <Treap> (100, gen_test(100, 2000, i), 0, 2, 4));
+    }
+    assert(check_zero_budget());
+    assert(check_zero_budget <SplayTree> ());
+    assert(check_zero_budget <Treap> ());
+
+    // batches of queries
+    for (int i = 0; i < 10; i++) {
+        printf ("Test connected batch %d\n", i);
+        assert(check_connected_batch(200, gen_test(200, 5000, i)));
+        assert(check_connected_batch <SplayTree> (200, gen_test(200, 5000, i)));
+        assert(check_connected_batch <Treap> (200, gen_test(200, 5000, i)));
+    }
+
+    // concurrent readers
+    for (int i = 0; i < 4; i++) {
+        printf ("Test concurrent reads %d\n", i);
+        assert(check_concurrent_reads(200, 20000, 4, i));
+        assert(check_concurrent_reads <Treap> (200, 5000, 2, i));
+    }
+
+    // the sketch engine
+    for (int i = 0; i < 10; i++) {
+        printf ("Test sketch %d\n", i);
+        assert(check_sketch(100, gen_test(100, 2000, i), 1, i));
+        assert(check_sketch(100, gen_test(100, 2000, i), 2, i));
+        assert(check_sketch(100, gen_test(100, 2000, i), 0, i));
+    }
+    assert(check_sketch_collision(64));
+
+    // the interface shared by the engines
+    for (int i = 0; i < 10; i++) {
+        printf ("Test engines %d\n", i);
+        assert(check_engine <DynamicConnectivity> (100, gen_test(100, 2000, i)));
+        assert(check_engine <SketchConnectivity> (100, gen_test(100, 2000, i)));
+        assert(check_engine <HybridConnectivity> (100, gen_test(100, 2000, i)));
+        assert(check_engine <BatchDynamicConnectivity> (100, gen_test(100, 2000, i)));
+    }
+
+    // the hybrid engine
+    for (int i = 0; i < 10; i++) {
+        printf ("Test hybrid %d\n", i);
+        assert(check_hybrid(100, gen_edges(100, 80, i), gen_test(100, 2000, i)));
+        assert(check_hybrid(500, gen_edges(500, 1000, i), gen_test(500, 5000, i)));
+    }
+    assert(check_hybrid_missing_remove());
+
+    // merge and split events
+    for (int i = 0; i < 10; i++) {
+        printf ("Test events %d\n", i);
+        assert(check_events(100, gen_test(100, 2000, i), false));
+        assert(check_events <Treap> (100, gen_test(100, 2000, i), false));
+        assert(check_events(100, gen_batch_test(100, 200, 40, i), true));
+        assert(check_events <SplayTree> (100, gen_batch_test(100, 200, 40, i), true));
+    }
+
+    // enumeration of components
+    for (int i = 0; i < 10; i++) {
+        printf ("Test enumeration %d\n", i);
+        assert(check_enumeration(100, gen_test(100, 2000, i)));
+        assert(check_enumeration <SplayTree> (100, gen_test(100, 2000, i)));
+        assert(check_enumeration <Treap> (100, gen_test(100, 2000, i)));
+    }
+
+    // aggregates of the values in the vertices
+    for (int i = 0; i < 10; i++) {
+        printf ("Test aggregates %d\n", i);
+        assert(check_aggregates(100, gen_test(100, 2000, i)));
+        assert(check_aggregates <SplayTree> (100, gen_test(100, 2000, i)));
+        assert(check_aggregates <Treap> (100, gen_test(100, 2000, i)));
+        assert(check_aggregates(100, gen_test(100, 2000, i), gen_edges(100, 150, i)));
+    }
+
+    // offline engine
+    for (int i = 0; i < 10; i++) {
+        printf ("Test offline %d\n", i);
+        assert(check_offline(100, gen_test(100, 2000, i)));
+        assert(check_offline(1000, gen_test(1000, 20000, i)));
+    }
+    assert(check_offline(3, {{'Q', {0, 1}}, {'I', {0, 1}}, {'I', {0, 1}}, {'R', {0, 1}},
+                             {'Q', {0, 1}}, {'I', {2, 2}}, {'R', {1, 2}}, {'R', {0, 1}},
+                             {'R', {0, 1}}, {'Q', {1, 2}}}));
+
     assert(check_correctness(100, gen_test(100, 1000, -1)));
     assert(check_correctness(100, gen_test(100, 1000, -3)));
     assert(check_correctness(100, gen_test(100, 1000, -5)));
@@ -0,0 +1,427 @@
+#include <cassert>
+#include "tour_tree.hpp"
+
+template <class Hook>
+TourTree<Hook>::TourTree() {
+    // the sentinel: all aggregates and the height are zero
+    Nodes.push_back(TourNode{NIL, NIL, NIL, 0, 0, 0, 0, 0, 0});
+    free_pairs = free_vertices = NIL;
+    hook = NULL;
+}
+
+template <class Hook>
+void TourTree<Hook>::set_aggregate_hook(Hook *_hook) {
+    hook = _hook;
+    if constexpr (Hook::enabled) {
+        if (hook != NULL)
+            hook->resize(Nodes.size());
+    }
+}
+
+/**
+ * With b_1 .. b_d the path from the root to x (1 for a step to
+ * the right child), the key is the binary fraction 0.b_1 .. b_d 1
+ * scaled by 2^63: the nodes in the left subtree of x continue the
+ * path with a 0 and those in the right one with a 1, so they get
+ * smaller and greater keys respectively.
+ */
+template <class Hook>
+bool TourTree<Hook>::order_key(node_t x, uint64_t &key, node_t &root) const {
+    uint64_t path = 0;
+    int depth = 0;
+    node_t cur = x;
+    while (Nodes[cur].parent != NIL) {
+        node_t parent = Nodes[cur].parent;
+        if (depth < MAX_KEY_DEPTH && Nodes[parent].right == cur)
+            path |= uint64_t(1) << depth;
+        depth++;
+        cur = parent;
+    }
+
+    root = cur;
+    if (depth > MAX_KEY_DEPTH)
+        return false;
+    key = (2 * path + 1) << (MAX_KEY_DEPTH - depth);
+    return true;
+}
+
+template <class Hook>
+void TourTree<Hook>::update_path(node_t x) {
+    for (node_t cur = x; cur != NIL; cur = Nodes[cur].parent)
+        update_aggregates(cur);
+}
+
+/**
+ * Copies init into the node x field by field, so that the parent
+ * is stored with set_parent (a released node may still be on the
+ * path of a concurrent walk)
+ */
+template <class Hook>
+void TourTree<Hook>::init_node(node_t x, const TourNode &init) {
+    TourNode &node = Nodes[x];
+    node.left = init.left;
+    node.right = init.right;
+    set_parent(x, init.parent);
+    node.size = init.size;
+    node.nontree_cnt = init.nontree_cnt;
+    node.on_level_cnt = init.on_level_cnt;
+    node.aux = init.aux;
+    node.height = init.height;
+    node.flags = init.flags;
+}
+
+template <class Hook>
+node_t TourTree<Hook>::new_vertex_node() {
+    node_t x = free_vertices;
+    if (x != NIL) {
+        free_vertices = Nodes[x].parent;
+
+    } else {
+        x = Nodes.size();
+        grow_nodes(Nodes.size() + 1);
+    }
+
+    init_node(x, TourNode{NIL, NIL, NIL, 1, 0, 0, -1, 1, VERTEX_NODE});
+    // a reused node may still hold stale extra aggregates
+    if (Hook::enabled && hook != NULL)
+        update_aggregates(x);
+    return x;
+}
+
+template <class Hook>
+void TourTree<Hook>::grow_nodes(size_t k) {
+    Nodes.resize(k);
+    if constexpr (Hook::enabled) {
+        if (hook != NULL)
+            hook->resize(k);
+    }
+}
+
+template <class Hook>
+void TourTree<Hook>::free_vertex_node(node_t x) {
+    // released nodes are linked through the parent field
+    set_parent(x, free_vertices);
+    free_vertices = x;
+}
+
+template <class Hook>
+node_t TourTree<Hook>::new_edge_nodes(int a, int b, bool on_level) {
+    node_t e = free_pairs;
+    if (e != NIL) {
+        free_pairs = Nodes[e].parent;
+
+    } else {
+        e = Nodes.size();
+        grow_nodes(Nodes.size() + 2);
+    }
+
+    // it's enough to mark only one of the copies as on the level
+    init_node(e, TourNode{NIL, NIL, NIL, 0, 0, on_level ? 1 : 0, b, 1,
+                          uint8_t(on_level ? ON_LEVEL : 0)});
+    init_node(e+1, TourNode{NIL, NIL, NIL, 0, 0, 0, a, 1, 0});
+    // a reused pair may still hold stale extra aggregates
+    if (Hook::enabled && hook != NULL) {
+        update_aggregates(e);
+        update_aggregates(e+1);
+    }
+    return e;
+}
+
+template <class Hook>
+void TourTree<Hook>::free_edge_nodes(node_t e) {
+    // released pairs are linked through the parent field
+    set_parent(e, free_pairs);
+    free_pairs = e;
+}
+
+template <class Hook>
+node_t TourTree<Hook>::find_root(node_t x) const {
+    node_t cur = x;
+    while (Nodes[cur].parent != NIL) {
+        cur = Nodes[cur].parent;
+    }
+    return cur;
+}
+
+template <class Hook>
+node_t TourTree<Hook>::find_root_concurrent(node_t x, int limit) const {
+    node_t cur = x;
+    for (int steps = 0; steps <= limit; steps++) {
+        node_t parent = __atomic_load_n(&Nodes[cur].parent, __ATOMIC_ACQUIRE);
+        if (parent == NIL)
+            return cur;
+        cur = parent;
+    }
+    return NIL;
+}
+
+template <class Hook>
+void TourTree<Hook>::find_roots(const node_t *xs, int k, node_t *roots) const {
+    // the walks in flight: the index of the query and the node reached
+    int query[ROOT_WALKS];
+    node_t cur[ROOT_WALKS];
+    int active = 0, next = 0;
+
+    for (; active < ROOT_WALKS && next < k; active++, next++) {
+        query[active] = next;
+        cur[active] = xs[next];
+        __builtin_prefetch(&Nodes[cur[active]]);
+    }
+
+    while (active > 0) {
+        for (int i = 0; i < active; ) {
+            node_t parent = Nodes[cur[i]].parent;
+            if (parent != NIL) {
+                cur[i] = parent;
+                __builtin_prefetch(&Nodes[parent]);
+                i++;
+                continue;
+            }
+
+            roots[query[i]] = cur[i];
+            if (next < k) {
+                query[i] = next;
+                cur[i] = xs[next++];
+                __builtin_prefetch(&Nodes[cur[i]]);
+                i++;
+            } else {
+                // the last walk takes the place of the finished one
+                active--;
+                query[i] = query[active];
+                cur[i] = cur[active];
+            }
+        }
+    }
+}
+
+template <class Hook>
+void TourTree<Hook>::reserve(int k) {
+    Nodes.reserve(k);
+}
+
+template <class Hook>
+void TourTree<Hook>::replace_child(node_t x, node_t old_child, node_t new_child) {
+
+    if (Nodes[x].left == old_child) {
+        Nodes[x].left = new_child;
+
+    } else if (Nodes[x].right == old_child) {
+        Nodes[x].right = new_child;
+
+    } else {
+        assert(0);
+    }
+}
+
+/**
+ * Builds a perfectly balanced tree (the heights of the subtrees
+ * of every node differ by at most one) over the single-node
+ * trees seq[0..k-1] and returns its root
+ */
+template <class Hook>
+node_t TourTree<Hook>::build_balanced(const node_t *seq, int k) {
+    if (k == 0)
+        return NIL;
+
+    int mid = k / 2;
+    node_t x = seq[mid];
+    node_t left = build_balanced(seq, mid);
+    node_t right = build_balanced(seq + mid + 1, k - mid - 1);
+
+    Nodes[x].left = left;
+    Nodes[x].right = right;
+    if (left != NIL)
+        set_parent(left, x);
+    if (right != NIL)
+        set_parent(right, x);
+
+    Nodes[x].height = max(Nodes[left].height, Nodes[right].height) + 1;
+    update_aggregates(x);
+    return x;
+}
+
+template <class Hook>
+void TourTree<Hook>::flatten(node_t x, vector <node_t> &seq) {
+    size_t first = seq.size();
+    for_each_node(x, [&](node_t y) { seq.push_back(y); });
+
+    for (size_t i = first; i < seq.size(); i++) {
+        node_t y = seq[i];
+        Nodes[y].left = Nodes[y].right = NIL;
+        set_parent(y, NIL);
+        Nodes[y].height = 1;
+        update_aggregates(y);
+    }
+}
+
+// Manage data stored in the nodes
+
+template <class Hook>
+void TourTree<Hook>::update_on_level_cnt(node_t x, int dx) {
+    for (node_t cur = x; cur != NIL; cur = Nodes[cur].parent) {
+        Nodes[cur].on_level_cnt += dx;
+    }
+}
+
+template <class Hook>
+void TourTree<Hook>::set_nontree_head(node_t x, int head) {
+    bool had_edges = (Nodes[x].aux != -1);
+    Nodes[x].aux = head;
+
+    if (had_edges != (head != -1))
+        update_nontree_cnt(x, had_edges ? -1 : 1);
+}
+
+template <class Hook>
+void TourTree<Hook>::update_nontree_cnt(node_t x, int dx) {
+    for (node_t cur = x; cur != NIL; cur = Nodes[cur].parent) {
+        Nodes[cur].nontree_cnt += dx;
+    }
+}
+
+/**
+ * Descends to the r-th (from 0, in order) vertex node holding
+ * nontree edges, choosing the subtree by the counters, so the
+ * descent never backtracks.
+ */
+template <class Hook>
+node_t TourTree<Hook>::descend_to_nontree_edge(node_t x, int r) const {
+    if (r >= Nodes[x].nontree_cnt)
+        return NIL;
+
+    node_t cur = x;
+    while (true) {
+        node_t left = Nodes[cur].left;
+        if (r < Nodes[left].nontree_cnt) {
+            cur = left;
+            continue;
+        }
+
+        r -= Nodes[left].nontree_cnt;
+        if ((Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1) {
+            if (r == 0)
+                return cur;
+            r--;
+        }
+        cur = Nodes[cur].right;
+    }
+}
+
+/* Same as above, for the edge nodes marked as ON_LEVEL */
+template <class Hook>
+node_t TourTree<Hook>::descend_to_on_level(node_t x) const {
+    if (Nodes[x].on_level_cnt == 0)
+        return NIL;
+
+    node_t cur = x;
+    while (!(Nodes[cur].flags & ON_LEVEL)) {
+        node_t left = Nodes[cur].left;
+        if (Nodes[left].on_level_cnt > 0)
+            cur = left;
+        else
+            cur = Nodes[cur].right;
+    }
+
+    return cur;
+}
+
+template <class Hook>
+pair <int, int> TourTree<Hook>::unmark_on_level(node_t x) {
+    // only the first node of a pair is ever marked as on the level
+    Nodes[x].flags &= ~ON_LEVEL;
+    update_on_level_cnt(x, -1);
+    return {Nodes[x+1].aux, Nodes[x].aux};
+}
+
+template <class Hook>
+node_t TourTree<Hook>::find_nontree_edge(node_t x, int r) {
+    return descend_to_nontree_edge(x, r);
+}
+
+// diagnostic methods:
+
+template <class Hook>
+void TourTree<Hook>::print_tree(node_t x, int indent) const {
+#ifdef DBG
+    if (Nodes[x].left != NIL)
+        print_tree(Nodes[x].left, indent + 3);
+    print_node(x, indent);
+    if (Nodes[x].right != NIL)
+        print_tree(Nodes[x].right, indent + 3);
+#else
+    (void) x;
+    (void) indent;
+#endif
+}
+
+template <class Hook>
+void TourTree<Hook>::print_node(node_t x, int indent) const {
+#ifdef DBG
+    char spaces[20] = "                   ";
+    spaces[min(19, indent)] = 0;
+    const TourNode &node = Nodes[x];
+
+    if (node.flags & VERTEX_NODE)
+        debug("%sVertexNode: nontree edges from %d\n", spaces, node.aux);
+    else
+        debug("%sEdgeNode: to %d%s\n", spaces, node.aux,
+              (node.flags & ON_LEVEL) ? " (on level)" : "");
+
+    debug("%s%u: left = %u, right = %u, parent = %u,\n \
+        %sheight = %d, nontree_cnt = %d, on_level_cnt = %d, size = %d\n",
+        spaces, x, node.left, node.right, node.parent, spaces,
+        node.height, node.nontree_cnt, node.on_level_cnt, node.size);
+#else
+    (void) x;
+    (void) indent;
+#endif
+}
+
+/**
+ * Checks the invariants of x which do not depend on the
+ * balancing scheme: the links and the aggregates
+ * (assuming those of its children are correct)
+ */
+template <class Hook>
+bool TourTree<Hook>::correct_node(node_t x, node_t correct_parent) const {
+    const TourNode &node = Nodes[x];
+    const TourNode &left = Nodes[node.left];
+    const TourNode &right = Nodes[node.right];
+    bool vertex = node.flags & VERTEX_NODE;
+
+    if (vertex && (node.flags & ON_LEVEL)) {
+        debug ("a vertex node is marked as on the level\n");
+        return false;
+    }
+
+    if (node.parent != correct_parent) {
+        debug ("parent does not match: %u vs %u\n",
+        node.parent, correct_parent);
+        return false;
+    }
+
+    if (node.left != NIL && node.left == node.right) {
+        debug ("left and right children are the same!\n");
+        return false;
+    }
+
+    if (node.size != left.size + right.size + (vertex ? 1 : 0)) {
+        debug ("size does not match\n");
+        return false;
+    }
+    if (node.nontree_cnt != left.nontree_cnt + right.nontree_cnt +
+                            ((vertex && node.aux != -1) ? 1 : 0)) {
+        debug ("nontree_cnt does not match\n");
+        return false;
+    }
+    if (node.on_level_cnt != left.on_level_cnt + right.on_level_cnt +
+                             ((node.flags & ON_LEVEL) ? 1 : 0)) {
+        debug ("on_level_cnt does not match\n");
+        return false;
+    }
+
+    return true;
+}
+
+template class TourTree<NoHook>;
+template class TourTree<AggregateHook>;
@@ -0,0 +1,486 @@
+#ifndef TOUR_TREE_HPP
+#define TOUR_TREE_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <cassert>
+using namespace std;
+
+// A switch for managing debug output
+// #define DBG
+#ifdef DBG
+    #define debug(...) fprintf(stderr, __VA_ARGS__), fflush(stderr)
+#else
+    #define debug(...) {}
+#endif
+
+/* Nodes are addressed by 32-bit indices into the node array */
+typedef uint32_t node_t;
+
+/* Index of the sentinel node, which stands for an empty tree */
+const node_t NIL = 0;
+
+enum NodeFlags : uint8_t {
+    /* the node represents a vertex (otherwise a tree edge) */
+    VERTEX_NODE = 1,
+    /* the node is a tree edge on the level of the forest */
+    ON_LEVEL = 2
+};
+
+/**
+ * A node of an Euler tour: either a vertex or one direction
+ * of a tree edge (see et_trees.hpp). All the fields used while
+ * restructuring the tree are packed into 32 bytes, so two nodes
+ * share a cache line.
+ */
+struct TourNode {
+    node_t left, right, parent;
+
+    /* number of vertex nodes in the subtree of this node */
+    int size;
+    /* number of vertex nodes in the subtree storing nontree edges */
+    int nontree_cnt;
+    /* number of ON_LEVEL edge nodes in the subtree */
+    int on_level_cnt;
+
+    /**
+     * Vertex nodes: the first record of the list of nontree
+     * edges of the vertex (-1 if it is empty, see et_trees.hpp)
+     * Edge nodes: the vertex the edge leads to
+     */
+    int aux;
+
+    /* height of the subtree (maintained only by AVLTree) */
+    uint8_t height;
+    uint8_t flags;
+};
+
+/**
+ * Extra aggregates of the subtrees, maintained outside of the
+ * nodes on behalf of a user of a forest: update(x, left, right)
+ * is called whenever the aggregates of the node x are recomputed
+ * from those of its children (NIL for a missing child).
+ * Before a node past the array of nodes is updated, resize(k)
+ * tells that the forest has grown to k nodes; update itself must
+ * not grow the storage, as a forest may recompute the nodes of
+ * different trees on several threads at once (see ETTForest::
+ * link_batch and ETTForest::plan_cuts) and update may only write
+ * the aggregates of x.
+ *
+ * The hook is a policy of the sequence trees (see TourTree):
+ * only the trees instantiated with AggregateHook call it.
+ */
+class AggregateHook {
+    public:
+    static constexpr bool enabled = true;
+
+    virtual void update(node_t x, node_t left, node_t right) = 0;
+    virtual void resize(size_t) {}
+    virtual ~AggregateHook() {}
+};
+
+/* The hook policy of the trees without extra aggregates */
+struct NoHook {
+    static constexpr bool enabled = false;
+};
+
+/**
+ * The part of a balanced sequence tree which does not depend on
+ * the balancing scheme: the array of TourNodes owned by a forest,
+ * allocation of nodes and the aggregates stored in them.
+ *
+ * Node 0 is a sentinel (NIL) whose aggregates are all zero, so
+ * they can be summed without checking for missing children. Edge
+ * nodes are allocated in pairs (e, e+1), one for each direction
+ * of the edge; released nodes are reused before the array grows.
+ *
+ * ETTForest (et_trees.hpp) takes the sequence tree as a template
+ * parameter. Besides the methods below, a sequence tree provides:
+ *
+ *   pair <node_t, node_t> split(node_t x);
+ *   pair <node_t, node_t> split_around(node_t x);
+ *   node_t merge(node_t left, node_t middle, node_t right);
+ *   node_t root(node_t x);
+ *   bool same_tree(node_t x, node_t y);
+ *   void unlink(node_t x);
+ *   node_t build(const node_t *seq, int k);
+ *   bool correct_tree(node_t x, node_t correct_parent) const;
+ *
+ * with the semantics documented in avl_tree.hpp, and the alias
+ *
+ *   template <class OtherHook> using with_hook = ...;
+ *
+ * for the same tree with another hook policy. A sequence tree
+ * may restructure the tree in any of them (even in root), so a
+ * root returned by one call is only valid until the next one.
+ * Only a tree which sets self_adjusting does so in root,
+ * same_tree and find_nontree_edge; in the others, these only
+ * read the tree and may run on several threads at once.
+ * Implementations: AVLTree (avl_tree.hpp), SplayTree
+ * (splay_tree.hpp) and Treap (treap.hpp).
+ *
+ * The Hook parameter is NoHook or AggregateHook. With NoHook,
+ * the call of the hook is compiled out of every recomputation
+ * of the aggregates; the trees are compiled for both policies
+ * and HookedTree below names the one calling a hook.
+ */
+
+template <class Hook>
+class TourTree {
+    public:
+    typedef Hook hook_type;
+
+    /* whether the queries restructure the tree (see above) */
+    static constexpr bool self_adjusting = false;
+
+    /* the number of walks of find_roots in flight */
+    static constexpr int ROOT_WALKS = 32;
+
+    TourTree();
+
+    /**
+     * Creates a new single-node tree representing a vertex
+     * Complexity: O(1) (amortized)
+     */
+    node_t new_vertex_node();
+
+    /**
+     * Releases the vertex node x, which must form
+     * a single-node tree
+     * Complexity: O(1)
+     */
+    void free_vertex_node(node_t x);
+
+    /**
+     * Creates two single-node trees: e representing the edge
+     * (a,b) (on the level if on_level is set) and e+1
+     * representing the edge (b,a). Returns e.
+     * Complexity: O(1) (amortized)
+     */
+    node_t new_edge_nodes(int a, int b, bool on_level);
+
+    /**
+     * Releases the pair of edge nodes starting at e
+     * Both of them must already be unlinked
+     * Complexity: O(1)
+     */
+    void free_edge_nodes(node_t e);
+
+    const TourNode &operator[](node_t x) const {
+        return Nodes[x];
+    }
+
+    /**
+     * Sets the hook maintaining extra aggregates (or turns them
+     * off if hook is NULL) and tells it the number of nodes.
+     * The aggregates of the existing nodes are not recomputed.
+     * With NoHook, the hook is never called.
+     * Complexity: O(1) besides the resize of the hook
+     */
+    void set_aggregate_hook(Hook *_hook);
+
+    /**
+     * Sets key to a number ordering x among the nodes of its
+     * tree as the sequence does and root to the root of the
+     * tree, without restructuring the tree. Returns false (and
+     * no key) if x is deeper than MAX_KEY_DEPTH, as its path from
+     * the root does not fit in the key then.
+     * Complexity: O(depth of x)
+     */
+    bool order_key(node_t x, uint64_t &key, node_t &root) const;
+    static constexpr int MAX_KEY_DEPTH = 62;
+
+    /**
+     * Recomputes the aggregates of x and all its ancestors
+     * Complexity: O(depth of x)
+     */
+    void update_path(node_t x);
+
+    /**
+     * Returns the root of the tree containing x without
+     * restructuring the tree (for diagnostics)
+     *
+     * Complexity: O(depth of x)
+     */
+    node_t find_root(node_t x) const;
+
+    /**
+     * Like find_root, but loads the parent pointers atomically
+     * (see set_parent), so that it may run while another thread
+     * restructures the tree. The result is then meaningless and
+     * must be validated by the caller (see SeqLock in
+     * seqlock.hpp). Gives up and
+     * returns NIL after limit steps, as a concurrent rotation may
+     * close a cycle of parent pointers for a moment.
+     *
+     * Complexity: O(min(depth of x, limit))
+     */
+    node_t find_root_concurrent(node_t x, int limit) const;
+
+    /**
+     * Sets roots[i] to find_root(xs[i]) for all i < k. Up to
+     * ROOT_WALKS walks advance in lock-step, each prefetching
+     * the next node on its path, so that the cache misses of
+     * different walks overlap; a finished walk is replaced by
+     * the next one right away.
+     *
+     * Complexity: O(sum of the depths of the nodes)
+     */
+    void find_roots(const node_t *xs, int k, node_t *roots) const;
+
+    /**
+     * Reserves memory for k nodes (including NIL), so that the
+     * array of nodes is not reallocated while it holds at most
+     * k of them
+     *
+     * Complexity: O(k)
+     */
+    void reserve(int k);
+
+    /**
+     * Appends the nodes of the tree rooted in x to seq (in
+     * order) and turns each of them into a single-node tree
+     * (to be reassembled with build)
+     *
+     * Complexity: O(size of the tree)
+     */
+    void flatten(node_t x, vector <node_t> &seq);
+
+    /**
+     * Calls f(y) for every node y of the tree rooted in x, in
+     * order, walking the parent pointers (without restructuring
+     * the tree or allocating memory)
+     *
+     * Complexity: O(size of the tree)
+     */
+    template <class F>
+    void for_each_node(node_t x, F f) const;
+
+    /**
+     * Returns the r-th (from 0, in order) vertex node storing
+     * nontree edges in the tree rooted in x or NIL if there are
+     * at most r of them
+     *
+     * Complexity: O(height of the tree)
+     */
+    node_t find_nontree_edge(node_t x, int r);
+
+    /**
+     * Calls f(v, head) for the vertex nodes v storing nontree
+     * edges in the tree rooted in x, in order. head is the list
+     * of v, which f may shorten by setting it to its remaining
+     * part; f returns false to end the traversal. f must not
+     * restructure the tree, but it may set the lists of other
+     * vertex nodes (with set_nontree_head).
+     *
+     * The counters of the nodes above the lists emptied by f
+     * are recomputed once, when the traversal leaves them.
+     *
+     * Complexity: O(k log(n/k)) plus the time of f, where k is
+     * the number of vertex nodes visited
+     */
+    template <class F>
+    void scan_nontree_heads(node_t x, F f);
+
+    /**
+     * Sets the head of the list of nontree edges stored in
+     * the vertex node x
+     *
+     * Complexity: O(depth of x) if the list becomes empty or
+     * stops being empty, O(1) otherwise
+     */
+    void set_nontree_head(node_t x, int head);
+
+    /**
+     * Unmarks the edge nodes marked as on_level in the tree
+     * rooted in x and calls f(edge) with the edge (a,b) of each
+     * of them, until f returns false. A single traversal, pruned
+     * by the counters, visits only the marked nodes and their
+     * ancestors and clears the counters on its way back up.
+     * f must not modify the tree.
+     *
+     * Complexity: O(k log(n/k)) plus the time of f, where k is
+     * the number of marked nodes
+     */
+    template <class F>
+    void take_on_level(node_t x, F f);
+
+    void print_tree(node_t x, int indent = 0) const;
+    void print_node(node_t x, int indent = 0) const;
+
+    protected:
+    vector <TourNode> Nodes;
+    /* first released edge pair and vertex node (or NIL) */
+    node_t free_pairs, free_vertices;
+    Hook *hook;
+
+    void set_parent(node_t x, node_t parent);
+    void init_node(node_t x, const TourNode &init);
+    void replace_child(node_t x, node_t old_child, node_t new_child);
+    node_t build_balanced(const node_t *seq, int k);
+
+    node_t descend_to_nontree_edge(node_t x, int r = 0) const;
+    node_t descend_to_on_level(node_t x) const;
+    pair <int, int> unmark_on_level(node_t x);
+
+    void update_on_level_cnt(node_t x, int dx);
+    void update_nontree_cnt(node_t x, int dx);
+    void update_aggregates(node_t x);
+    void grow_nodes(size_t k);
+
+    bool correct_node(node_t x, node_t correct_parent) const;
+};
+
+/**
+ * Every write of a parent goes through here: find_root_concurrent
+ * loads the parents while the tree changes, so the stores must be
+ * atomic. A store releases the node it links to, so that a walk
+ * which reaches a newly allocated node also sees it initialized;
+ * on x86 both sides are plain moves.
+ */
+template <class Hook>
+inline void TourTree<Hook>::set_parent(node_t x, node_t parent) {
+    __atomic_store_n(&Nodes[x].parent, parent, __ATOMIC_RELEASE);
+}
+
+template <class Hook>
+inline void TourTree<Hook>::update_aggregates(node_t x) {
+    TourNode &node = Nodes[x];
+    const TourNode &l = Nodes[node.left];
+    const TourNode &r = Nodes[node.right];
+    bool vertex = node.flags & VERTEX_NODE;
+
+    node.size = l.size + r.size + (vertex ? 1 : 0);
+    node.on_level_cnt = l.on_level_cnt + r.on_level_cnt +
+                        ((node.flags & ON_LEVEL) ? 1 : 0);
+    node.nontree_cnt = l.nontree_cnt + r.nontree_cnt +
+                       ((vertex && node.aux != -1) ? 1 : 0);
+
+    if constexpr (Hook::enabled) {
+        if (hook != NULL)
+            hook->update(x, node.left, node.right);
+    }
+}
+
+template <class Hook>
+template <class F>
+void TourTree<Hook>::for_each_node(node_t x, F f) const {
+    if (x == NIL)
+        return;
+
+    node_t cur = x;
+    while (Nodes[cur].left != NIL)
+        cur = Nodes[cur].left;
+
+    while (true) {
+        f(cur);
+
+        if (Nodes[cur].right != NIL) {
+            // the successor is the first node of the right subtree
+            cur = Nodes[cur].right;
+            while (Nodes[cur].left != NIL)
+                cur = Nodes[cur].left;
+
+        } else {
+            // the successor is the first ancestor entered from the left
+            while (cur != x && Nodes[Nodes[cur].parent].right == cur)
+                cur = Nodes[cur].parent;
+            if (cur == x)
+                return;
+            cur = Nodes[cur].parent;
+        }
+    }
+}
+
+/**
+ * Walks down into the subtrees with marked nodes first, then
+ * unmarks the node itself and goes right. A node is left (with
+ * its counter zeroed) only when nothing below it is marked, so
+ * the walk comes back to every node at most twice. When f asks
+ * to stop, only the counters on the path back to x are stale.
+ */
+template <class Hook>
+template <class F>
+void TourTree<Hook>::take_on_level(node_t x, F f) {
+    node_t cur = x;
+
+    while (Nodes[x].on_level_cnt > 0) {
+        TourNode &node = Nodes[cur];
+
+        if (Nodes[node.left].on_level_cnt > 0) {
+            cur = node.left;
+            continue;
+        }
+        if (node.flags & ON_LEVEL) {
+            node.flags &= ~ON_LEVEL;
+            if (!f(pair <int, int> (Nodes[cur+1].aux, node.aux))) {
+                for (node_t y = cur; y != Nodes[x].parent; y = Nodes[y].parent) {
+                    Nodes[y].on_level_cnt = Nodes[Nodes[y].left].on_level_cnt +
+                                            Nodes[Nodes[y].right].on_level_cnt +
+                                            ((Nodes[y].flags & ON_LEVEL) ? 1 : 0);
+                }
+                return;
+            }
+        }
+        if (Nodes[node.right].on_level_cnt > 0) {
+            cur = node.right;
+            continue;
+        }
+
+        node.on_level_cnt = 0;
+        cur = node.parent;
+    }
+}
+
+/**
+ * An in-order walk through the nodes with nontree edges below
+ * them. The node the walk came from tells which part of a node
+ * comes next. Once f asks to stop, the walk only goes back up to
+ * the root, fixing the counters.
+ */
+template <class Hook>
+template <class F>
+void TourTree<Hook>::scan_nontree_heads(node_t x, F f) {
+    node_t cur = x, prv = Nodes[x].parent;
+    bool more = true;
+
+    while (cur != Nodes[x].parent) {
+        node_t left = Nodes[cur].left, right = Nodes[cur].right;
+
+        if (prv == Nodes[cur].parent) {
+            if (more && Nodes[left].nontree_cnt > 0) {
+                prv = cur;
+                cur = left;
+                continue;
+            }
+            prv = left;
+        }
+
+        if (prv == left) {
+            if (more && (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1) {
+                int head = Nodes[cur].aux;
+                more = f(cur, head);
+                Nodes[cur].aux = head;
+            }
+            if (more && Nodes[right].nontree_cnt > 0) {
+                prv = cur;
+                cur = right;
+                continue;
+            }
+        }
+
+        bool own = (Nodes[cur].flags & VERTEX_NODE) && Nodes[cur].aux != -1;
+        Nodes[cur].nontree_cnt = Nodes[left].nontree_cnt +
+                                 Nodes[right].nontree_cnt + (own ? 1 : 0);
+        prv = cur;
+        cur = Nodes[cur].parent;
+    }
+}
+
+/* The sequence tree Tree calling an AggregateHook */
+template <class Tree>
+using HookedTree = typename Tree::template with_hook <AggregateHook>;
+
+#endif
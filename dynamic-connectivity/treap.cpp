@@ -0,0 +1,208 @@
+#include <vector>
+#include "treap.hpp"
+
+template <class Hook>
+node_t BasicTreap<Hook>::root(node_t x) const {
+    return find_root(x);
+}
+
+template <class Hook>
+bool BasicTreap<Hook>::same_tree(node_t x, node_t y) const {
+    return find_root(x) == find_root(y);
+}
+
+/**
+ * Joins two trees whose roots have no parents, placing all
+ * nodes of left before those of right. The root with the
+ * higher priority stays on top and the other tree is
+ * joined recursively with its inner subtree.
+ */
+template <class Hook>
+node_t BasicTreap<Hook>::join(node_t left, node_t right) {
+    if (left == NIL)
+        return right;
+    if (right == NIL)
+        return left;
+
+    if (priority(left) > priority(right)) {
+        node_t left_right = Nodes[left].right;
+        if (left_right != NIL)
+            set_parent(left_right, NIL);
+
+        left_right = join(left_right, right);
+        Nodes[left].right = left_right;
+        set_parent(left_right, left);
+        update_aggregates(left);
+        return left;
+
+    } else {
+        node_t right_left = Nodes[right].left;
+        if (right_left != NIL)
+            set_parent(right_left, NIL);
+
+        right_left = join(left, right_left);
+        Nodes[right].left = right_left;
+        set_parent(right_left, right);
+        update_aggregates(right);
+        return right;
+    }
+}
+
+template <class Hook>
+node_t BasicTreap<Hook>::merge(node_t left, node_t middle, node_t right) {
+    return join(join(left, middle), right);
+}
+
+/**
+ * Walks from x to the root. Every node on the path keeps the
+ * subtree which is on its own side of x and adopts the part
+ * of the path below it which is on the same side, so the
+ * heap order is preserved without any rotations.
+ */
+template <class Hook>
+pair <node_t, node_t> BasicTreap<Hook>::split(node_t x) {
+    node_t right = Nodes[x].right;
+
+    Nodes[x].right = NIL;
+    update_aggregates(x);
+    return split_path(x, x, right);
+}
+
+template <class Hook>
+pair <node_t, node_t> BasicTreap<Hook>::split_around(node_t x) {
+    node_t left = Nodes[x].left, right = Nodes[x].right;
+
+    // x is left out of both trees, but the walk starts at it
+    Nodes[x].left = Nodes[x].right = NIL;
+    pair <node_t, node_t> trees = split_path(x, left, right);
+
+    set_parent(x, NIL);
+    update_aggregates(x);
+    return trees;
+}
+
+/**
+ * The walk of split from x, which has already been cut into
+ * the (possibly empty) trees left_tree and right_tree
+ */
+template <class Hook>
+pair <node_t, node_t> BasicTreap<Hook>::split_path(node_t x, node_t left_tree,
+                                        node_t right_tree) {
+    node_t prv, cur = x, nxt = Nodes[x].parent;
+
+    while (nxt != NIL) {
+        prv = cur;
+        cur = nxt;
+        nxt = Nodes[cur].parent;
+
+        if (Nodes[cur].right == prv) {
+            Nodes[cur].right = left_tree;
+            if (left_tree != NIL)
+                set_parent(left_tree, cur);
+            left_tree = cur;
+
+        } else {
+            Nodes[cur].left = right_tree;
+            if (right_tree != NIL)
+                set_parent(right_tree, cur);
+            right_tree = cur;
+        }
+
+        update_aggregates(cur);
+    }
+
+    if (left_tree != NIL)
+        set_parent(left_tree, NIL);
+    if (right_tree != NIL)
+        set_parent(right_tree, NIL);
+
+    return {left_tree, right_tree};
+}
+
+template <class Hook>
+void BasicTreap<Hook>::unlink(node_t x) {
+    node_t left = Nodes[x].left, right = Nodes[x].right;
+    node_t parent = Nodes[x].parent;
+
+    // replace this node with its subtree
+    if (left != NIL)
+        set_parent(left, NIL);
+    if (right != NIL)
+        set_parent(right, NIL);
+
+    node_t subtree = join(left, right);
+    if (parent != NIL) {
+        replace_child(parent, x, subtree);
+        if (subtree != NIL)
+            set_parent(subtree, parent);
+    }
+
+    for (node_t cur = parent; cur != NIL; cur = Nodes[cur].parent) {
+        update_aggregates(cur);
+    }
+
+    Nodes[x].left = Nodes[x].right = NIL;
+    set_parent(x, NIL);
+    update_aggregates(x);
+}
+
+/**
+ * Builds the Cartesian tree of the sequence by priorities: the
+ * stack holds the right spine of the tree built so far, and
+ * every node popped from it is complete, so its aggregates
+ * can be computed right away.
+ */
+template <class Hook>
+node_t BasicTreap<Hook>::build(const node_t *seq, int k) {
+    vector <node_t> spine;
+
+    for (int i = 0; i < k; i++) {
+        node_t x = seq[i], last = NIL;
+        while (!spine.empty() && priority(spine.back()) < priority(x)) {
+            last = spine.back();
+            spine.pop_back();
+            update_aggregates(last);
+        }
+
+        Nodes[x].left = last;
+        if (last != NIL)
+            set_parent(last, x);
+        if (!spine.empty()) {
+            Nodes[spine.back()].right = x;
+            set_parent(x, spine.back());
+        }
+        spine.push_back(x);
+    }
+
+    node_t root = spine.empty() ? NIL : spine.front();
+    while (!spine.empty()) {
+        update_aggregates(spine.back());
+        spine.pop_back();
+    }
+
+    return root;
+}
+
+template <class Hook>
+bool BasicTreap<Hook>::correct_tree(node_t x, node_t correct_parent) const {
+    const TourNode &node = Nodes[x];
+
+    if (!correct_node(x, correct_parent))
+        return false;
+
+    if ((node.left != NIL && priority(node.left) > priority(x)) ||
+        (node.right != NIL && priority(node.right) > priority(x))) {
+        debug ("heap invariant violated\n");
+        return false;
+    }
+
+    if (node.left != NIL && !correct_tree(node.left, x))
+        return false;
+    if (node.right != NIL && !correct_tree(node.right, x))
+        return false;
+
+    return true;
+}
+
+template class BasicTreap<NoHook>;
+template class BasicTreap<AggregateHook>;
@@ -0,0 +1,121 @@
+#ifndef TREAP_HPP
+#define TREAP_HPP
+
+#include <utility>
+#include "tour_tree.hpp"
+using namespace std;
+
+/**
+ * Treap implementation (https://en.wikipedia.org/wiki/Treap)
+ * over an array of TourNodes.
+ *
+ * The tree is a binary search tree by the order of nodes and
+ * a max-heap by their priorities. Priorities are computed by
+ * hashing node indices, so they take no space in the nodes.
+ * Split and merge never rotate: they only relink the nodes on
+ * the paths they walk. All the bounds below are expected.
+ * Hook is the policy of the extra aggregates (see TourTree).
+ */
+
+template <class Hook = NoHook>
+class BasicTreap : public TourTree <Hook> {
+    typedef TourTree <Hook> Base;
+
+    public:
+    template <class OtherHook>
+    using with_hook = BasicTreap <OtherHook>;
+
+    using Base::find_root;
+
+    /**
+     * Splits the tree into two parts and returns their roots.
+     * The first part contains all nodes to the left of x
+     * (inclusive), the second part contains all nodes to the
+     * right of it (exclusive).
+     *
+     * Complexity: O(log n)
+     */
+    pair <node_t, node_t> split(node_t x);
+
+    /**
+     * Removes x from its tree and splits the rest of it into
+     * the nodes to the left and to the right of x (exclusive)
+     *
+     * Complexity: O(log n)
+     */
+    pair <node_t, node_t> split_around(node_t x);
+
+    /**
+     * Merges two trees (left and right) into one (the middle
+     * node is optional) and returns its root.
+     * The order of nodes is as follows:
+     * left(unchanged), middle, right(unchanged).
+     *
+     * Complexity: O(log n)
+     */
+    node_t merge(node_t left, node_t middle, node_t right);
+
+    /**
+     * Returns the root of the tree containing x
+     *
+     * Complexity: O(log n)
+     */
+    node_t root(node_t x) const;
+
+    /**
+     * Checks whether x and y belong to the same tree
+     *
+     * Complexity: O(log n)
+     */
+    bool same_tree(node_t x, node_t y) const;
+
+    /**
+     * Removes x from the tree it belongs to
+     *
+     * Complexity: O(log n)
+     */
+    void unlink(node_t x);
+
+    /**
+     * Builds a tree from the single-node trees seq[0..k-1]
+     * (in this order) and returns its root
+     *
+     * Complexity: O(k)
+     */
+    node_t build(const node_t *seq, int k);
+
+    /**
+     * Checks if the invariants hold in the subtree of x
+     *
+     * Complexity: linear in the size of the tree
+     */
+    bool correct_tree(node_t x, node_t correct_parent) const;
+
+    private:
+    using Base::Nodes;
+    using Base::set_parent;
+    using Base::update_aggregates;
+    using Base::replace_child;
+    using Base::correct_node;
+
+    static uint32_t priority(node_t x);
+    node_t join(node_t left, node_t right);
+    pair <node_t, node_t> split_path(node_t x, node_t left_tree,
+                                     node_t right_tree);
+};
+
+/* The finalizer of MurmurHash3, which mixes consecutive indices well */
+template <class Hook>
+inline uint32_t BasicTreap<Hook>::priority(node_t x) {
+    uint32_t h = x;
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+typedef BasicTreap <> Treap;
+
+#endif
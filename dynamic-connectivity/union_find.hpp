@@ -0,0 +1,150 @@
+#ifndef UNION_FIND_HPP
+#define UNION_FIND_HPP
+
+#include <utility>
+#include <vector>
+using namespace std;
+
+/**
+ * Disjoint set union over n elements with union by size
+ * and path halving
+ * (https://en.wikipedia.org/wiki/Disjoint-set_data_structure).
+ */
+
+class UnionFind {
+    public:
+
+    UnionFind(int n) {
+        Parent.resize(n);
+        Size.assign(n, 1);
+        for (int i = 0; i < n; i++)
+            Parent[i] = i;
+    }
+
+    /**
+     * Returns the representative of the set containing a
+     * Complexity: O(alpha(n)) (amortized)
+     */
+    int find(int a) {
+        while (Parent[a] != a) {
+            Parent[a] = Parent[Parent[a]];
+            a = Parent[a];
+        }
+        return a;
+    }
+
+    /**
+     * Merges the sets containing a and b
+     * Returns false if they were already the same set
+     * Complexity: O(alpha(n)) (amortized)
+     */
+    bool unite(int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a == b)
+            return false;
+
+        if (Size[a] < Size[b])
+            swap(a, b);
+        Parent[b] = a;
+        Size[a] += Size[b];
+        return true;
+    }
+
+    /**
+     * Returns the size of the set containing a
+     * Complexity: O(alpha(n)) (amortized)
+     */
+    int size(int a) {
+        return Size[find(a)];
+    }
+
+    private:
+    vector <int> Parent;
+    vector <int> Size;
+};
+
+/**
+ * Disjoint set union over n elements with union by size and
+ * no path compression, so that the unions can be undone in
+ * the reverse order.
+ */
+
+class RollbackUnionFind {
+    public:
+
+    RollbackUnionFind(int n) {
+        Parent.resize(n);
+        Size.assign(n, 1);
+        for (int i = 0; i < n; i++)
+            Parent[i] = i;
+        sets = n;
+    }
+
+    /**
+     * Returns the representative of the set containing a
+     * Complexity: O(log n)
+     */
+    int find(int a) const {
+        while (Parent[a] != a)
+            a = Parent[a];
+        return a;
+    }
+
+    /**
+     * Merges the sets containing a and b
+     * Returns false if they were already the same set
+     * Complexity: O(log n)
+     */
+    bool unite(int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a == b)
+            return false;
+
+        if (Size[a] < Size[b])
+            swap(a, b);
+        Parent[b] = a;
+        Size[a] += Size[b];
+        History.push_back(b);
+        sets--;
+        return true;
+    }
+
+    /* Returns the number of sets */
+    int count() const {
+        return sets;
+    }
+
+    /**
+     * Returns a checkpoint to roll back to, which stays valid
+     * until the unions made before it are rolled back
+     * Complexity: O(1)
+     */
+    int checkpoint() const {
+        return History.size();
+    }
+
+    /**
+     * Undoes all unions made since the checkpoint
+     * Complexity: O(1) per union undone
+     */
+    void rollback(int checkpoint) {
+        while ((int) History.size() > checkpoint) {
+            int b = History.back(), a = Parent[b];
+            History.pop_back();
+            Parent[b] = b;
+            Size[a] -= Size[b];
+            sets++;
+        }
+    }
+
+    private:
+    vector <int> Parent;
+    vector <int> Size;
+    /* the roots which got a parent, in the order of the unions */
+    vector <int> History;
+    int sets;
+};
+
+#endif